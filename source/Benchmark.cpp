@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "Benchmark.h"
+
+namespace dae
+{
+	bool Benchmark::Run(const std::string& name)
+	{
+		if (name == "--bench-transforms")
+		{
+			TransformSystemUpdate(100'000);
+			return true;
+		}
+
+		if (name == "--bench-jobs")
+			return JobSystemScaling(100'000);
+
+		if (name == "--bench-matrices")
+			return Matrices(100'000);
+
+		if (name == "--bench-commands")
+			return CommandRecording(20'000);
+
+		if (name == "--bench-renderer")
+			return HeadlessRenderer(10'000);
+
+		if (name == "--bench-ring")
+			return RingAllocator();
+
+		if (name == "--bench-effect-cache")
+			return EffectCacheCheck();
+
+		if (name == "--bench-registry")
+			return Registry();
+
+		if (name == "--bench-permutations")
+			return ShaderPermutations(1'000'000);
+
+		if (name == "--bench-mips")
+			return MipChains();
+
+		if (name == "--bench-compression")
+			return TextureCompression();
+
+		if (name == "--bench-packing")
+			return ChannelPacking();
+
+		if (name == "--bench-startup")
+			return Startup();
+
+		if (name == "--bench-pixels")
+			return PixelConversions();
+
+		if (name == "--bench-cooked")
+			return CookedTextures();
+
+		if (name == "--bench-streaming")
+			return TextureStreaming();
+
+		if (name == "--bench-atlas")
+			return TextureAtlases(500);
+
+		if (name == "--bench-sampler")
+			return CpuSampling(1'000'000);
+
+		if (name == "--bench-tiling")
+			return TexelLayouts(1'000'000);
+
+		if (name == "--bench-software")
+			return SoftwareRendering(20);
+
+		std::cout << "Unknown benchmark: " << name << "\n";
+		return false;
+	}
+}
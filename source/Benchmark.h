@@ -0,0 +1,74 @@
+#pragma once
+
+namespace dae
+{
+	//Headless benchmarks, started with the benchmark name as the first command line argument
+	//e.g. "DirectX.exe --bench-transforms"
+	//The ones returning bool first run self-checks, one PASS or FAIL line each, then time what they checked.
+	//They return false as soon as one check failed, so they double as the tests of their subsystem.
+	namespace Benchmark
+	{
+		//Returns false if the name isn't a known benchmark
+		bool Run(const std::string& name);
+
+		//BenchmarkEngine.cpp
+		void TransformSystemUpdate(uint32_t numObjects);
+		//Whose jobs a waiting thread runs, then the same transform update with 1 to N threads
+		bool JobSystemScaling(uint32_t numObjects);
+		//Every pair of transform types multiplied, every type inverted, against the plain 4x4 math, then both timed per type
+		bool Matrices(uint32_t numMatrices);
+
+		//BenchmarkRendering.cpp
+		//Records synthetic draws serially and in parallel, replays both on the recording backend and compares them
+		bool CommandRecording(uint32_t numDraws);
+		//Full update + render of a synthetic scene on the null device, which counts invalid calls
+		bool HeadlessRenderer(uint32_t numMeshes);
+		//Per-frame constant ring: alignment, discard/no-overwrite, wrapping, fencing, a long randomized run,
+		//then the device growing it under the state cache
+		bool RingAllocator();
+		//Decodes the scene's images one after another and then concurrently, then starts the vehicle scene
+		//on the null device twice (the second start hits the texture cache) and reports the time to its first frame
+		bool Startup();
+
+		//BenchmarkEffects.cpp
+		//Compiled effect cache on a scratch directory: key sensitivity, round trip, corrupt entries, the cost of a hit
+		bool EffectCacheCheck();
+		//Acquires the same effects and samplers for more and more materials, from several threads,
+		//then shared textures under different spellings of their paths. Fails if device objects grow with the materials.
+		bool Registry();
+		//Every permutation of PosCol3D.fx through its preprocessor switches, then its CPU port (CpuShader.h),
+		//the one the software device shades with, run per permutation over the same pixels. Stands in for GPU timings, which need a window;
+		//the D3D device logs the compiled instruction counts.
+		bool ShaderPermutations(uint32_t numPixels);
+
+		//BenchmarkTextures.cpp
+		//Mip generator on synthetic images (sizes, flat colors, sRGB averaging, unit normals), then per filter and thread count
+		bool MipChains();
+		//Block compressors (flat and two color blocks, sizes, device validation, the disk cache), then quality and speed
+		bool TextureCompression();
+		//Specular and glossiness packed into one texture, every texel in its channel, against two separate textures
+		bool ChannelPacking();
+		//RGBA normalization of every decoded layout (SIMD against scalar, odd widths, padded pitches, palettes)
+		bool PixelConversions();
+		//Cooked files against the chains they came from, their alignment, rejection of damaged or stale files,
+		//then loading each scene texture from its images against from its cooked file
+		bool CookedTextures();
+		//Texture streamer on synthetic chains (mip selection, tails, the budget, eviction, deferred releases),
+		//then a fly-through past a road of vehicles
+		bool TextureStreaming();
+		//Atlas packer and builder (no overlaps, no bleeding at any level, UV remapping),
+		//then numObjects props drawn with their own textures against merged per atlas page
+		bool TextureAtlases(uint32_t numObjects);
+
+		//BenchmarkSampling.cpp
+		//CPU sampler (texel centers, addressing, mip selection, anisotropy), batched against scalar on the vehicle's map
+		bool CpuSampling(uint32_t numSamples);
+		//Tiled texel layout (round trips through partial tiles, same samples as rows), then rows against tiles
+		bool TexelLayouts(uint32_t numSamples);
+
+		//BenchmarkSoftware.cpp
+		//Software device coverage (no gaps or overlaps), pixel by pixel against the fill rule, depth and alpha tests, near plane and guard band,
+		//then numFrames of the scene per worker count, the same image on each
+		bool SoftwareRendering(uint32_t numFrames);
+	}
+}
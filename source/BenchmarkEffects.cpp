@@ -0,0 +1,479 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "JobSystem.h"
+#include "NullDevice.h"
+#include "EffectCache.h"
+#include "ResourceRegistry.h"
+#include "ShaderPermutation.h"
+#include "Texture.h"
+#include "CpuTexture.h"
+#include "CpuShader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace
+	{
+		using Benchmark::Clock;
+		using Benchmark::ElapsedMs;
+
+		//What the rasterizer interpolates for the PS of PosCol3D.fx, the textures are sampled at uv
+		struct Interpolants
+		{
+			Vector3 worldPosition{};
+			Vector2 uv{};
+			Vector3 normal{};
+			Vector3 tangent{};
+		};
+
+		//Point sampled with wrapping, like gSamState
+		const SamplerDesc g_ShaderSampler{ SamplerFilter::Point, SamplerAddress::Wrap };
+
+		struct CpuMaterial
+		{
+			const CpuTexture* pDiffuse{ nullptr };
+			const CpuTexture* pNormal{ nullptr };
+			//Glossiness in w
+			const CpuTexture* pSpecular{ nullptr };
+		};
+
+		float ShadePixels(uint32_t features, const std::vector<Interpolants>& pixels, const CpuMaterial& material, float& checksum)
+		{
+			//The scene's light, seen from its camera
+			FrameConstants frame{};
+			for (int i{}; i < 4; ++i)
+				frame.viewInverse[i * 5] = 1.f;
+			frame.viewInverse[14] = -50.f;
+			const Vector3 lightDirection{ 0.577f, -0.577f, 0.577f };
+			frame.lightDirection[0] = lightDirection.x;
+			frame.lightDirection[1] = lightDirection.y;
+			frame.lightDirection[2] = lightDirection.z;
+			frame.lightIntensity = 7.f;
+			const MaterialConstants constants{};
+
+			const CpuShader::ShadePixelFunction shadePixel{ CpuShader::GetShadePixel(features) };
+			Vector4 sum{};
+
+			const Clock::time_point start{ Clock::now() };
+			for (const Interpolants& pixel : pixels)
+			{
+				CpuShader::PixelInput input{ pixel.worldPosition, pixel.normal, pixel.tangent, material.pDiffuse->Sample(g_ShaderSampler, pixel.uv) };
+				if (features & ShaderFeature::NormalMap)
+					input.normalMap = material.pNormal->Sample(g_ShaderSampler, pixel.uv);
+				if (features & ShaderFeature::SpecularMap)
+					input.specularGlossiness = material.pSpecular->Sample(g_ShaderSampler, pixel.uv);
+
+				Vector4 color{};
+				if (shadePixel(input, frame, constants, color))
+					sum += color;
+			}
+			const float ms{ ElapsedMs(start) };
+
+			checksum = sum.x + sum.y + sum.z + sum.w;
+			return ms;
+		}
+
+		//The lines of an effect file a permutation compiles, with its defines set first.
+		//Only understands what PosCol3D.fx uses (#define, #ifndef, #if on a switch, #else, #endif),
+		//returns false on anything else and on unbalanced directives.
+		bool PreprocessEffect(const std::string& path, const std::vector<EffectDefine>& defines, std::string& output)
+		{
+			std::ifstream file{ path };
+			if (!file)
+				return false;
+
+			std::unordered_map<std::string, std::string> macros{};
+			for (const EffectDefine& define : defines)
+				macros[define.name] = define.value;
+
+			struct Branch
+			{
+				bool isParentActive;
+				bool isTaken;
+				bool hasElse;
+			};
+			std::vector<Branch> branches{};
+			const auto isActive = [&branches]() { return branches.empty() || (branches.back().isParentActive && branches.back().isTaken); };
+
+			std::string line{};
+			while (std::getline(file, line))
+			{
+				std::istringstream words{ line };
+				std::string directive{};
+				std::string name{};
+				words >> directive >> name;
+				if (directive.empty() || directive[0] != '#')
+				{
+					if (isActive())
+						output += line + '\n';
+					continue;
+				}
+
+				if (directive == "#ifdef" || directive == "#ifndef")
+				{
+					const bool isDefined{ macros.contains(name) };
+					branches.push_back(Branch{ isActive(), directive == "#ifdef" ? isDefined : !isDefined, false });
+				}
+				else if (directive == "#if")
+				{
+					//Like the real preprocessor, a switch nobody defined is 0
+					const auto it{ macros.find(name) };
+					const std::string value{ it == macros.end() ? "0" : it->second };
+					if (value.empty() || !std::all_of(value.begin(), value.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+						return false;
+					branches.push_back(Branch{ isActive(), std::stoi(value) != 0, false });
+				}
+				else if (directive == "#else")
+				{
+					if (branches.empty() || branches.back().hasElse)
+						return false;
+					branches.back().isTaken = !branches.back().isTaken;
+					branches.back().hasElse = true;
+				}
+				else if (directive == "#endif")
+				{
+					if (branches.empty())
+						return false;
+					branches.pop_back();
+				}
+				else if (directive == "#define")
+				{
+					std::string value{};
+					words >> value;
+					if (isActive())
+						macros[name] = value;
+				}
+				else
+					return false;
+			}
+			return branches.empty();
+		}
+	}
+
+	bool Benchmark::EffectCacheCheck()
+	{
+		CheckList check{};
+
+		const auto writeFile = [](const std::filesystem::path& path, const std::string& contents)
+			{
+				std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+				file << contents;
+			};
+
+		std::cout << "Compiled effect cache\n";
+
+		const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "dae_effect_cache_check" };
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory / "include");
+
+		//An effect with a nested include, the key has to follow it
+		const std::filesystem::path sourceFile{ directory / "Effect.fx" };
+		const std::string source{ "#include \"include/Common.fx\"\nfloat4 gColor;\n" };
+		writeFile(sourceFile, source);
+		writeFile(directory / "include" / "Common.fx", "#include \"Lighting.fx\"\nfloat gPI = 3.14159f;\n");
+		writeFile(directory / "include" / "Lighting.fx", "float3 gLightDirection = float3(0.577f, -0.577f, 0.577f);\n");
+
+		const std::vector<EffectDefine> noDefines{};
+		const std::string target{ "fx_5_0" };
+		const uint64_t key{ EffectCache::ComputeKey(sourceFile, source, noDefines, 0, target) };
+
+		check(key == EffectCache::ComputeKey(sourceFile, source, noDefines, 0, target), "key is stable");
+		check(key != EffectCache::ComputeKey(sourceFile, source + " ", noDefines, 0, target), "source changes the key");
+		check(key != EffectCache::ComputeKey(sourceFile, source, { { "USE_NORMAL_MAP", "1" } }, 0, target), "defines change the key");
+		check(key != EffectCache::ComputeKey(sourceFile, source, noDefines, 1, target), "flags change the key");
+		check(key != EffectCache::ComputeKey(sourceFile, source, noDefines, 0, "fx_5_0/47"), "target changes the key");
+
+		writeFile(directory / "include" / "Lighting.fx", "float3 gLightDirection = float3(0.f, -1.f, 0.f);\n");
+		check(key != EffectCache::ComputeKey(sourceFile, source, noDefines, 0, target), "nested include changes the key");
+
+		//Round trip with a blob about the size of a compiled effect
+		EffectCache cache{ directory / "Cache" };
+		std::vector<uint8_t> compiled(64 * 1024);
+		for (size_t i{}; i < compiled.size(); ++i)
+			compiled[i] = static_cast<uint8_t>(i * 31 + 7);
+
+		std::vector<uint8_t> loaded{};
+		const bool isMissing{ !cache.Load(key, loaded) };
+		const bool isStored{ cache.Store(key, compiled.data(), compiled.size()) };
+		check(isMissing && isStored && cache.Load(key, loaded) && loaded == compiled, "stored entry loads back");
+
+		//Flip a byte of the payload, the entry has to be rejected instead of handed to the runtime
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator{ cache.GetDirectory() })
+		{
+			std::fstream file{ entry.path(), std::ios::binary | std::ios::in | std::ios::out };
+			file.seekp(-1, std::ios::end);
+			file.put(static_cast<char>(compiled.back() ^ 0x5a));
+		}
+		check(!cache.Load(key, loaded), "corrupt entry misses");
+		check(cache.GetNumHits() == 1 && cache.GetNumMisses() == 2, "hits and misses are counted");
+
+		//What a hit costs at startup: hashing the sources plus reading the entry
+		cache.Store(EffectCache::ComputeKey(sourceFile, source, noDefines, 0, target), compiled.data(), compiled.size());
+		constexpr int numLoads{ 200 };
+		const Clock::time_point start{ Clock::now() };
+		bool isEveryLoadHit{ true };
+		for (int i{}; i < numLoads; ++i)
+		{
+			const uint64_t loadKey{ EffectCache::ComputeKey(sourceFile, source, noDefines, 0, target) };
+			isEveryLoadHit = cache.Load(loadKey, loaded) && isEveryLoadHit;
+		}
+		const float hitMs{ ElapsedMs(start) / numLoads };
+		check(isEveryLoadHit, "unchanged sources keep hitting");
+		std::cout << "    hit: " << hitMs << " ms for " << compiled.size() / 1024 << " KiB (compiling the effects takes hundreds of ms)\n";
+
+		std::filesystem::remove_all(directory);
+
+		return check.Finish("effect cache");
+	}
+
+	bool Benchmark::Registry()
+	{
+		CheckList check{};
+		JobSystem jobs{};
+
+		std::cout << "Effect, sampler and texture registry, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//Every material asks for one of two effects and one of two samplers, all at once from the workers
+		for (uint32_t numMaterials : { 1u, 10u, 100u, 1'000u, 10'000u })
+		{
+			NullDevice device{};
+			ResourceRegistry registry{ &device };
+			std::vector<EffectHandle> effects(numMaterials);
+			std::vector<SamplerHandle> samplers(numMaterials);
+			const std::vector<EffectDefine> alphaTest{ { "ALPHA_TEST", "1" } };
+
+			const Clock::time_point start{ Clock::now() };
+			jobs.ParallelFor(numMaterials, 16, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i{ begin }; i < end; ++i)
+					{
+						effects[i] = i % 2 == 0
+							? registry.AcquireEffect(EffectType::Shaded, L"Resources/PosCol3D.fx")
+							: registry.AcquireEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", alphaTest);
+						samplers[i] = registry.AcquireSampler(SamplerDesc{ i % 3 == 0 ? SamplerFilter::Linear : SamplerFilter::Point });
+					}
+				});
+			const float acquireMs{ ElapsedMs(start) };
+
+			const uint32_t numLive{ device.GetNumLiveResources() };
+			const uint32_t expectedEffects{ std::min(numMaterials, 2u) };
+			const uint32_t expectedSamplers{ std::min(numMaterials, 2u) };
+			const bool isShared{ registry.GetNumEffectsCreated() == expectedEffects && registry.GetNumSamplersCreated() == expectedSamplers
+				&& numLive == expectedEffects + expectedSamplers };
+
+			for (uint32_t i{}; i < numMaterials; ++i)
+			{
+				registry.Release(effects[i]);
+				registry.Release(samplers[i]);
+			}
+			registry.PurgeUnused();
+			const bool isReleased{ device.GetNumLiveResources() == 0 && device.GetNumErrors() == 0 };
+
+			std::cout << "  " << (isShared && isReleased ? "PASS " : "FAIL ") << numMaterials << " materials: "
+				<< registry.GetNumEffectsCreated() << " effects and " << registry.GetNumSamplersCreated() << " samplers created, "
+				<< numLive << " device objects, " << acquireMs * 1000.f / numMaterials << " us per material\n";
+			check.Add(isShared && isReleased);
+		}
+
+		//F2 cycling: unreferenced samplers stay cached until purged
+		{
+			NullDevice device{};
+			ResourceRegistry registry{ &device };
+			SamplerHandle sampler{ SamplerHandle::Invalid };
+			for (int press{}; press < 300; ++press)
+			{
+				const SamplerHandle previous{ sampler };
+				sampler = registry.AcquireSampler(SamplerDesc{ static_cast<SamplerFilter>(press % 3) });
+				registry.Release(previous);
+			}
+			registry.Release(sampler);
+
+			const bool isCached{ registry.GetNumSamplersCreated() == 3 && registry.GetNumSamplers() == 3 };
+			std::cout << "  " << (isCached ? "PASS " : "FAIL ") << "300 filter toggles created " << registry.GetNumSamplersCreated() << " samplers\n";
+			check.Add(isCached);
+		}
+
+		//Textures: every material asks for the diffuse map under one of three spellings, a third of them compressed,
+		//and the packed specular map. Three textures exist, whatever the number of materials.
+		{
+			constexpr uint32_t numMaterials{ 300 };
+			NullDevice device{};
+			ResourceRegistry registry{ &device };
+			const std::string diffusePaths[]{ "Resources/vehicle_diffuse.png", "./Resources/vehicle_diffuse.png", "Resources/../Resources/vehicle_diffuse.png" };
+			const std::vector<ChannelSource> specularGlossiness{
+				{ "Resources/vehicle_specular.png", { 0, 1, 2, ChannelSource::NoChannel } },
+				{ "Resources/vehicle_gloss.png", { ChannelSource::NoChannel, ChannelSource::NoChannel, ChannelSource::NoChannel, 0 } }
+			};
+			std::vector<TextureHandle> textures(numMaterials * 2);
+
+			const Clock::time_point start{ Clock::now() };
+			jobs.ParallelFor(numMaterials, 16, [&](uint32_t begin, uint32_t end)
+				{
+					for (uint32_t i{ begin }; i < end; ++i)
+					{
+						const TextureFormat format{ i % 3 == 0 ? TextureFormat::Bc1 : TextureFormat::Rgba8 };
+						textures[i * 2] = registry.AcquireTexture(diffusePaths[i % 3], TextureSettings{ {}, format }, &jobs);
+						textures[i * 2 + 1] = registry.AcquireTexture(specularGlossiness, TextureSettings{}, &jobs);
+					}
+				});
+			const float acquireMs{ ElapsedMs(start) };
+
+			const std::vector<ResourceRegistry::TextureUsage> usage{ registry.GetTextureUsage() };
+			uint64_t usageBytes{};
+			uint32_t numReferences{};
+			for (const ResourceRegistry::TextureUsage& texture : usage)
+			{
+				usageBytes += texture.numBytes;
+				numReferences += texture.numReferences;
+			}
+
+			const bool isShared{ registry.GetNumTexturesCreated() == 3 && usage.size() == 3 && device.GetNumLiveResources() == 3
+				&& numReferences == numMaterials * 2 && usageBytes == registry.GetTextureMemory()
+				&& std::find(textures.begin(), textures.end(), TextureHandle::Invalid) == textures.end() };
+			std::cout << "  " << (isShared ? "PASS " : "FAIL ") << numMaterials << " materials: " << registry.GetNumTexturesCreated()
+				<< " textures created, " << registry.GetTextureMemory() / 1024 << " KiB, loaded in " << acquireMs << " ms\n";
+			for (const ResourceRegistry::TextureUsage& texture : usage)
+			{
+				std::cout << "      " << texture.name << " (" << (texture.format == TextureFormat::Bc1 ? "BC1" : "RGBA8") << "): "
+					<< texture.numBytes / 1024 << " KiB, " << texture.numReferences << " reference(s)\n";
+			}
+			check.Add(isShared);
+
+			//Memory stays until the last user is gone, then goes right away
+			for (uint32_t i{}; i < numMaterials * 2 - 1; ++i)
+				registry.Release(textures[i]);
+			const bool isKept{ registry.GetNumTextures() == 1 && device.GetNumLiveResources() == 1 };
+			registry.Release(textures.back());
+			const bool isFreed{ registry.GetNumTextures() == 0 && registry.GetTextureMemory() == 0 && device.GetNumLiveResources() == 0 };
+
+			std::cout << "  " << (isKept && isFreed ? "PASS " : "FAIL ") << "textures are freed with their last reference\n";
+			check.Add(isKept && isFreed);
+
+			//Nothing is cached for an image that isn't there, asking again tries again
+			const TextureHandle missing{ registry.AcquireTexture("Resources/missing.png") };
+			const TextureHandle missingAgain{ registry.AcquireTexture("Resources/missing.png") };
+			const bool isMissingHandled{ missing == TextureHandle::Invalid && missingAgain == TextureHandle::Invalid
+				&& registry.GetNumTextures() == 0 && registry.GetNumTexturesCreated() == 5 && device.GetNumErrors() == 0 };
+
+			std::cout << "  " << (isMissingHandled ? "PASS " : "FAIL ") << "a missing image gives an invalid handle and isn't kept\n";
+			check.Add(isMissingHandled);
+		}
+
+		return check.Finish("registry");
+	}
+
+	bool Benchmark::ShaderPermutations(uint32_t numPixels)
+	{
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+
+		//Random texels, a single level
+		std::uniform_int_distribution<uint32_t> channel{ 0, 255 };
+		const auto makeChain = [&](uint32_t size)
+			{
+				MipChain chain{};
+				chain.levels.push_back(MipChain::Level{ size, size, 0 });
+				chain.pixels.resize(size_t{ size } * size * 4);
+				for (uint8_t& texel : chain.pixels)
+					texel = static_cast<uint8_t>(channel(rng));
+				return chain;
+			};
+
+		const CpuTexture diffuse{ makeChain(512) };
+		const CpuTexture normal{ makeChain(512) };
+		const CpuTexture specular{ makeChain(512) };
+		const CpuMaterial material{ &diffuse, &normal, &specular };
+
+		//Pixels of a lit, curved surface in front of the camera
+		std::vector<Interpolants> pixels(numPixels);
+		for (Interpolants& pixel : pixels)
+		{
+			const Vector3 normal{ Vector3{ unit(rng) - 0.5f, unit(rng) - 0.5f, -1.f }.Normalized() };
+			pixel.worldPosition = Vector3{ unit(rng) * 20.f - 10.f, unit(rng) * 20.f - 10.f, unit(rng) * 5.f };
+			pixel.uv = Vector2{ unit(rng) * 4.f, unit(rng) * 4.f };
+			pixel.normal = normal;
+			pixel.tangent = Vector3::Cross(normal, Vector3::UnitY).Normalized();
+		}
+
+		struct Variant
+		{
+			const char* pName;
+			uint32_t features;
+		};
+
+		constexpr uint32_t full{ ShaderFeature::Default };
+		constexpr uint32_t diffuseOnly{ 0 };
+		constexpr uint32_t normalOnly{ ShaderFeature::NormalMap };
+		constexpr uint32_t specularOnly{ ShaderFeature::SpecularMap | ShaderFeature::GlossinessMap };
+		constexpr uint32_t alphaTested{ ShaderFeature::AlphaTest };
+		const Variant variants[]{
+			{ "full (normal, specular, gloss)", full },
+			{ "normal map only", normalOnly },
+			{ "specular + gloss only", specularOnly },
+			{ "diffuse only", diffuseOnly },
+			{ "diffuse only, alpha test", alphaTested }
+		};
+
+		std::cout << "Shader permutations\n";
+		Benchmark::CheckList check{};
+
+		//Every variant the renderer can ask for, through the same defines it passes the device
+		{
+			bool isEveryPermutationOk{ true };
+			for (uint32_t features{}; features < ShaderFeature::NumPermutations; ++features)
+			{
+				std::string source{};
+				if (!PreprocessEffect("Resources/PosCol3D.fx", ShaderPermutation::GetDefines(features), source))
+				{
+					std::cout << "    features " << features << ": unbalanced or unknown directives\n";
+					isEveryPermutationOk = false;
+					continue;
+				}
+
+				const auto has = [&source](const char* pCode) { return source.find(pCode) != std::string::npos; };
+				const bool isSpecular{ (features & ShaderFeature::SpecularMap) != 0 };
+				const bool isOk{ has("gDiffuseMap.Sample") && has("float4 PS(")
+					&& has("gNormalMap.Sample") == ((features & ShaderFeature::NormalMap) != 0)
+					&& has("gSpecularMap.Sample") == isSpecular
+					&& has("specularGlossiness.a") == (isSpecular && (features & ShaderFeature::GlossinessMap) != 0)
+					&& has("clip(") == ((features & ShaderFeature::AlphaTest) != 0) };
+				if (!isOk)
+					std::cout << "    features " << features << ": samples or clip don't match the features\n";
+				isEveryPermutationOk = isEveryPermutationOk && isOk;
+			}
+			check(isEveryPermutationOk, "all " + std::to_string(ShaderFeature::NumPermutations)
+				+ " permutations of PosCol3D.fx preprocess, each with exactly the samples and clip of its features");
+		}
+		if (!check.IsPassing())
+			return check.Finish("shader permutation");
+
+		std::cout << "  CPU port of the PosCol3D pixel shader over " << numPixels << " pixels\n";
+		std::cout << "  a material without normal/specular maps selects features " << ShaderPermutation::Select(false, false, true, false)
+			<< " (" << ShaderPermutation::GetDefines(ShaderPermutation::Select(false, false, true, false)).size() << " defines)\n";
+
+		float fullMs{};
+		for (const Variant& variant : variants)
+		{
+			constexpr int numRuns{ 5 };
+			float bestMs{ FLT_MAX };
+			float checksum{};
+			for (int run{}; run < numRuns; ++run)
+				bestMs = std::min(bestMs, ShadePixels(variant.features, pixels, material, checksum));
+
+			if (variant.features == full)
+				fullMs = bestMs;
+
+			//Glossiness comes with the specular sample
+			const uint32_t numSamples{ 1u + ((variant.features & ShaderFeature::NormalMap) ? 1u : 0u)
+				+ ((variant.features & ShaderFeature::SpecularMap) ? 1u : 0u) };
+			std::cout << "  " << variant.pName << ": " << bestMs << " ms, " << numSamples << " samples/pixel, "
+				<< bestMs / fullMs * 100.f << "% of full (checksum " << checksum << ")\n";
+		}
+		return check.Finish("shader permutation");
+	}
+}
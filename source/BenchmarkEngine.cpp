@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "TransformSystem.h"
+#include "JobSystem.h"
+
+#include <random>
+#include <thread>
+
+namespace dae
+{
+	namespace
+	{
+		//Reference: the old layout, one heap object per instance that updates itself through a parent pointer
+		struct PointerTransform
+		{
+			Vector3 position{};
+			Vector3 rotation{};
+			Vector3 scale{};
+			Vector3 angularVelocity{};
+			const PointerTransform* pParent{ nullptr };
+			Matrix world{};
+
+			void Update(float deltaTime)
+			{
+				rotation += angularVelocity * deltaTime;
+				world = Matrix::CreateScale(scale) * Matrix::CreateRotation(rotation) * Matrix::CreateTranslation(position);
+				if (pParent)
+					world *= pParent->world;
+			}
+		};
+
+		//Plain 4x4 product, nothing skipped, to check the typed paths against
+		Matrix MultiplyReference(const Matrix& m1, const Matrix& m2)
+		{
+			Vector4 rows[4]{};
+			for (int r{}; r < 4; ++r)
+			{
+				for (int c{}; c < 4; ++c)
+				{
+					float sum{};
+					for (int k{}; k < 4; ++k)
+						sum += m1[r][k] * m2[k][c];
+					rows[r][c] = sum;
+				}
+			}
+			return Matrix{ rows[0], rows[1], rows[2], rows[3] };
+		}
+
+		bool IsNear(const Matrix& m1, const Matrix& m2, float tolerance)
+		{
+			for (int r{}; r < 4; ++r)
+			{
+				for (int c{}; c < 4; ++c)
+				{
+					if (std::abs(m1[r][c] - m2[r][c]) > tolerance * std::max(1.f, std::abs(m2[r][c])))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		float GetMaxAbs(const Matrix& m)
+		{
+			float maxAbs{};
+			for (int r{}; r < 4; ++r)
+				for (int c{}; c < 4; ++c)
+					maxAbs = std::max(maxAbs, std::abs(m[r][c]));
+			return maxAbs;
+		}
+
+		const char* GetTypeName(TransformType type)
+		{
+			constexpr const char* names[]{ "identity", "translation", "rigid", "affine", "projective" };
+			return names[static_cast<uint32_t>(type)];
+		}
+	}
+
+	void Benchmark::TransformSystemUpdate(uint32_t numObjects)
+	{
+		constexpr int numFrames{ 100 };
+		constexpr float deltaTime{ 1.f / 60.f };
+		constexpr uint32_t childrenPerRoot{ 3 };
+
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> position{ -100.f, 100.f };
+		std::uniform_real_distribution<float> angle{ -PI, PI };
+
+		//Roots first, then their children => breadth-first
+		const uint32_t numRoots{ numObjects / (childrenPerRoot + 1) };
+		std::vector<PointerTransform*> pointerTransforms{};
+		pointerTransforms.reserve(numObjects);
+
+		TransformSystem transforms{};
+		transforms.Reserve(numObjects);
+
+		for (uint32_t i{}; i < numObjects; ++i)
+		{
+			const bool isRoot{ i < numRoots };
+			const TransformId parent{ isRoot ? InvalidTransformId : (i - numRoots) % numRoots };
+
+			PointerTransform* pTransform{ new PointerTransform{} };
+			pTransform->position = { position(rng), position(rng), position(rng) };
+			pTransform->rotation = { angle(rng), angle(rng), angle(rng) };
+			pTransform->scale = { 1.f, 1.f, 1.f };
+			pTransform->angularVelocity = { 0.f, angle(rng), 0.f };
+			pTransform->pParent = isRoot ? nullptr : pointerTransforms[parent];
+			pointerTransforms.push_back(pTransform);
+
+			const TransformId id{ transforms.Add(pTransform->position, pTransform->rotation, pTransform->scale, parent) };
+			transforms.SetAngularVelocity(id, pTransform->angularVelocity);
+		}
+
+		Clock::time_point start{ Clock::now() };
+		for (int frame{}; frame < numFrames; ++frame)
+		{
+			for (PointerTransform* pTransform : pointerTransforms)
+				pTransform->Update(deltaTime);
+		}
+		const float pointerMs{ ElapsedMs(start) / numFrames };
+
+		JobSystem jobs{};
+		start = Clock::now();
+		for (int frame{}; frame < numFrames; ++frame)
+			transforms.Update(deltaTime, jobs);
+		const float soaMs{ ElapsedMs(start) / numFrames };
+
+		for (PointerTransform* pTransform : pointerTransforms)
+			delete pTransform;
+
+		constexpr float frameBudgetMs{ 1000.f / 60.f };
+		std::cout << "Transform update, " << numObjects << " animated objects (" << numRoots << " roots)\n";
+		std::cout << "  pointer objects: " << pointerMs << " ms/frame (" << 100.f * pointerMs / frameBudgetMs << "% of a 60Hz frame)\n";
+		std::cout << "  SoA system:      " << soaMs << " ms/frame (" << 100.f * soaMs / frameBudgetMs << "% of a 60Hz frame)\n";
+	}
+
+	bool Benchmark::JobSystemScaling(uint32_t numObjects)
+	{
+		constexpr int numFrames{ 50 };
+		constexpr float deltaTime{ 1.f / 60.f };
+
+		CheckList check{};
+		std::cout << "Job system\n";
+
+		//The only worker is kept busy while another thread queues a job (think texture load) on top of a ParallelFor's batches.
+		//The thread waiting on the ParallelFor runs its own batches, and leaves the other job to the worker.
+		{
+			JobSystem jobs{ 1 };
+			std::atomic<bool> isBlocking{ false };
+			std::atomic<bool> isReleased{ false };
+			JobCounter blockerCounter{};
+			jobs.Run([&]()
+				{
+					isBlocking = true;
+					while (!isReleased)
+						std::this_thread::yield();
+				}, &blockerCounter);
+			while (!isBlocking)
+				std::this_thread::yield();
+
+			std::thread::id foreignThread{};
+			JobCounter foreignCounter{};
+			std::atomic<uint32_t> numBatches{};
+			jobs.ParallelFor(64, 16, [&](uint32_t, uint32_t)
+				{
+					if (numBatches++ == 0)
+						std::thread{ [&]() { jobs.Run([&]() { foreignThread = std::this_thread::get_id(); }, &foreignCounter); } }.join();
+				});
+			const bool isForeignLeft{ !foreignCounter.IsDone() };
+
+			isReleased = true;
+			while (!foreignCounter.IsDone())
+				std::this_thread::yield();
+			jobs.Wait(blockerCounter);
+
+			check(numBatches == 4 && isForeignLeft && foreignThread != std::this_thread::get_id(),
+				"a waiting thread outside the pool only runs the jobs it waits on");
+		}
+
+		//Without workers nothing else would run them, so then it runs anything
+		{
+			JobSystem jobs{ 0 };
+			JobCounter dependency{};
+			JobCounter counter{};
+			bool isRun{ false };
+			jobs.Run([]() {}, &dependency);
+			jobs.RunAfter(dependency, [&]() { isRun = true; }, &counter);
+			jobs.Wait(counter);
+			check(isRun, "without workers a waiting thread runs whatever its counter depends on");
+		}
+
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> angle{ -PI, PI };
+
+		TransformSystem transforms{};
+		transforms.Reserve(numObjects);
+		for (uint32_t i{}; i < numObjects; ++i)
+		{
+			const TransformId id{ transforms.Add({ float(i), 0.f, 0.f }, { angle(rng), angle(rng), angle(rng) }) };
+			transforms.SetAngularVelocity(id, { angle(rng), angle(rng), 0.f });
+		}
+
+		std::cout << "  scaling, transform update of " << numObjects << " objects\n";
+
+		const uint32_t maxThreads{ JobSystem::DefaultNumWorkers() + 1 };
+		float singleThreadMs{};
+		for (uint32_t numThreads{ 1 }; numThreads <= maxThreads; ++numThreads)
+		{
+			JobSystem jobs{ numThreads - 1 };
+
+			//Warm up the caches and wake the workers
+			transforms.Update(deltaTime, jobs);
+
+			const Clock::time_point start{ Clock::now() };
+			for (int frame{}; frame < numFrames; ++frame)
+				transforms.Update(deltaTime, jobs);
+			const float ms{ ElapsedMs(start) / numFrames };
+
+			if (numThreads == 1)
+				singleThreadMs = ms;
+
+			std::cout << "  " << numThreads << " thread(s): " << ms << " ms/frame, speedup " << singleThreadMs / ms << "x\n";
+		}
+
+		return check.Finish("job system");
+	}
+
+	bool Benchmark::Matrices(uint32_t numMatrices)
+	{
+		constexpr uint32_t numTypes{ static_cast<uint32_t>(TransformType::Projective) + 1 };
+		constexpr float tolerance{ 1e-4f };
+
+		CheckList check{};
+		std::cout << "Matrix transform types\n";
+
+		//A random matrix built the way each type comes about in the engine
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> angle{ -PI, PI };
+		std::uniform_real_distribution<float> offset{ -100.f, 100.f };
+		std::uniform_real_distribution<float> scale{ 0.25f, 4.f };
+		const auto createMatrix = [&](TransformType type)
+			{
+				const Matrix translation{ Matrix::CreateTranslation(offset(rng), offset(rng), offset(rng)) };
+				const Matrix rigid{ Matrix::CreateRotation(angle(rng), angle(rng), angle(rng)) * translation };
+				switch (type)
+				{
+				case TransformType::Identity:
+					return Matrix{};
+				case TransformType::Translation:
+					return translation;
+				case TransformType::Rigid:
+					return rigid;
+				case TransformType::Affine:
+					return Matrix::CreateScale(scale(rng), scale(rng), scale(rng)) * rigid;
+				case TransformType::Projective:
+				default:
+				{
+					//A view followed by a perspective projection, like the camera's
+					const float nearClip{ 0.1f };
+					const float farClip{ 100.f };
+					const Matrix projection{ Vector4{ scale(rng), 0, 0, 0 }, Vector4{ 0, scale(rng), 0, 0 },
+						Vector4{ 0, 0, farClip / (farClip - nearClip), 1 }, Vector4{ 0, 0, -farClip * nearClip / (farClip - nearClip), 0 } };
+					return rigid * projection;
+				}
+				}
+			};
+
+		//Every type is tagged as itself, products as the larger of both and inverses as what they invert
+		bool isTagged{ true };
+		for (uint32_t i{}; i < numTypes; ++i)
+			isTagged = isTagged && createMatrix(static_cast<TransformType>(i)).GetTransformType() == static_cast<TransformType>(i);
+		check(isTagged, "the Create functions and constructors tag each type");
+
+		constexpr uint32_t samplesPerCombination{ 100 };
+		for (uint32_t a{}; a < numTypes; ++a)
+		{
+			for (uint32_t b{}; b < numTypes; ++b)
+			{
+				const TransformType typeA{ static_cast<TransformType>(a) };
+				const TransformType typeB{ static_cast<TransformType>(b) };
+				bool isExact{ true };
+				bool isTypeKept{ true };
+				for (uint32_t sample{}; sample < samplesPerCombination; ++sample)
+				{
+					const Matrix m1{ createMatrix(typeA) };
+					const Matrix m2{ createMatrix(typeB) };
+					Matrix product{ m1 * m2 };
+					isExact = isExact && IsNear(product, MultiplyReference(m1, m2), tolerance);
+					isTypeKept = isTypeKept && product.GetTransformType() == std::max(typeA, typeB);
+
+					product = m1;
+					product *= m2;
+					isExact = isExact && IsNear(product, MultiplyReference(m1, m2), tolerance);
+				}
+				check(isExact && isTypeKept, std::string{ GetTypeName(typeA) } + " * " + GetTypeName(typeB) + " matches the full product, "
+					+ GetTypeName(std::max(typeA, typeB)));
+			}
+		}
+
+		for (uint32_t i{}; i < numTypes; ++i)
+		{
+			const TransformType type{ static_cast<TransformType>(i) };
+			bool isInverse{ true };
+			for (uint32_t sample{}; sample < samplesPerCombination; ++sample)
+			{
+				const Matrix m{ createMatrix(type) };
+				const Matrix inverse{ Matrix::Inverse(m) };
+				//Float rounding grows with the condition number, a projection with a near plane of 0.1 has a large one
+				const float inverseTolerance{ tolerance * std::max(1.f, GetMaxAbs(m) * GetMaxAbs(inverse)) };
+				isInverse = isInverse && inverse.GetTransformType() == type
+					&& IsNear(MultiplyReference(m, inverse), Matrix{}, inverseTolerance) && IsNear(MultiplyReference(inverse, m), Matrix{}, inverseTolerance);
+			}
+			check(isInverse, std::string{ "inverse of " } + GetTypeName(type) + " times it is the identity");
+		}
+
+		//Writes keep what they can: a new translation leaves rigid axes rigid, a new w column makes it projective
+		{
+			Matrix m{ createMatrix(TransformType::Rigid) };
+			m.SetRow(3, Vector4{ 1.f, 2.f, 3.f, 1.f });
+			const bool isRigidKept{ m.GetTransformType() == TransformType::Rigid };
+			Matrix translation{};
+			translation.SetRow(3, Vector4{ 1.f, 2.f, 3.f, 1.f });
+			const bool isTranslation{ translation.GetTransformType() == TransformType::Translation };
+			m.SetRow(2, Vector4{ 0.f, 0.f, 1.f, 1.f });
+			const bool isProjective{ m.GetTransformType() == TransformType::Projective };
+			m.SetRow(2, Vector4{ 0.f, 0.f, 1.f, 0.f });
+			check(isRigidKept && isTranslation && isProjective && m.GetTransformType() == TransformType::Affine,
+				"SetRow keeps the type of a new translation and reclassifies new axes");
+		}
+
+		//Per type: the typed paths against the full product and a general inverse through the projective path
+		std::cout << "  per type, " << numMatrices << " matrices:\n";
+		for (uint32_t i{}; i < numTypes; ++i)
+		{
+			const TransformType type{ static_cast<TransformType>(i) };
+			std::vector<Matrix> matrices{};
+			for (uint32_t m{}; m < numMatrices; ++m)
+				matrices.push_back(createMatrix(type));
+
+			float checksum{};
+			Clock::time_point start{ Clock::now() };
+			for (uint32_t m{}; m + 1 < numMatrices; ++m)
+				checksum += (matrices[m] * matrices[m + 1])[3][0];
+			const float multiplyMs{ ElapsedMs(start) };
+
+			start = Clock::now();
+			for (uint32_t m{}; m + 1 < numMatrices; ++m)
+				checksum += MultiplyReference(matrices[m], matrices[m + 1])[3][0];
+			const float referenceMs{ ElapsedMs(start) };
+
+			start = Clock::now();
+			for (const Matrix& m : matrices)
+				checksum += Matrix::Inverse(m)[3][0];
+			const float inverseMs{ ElapsedMs(start) };
+
+			std::cout << "    " << GetTypeName(type) << ": multiply " << multiplyMs << " ms (full product " << referenceMs << " ms), inverse "
+				<< inverseMs << " ms (checksum " << checksum << ")\n";
+		}
+
+		return check.Finish("matrix");
+	}
+}
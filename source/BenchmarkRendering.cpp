@@ -0,0 +1,443 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "JobSystem.h"
+#include "CommandBuffer.h"
+#include "RecordingCommandBackend.h"
+#include "NullDevice.h"
+#include "Renderer.h"
+#include "Mesh.h"
+#include "FrameRingAllocator.h"
+#include "StateCache.h"
+#include "FrameStats.h"
+#include "Texture.h"
+#include "TextureStreamer.h"
+
+#include <cstring>
+#include <random>
+
+namespace dae
+{
+	namespace
+	{
+		//What a Mesh records, with made up handles
+		struct SyntheticDraw
+		{
+			EffectHandle effect{};
+			InputLayoutHandle layout{};
+			BufferHandle vertexBuffer{};
+			BufferHandle indexBuffer{};
+			uint32_t numIndices{};
+			Matrix world{};
+		};
+
+		constexpr uint32_t FrameConstantsSize{ GraphicsDevice::AlignConstantSize(sizeof(FrameConstants)) };
+		constexpr uint32_t ConstantsStride{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+
+		void RecordDraw(CommandBuffer& commands, const SyntheticDraw& draw, const Matrix& viewProjection, uint8_t* pConstants, uint32_t constantsOffset)
+		{
+			ObjectConstants object{};
+			StoreMatrix(object.worldViewProjection, draw.world * viewProjection);
+			StoreMatrix(object.world, draw.world);
+			std::memcpy(pConstants, &object, sizeof(ObjectConstants));
+
+			commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+			commands.SetInputLayout(draw.layout);
+			commands.SetVertexBuffer(draw.vertexBuffer, 60);
+			commands.SetIndexBuffer(draw.indexBuffer);
+			commands.ApplyPass(draw.effect, 0);
+			commands.SetConstants(ConstantSlot::Frame, 0, FrameConstantsSize);
+			commands.SetConstants(ConstantSlot::Object, constantsOffset, ConstantsStride);
+			commands.DrawIndexed(draw.numIndices);
+		}
+	}
+
+	bool Benchmark::CommandRecording(uint32_t numDraws)
+	{
+		constexpr int numFrames{ 50 };
+		constexpr uint32_t drawsPerCommandBuffer{ 64 };
+
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> position{ -100.f, 100.f };
+		std::uniform_int_distribution<uint32_t> handle{ 1, 16 };
+
+		std::vector<SyntheticDraw> draws(numDraws);
+		for (SyntheticDraw& draw : draws)
+		{
+			draw.effect = static_cast<EffectHandle>(handle(rng));
+			draw.layout = static_cast<InputLayoutHandle>(handle(rng));
+			draw.vertexBuffer = static_cast<BufferHandle>(handle(rng));
+			draw.indexBuffer = static_cast<BufferHandle>(handle(rng));
+			draw.numIndices = 3 * handle(rng);
+			draw.world = Matrix::CreateTranslation(position(rng), position(rng), position(rng));
+		}
+		const Matrix viewProjection{ Matrix::CreateRotation(0.f, 0.5f, 0.f) * Matrix::CreateTranslation(0.f, 0.f, 50.f) };
+
+		//Stands in for the mapped constant ring
+		std::vector<uint8_t> constants(FrameConstantsSize + size_t{ numDraws } * ConstantsStride);
+
+		//Reference: everything in one buffer on this thread
+		CommandBuffer serialBuffer{};
+		const Clock::time_point serialStart{ Clock::now() };
+		for (int frame{}; frame < numFrames; ++frame)
+		{
+			serialBuffer.Reset();
+			for (uint32_t i{}; i < numDraws; ++i)
+				RecordDraw(serialBuffer, draws[i], viewProjection, constants.data() + FrameConstantsSize + i * ConstantsStride, FrameConstantsSize + i * ConstantsStride);
+		}
+		const float serialMs{ ElapsedMs(serialStart) / numFrames };
+
+		//Same draws split in ranges, each recorded into its own buffer by whichever thread picks it up
+		JobSystem jobs{};
+		std::vector<CommandBuffer> parallelBuffers((numDraws + drawsPerCommandBuffer - 1) / drawsPerCommandBuffer);
+		const Clock::time_point parallelStart{ Clock::now() };
+		for (int frame{}; frame < numFrames; ++frame)
+		{
+			jobs.ParallelFor(numDraws, drawsPerCommandBuffer, [&](uint32_t begin, uint32_t end)
+				{
+					CommandBuffer& commands{ parallelBuffers[begin / drawsPerCommandBuffer] };
+					commands.Reset();
+					for (uint32_t i{ begin }; i < end; ++i)
+						RecordDraw(commands, draws[i], viewProjection, constants.data() + FrameConstantsSize + i * ConstantsStride, FrameConstantsSize + i * ConstantsStride);
+				});
+		}
+		const float parallelMs{ ElapsedMs(parallelStart) / numFrames };
+
+		RecordingCommandBackend serialBackend{};
+		serialBackend.Submit(serialBuffer);
+
+		RecordingCommandBackend parallelBackend{};
+		for (const CommandBuffer& commands : parallelBuffers)
+			parallelBackend.Submit(commands);
+
+		const bool isIdentical{ serialBackend.GetChecksum() == parallelBackend.GetChecksum()
+			&& serialBackend.GetNumCommands() == parallelBackend.GetNumCommands() };
+		const bool isValid{ serialBackend.GetNumDraws() == numDraws && parallelBackend.GetNumInvalidDraws() == 0 };
+
+		std::cout << "Command recording, " << numDraws << " draws in buffers of " << drawsPerCommandBuffer << "\n";
+		std::cout << "  serial:   " << serialMs << " ms/frame\n";
+		std::cout << "  parallel: " << parallelMs << " ms/frame on " << jobs.GetNumThreads() << " thread(s), " << parallelBuffers.size() << " buffers\n";
+		std::cout << "  replay:   " << parallelBackend.GetNumCommands() << " commands, " << parallelBackend.GetNumDraws() << " draws, "
+			<< parallelBackend.GetNumIndices() << " indices, " << (isIdentical ? "identical to" : "DIFFERENT from") << " serial recording\n";
+
+		return isIdentical && isValid;
+	}
+
+	bool Benchmark::HeadlessRenderer(uint32_t numMeshes)
+	{
+		constexpr int numFrames{ 200 };
+
+		NullDevice* pDevice{ new NullDevice{} };
+		Renderer renderer{ pDevice, 1280, 720, numMeshes };
+
+		Timer timer{};
+		timer.Start();
+
+		//Warm up: first frame uploads everything
+		timer.Update();
+		renderer.Update(&timer);
+		renderer.Flush();
+		const FrameStats firstFrame{ renderer.GetFrameStats() };
+		const uint32_t firstDraws{ pDevice->GetNumDraws() };
+		const uint32_t firstStateChanges{ pDevice->GetNumStateChanges() };
+		const uint64_t firstConstantBytes{ pDevice->GetNumConstantBytes() };
+
+		const Clock::time_point start{ Clock::now() };
+		for (int frame{}; frame < numFrames; ++frame)
+		{
+			timer.Update();
+			renderer.Update(&timer);
+		}
+		renderer.Flush();
+		const float frameMs{ ElapsedMs(start) / numFrames };
+
+		const FrameStats lastFrame{ renderer.GetFrameStats() };
+		const uint32_t numDraws{ pDevice->GetNumDraws() - firstDraws };
+		const uint32_t numStateChanges{ pDevice->GetNumStateChanges() - firstStateChanges };
+		const uint64_t numConstantBytes{ pDevice->GetNumConstantBytes() - firstConstantBytes };
+		const uint32_t numErrors{ pDevice->GetNumErrors() };
+
+		std::cout << "Headless renderer, " << numMeshes << " meshes, " << numFrames << " frames on the null device\n";
+		std::cout << "  frame:         " << frameMs << " ms (update " << lastFrame.updateMs << " ms, render " << lastFrame.renderMs << " ms)\n";
+		std::cout << "  per frame:     " << numDraws / numFrames << " draws, " << numStateChanges / numFrames << " state changes, "
+			<< numConstantBytes / numFrames / 1024 << " KiB constants (ring " << pDevice->GetConstantRingCapacity() / 1024 << " KiB)\n";
+		std::cout << "  first frame:   " << firstFrame << "\n";
+		std::cout << "  last frame:    " << lastFrame << "\n";
+		std::cout << "  device errors: " << numErrors << ", live resources: " << pDevice->GetNumLiveResources() << "\n";
+
+		return numErrors == 0;
+	}
+
+	bool Benchmark::RingAllocator()
+	{
+		constexpr uint32_t alignment{ GraphicsDevice::ConstantAlignment };
+		CheckList check{};
+
+		std::cout << "Constant ring allocator\n";
+
+		//Sizes are rounded up, the first block of a fresh ring discards
+		{
+			FrameRingAllocator ring{ 4 * alignment, alignment };
+			RingAllocation first{};
+			RingAllocation second{};
+			ring.BeginFrame(0);
+			const bool isAllocated{ ring.Allocate(1, first) && ring.Allocate(alignment + 1, second) };
+			ring.EndFrame();
+
+			check(isAllocated && first.offset == 0 && second.offset == alignment, "blocks are aligned");
+			check(first.isDiscard && !second.isDiscard, "first block discards, the rest doesn't overwrite");
+			check(ring.GetUsed() == 3 * alignment, "used size includes rounding");
+		}
+
+		//A block that doesn't fit at the end goes to the front and discards
+		{
+			FrameRingAllocator ring{ 4 * alignment, alignment };
+			RingAllocation allocation{};
+			ring.BeginFrame(0);
+			ring.Allocate(3 * alignment, allocation);
+			ring.EndFrame();
+			ring.BeginFrame(1);
+			ring.RetireFrame(0);
+			const bool isAllocated{ ring.Allocate(2 * alignment, allocation) };
+			ring.EndFrame();
+
+			check(isAllocated && allocation.offset == 0 && allocation.isDiscard, "wrapping starts over with discard");
+		}
+
+		//Space of a frame only comes back once it is retired
+		{
+			FrameRingAllocator ring{ 4 * alignment, alignment };
+			RingAllocation allocation{};
+			ring.BeginFrame(0);
+			ring.Allocate(2 * alignment, allocation);
+			ring.EndFrame();
+			ring.BeginFrame(1);
+			ring.Allocate(alignment, allocation);
+			const bool isBlocked{ !ring.Allocate(2 * alignment, allocation) };
+			ring.RetireFrame(0);
+			const bool isFreed{ ring.Allocate(2 * alignment, allocation) };
+			ring.EndFrame();
+
+			check(isBlocked && isFreed && allocation.offset == 0, "frames in flight are fenced until retired");
+		}
+
+		//Random block sizes with the GPU lagging behind, no block may touch a range a frame in flight still owns
+		{
+			constexpr uint32_t latency{ 2 };
+			constexpr uint64_t numFrames{ 1000 };
+			FrameRingAllocator ring{ 32 * alignment, alignment };
+			std::mt19937 rng{ 1337 };
+			std::uniform_int_distribution<uint32_t> numBlocks{ 0, 8 };
+			std::uniform_int_distribution<uint32_t> blockSize{ 1, 4 * alignment };
+
+			//A discard starts a new generation of the buffer, no-overwrite only has to respect the current one
+			struct Range { uint64_t frame; uint32_t generation; uint32_t begin; uint32_t end; };
+			std::deque<Range> inFlight{};
+			bool isOverlapFree{ true };
+			bool isDiscardCorrect{ true };
+			uint32_t generation{};
+			uint32_t numAllocated{};
+			uint32_t numRejected{};
+
+			for (uint64_t frame{}; frame < numFrames; ++frame)
+			{
+				if (frame >= latency)
+				{
+					ring.RetireFrame(frame - latency);
+					while (!inFlight.empty() && inFlight.front().frame <= frame - latency)
+						inFlight.pop_front();
+				}
+
+				ring.BeginFrame(frame);
+				const uint32_t count{ numBlocks(rng) };
+				for (uint32_t block{}; block < count; ++block)
+				{
+					const uint32_t size{ blockSize(rng) };
+					RingAllocation allocation{};
+					if (!ring.Allocate(size, allocation))
+					{
+						++numRejected;
+						continue;
+					}
+					++numAllocated;
+
+					if (allocation.isDiscard)
+						++generation;
+
+					const Range range{ frame, generation, allocation.offset, allocation.offset + size };
+					isOverlapFree = isOverlapFree && range.end <= ring.GetCapacity() && allocation.offset % alignment == 0;
+					for (const Range& other : inFlight)
+					{
+						if (range.begin < other.end && other.begin < range.end)
+							isOverlapFree = false;
+					}
+
+					//Without a discard the ring only moves forward
+					for (const Range& other : inFlight)
+					{
+						if (other.generation == generation && other.begin >= range.begin)
+							isDiscardCorrect = false;
+					}
+					inFlight.push_back(range);
+				}
+				ring.EndFrame();
+			}
+
+			check(isOverlapFree, "no block overlaps a frame in flight");
+			check(isDiscardCorrect, "no-overwrite blocks only follow older ranges");
+			std::cout << "    " << numAllocated << " blocks over " << numFrames << " frames, " << numRejected << " rejected while full\n";
+		}
+
+		//Growing the ring on the device: the same offsets in the new buffer have to be bound again,
+		//the null device counts draws with constants still bound into the old one
+		{
+			const auto drawTwoFrames = [](bool isCacheResetOnGrowth)
+				{
+					NullDevice device{};
+					const uint32_t indices[]{ 0, 1, 2 };
+					const Vertex vertices[3]{};
+					const EffectHandle effect{ device.CreateEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", {}) };
+					const InputLayoutHandle layout{ device.CreateInputLayout(effect) };
+					const BufferHandle vertexBuffer{ device.CreateVertexBuffer(vertices, sizeof(vertices)) };
+					const BufferHandle indexBuffer{ device.CreateIndexBuffer(indices, 3) };
+					StateCache cache{};
+					FrameStats stats{};
+					CommandBuffer commands{};
+					bool isNewRing{ false };
+					for (uint32_t size : { FrameConstantsSize + ConstantsStride, device.GetConstantRingCapacity() + ConstantsStride })
+					{
+						device.BeginFrame(ColorRGB{});
+						const ConstantBlock block{ device.MapConstants(size) };
+						device.UnmapConstants();
+						isNewRing = block.isNewRing;
+						if (block.isNewRing && isCacheResetOnGrowth)
+							cache.Reset();
+
+						commands.Reset();
+						commands.ApplyPass(effect, 0);
+						commands.SetInputLayout(layout);
+						commands.SetVertexBuffer(vertexBuffer, sizeof(Vertex));
+						commands.SetIndexBuffer(indexBuffer);
+						commands.SetConstants(ConstantSlot::Frame, block.offset, FrameConstantsSize);
+						commands.SetConstants(ConstantSlot::Object, block.offset + FrameConstantsSize, ConstantsStride);
+						commands.DrawIndexed(3);
+						cache.Filter(commands, stats);
+						device.Submit(commands);
+						device.Present();
+					}
+
+					device.Release(indexBuffer);
+					device.Release(vertexBuffer);
+					device.Release(layout);
+					device.Release(effect);
+					return std::pair{ isNewRing, device.GetNumErrors() };
+				};
+
+			const auto [isNewRing, numErrors] { drawTwoFrames(true) };
+			const auto [isNewRingToo, numStaleErrors] { drawTwoFrames(false) };
+			check(isNewRing && numErrors == 0, "a grown ring is reported, resetting the state cache binds the new buffer");
+			check(isNewRingToo && numStaleErrors > 0, "the null device catches draws bound into the old buffer");
+		}
+
+		//Throughput: the renderer maps one block per frame, this is the worst case of one block per draw
+		{
+			constexpr uint32_t numBlocks{ 1'000'000 };
+			FrameRingAllocator ring{ 1024 * alignment, alignment };
+			RingAllocation allocation{};
+			uint64_t checksum{};
+
+			const Clock::time_point start{ Clock::now() };
+			for (uint32_t block{}; block < numBlocks; ++block)
+			{
+				if (block % 512 == 0)
+				{
+					if (block > 0)
+						ring.EndFrame();
+					ring.RetireFrame(block / 512);
+					ring.BeginFrame(block / 512 + 2);
+				}
+				ring.Allocate(alignment, allocation);
+				checksum += allocation.offset;
+			}
+			ring.EndFrame();
+			const float ms{ ElapsedMs(start) };
+
+			std::cout << "    " << numBlocks << " allocations in " << ms << " ms (" << ms * 1'000'000.f / numBlocks << " ns each, checksum " << checksum << ")\n";
+		}
+
+		return check.Finish("ring");
+	}
+
+	bool Benchmark::Startup()
+	{
+		CheckList check{};
+		JobSystem jobs{};
+
+		std::cout << "Startup, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//PNG inflate alone, what the main thread used to do before anything else
+		std::vector<std::string> paths{};
+		for (const TextureAsset& asset : Renderer::GetTextureAssets())
+		{
+			for (const ChannelSource& source : asset.sources)
+				paths.push_back(source.path);
+		}
+		const uint32_t numImages{ static_cast<uint32_t>(paths.size()) };
+
+		std::vector<SDL_Surface*> surfaces(numImages);
+		const auto decode = [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i{ begin }; i < end; ++i)
+					surfaces[i] = IMG_Load(paths[i].c_str());
+			};
+		const auto freeSurfaces = [&]()
+			{
+				bool isDecoded{ true };
+				for (SDL_Surface*& pSurface : surfaces)
+				{
+					isDecoded = isDecoded && pSurface;
+					SDL_FreeSurface(pSurface);
+					pSurface = nullptr;
+				}
+				return isDecoded;
+			};
+
+		Clock::time_point start{ Clock::now() };
+		decode(0, numImages);
+		const float sequentialMs{ ElapsedMs(start) };
+		const bool isSequentialDecoded{ freeSurfaces() };
+
+		start = Clock::now();
+		jobs.ParallelFor(numImages, 1, decode);
+		const float concurrentMs{ ElapsedMs(start) };
+		const bool isConcurrentDecoded{ freeSurfaces() };
+
+		const bool isDecoded{ isSequentialDecoded && isConcurrentDecoded };
+		std::cout << "  " << (isDecoded ? "PASS " : "FAIL ") << numImages << " images decoded in " << sequentialMs << " ms one after another, "
+			<< concurrentMs << " ms concurrently\n";
+		check.Add(isDecoded);
+
+		//The whole scene: effects, textures and meshes, then one frame through the pipeline
+		for (const char* pStart : { "first start", "second start" })
+		{
+			NullDevice* pDevice{ new NullDevice{} };
+			start = Clock::now();
+			Renderer renderer{ pDevice, 1280, 720 };
+			const float constructMs{ ElapsedMs(start) };
+
+			Timer timer{};
+			timer.Start();
+			timer.Update();
+			renderer.Update(&timer);
+			renderer.Flush();
+
+			const bool isValid{ pDevice->GetNumErrors() == 0 && renderer.GetTimeToFirstFrame() > 0.f };
+			std::cout << "  " << (isValid ? "PASS " : "FAIL ") << pStart << ": loaded in " << constructMs << " ms, first frame after "
+				<< renderer.GetTimeToFirstFrame() << " ms, " << renderer.GetTextureStreamer().GetNumTextures() << " textures ("
+				<< renderer.GetTextureStreamer().GetResidentBytes() / 1024 << " KiB resident)\n";
+			check.Add(isValid);
+		}
+
+		return check.Finish("startup");
+	}
+}
@@ -0,0 +1,370 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "JobSystem.h"
+#include "MipChain.h"
+#include "Renderer.h"
+#include "Texture.h"
+#include "CpuTexture.h"
+
+#include <cstring>
+#include <random>
+
+namespace dae
+{
+	bool Benchmark::CpuSampling(uint32_t numSamples)
+	{
+		CheckList check{};
+		const auto isNear = [](const Vector4& a, const Vector4& b, float tolerance = 1e-5f)
+			{
+				return std::abs(a.x - b.x) <= tolerance && std::abs(a.y - b.y) <= tolerance && std::abs(a.z - b.z) <= tolerance && std::abs(a.w - b.w) <= tolerance;
+			};
+
+		JobSystem jobs{};
+		std::cout << "CPU texture sampling, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		const SamplerDesc point{ SamplerFilter::Point };
+		const SamplerDesc linear{ SamplerFilter::Linear };
+		const SamplerDesc anisotropic{ SamplerFilter::Anisotropic };
+		const SamplerDesc clampedLinear{ SamplerFilter::Linear, SamplerAddress::Clamp };
+
+		//16x16 gradient, every texel different
+		constexpr uint32_t size{ 16 };
+		std::vector<uint8_t> gradient(size * size * 4);
+		for (uint32_t y{}; y < size; ++y)
+			for (uint32_t x{}; x < size; ++x)
+			{
+				uint8_t* pTexel{ gradient.data() + (y * size + x) * 4 };
+				pTexel[0] = static_cast<uint8_t>(x * 16);
+				pTexel[1] = static_cast<uint8_t>(y * 16);
+				pTexel[2] = static_cast<uint8_t>((x + y) * 8);
+				pTexel[3] = 255;
+			}
+		MipChain gradientChain{};
+		MipGenerator::Generate(gradient.data(), size, size, size * 4, MipSettings{}, gradientChain);
+		const CpuTexture texture{ gradientChain };
+
+		{
+			bool isExact{ texture.GetWidth() == size && texture.GetNumLevels() == 5 };
+			for (uint32_t y{}; y < size; ++y)
+				for (uint32_t x{}; x < size; ++x)
+					isExact = isExact && isNear(texture.Sample(point, Vector2{ (x + 0.5f) / size, (y + 0.5f) / size }), texture.GetTexel(0, x, y), 0.f)
+						&& isNear(texture.Sample(linear, Vector2{ (x + 0.5f) / size, (y + 0.5f) / size }), texture.GetTexel(0, x, y));
+			check(isExact, "point and linear return the texel at its center");
+
+			const Vector4 between{ texture.Sample(linear, Vector2{ 4.f / size, 2.5f / size }) };
+			const Vector4 wrapped{ texture.Sample(linear, Vector2{ 0.f, 2.5f / size }) };
+			const Vector4 clamped{ texture.Sample(clampedLinear, Vector2{ 0.f, 2.5f / size }) };
+			check(isNear(between, (texture.GetTexel(0, 3, 2) + texture.GetTexel(0, 4, 2)) * 0.5f)
+				&& isNear(wrapped, (texture.GetTexel(0, 15, 2) + texture.GetTexel(0, 0, 2)) * 0.5f) && isNear(clamped, texture.GetTexel(0, 0, 2)),
+				"linear blends its neighbours, across the edge when wrapping, not when clamping");
+		}
+
+		//Every level its own flat color, so the color says which levels were read
+		MipChain levelChain{ CreateBlankChain(TextureFormat::Rgba8, 64) };
+		for (uint32_t level{}; level < levelChain.levels.size(); ++level)
+		{
+			const TextureLevel texels{ levelChain.GetLevel(level) };
+			for (size_t texel{}; texel < size_t{ texels.width } * texels.height; ++texel)
+			{
+				uint8_t* pTexel{ levelChain.pixels.data() + levelChain.levels[level].offset + texel * 4 };
+				pTexel[0] = static_cast<uint8_t>(level * 40);
+				pTexel[3] = 255;
+			}
+		}
+		{
+			const CpuTexture levels{ levelChain };
+			const Vector2 uv{ 0.3f, 0.6f };
+			const auto levelRed = [](float level) { return level * 40.f / 255.f; };
+
+			check(std::abs(levels.Sample(point, uv, Vector2{ 4.f / 64, 0.f }).x - levelRed(2.f)) < 1e-5f
+				&& std::abs(levels.Sample(linear, uv, Vector2{ 4.f / 64, 0.f }).x - levelRed(2.f)) < 1e-5f
+				&& std::abs(levels.Sample(point, uv, Vector2{ 3.f / 64, 0.f }).x - levelRed(2.f)) < 1e-5f
+				&& std::abs(levels.Sample(linear, uv, Vector2{ 3.f / 64, 0.f }).x - levelRed(std::log2(3.f))) < 1e-4f
+				&& std::abs(levels.Sample(linear, uv).x - levelRed(0.f)) < 1e-5f,
+				"point takes the nearest level, linear blends the two around the footprint");
+
+			SamplerDesc twoTaps{ anisotropic };
+			twoTaps.maxAnisotropy = 2;
+			const Vector2 along{ 8.f / 64, 0.f };
+			const Vector2 across{ 0.f, 1.f / 64 };
+			check(std::abs(levels.Sample(anisotropic, uv, along, across).x - levelRed(0.f)) < 1e-5f
+				&& std::abs(levels.Sample(twoTaps, uv, along, across).x - levelRed(2.f)) < 1e-5f
+				&& std::abs(levels.Sample(linear, uv, along, across).x - levelRed(3.f)) < 1e-5f,
+				"an 8:1 footprint stays on level 0 with 16x anisotropy, level 2 with 2x, level 3 without");
+		}
+
+		//The batched path against the scalar one, then both timed on the vehicle's diffuse map
+		const TextureAsset& diffuse{ Renderer::GetTextureAsset(SceneTexture::VehicleDiffuse) };
+		CpuTexture* pTexture{ CpuTexture::Load(diffuse.sources, diffuse.settings, &jobs) };
+		if (!pTexture)
+		{
+			check(false, "vehicle_diffuse.png loads, run from the directory that holds Resources");
+			return false;
+		}
+
+		std::mt19937 rng{ 1337 };
+		std::uniform_real_distribution<float> uvs{ -3.f, 3.f };
+		std::uniform_real_distribution<float> angles{ 0.f, 6.2831853f };
+		std::uniform_real_distribution<float> footprints{ -12.f, 0.f };
+		std::vector<SampleBatch> batches(numSamples / SampleBatch::Size);
+		for (SampleBatch& batch : batches)
+		{
+			for (uint32_t i{}; i < SampleBatch::Size; ++i)
+			{
+				//Pixel footprints from 1/4096 to 1 UV, stretched up to 8:1 in a random direction
+				const float angle{ angles(rng) };
+				const float length{ std::exp2(footprints(rng)) };
+				const float stretch{ 1.f + 7.f * (angles(rng) / 6.2831853f) };
+				batch.u[i] = uvs(rng);
+				batch.v[i] = uvs(rng);
+				batch.dudx[i] = std::cos(angle) * length * stretch;
+				batch.dvdx[i] = std::sin(angle) * length * stretch;
+				batch.dudy[i] = -std::sin(angle) * length;
+				batch.dvdy[i] = std::cos(angle) * length;
+			}
+		}
+
+		const std::pair<const char*, SamplerDesc> samplers[]{
+			{ "point", point }, { "linear", linear }, { "anisotropic", anisotropic },
+			{ "linear mirror", SamplerDesc{ SamplerFilter::Linear, SamplerAddress::Mirror } }, { "linear clamp", clampedLinear } };
+		for (const auto& [pName, sampler] : samplers)
+		{
+			float maxDifference{};
+			float checksum{};
+			Vector4 colors[SampleBatch::Size]{};
+
+			Clock::time_point start{ Clock::now() };
+			for (const SampleBatch& batch : batches)
+			{
+				for (uint32_t i{}; i < SampleBatch::Size; ++i)
+					checksum += pTexture->Sample(sampler, Vector2{ batch.u[i], batch.v[i] }, Vector2{ batch.dudx[i], batch.dvdx[i] }, Vector2{ batch.dudy[i], batch.dvdy[i] }).x;
+			}
+			const float scalarMs{ ElapsedMs(start) };
+
+			start = Clock::now();
+			for (const SampleBatch& batch : batches)
+			{
+				pTexture->Sample(sampler, batch, colors);
+				checksum -= colors[0].x;
+			}
+			const float batchedMs{ ElapsedMs(start) };
+
+			for (size_t b{}; b < batches.size(); b += 16)
+			{
+				const SampleBatch& batch{ batches[b] };
+				pTexture->Sample(sampler, batch, colors);
+				for (uint32_t i{}; i < SampleBatch::Size; ++i)
+				{
+					const Vector4 reference{ pTexture->Sample(sampler, Vector2{ batch.u[i], batch.v[i] }, Vector2{ batch.dudx[i], batch.dvdx[i] }, Vector2{ batch.dudy[i], batch.dvdy[i] }) };
+					maxDifference = std::max({ maxDifference, std::abs(colors[i].x - reference.x), std::abs(colors[i].y - reference.y),
+						std::abs(colors[i].z - reference.z), std::abs(colors[i].w - reference.w) });
+				}
+			}
+
+			const uint32_t numTaken{ static_cast<uint32_t>(batches.size() * SampleBatch::Size) };
+			std::ostringstream message{};
+			message << pName << ": scalar " << numTaken / scalarMs / 1000.f << " M samples/s, 8 at a time " << numTaken / batchedMs / 1000.f
+				<< " M samples/s (" << scalarMs / batchedMs << "x), largest difference " << maxDifference << (checksum == 0.5f ? " " : "");
+			check(maxDifference <= 1e-5f, message.str());
+		}
+
+		delete pTexture;
+		return check.Finish("CPU sampling");
+	}
+
+	bool Benchmark::TexelLayouts(uint32_t numSamples)
+	{
+		CheckList check{};
+
+		JobSystem jobs{};
+		std::cout << "Texel layouts, rows against 4x4 Morton tiles, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		std::mt19937 rng{ 1337 };
+		std::uniform_int_distribution<uint32_t> channel{ 0, 255 };
+
+		//Partial tiles on both edges, rows with padding at their end
+		{
+			const std::pair<uint32_t, uint32_t> sizes[]{ { 1, 1 }, { 3, 5 }, { 4, 4 }, { 37, 13 }, { 64, 7 } };
+			bool isExact{ true };
+			for (const auto& [width, height] : sizes)
+			{
+				const uint32_t rowPitch{ width * 4 + 12 };
+				std::vector<uint8_t> source(size_t{ rowPitch } * height);
+				for (uint8_t& value : source)
+					value = static_cast<uint8_t>(channel(rng));
+
+				std::vector<uint8_t> tiles(TexelTiling::GetTiledSize(width, height));
+				std::vector<uint8_t> rows(source.size());
+				TexelTiling::Tile(source.data(), width, height, rowPitch, tiles.data());
+				TexelTiling::Untile(tiles.data(), width, height, rows.data(), rowPitch);
+				for (uint32_t y{}; y < height; ++y)
+					isExact = isExact && std::memcmp(source.data() + size_t{ y } * rowPitch, rows.data() + size_t{ y } * rowPitch, size_t{ width } * 4) == 0;
+			}
+			check(isExact, "rows come back unchanged from tiles, partial tiles included");
+		}
+
+		//Same texels, same samples: the layout only moves bytes
+		{
+			constexpr uint32_t width{ 37 };
+			constexpr uint32_t height{ 13 };
+			std::vector<uint8_t> pixels(width * height * 4);
+			for (uint8_t& value : pixels)
+				value = static_cast<uint8_t>(channel(rng));
+			MipChain chain{};
+			MipGenerator::Generate(pixels.data(), width, height, width * 4, MipSettings{}, chain);
+			const CpuTexture linear{ chain, nullptr, TexelLayout::Linear };
+			const CpuTexture tiled{ chain, nullptr, TexelLayout::Tiled };
+
+			bool isSame{ linear.GetNumLevels() == tiled.GetNumLevels() };
+			for (uint32_t level{}; isSame && level < chain.levels.size(); ++level)
+			{
+				const TextureLevel texels{ chain.GetLevel(level) };
+				std::vector<uint8_t> rows(size_t{ texels.width } * texels.height * 4);
+				tiled.CopyLevel(level, rows.data(), texels.width * 4);
+				isSame = isSame && std::memcmp(rows.data(), texels.pPixels, rows.size()) == 0;
+				for (uint32_t y{}; y < texels.height; ++y)
+					for (uint32_t x{}; x < texels.width; ++x)
+					{
+						const Vector4 a{ linear.GetTexel(level, x, y) };
+						const Vector4 b{ tiled.GetTexel(level, x, y) };
+						isSame = isSame && a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+					}
+			}
+			check(isSame, "every texel of every level reads the same from both layouts, and copies back to the chain");
+
+			std::uniform_real_distribution<float> uvs{ -2.f, 2.f };
+			std::uniform_real_distribution<float> derivatives{ -0.3f, 0.3f };
+			const SamplerDesc samplers[]{ { SamplerFilter::Point }, { SamplerFilter::Linear, SamplerAddress::Mirror },
+				{ SamplerFilter::Anisotropic, SamplerAddress::Clamp } };
+			for (uint32_t b{}; b < 1000 && isSame; ++b)
+			{
+				SampleBatch batch{};
+				for (uint32_t i{}; i < SampleBatch::Size; ++i)
+				{
+					batch.u[i] = uvs(rng);
+					batch.v[i] = uvs(rng);
+					batch.dudx[i] = derivatives(rng);
+					batch.dvdx[i] = derivatives(rng);
+					batch.dudy[i] = derivatives(rng);
+					batch.dvdy[i] = derivatives(rng);
+				}
+
+				Vector4 a[SampleBatch::Size]{};
+				Vector4 c[SampleBatch::Size]{};
+				for (const SamplerDesc& sampler : samplers)
+				{
+					linear.Sample(sampler, batch, a);
+					tiled.Sample(sampler, batch, c);
+					for (uint32_t i{}; i < SampleBatch::Size; ++i)
+						isSame = isSame && a[i].x == c[i].x && a[i].y == c[i].y && a[i].z == c[i].z && a[i].w == c[i].w;
+				}
+			}
+			check(isSame, "batched samples are identical from both layouts with every filter");
+		}
+
+		//The vehicle's maps as shipped
+		for (SceneTexture texture : { SceneTexture::VehicleDiffuse, SceneTexture::VehicleNormal })
+		{
+			const std::string& path{ Renderer::GetTextureAsset(texture).sources[0].path };
+			MipChain chain{};
+			if (!Texture::LoadChain({ { path } }, { { MipFilter::Box, MipContent::Linear }, TextureFormat::Rgba8 }, chain, &jobs))
+			{
+				check(false, path + " loads, run from the directory that holds Resources");
+				return false;
+			}
+			const CpuTexture linear{ chain, nullptr, TexelLayout::Linear };
+			const CpuTexture tiled{ chain, nullptr, TexelLayout::Tiled };
+			const TextureLevel top{ chain.GetLevel(0) };
+			std::cout << "  " << path << ", " << top.width << "x" << top.height << "\n";
+
+			//Conversion of the top level, repeated so it is timed from the caches it will usually come from
+			{
+				constexpr uint32_t numRepeats{ 20 };
+				std::vector<uint8_t> tiles(TexelTiling::GetTiledSize(top.width, top.height));
+				std::vector<uint8_t> rows(size_t{ top.rowPitch } * top.height);
+				Clock::time_point start{ Clock::now() };
+				for (uint32_t i{}; i < numRepeats; ++i)
+					TexelTiling::Tile(static_cast<const uint8_t*>(top.pPixels), top.width, top.height, top.rowPitch, tiles.data());
+				const float tileMs{ ElapsedMs(start) };
+				start = Clock::now();
+				for (uint32_t i{}; i < numRepeats; ++i)
+					TexelTiling::Untile(tiles.data(), top.width, top.height, rows.data(), top.rowPitch);
+				const float untileMs{ ElapsedMs(start) };
+
+				const float megabytes{ numRepeats * rows.size() / (1024.f * 1024.f) };
+				std::ostringstream message{};
+				message << "swizzle " << megabytes / tileMs << " GB/s, deswizzle " << megabytes / untileMs << " GB/s, round trip exact";
+				check(std::memcmp(rows.data(), top.pPixels, rows.size()) == 0, message.str());
+			}
+
+			//Random: every batch lands somewhere else. Coherent: a floor rotated 30 degrees seen at a grazing angle,
+			//8 neighbouring pixels of a 1024 pixel wide scanline per batch, 1.25 texels a pixel across and 5 down.
+			const float size{ static_cast<float>(top.width) };
+			std::uniform_real_distribution<float> uvs{ 0.f, 1.f };
+			std::uniform_real_distribution<float> angles{ 0.f, 6.2831853f };
+			std::vector<SampleBatch> randomBatches(numSamples / SampleBatch::Size);
+			std::vector<SampleBatch> coherentBatches(numSamples / SampleBatch::Size);
+			constexpr uint32_t screenWidth{ 1024 };
+			const float cosine{ std::cos(0.5235988f) };
+			const float sine{ std::sin(0.5235988f) };
+			for (size_t b{}; b < randomBatches.size(); ++b)
+			{
+				SampleBatch& random{ randomBatches[b] };
+				SampleBatch& coherent{ coherentBatches[b] };
+				for (uint32_t i{}; i < SampleBatch::Size; ++i)
+				{
+					const float angle{ angles(rng) };
+					random.u[i] = uvs(rng);
+					random.v[i] = uvs(rng);
+					random.dudx[i] = std::cos(angle) * 1.25f / size;
+					random.dvdx[i] = std::sin(angle) * 1.25f / size;
+					random.dudy[i] = -std::sin(angle) * 5.f / size;
+					random.dvdy[i] = std::cos(angle) * 5.f / size;
+
+					const size_t pixel{ b * SampleBatch::Size + i };
+					const float x{ static_cast<float>(pixel % screenWidth) };
+					const float y{ static_cast<float>(pixel / screenWidth) };
+					coherent.u[i] = (x * cosine * 1.25f - y * sine * 5.f) / size;
+					coherent.v[i] = (x * sine * 1.25f + y * cosine * 5.f) / size;
+					coherent.dudx[i] = cosine * 1.25f / size;
+					coherent.dvdx[i] = sine * 1.25f / size;
+					coherent.dudy[i] = -sine * 5.f / size;
+					coherent.dvdy[i] = cosine * 5.f / size;
+				}
+			}
+
+			const std::pair<const char*, const std::vector<SampleBatch>*> workloads[]{ { "random UVs", &randomBatches }, { "coherent UVs", &coherentBatches } };
+			const std::pair<const char*, SamplerDesc> samplers[]{ { "linear", SamplerDesc{ SamplerFilter::Linear } },
+				{ "anisotropic", SamplerDesc{ SamplerFilter::Anisotropic } } };
+			for (const auto& [pWorkload, pBatches] : workloads)
+			{
+				for (const auto& [pFilter, sampler] : samplers)
+				{
+					float checksums[2]{};
+					float ms[2]{};
+					const CpuTexture* pTextures[2]{ &linear, &tiled };
+					for (uint32_t layout{}; layout < 2; ++layout)
+					{
+						Vector4 colors[SampleBatch::Size]{};
+						const Clock::time_point start{ Clock::now() };
+						for (const SampleBatch& batch : *pBatches)
+						{
+							pTextures[layout]->Sample(sampler, batch, colors);
+							checksums[layout] += colors[0].x + colors[7].y;
+						}
+						ms[layout] = ElapsedMs(start);
+					}
+
+					const uint32_t numTaken{ static_cast<uint32_t>(pBatches->size() * SampleBatch::Size) };
+					std::ostringstream message{};
+					message << pWorkload << ", " << pFilter << ": rows " << numTaken / ms[0] / 1000.f << " M samples/s, tiles "
+						<< numTaken / ms[1] / 1000.f << " M samples/s (" << ms[0] / ms[1] << "x)";
+					check(checksums[0] == checksums[1], message.str());
+				}
+			}
+		}
+
+		return check.Finish("texel layout");
+	}
+}
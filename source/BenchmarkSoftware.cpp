@@ -0,0 +1,376 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+#include "Renderer.h"
+#include "Mesh.h"
+#include "SoftwareDevice.h"
+#include "CpuShader.h"
+#include "ShaderPermutation.h"
+
+#include <cstring>
+#include <random>
+
+namespace dae
+{
+	namespace
+	{
+		//Small enough that the per-pixel checks stay cheap
+		constexpr uint32_t g_ReferenceSize{ 32 };
+
+		//An axis-aligned quad in pixel coordinates (y down), in one solid RGBA8 color (R in the lowest byte).
+		//Depth runs linearly from its left to its right edge, w is 1.
+		struct ReferenceQuad
+		{
+			float left;
+			float top;
+			float right;
+			float bottom;
+			float leftZ;
+			float rightZ;
+			uint32_t color;
+			EffectType type{ EffectType::Shaded };
+			uint32_t features{};
+		};
+
+		//Faces the light head on, full intensity: a shaded quad comes out as its color / PI
+		FrameConstants GetReferenceFrame()
+		{
+			FrameConstants frame{};
+			for (int i{}; i < 4; ++i)
+				frame.viewInverse[i * 5] = 1.f;
+			frame.lightDirection[2] = 1.f;
+			frame.lightIntensity = 1.f;
+			return frame;
+		}
+		const Vector3 g_ReferenceNormal{ 0.f, 0.f, -1.f };
+
+		Vector4 UnpackRgba8(uint32_t color)
+		{
+			return Vector4{ (color & 0xFF) / 255.f, (color >> 8 & 0xFF) / 255.f, (color >> 16 & 0xFF) / 255.f, (color >> 24) / 255.f };
+		}
+
+		uint32_t PackRgba8(const Vector4& color)
+		{
+			const auto toUnorm = [](float value) { return static_cast<uint32_t>(Saturate(value) * 255.f + 0.5f); };
+			return toUnorm(color.x) | toUnorm(color.y) << 8 | toUnorm(color.z) << 16 | toUnorm(color.w) << 24;
+		}
+
+		//What the pixel of a quad should hold once it's drawn over target, or nothing when the quad clips it
+		bool GetReferenceColor(const ReferenceQuad& quad, uint32_t target, uint32_t& color)
+		{
+			const Vector4 diffuse{ UnpackRgba8(quad.color) };
+			if (quad.type == EffectType::Transparent)
+			{
+				const Vector4 below{ UnpackRgba8(target) };
+				color = PackRgba8(Vector4{ diffuse.x * diffuse.w + below.x * (1.f - diffuse.w), diffuse.y * diffuse.w + below.y * (1.f - diffuse.w),
+					diffuse.z * diffuse.w + below.z * (1.f - diffuse.w), 0.f });
+				return true;
+			}
+
+			const CpuShader::PixelInput input{ Vector3{}, g_ReferenceNormal, Vector3::UnitX, diffuse };
+			Vector4 shaded{};
+			if (!CpuShader::GetShadePixel(quad.features)(input, GetReferenceFrame(), MaterialConstants{}, shaded))
+				return false;
+			color = PackRgba8(shaded);
+			return true;
+		}
+
+		//The quads drawn in order on a fresh device, cleared to opaque black
+		std::vector<uint32_t> DrawReferenceQuads(const std::vector<ReferenceQuad>& quads, uint64_t& numPixelsShaded, uint32_t& numErrors)
+		{
+			constexpr float size{ static_cast<float>(g_ReferenceSize) };
+			SoftwareDevice device{ g_ReferenceSize, g_ReferenceSize };
+
+			struct Resources
+			{
+				TextureHandle texture;
+				EffectHandle effect;
+				InputLayoutHandle layout;
+				BufferHandle vertexBuffer;
+			};
+			std::vector<Resources> resources{};
+			const uint32_t indices[]{ 0, 1, 2, 0, 2, 3 };
+			const BufferHandle indexBuffer{ device.CreateIndexBuffer(indices, 6) };
+			for (const ReferenceQuad& quad : quads)
+			{
+				//Counterclockwise with y up, the faces gRasterizerState keeps
+				const float left{ quad.left / size * 2.f - 1.f };
+				const float right{ quad.right / size * 2.f - 1.f };
+				const float top{ 1.f - quad.top / size * 2.f };
+				const float bottom{ 1.f - quad.bottom / size * 2.f };
+				const Vertex vertices[]{
+					Vertex{ Vector3{ left, bottom, quad.leftZ }, {}, g_ReferenceNormal, Vector3::UnitX },
+					Vertex{ Vector3{ right, bottom, quad.rightZ }, {}, g_ReferenceNormal, Vector3::UnitX },
+					Vertex{ Vector3{ right, top, quad.rightZ }, {}, g_ReferenceNormal, Vector3::UnitX },
+					Vertex{ Vector3{ left, top, quad.leftZ }, {}, g_ReferenceNormal, Vector3::UnitX }
+				};
+
+				const TextureLevel level{ &quad.color, 1, 1, 4 };
+				Resources& quadResources{ resources.emplace_back() };
+				quadResources.texture = device.CreateTexture(TextureFormat::Rgba8, &level, 1);
+				quadResources.effect = device.CreateEffect(quad.type, L"",
+					quad.type == EffectType::Shaded ? ShaderPermutation::GetDefines(quad.features) : std::vector<EffectDefine>{});
+				quadResources.layout = device.CreateInputLayout(quadResources.effect);
+				quadResources.vertexBuffer = device.CreateVertexBuffer(vertices, sizeof(vertices));
+				device.SetTexture(quadResources.effect, TextureSlot::Diffuse, quadResources.texture);
+			}
+
+			constexpr uint32_t frameSize{ GraphicsDevice::AlignConstantSize(sizeof(FrameConstants)) };
+			constexpr uint32_t objectSize{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+			device.BeginFrame(ColorRGB{ 0.f, 0.f, 0.f });
+			const ConstantBlock constants{ device.MapConstants(frameSize + objectSize) };
+			const FrameConstants frame{ GetReferenceFrame() };
+			ObjectConstants object{};
+			for (int i{}; i < 4; ++i)
+				object.worldViewProjection[i * 5] = object.world[i * 5] = 1.f;
+			std::memcpy(constants.pData, &frame, sizeof(frame));
+			std::memcpy(constants.pData + frameSize, &object, sizeof(object));
+			device.UnmapConstants();
+
+			CommandBuffer commands{};
+			commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+			commands.SetIndexBuffer(indexBuffer);
+			for (const Resources& quadResources : resources)
+			{
+				commands.ApplyPass(quadResources.effect, 0);
+				commands.SetInputLayout(quadResources.layout);
+				commands.SetVertexBuffer(quadResources.vertexBuffer, sizeof(Vertex));
+				commands.SetConstants(ConstantSlot::Frame, constants.offset, frameSize);
+				commands.SetConstants(ConstantSlot::Object, constants.offset + frameSize, objectSize);
+				commands.DrawIndexed(6);
+			}
+			device.Submit(commands);
+			device.Present();
+
+			for (const Resources& quadResources : resources)
+			{
+				device.Release(quadResources.vertexBuffer);
+				device.Release(quadResources.layout);
+				device.Release(quadResources.effect);
+				device.Release(quadResources.texture);
+			}
+			device.Release(indexBuffer);
+
+			numPixelsShaded = device.GetNumPixelsShaded();
+			numErrors = device.GetNumErrors();
+			return device.GetColorBuffer();
+		}
+
+		//Each pixel against the quads drawn over each other in order: a quad covers the pixel centers inside it,
+		//or on its left or top edge, where its depth is in [0, 1) and below what an earlier opaque quad left there
+		bool IsEveryPixelAsReferenced(const std::vector<ReferenceQuad>& quads)
+		{
+			uint64_t numPixelsShaded{};
+			uint32_t numErrors{};
+			const std::vector<uint32_t> colors{ DrawReferenceQuads(quads, numPixelsShaded, numErrors) };
+
+			bool isMatching{ numErrors == 0 };
+			for (uint32_t y{}; y < g_ReferenceSize; ++y)
+			{
+				for (uint32_t x{}; x < g_ReferenceSize; ++x)
+				{
+					const float centerX{ x + 0.5f };
+					const float centerY{ y + 0.5f };
+					uint32_t expected{ 0xFF000000 };
+					float depth{ 1.f };
+					for (const ReferenceQuad& quad : quads)
+					{
+						const float z{ quad.leftZ + (quad.rightZ - quad.leftZ) * (centerX - quad.left) / (quad.right - quad.left) };
+						const bool isCovered{ centerX >= quad.left && centerX < quad.right && centerY >= quad.top && centerY < quad.bottom };
+						if (!isCovered || z < 0.f || !(z < depth))
+							continue;
+
+						uint32_t color{};
+						if (!GetReferenceColor(quad, expected, color))
+							continue;
+						expected = color;
+						//PartialCoverage.fx doesn't write depth
+						if (quad.type == EffectType::Shaded)
+							depth = z;
+					}
+					isMatching = isMatching && colors[size_t{ y } * g_ReferenceSize + x] == expected;
+				}
+			}
+			return isMatching;
+		}
+	}
+
+	bool Benchmark::SoftwareRendering(uint32_t numFrames)
+	{
+		constexpr uint32_t width{ 640 };
+		constexpr uint32_t height{ 480 };
+
+		CheckList check{};
+
+		std::cout << "Software device, " << width << "x" << height << "\n";
+
+		//A jittered grid reaching past the screen, drawn with PartialCoverage.fx: it doesn't depth test against itself,
+		//so every pixel is shaded once per triangle covering it and has to be shaded exactly once
+		{
+			constexpr uint32_t gridSize{ 37 };
+			std::mt19937 rng{ 1337 };
+			std::uniform_real_distribution<float> jitter{ -0.3f, 0.3f };
+
+			std::vector<Vertex> vertices{};
+			for (uint32_t y{}; y <= gridSize; ++y)
+			{
+				for (uint32_t x{}; x <= gridSize; ++x)
+				{
+					const bool isBorder{ x == 0 || y == 0 || x == gridSize || y == gridSize };
+					const float cellX{ x + (isBorder ? 0.f : jitter(rng)) };
+					const float cellY{ y + (isBorder ? 0.f : jitter(rng)) };
+					vertices.push_back(Vertex{ Vector3{ -1.1f + 2.2f * cellX / gridSize, -1.1f + 2.2f * cellY / gridSize, 0.5f }, {}, {}, {} });
+				}
+			}
+
+			//Counterclockwise with y up, the faces gRasterizerState keeps
+			std::vector<uint32_t> indices{};
+			for (uint32_t y{}; y < gridSize; ++y)
+			{
+				for (uint32_t x{}; x < gridSize; ++x)
+				{
+					const uint32_t corner{ y * (gridSize + 1) + x };
+					indices.insert(indices.end(), { corner, corner + 1, corner + gridSize + 2, corner, corner + gridSize + 2, corner + gridSize + 1 });
+				}
+			}
+
+			SoftwareDevice device{ width, height };
+			const BufferHandle vertexBuffer{ device.CreateVertexBuffer(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(Vertex))) };
+			const BufferHandle indexBuffer{ device.CreateIndexBuffer(indices.data(), static_cast<uint32_t>(indices.size())) };
+			const EffectHandle effect{ device.CreateEffect(EffectType::Transparent, L"", {}) };
+			const InputLayoutHandle layout{ device.CreateInputLayout(effect) };
+
+			constexpr uint32_t constantsSize{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+			device.BeginFrame(ColorRGB{ 0.f, 0.f, 0.3f });
+			const ConstantBlock constants{ device.MapConstants(constantsSize) };
+			ObjectConstants object{};
+			for (int i{}; i < 4; ++i)
+				object.worldViewProjection[i * 5] = object.world[i * 5] = 1.f;
+			std::memcpy(constants.pData, &object, sizeof(object));
+			device.UnmapConstants();
+
+			CommandBuffer commands{};
+			commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
+			commands.SetInputLayout(layout);
+			commands.SetVertexBuffer(vertexBuffer, sizeof(Vertex));
+			commands.SetIndexBuffer(indexBuffer);
+			commands.ApplyPass(effect, 0);
+			commands.SetConstants(ConstantSlot::Object, constants.offset, constantsSize);
+			commands.DrawIndexed(static_cast<uint32_t>(indices.size()));
+			device.Submit(commands);
+			device.Present();
+
+			//The blend state zeroes alpha, the clear color has it at 1
+			const std::vector<uint32_t>& colors{ device.GetColorBuffer() };
+			const bool isCovered{ std::all_of(colors.begin(), colors.end(), [](uint32_t color) { return color >> 24 == 0; }) };
+			check(isCovered && device.GetNumPixelsShaded() == uint64_t{ width } * height,
+				std::to_string(device.GetNumTriangles()) + " triangles cover every pixel exactly once (" + std::to_string(device.GetNumPixelsShaded())
+				+ " pixels shaded)");
+
+			device.Release(layout);
+			device.Release(effect);
+			device.Release(indexBuffer);
+			device.Release(vertexBuffer);
+		}
+
+		//Pixel by pixel against the rules the device follows
+		{
+			constexpr uint32_t red{ 0xFF0000FF };
+			constexpr uint32_t green{ 0xFF00FF00 };
+			constexpr uint32_t blue{ 0xFFFF0000 };
+
+			//Edges exactly through pixel centers: left and top ones own them, right and bottom ones don't,
+			//and the diagonal both triangles share is drawn once
+			{
+				uint64_t numPixelsShaded{};
+				uint32_t numErrors{};
+				DrawReferenceQuads({ ReferenceQuad{ 4.5f, 6.5f, 14.5f, 16.5f, 0.5f, 0.5f, blue, EffectType::Transparent } }, numPixelsShaded, numErrors);
+				check(numErrors == 0 && numPixelsShaded == 100
+					&& IsEveryPixelAsReferenced({ ReferenceQuad{ 4.5f, 6.5f, 14.5f, 16.5f, 0.5f, 0.5f, blue, EffectType::Transparent } }),
+					"top-left fill rule, " + std::to_string(numPixelsShaded) + " pixels of a 10x10 quad shaded");
+			}
+
+			//The nearer quad wins whichever is drawn first
+			const ReferenceQuad nearQuad{ 2.f, 2.f, 20.f, 20.f, 0.25f, 0.25f, red };
+			const ReferenceQuad farQuad{ 10.f, 10.f, 30.f, 30.f, 0.75f, 0.75f, green };
+			check(IsEveryPixelAsReferenced({ nearQuad, farQuad }) && IsEveryPixelAsReferenced({ farQuad, nearQuad }), "depth test in either draw order");
+
+			//Clipped pixels keep what's behind them and leave the depth alone, so a farther quad drawn later still shows
+			ReferenceQuad clippedQuad{ nearQuad };
+			clippedQuad.features = ShaderFeature::AlphaTest;
+			clippedQuad.color = red & 0x00FFFFFF;
+			ReferenceQuad keptQuad{ clippedQuad };
+			keptQuad.color = red;
+			check(IsEveryPixelAsReferenced({ clippedQuad, farQuad }) && IsEveryPixelAsReferenced({ keptQuad, farQuad }),
+				"alpha test clips below the cutoff without writing depth, and writes it above");
+
+			//Depth from -1 on the left to 1 on the right: the left half is in front of the near plane and cut off
+			check(IsEveryPixelAsReferenced({ ReferenceQuad{ 0.f, 0.f, 32.f, 32.f, -1.f, 1.f, red } }), "near plane clipping");
+
+			//Corners millions of pixels off screen are clipped to the guard band instead of losing the triangle
+			const ReferenceQuad hugeQuad{ -1e7f, -1e7f, 1e7f, 1e7f, 0.5f, 0.5f, red };
+			const ReferenceQuad hugeStrip{ 8.f, -1e7f, 1e7f, 24.f, 0.25f, 0.25f, green };
+			check(IsEveryPixelAsReferenced({ hugeQuad, hugeStrip }), "guard band clipping");
+		}
+
+		//The scene, the same frames on every worker count. The renderer hands the device its own pool,
+		//here it's swapped for one of each size to see how rasterizing scales.
+		std::vector<uint32_t> firstImage{};
+		float singleThreadMs{};
+		for (uint32_t numWorkers : { 0u, 1u, 3u, 7u })
+		{
+			JobSystem jobs{ numWorkers };
+			SoftwareDevice* pDevice{ new SoftwareDevice{ width, height, nullptr } };
+			Renderer renderer{ pDevice, width, height };
+			if (firstImage.empty())
+				check(pDevice->GetNumThreads() == JobSystem::DefaultNumWorkers() + 1, "the device rasterizes on the renderer's job system");
+
+			Timer timer{};
+			timer.Start();
+			timer.Update();
+			renderer.Update(&timer);
+			renderer.Flush();
+			pDevice->SetJobSystem(&jobs);
+
+			float rasterizeMs{};
+			const Clock::time_point start{ Clock::now() };
+			for (uint32_t frame{}; frame < numFrames; ++frame)
+			{
+				timer.Update();
+				renderer.Update(&timer);
+				renderer.Flush();
+				rasterizeMs += pDevice->GetRasterizeMs();
+			}
+			const float frameMs{ ElapsedMs(start) / numFrames };
+
+			//Fire pixels have their alpha zeroed by the blend, the clear color is opaque dark blue
+			const std::vector<uint32_t>& colors{ pDevice->GetColorBuffer() };
+			const uint32_t clearColor{ 0xFF4D0000 };
+			const size_t numFirePixels{ static_cast<size_t>(std::count_if(colors.begin(), colors.end(), [](uint32_t color) { return color >> 24 == 0; })) };
+			const size_t numOpaquePixels{ static_cast<size_t>(std::count_if(colors.begin(), colors.end(),
+				[clearColor](uint32_t color) { return color >> 24 == 0xFF && color != clearColor; })) };
+
+			const float presentMs{ rasterizeMs / numFrames };
+			if (numWorkers == 0)
+				singleThreadMs = presentMs;
+			std::cout << "  " << pDevice->GetNumThreads() << " thread(s): " << frameMs << " ms/frame, Present " << presentMs << " ms (speedup "
+				<< singleThreadMs / presentMs << "x), " << pDevice->GetNumTriangles() << " triangles, " << pDevice->GetNumPixelsShaded() << " pixels shaded\n";
+
+			if (firstImage.empty())
+			{
+				check(pDevice->GetNumErrors() == 0, "no device errors");
+				check(numOpaquePixels > width * height / 20, "vehicle on screen (" + std::to_string(numOpaquePixels) + " pixels)");
+				check(numFirePixels > 0, "fire blended over it (" + std::to_string(numFirePixels) + " pixels)");
+				firstImage = colors;
+			}
+			else
+			{
+				check(pDevice->GetNumErrors() == 0 && colors == firstImage, "same image on " + std::to_string(numWorkers + 1) + " threads");
+			}
+		}
+
+		return check.Finish("software device");
+	}
+}
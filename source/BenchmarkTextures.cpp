@@ -0,0 +1,1206 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "BenchmarkUtils.h"
+#include "JobSystem.h"
+#include "CommandBuffer.h"
+#include "NullDevice.h"
+#include "Renderer.h"
+#include "Mesh.h"
+#include "MipChain.h"
+#include "BlockCompression.h"
+#include "TextureCache.h"
+#include "Texture.h"
+#include "PixelConversion.h"
+#include "CookedTexture.h"
+#include "TextureStreamer.h"
+#include "TextureAtlas.h"
+#include "FramePipeline.h"
+#include "StateCache.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace dae
+{
+	bool Benchmark::MipChains()
+	{
+		CheckList check{};
+
+		const auto makeImage = [](uint32_t width, uint32_t height, const auto& texel)
+			{
+				std::vector<uint8_t> pixels(size_t{ width } * height * 4);
+				for (uint32_t y{}; y < height; ++y)
+					for (uint32_t x{}; x < width; ++x)
+						texel(x, y, &pixels[(size_t{ y } * width + x) * 4]);
+				return pixels;
+			};
+
+		const MipSettings allSettings[]{
+			{ MipFilter::Box, MipContent::Linear }, { MipFilter::Box, MipContent::Srgb }, { MipFilter::Box, MipContent::NormalMap },
+			{ MipFilter::Kaiser, MipContent::Linear }, { MipFilter::Kaiser, MipContent::Srgb }, { MipFilter::Kaiser, MipContent::NormalMap }
+		};
+		const auto getName = [](const MipSettings& settings)
+			{
+				std::string name{ settings.filter == MipFilter::Box ? "box" : "kaiser" };
+				name += settings.content == MipContent::Linear ? " linear" : settings.content == MipContent::Srgb ? " srgb" : " normal map";
+				return name;
+			};
+
+		JobSystem jobs{};
+		std::cout << "Mip chain generation, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//Odd and non-square sizes halve down to 1x1, a padded row pitch is honored
+		{
+			constexpr uint32_t width{ 37 };
+			constexpr uint32_t height{ 5 };
+			constexpr uint32_t rowPitch{ width * 4 + 12 };
+			std::vector<uint8_t> padded(size_t{ rowPitch } * height, 0xCD);
+			for (uint32_t y{}; y < height; ++y)
+				for (uint32_t x{}; x < width * 4; ++x)
+					padded[size_t{ y } * rowPitch + x] = static_cast<uint8_t>(x + y);
+
+			MipChain chain{};
+			MipGenerator::Generate(padded.data(), width, height, rowPitch, MipSettings{}, chain, &jobs);
+
+			bool isSized{ chain.levels.size() == 6 && MipGenerator::GetNumLevels(1024, 1024) == 11 };
+			for (uint32_t level{}; isSized && level < chain.levels.size(); ++level)
+				isSized = chain.levels[level].width == std::max(1u, width >> level) && chain.levels[level].height == std::max(1u, height >> level);
+			isSized = isSized && chain.levels.back().width == 1 && chain.levels.back().height == 1;
+
+			bool isCopied{ true };
+			for (uint32_t y{}; y < height; ++y)
+				isCopied = isCopied && std::memcmp(chain.pixels.data() + size_t{ y } * width * 4, padded.data() + size_t{ y } * rowPitch, width * 4) == 0;
+
+			check(isSized, "37x5 has 6 levels down to 1x1");
+			check(isCopied, "level 0 is the source without its row padding");
+		}
+
+		//A flat image stays flat in every mode, at every level, for both filters.
+		//Normal maps get a unit normal, (0.6, -0.29, 0.75) encoded, anything else would be renormalized.
+		{
+			for (const MipSettings& settings : allSettings)
+			{
+				const uint8_t color[4]{ 204, 90, 223, 77 };
+				const std::vector<uint8_t> flat{ makeImage(64, 48, [&](uint32_t, uint32_t, uint8_t* pTexel) { std::memcpy(pTexel, color, 4); }) };
+
+				MipChain chain{};
+				MipGenerator::Generate(flat.data(), 64, 48, 64 * 4, settings, chain, &jobs);
+
+				int maxError{};
+				for (size_t i{}; i < chain.pixels.size(); ++i)
+					maxError = std::max(maxError, std::abs(int(chain.pixels[i]) - int(color[i % 4])));
+				check(maxError <= 1, getName(settings) + " keeps a flat color, max error " + std::to_string(maxError));
+			}
+		}
+
+		//Black and white texels average to half the light, which is 188 in sRGB and 128 stored linearly
+		{
+			const std::vector<uint8_t> checker{ makeImage(64, 64, [](uint32_t x, uint32_t y, uint8_t* pTexel)
+				{
+					const uint8_t value{ static_cast<uint8_t>((x + y) % 2 == 0 ? 255 : 0) };
+					pTexel[0] = pTexel[1] = pTexel[2] = value;
+					pTexel[3] = 255;
+				}) };
+
+			MipChain srgb{};
+			MipChain linear{};
+			MipGenerator::Generate(checker.data(), 64, 64, 64 * 4, MipSettings{ MipFilter::Box, MipContent::Srgb }, srgb, &jobs);
+			MipGenerator::Generate(checker.data(), 64, 64, 64 * 4, MipSettings{ MipFilter::Box, MipContent::Linear }, linear, &jobs);
+
+			const uint8_t srgbValue{ srgb.pixels[srgb.levels[1].offset] };
+			const uint8_t linearValue{ linear.pixels[linear.levels[1].offset] };
+			check(std::abs(srgbValue - 188) <= 1 && srgb.pixels[srgb.levels[1].offset + 3] == 255, "sRGB checkerboard averages to " + std::to_string(srgbValue));
+			check(std::abs(linearValue - 128) <= 1, "linear checkerboard averages to " + std::to_string(linearValue));
+		}
+
+		//Random directions in the upper hemisphere stay unit length after filtering
+		{
+			std::mt19937 rng{ 1337 };
+			std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+			const std::vector<uint8_t> normals{ makeImage(64, 64, [&](uint32_t, uint32_t, uint8_t* pTexel)
+				{
+					const Vector3 normal{ Vector3{ unit(rng), unit(rng), std::abs(unit(rng)) + 0.1f }.Normalized() };
+					pTexel[0] = static_cast<uint8_t>((normal.x * 0.5f + 0.5f) * 255.f + 0.5f);
+					pTexel[1] = static_cast<uint8_t>((normal.y * 0.5f + 0.5f) * 255.f + 0.5f);
+					pTexel[2] = static_cast<uint8_t>((normal.z * 0.5f + 0.5f) * 255.f + 0.5f);
+					pTexel[3] = 255;
+				}) };
+
+			for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser })
+			{
+				MipChain chain{};
+				MipGenerator::Generate(normals.data(), 64, 64, 64 * 4, MipSettings{ filter, MipContent::NormalMap }, chain, &jobs);
+
+				float maxError{};
+				for (size_t i{ chain.levels[1].offset }; i < chain.pixels.size(); i += 4)
+				{
+					const Vector3 normal{ chain.pixels[i] / 127.5f - 1.f, chain.pixels[i + 1] / 127.5f - 1.f, chain.pixels[i + 2] / 127.5f - 1.f };
+					maxError = std::max(maxError, std::abs(normal.Magnitude() - 1.f));
+				}
+				check(maxError < 0.02f, getName(MipSettings{ filter, MipContent::NormalMap }) + " stays unit length, max error " + std::to_string(maxError));
+			}
+		}
+
+		//Timings: the vehicle maps as shipped, plus a synthetic 2048x2048 color map
+		struct Source
+		{
+			std::string name;
+			uint32_t width;
+			uint32_t height;
+			uint32_t rowPitch;
+			std::vector<uint8_t> pixels;
+		};
+
+		std::vector<Source> sources{};
+		for (SceneTexture texture : { SceneTexture::VehicleDiffuse, SceneTexture::VehicleNormal })
+		{
+			const char* pPath{ Renderer::GetTextureAsset(texture).sources[0].path.c_str() };
+			SDL_Surface* pSurface{ IMG_Load(pPath) };
+			const uint32_t width{ pSurface ? uint32_t(pSurface->w) : 0 };
+			const uint32_t height{ pSurface ? uint32_t(pSurface->h) : 0 };
+			Source source{ pPath, width, height, width * 4, std::vector<uint8_t>(size_t{ width } * height * 4) };
+			const bool isLoaded{ pSurface && PixelConversion::ConvertToRgba(pSurface, source.pixels.data(), source.rowPitch) };
+			SDL_FreeSurface(pSurface);
+
+			if (!isLoaded)
+			{
+				std::cout << "  skipping " << pPath << ", it couldn't be loaded\n";
+				continue;
+			}
+			sources.push_back(std::move(source));
+		}
+
+		std::mt19937 rng{ 7 };
+		sources.push_back(Source{ "synthetic", 2048, 2048, 2048 * 4, makeImage(2048, 2048, [&](uint32_t, uint32_t, uint8_t* pTexel)
+			{
+				const uint32_t value{ static_cast<uint32_t>(rng()) };
+				std::memcpy(pTexel, &value, sizeof(value));
+			}) });
+
+		JobSystem serialJobs{ 0 };
+		for (const Source& source : sources)
+		{
+			std::cout << "  " << source.name << " " << source.width << "x" << source.height << "\n";
+			for (const MipSettings& settings : { MipSettings{ MipFilter::Box, MipContent::Srgb }, MipSettings{ MipFilter::Kaiser, MipContent::Srgb },
+				MipSettings{ MipFilter::Box, MipContent::NormalMap } })
+			{
+				float timesMs[2]{};
+				JobSystem* pJobSystems[2]{ &serialJobs, &jobs };
+				for (int i{}; i < 2; ++i)
+				{
+					constexpr int numRuns{ 3 };
+					timesMs[i] = FLT_MAX;
+					for (int run{}; run < numRuns; ++run)
+					{
+						MipChain chain{};
+						const Clock::time_point start{ Clock::now() };
+						MipGenerator::Generate(source.pixels.data(), source.width, source.height, source.rowPitch, settings, chain, pJobSystems[i]);
+						timesMs[i] = std::min(timesMs[i], ElapsedMs(start));
+					}
+				}
+				std::cout << "    " << getName(settings) << ": " << timesMs[0] << " ms on 1 thread, " << timesMs[1] << " ms on "
+					<< jobs.GetNumThreads() << " (" << timesMs[0] / timesMs[1] << "x)\n";
+			}
+		}
+
+		return check.Finish("mip");
+	}
+
+	bool Benchmark::TextureCompression()
+	{
+		CheckList check{};
+
+		struct Format
+		{
+			const char* pName;
+			TextureFormat format;
+			//Channels the format keeps, the rest decodes to constants
+			uint32_t numChannels;
+		};
+		const Format formats[]{
+			{ "BC1", TextureFormat::Bc1, 3 }, { "BC3", TextureFormat::Bc3, 4 }, { "BC4", TextureFormat::Bc4, 1 },
+			{ "BC5", TextureFormat::Bc5, 2 }, { "BC7", TextureFormat::Bc7, 4 }
+		};
+
+		const auto getMaxError = [](const uint8_t* pA, const uint8_t* pB, size_t numTexels, uint32_t numChannels)
+			{
+				int maxError{};
+				for (size_t texel{}; texel < numTexels; ++texel)
+					for (uint32_t channel{}; channel < numChannels; ++channel)
+						maxError = std::max(maxError, std::abs(int(pA[texel * 4 + channel]) - int(pB[texel * 4 + channel])));
+				return maxError;
+			};
+
+		JobSystem jobs{};
+		std::cout << "Block compression, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//A flat block only loses what the endpoint precision can't hold, 565 for the color of BC1/BC3
+		{
+			uint8_t texels[64]{};
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const uint8_t color[4]{ 201, 87, 33, 140 };
+				std::memcpy(&texels[texel * 4], color, sizeof(color));
+			}
+
+			for (const Format& format : formats)
+			{
+				uint8_t block[16]{};
+				uint8_t decoded[64]{};
+				BlockCompression::EncodeBlock(format.format, texels, block);
+				BlockCompression::DecodeBlock(format.format, block, decoded);
+
+				const int maxError{ getMaxError(texels, decoded, 16, format.numChannels) };
+				const int allowed{ format.format == TextureFormat::Bc1 || format.format == TextureFormat::Bc3 ? 4
+					: format.format == TextureFormat::Bc7 ? 1 : 0 };
+				check(maxError <= allowed, std::string{ format.pName } + " flat block, max error " + std::to_string(maxError));
+			}
+		}
+
+		//Two colors at the ends of the range are exactly the endpoints
+		{
+			uint8_t texels[64]{};
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const uint8_t value{ static_cast<uint8_t>((texel * 7) % 3 == 0 ? 255 : 0) };
+				const uint8_t color[4]{ value, value, value, value };
+				std::memcpy(&texels[texel * 4], color, sizeof(color));
+			}
+
+			for (const Format& format : formats)
+			{
+				uint8_t block[16]{};
+				uint8_t decoded[64]{};
+				BlockCompression::EncodeBlock(format.format, texels, block);
+				BlockCompression::DecodeBlock(format.format, block, decoded);
+				const int maxError{ getMaxError(texels, decoded, 16, format.numChannels) };
+				check(maxError == 0, std::string{ format.pName } + " black and white block is exact, max error " + std::to_string(maxError));
+			}
+		}
+
+		//Sizes: 4x4 blocks, levels below 4 texels still take a whole block, the device takes the chain
+		{
+			std::vector<uint8_t> pixels(64 * 64 * 4, 128);
+			MipChain chain{};
+			MipGenerator::Generate(pixels.data(), 64, 64, 64 * 4, MipSettings{}, chain);
+
+			for (const Format& format : formats)
+			{
+				MipChain compressed{};
+				BlockCompression::Compress(chain, format.format, compressed, &jobs);
+
+				size_t expectedSize{};
+				for (const MipChain::Level& level : chain.levels)
+					expectedSize += size_t{ (level.width + 3) / 4 } * ((level.height + 3) / 4) * GetBlockSize(format.format);
+
+				NullDevice device{};
+				std::vector<TextureLevel> levels(compressed.levels.size());
+				for (uint32_t level{}; level < levels.size(); ++level)
+					levels[level] = compressed.GetLevel(level);
+				device.Release(device.CreateTexture(format.format, levels.data(), static_cast<uint32_t>(levels.size())));
+
+				check(compressed.pixels.size() == expectedSize && compressed.levels.size() == chain.levels.size() && device.GetNumErrors() == 0,
+					std::string{ format.pName } + " 64x64 chain is " + std::to_string(compressed.pixels.size()) + " bytes for "
+					+ std::to_string(chain.pixels.size()) + " uncompressed");
+			}
+
+			//D3D11 rejects block compressed textures that don't start at whole blocks
+			MipChain odd{};
+			MipGenerator::Generate(pixels.data(), 6, 6, 6 * 4, MipSettings{}, odd);
+			MipChain compressed{};
+			BlockCompression::Compress(odd, TextureFormat::Bc1, compressed);
+			const TextureLevel level{ compressed.GetLevel(0) };
+			NullDevice device{};
+			device.Release(device.CreateTexture(TextureFormat::Bc1, &level, 1));
+			check(device.GetNumErrors() == 1, "null device rejects a 6x6 BC1 texture");
+		}
+
+		//Disk cache on a scratch directory
+		{
+			const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "dae_texture_cache_check" };
+			std::error_code error{};
+			std::filesystem::remove_all(directory, error);
+
+			const std::string file{ "not really a png, the key only hashes the bytes" };
+			const MipSettings mips{ MipFilter::Box, MipContent::Srgb };
+			const uint64_t key{ TextureCache::ComputeKey(file.data(), file.size(), mips, TextureFormat::Bc1) };
+			check(key == TextureCache::ComputeKey(file.data(), file.size(), mips, TextureFormat::Bc1), "key is stable");
+			check(key != TextureCache::ComputeKey(file.data(), file.size() - 1, mips, TextureFormat::Bc1), "file changes the key");
+			check(key != TextureCache::ComputeKey(file.data(), file.size(), MipSettings{ MipFilter::Kaiser, MipContent::Srgb }, TextureFormat::Bc1), "mip settings change the key");
+			check(key != TextureCache::ComputeKey(file.data(), file.size(), mips, TextureFormat::Bc7), "format changes the key");
+
+			std::mt19937 rng{ 42 };
+			std::vector<uint8_t> pixels(256 * 256 * 4);
+			for (uint8_t& value : pixels)
+				value = static_cast<uint8_t>(rng());
+			MipChain chain{};
+			MipChain compressed{};
+			MipGenerator::Generate(pixels.data(), 256, 256, 256 * 4, mips, chain);
+			BlockCompression::Compress(chain, TextureFormat::Bc1, compressed, &jobs);
+
+			TextureCache cache{ directory };
+			MipChain loaded{};
+			const bool isMissing{ !cache.Load(key, loaded) };
+			const bool isStored{ cache.Store(key, compressed) };
+			const bool isLoaded{ cache.Load(key, loaded) && loaded.format == compressed.format && loaded.pixels == compressed.pixels
+				&& loaded.levels.size() == compressed.levels.size() && loaded.levels.back().offset == compressed.levels.back().offset };
+			check(isMissing && isStored && isLoaded, "round trip, " + std::to_string(cache.GetNumHits()) + " hit(s) " + std::to_string(cache.GetNumMisses()) + " miss(es)");
+
+			const std::filesystem::path entry{ std::filesystem::directory_iterator{ directory }->path() };
+			{
+				std::fstream corrupt{ entry, std::ios::binary | std::ios::in | std::ios::out };
+				corrupt.seekp(-7, std::ios::end);
+				corrupt.put('\x5A');
+			}
+			check(!cache.Load(key, loaded) && loaded.levels.empty(), "corrupt entry misses");
+
+			cache.Store(key, compressed);
+			std::filesystem::resize_file(entry, std::filesystem::file_size(entry) / 2, error);
+			check(!cache.Load(key, loaded), "truncated entry misses");
+
+			std::filesystem::remove_all(directory, error);
+		}
+
+		//The renderer's maps, with the settings it loads them with
+		struct Map
+		{
+			const char* pName;
+			SceneTexture texture;
+			uint32_t numChannels;
+		};
+		const Map maps[]{
+			{ "vehicle diffuse", SceneTexture::VehicleDiffuse, 3 },
+			{ "vehicle normal", SceneTexture::VehicleNormal, 2 },
+			{ "vehicle specular + glossiness", SceneTexture::VehicleSpecularGlossiness, 4 },
+			{ "fire diffuse", SceneTexture::FireDiffuse, 4 }
+		};
+
+		size_t uncompressedBytes{};
+		size_t compressedBytes{};
+		for (const Map& map : maps)
+		{
+			const TextureAsset& asset{ Renderer::GetTextureAsset(map.texture) };
+			MipChain chain{};
+			if (!Texture::LoadChain(asset.sources, TextureSettings{ asset.settings.mips, TextureFormat::Rgba8 }, chain, &jobs))
+			{
+				std::cout << "  skipping " << map.pName << ", it couldn't be loaded\n";
+				continue;
+			}
+
+			float timesMs[2]{};
+			MipChain compressed{};
+			JobSystem serialJobs{ 0 };
+			JobSystem* pJobSystems[2]{ &serialJobs, &jobs };
+			for (int i{}; i < 2; ++i)
+			{
+				const Clock::time_point start{ Clock::now() };
+				BlockCompression::Compress(chain, asset.settings.format, compressed, pJobSystems[i]);
+				timesMs[i] = ElapsedMs(start);
+			}
+
+			MipChain decoded{};
+			BlockCompression::Decompress(compressed, decoded, &jobs);
+
+			//Over every level, only the channels the format keeps
+			double squaredError{};
+			for (size_t texel{}; texel < chain.pixels.size() / 4; ++texel)
+				for (uint32_t channel{}; channel < map.numChannels; ++channel)
+				{
+					const double difference{ double(chain.pixels[texel * 4 + channel]) - decoded.pixels[texel * 4 + channel] };
+					squaredError += difference * difference;
+				}
+			const double meanSquaredError{ squaredError / (chain.pixels.size() / 4 * map.numChannels) };
+			const double psnr{ 10.0 * std::log10(255.0 * 255.0 / std::max(meanSquaredError, 1e-9)) };
+
+			uncompressedBytes += chain.pixels.size();
+			compressedBytes += compressed.pixels.size();
+
+			const Format& format{ *std::find_if(std::begin(formats), std::end(formats), [&](const Format& f) { return f.format == asset.settings.format; }) };
+			std::ostringstream message{};
+			message << map.pName << " as " << format.pName << ": " << psnr << " dB, " << float(chain.pixels.size()) / compressed.pixels.size()
+				<< "x smaller, encoded in " << timesMs[0] << " ms on 1 thread, " << timesMs[1] << " ms on " << jobs.GetNumThreads();
+			check(psnr > 30.0, message.str());
+		}
+
+		if (compressedBytes > 0)
+			std::cout << "  texture memory with mips: " << uncompressedBytes / 1024 << " KiB uncompressed, " << compressedBytes / 1024 << " KiB compressed ("
+				<< float(uncompressedBytes) / compressedBytes << "x)\n";
+
+		return check.Finish("compression");
+	}
+
+	bool Benchmark::ChannelPacking()
+	{
+		CheckList check{};
+
+		constexpr int8_t none{ ChannelSource::NoChannel };
+		const std::vector<ChannelSource>& packed{ Renderer::GetTextureAsset(SceneTexture::VehicleSpecularGlossiness).sources };
+		const ChannelSource& specular{ packed[0] };
+		const ChannelSource& glossiness{ packed[1] };
+		const MipSettings mips{ MipFilter::Box, MipContent::Linear };
+
+		JobSystem jobs{};
+		std::cout << "Channel packing, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//Both images as RGBA, however they were stored
+		uint32_t width{};
+		uint32_t height{};
+		std::vector<uint8_t> images[2]{};
+		const std::string* paths[2]{ &specular.path, &glossiness.path };
+		for (int i{}; i < 2; ++i)
+		{
+			SDL_Surface* pSurface{ IMG_Load(paths[i]->c_str()) };
+			if (pSurface)
+			{
+				width = uint32_t(pSurface->w);
+				height = uint32_t(pSurface->h);
+				images[i].resize(size_t{ width } * height * 4);
+				if (!PixelConversion::ConvertToRgba(pSurface, images[i].data(), width * 4))
+					images[i].clear();
+			}
+			SDL_FreeSurface(pSurface);
+		}
+
+		if (images[0].empty() || images[0].size() != images[1].size())
+		{
+			std::cout << "  the vehicle maps couldn't be loaded, run from the directory that holds Resources\n";
+			return false;
+		}
+
+		//Level 0 of the packed chain against the two images
+		{
+			MipChain chain{};
+			const bool isLoaded{ Texture::LoadChain(packed, TextureSettings{ mips, TextureFormat::Rgba8 }, chain, &jobs) };
+
+			bool isPacked{ isLoaded && chain.levels[0].width == width && chain.levels[0].height == height };
+			bool isSpecularGray{ true };
+			for (size_t texel{}; isPacked && texel < images[0].size(); texel += 4)
+			{
+				const uint8_t* pSpecular{ images[0].data() + texel };
+				isPacked = isPacked && std::memcmp(chain.pixels.data() + texel, pSpecular, 3) == 0 && chain.pixels[texel + 3] == images[1][texel];
+				isSpecularGray = isSpecularGray && pSpecular[0] == pSpecular[1] && pSpecular[0] == pSpecular[2];
+			}
+			check(isPacked, "specular RGB and glossiness R end up in RGBA of one texture");
+			std::cout << "  the specular map is " << (isSpecularGray ? "gray" : "colored") << ", so it needs " << (isSpecularGray ? "1" : "3") << " channel(s)\n";
+		}
+
+		//Failures
+		{
+			MipChain chain{};
+			check(!Texture::LoadChain({ specular, { "Resources/missing.png", { none, none, none, 0 } } }, TextureSettings{}, chain) && chain.levels.empty(),
+				"a missing image fails the whole texture");
+			check(!Texture::LoadChain({}, TextureSettings{}, chain), "no images fail");
+		}
+
+		//Two textures as before against the packed one, same formats per channel (BC3 is BC1 color + BC4 alpha)
+		struct Variant
+		{
+			const char* pName;
+			std::vector<std::pair<std::vector<ChannelSource>, TextureFormat>> textures;
+		};
+		const std::vector<ChannelSource> specularOnly{ { specular.path } };
+		const std::vector<ChannelSource> glossinessOnly{ { glossiness.path } };
+		const Variant variants[]{
+			{ "separate RGBA8", { { specularOnly, TextureFormat::Rgba8 }, { glossinessOnly, TextureFormat::Rgba8 } } },
+			{ "packed RGBA8", { { packed, TextureFormat::Rgba8 } } },
+			{ "separate BC1 + BC4", { { specularOnly, TextureFormat::Bc1 }, { glossinessOnly, TextureFormat::Bc4 } } },
+			{ "packed BC3", { { packed, TextureFormat::Bc3 } } }
+		};
+
+		for (const Variant& variant : variants)
+		{
+			//Loaded without a cache, the way a first start does it
+			constexpr int numRuns{ 3 };
+			float bestMs{ FLT_MAX };
+			bool isValid{ true };
+			for (int run{}; run < numRuns; ++run)
+			{
+				NullDevice device{};
+				std::vector<Texture*> textures{};
+
+				const Clock::time_point start{ Clock::now() };
+				for (const auto& [sources, format] : variant.textures)
+					textures.push_back(Texture::LoadPacked(sources, &device, TextureSettings{ mips, format }, &jobs));
+				bestMs = std::min(bestMs, ElapsedMs(start));
+
+				isValid = isValid && device.GetNumErrors() == 0 && device.GetNumLiveResources() == variant.textures.size();
+				for (Texture* pTexture : textures)
+					delete pTexture;
+			}
+
+			size_t bytes{};
+			for (const auto& [sources, format] : variant.textures)
+			{
+				MipChain chain{};
+				Texture::LoadChain(sources, TextureSettings{ mips, format }, chain, &jobs);
+				bytes += chain.pixels.size();
+			}
+
+			std::ostringstream message{};
+			message << variant.pName << ": " << variant.textures.size() << " texture(s), " << bytes / 1024 << " KiB with mips, loaded in "
+				<< bestMs << " ms, " << variant.textures.size() << " sample(s) per pixel";
+			check(isValid, message.str());
+		}
+
+		return check.Finish("channel packing");
+	}
+
+	bool Benchmark::PixelConversions()
+	{
+		using PixelConversion::Layout;
+
+		CheckList check{};
+
+		std::cout << "Pixel format normalization, SSSE3 " << (PixelConversion::HasSimd() ? "available" : "unavailable") << "\n";
+
+		struct Format
+		{
+			const char* pName;
+			uint32_t sdlFormat;
+			uint32_t bytesPerTexel;
+			Layout layout;
+		};
+
+		const Format formats[]{
+			{ "RGBA", SDL_PIXELFORMAT_RGBA32, 4, Layout::Rgba },
+			{ "BGRA", SDL_PIXELFORMAT_BGRA32, 4, Layout::Bgra },
+			{ "RGB", SDL_PIXELFORMAT_RGB24, 3, Layout::Rgb },
+			{ "BGR", SDL_PIXELFORMAT_BGR24, 3, Layout::Bgr },
+			{ "gray", SDL_PIXELFORMAT_INDEX8, 1, Layout::Gray },
+			{ "indexed", SDL_PIXELFORMAT_INDEX8, 1, Layout::Indexed }
+		};
+
+		//Gray as SDL_image builds it, and a palette that isn't
+		SDL_Color grayColors[256]{};
+		SDL_Color paletteColors[256]{};
+		for (int i{}; i < 256; ++i)
+		{
+			grayColors[i] = SDL_Color{ uint8_t(i), uint8_t(i), uint8_t(i), 255 };
+			paletteColors[i] = SDL_Color{ uint8_t(i * 7), uint8_t(255 - i), uint8_t(i * 13), uint8_t(i | 1) };
+		}
+		SDL_Palette grayPalette{ 256, grayColors, 0, 1 };
+		SDL_Palette palette{ 256, paletteColors, 0, 1 };
+
+		//The RGBA every layout has to produce, from the bytes as stored
+		const auto getExpected = [](const Format& format, const uint8_t* pTexel, const SDL_Palette* pPalette)
+			{
+				switch (format.layout)
+				{
+				case Layout::Bgra:
+					return std::array<uint8_t, 4>{ pTexel[2], pTexel[1], pTexel[0], pTexel[3] };
+				case Layout::Rgb:
+					return std::array<uint8_t, 4>{ pTexel[0], pTexel[1], pTexel[2], 255 };
+				case Layout::Bgr:
+					return std::array<uint8_t, 4>{ pTexel[2], pTexel[1], pTexel[0], 255 };
+				case Layout::Gray:
+				case Layout::Indexed:
+				{
+					const SDL_Color& color{ pPalette->colors[pTexel[0]] };
+					return std::array<uint8_t, 4>{ color.r, color.g, color.b, color.a };
+				}
+				default:
+					return std::array<uint8_t, 4>{ pTexel[0], pTexel[1], pTexel[2], pTexel[3] };
+				}
+			};
+
+		std::mt19937 rng{ 44 };
+		for (const Format& format : formats)
+		{
+			SDL_Palette* pPalette{ format.layout == Layout::Gray ? &grayPalette : &palette };
+			SDL_PixelFormat pixelFormat{};
+			pixelFormat.format = format.sdlFormat;
+			pixelFormat.BytesPerPixel = uint8_t(format.bytesPerTexel);
+			pixelFormat.BitsPerPixel = uint8_t(format.bytesPerTexel * 8);
+			pixelFormat.palette = format.sdlFormat == SDL_PIXELFORMAT_INDEX8 ? pPalette : nullptr;
+
+			//Widths around the 16 texel steps of the shuffles, rows padded like SDL pads them
+			bool isCorrect{ true };
+			for (uint32_t width : { 1u, 15u, 16u, 17u, 33u, 100u, 1027u })
+			{
+				constexpr uint32_t height{ 3 };
+				const uint32_t pitch{ (width * format.bytesPerTexel + 3) / 4 * 4 + 4 };
+				std::vector<uint8_t> source(size_t{ pitch } * height);
+				for (uint8_t& byte : source)
+					byte = uint8_t(rng());
+
+				SDL_Surface surface{};
+				surface.format = &pixelFormat;
+				surface.w = int(width);
+				surface.h = int(height);
+				surface.pitch = int(pitch);
+				surface.pixels = source.data();
+
+				std::vector<uint8_t> rgba(size_t{ width } * height * 4);
+				std::vector<uint8_t> scalar(width * 4);
+				isCorrect = isCorrect && PixelConversion::GetLayout(&surface) == format.layout
+					&& PixelConversion::ConvertToRgba(&surface, rgba.data(), width * 4);
+
+				for (uint32_t y{}; isCorrect && y < height; ++y)
+				{
+					const uint8_t* pRow{ source.data() + size_t{ y } * pitch };
+					PixelConversion::ConvertRowScalar(format.layout, pRow, width, pPalette, scalar.data());
+					isCorrect = std::memcmp(scalar.data(), rgba.data() + size_t{ y } * width * 4, scalar.size()) == 0;
+
+					for (uint32_t x{}; isCorrect && x < width; ++x)
+					{
+						const std::array<uint8_t, 4> expected{ getExpected(format, pRow + x * format.bytesPerTexel, pPalette) };
+						isCorrect = std::memcmp(expected.data(), scalar.data() + x * 4, 4) == 0;
+					}
+				}
+			}
+			check(isCorrect, std::string{ format.pName } + " converts to RGBA at every width");
+		}
+
+		//Throughput on a 2048x2048 image, the size of the larger maps
+		constexpr uint32_t size{ 2048 };
+		std::vector<uint8_t> source(size_t{ size } * size * 4);
+		for (uint8_t& byte : source)
+			byte = uint8_t(rng());
+		std::vector<uint8_t> target(size_t{ size } * size * 4);
+
+		for (const Format& format : formats)
+		{
+			const SDL_Palette* pPalette{ format.layout == Layout::Gray ? &grayPalette : &palette };
+			float timesMs[2]{};
+			for (int isSimd{}; isSimd < 2; ++isSimd)
+			{
+				constexpr int numRuns{ 5 };
+				timesMs[isSimd] = FLT_MAX;
+				for (int run{}; run < numRuns; ++run)
+				{
+					const Clock::time_point start{ Clock::now() };
+					for (uint32_t y{}; y < size; ++y)
+					{
+						const uint8_t* pRow{ source.data() + size_t{ y } * size * format.bytesPerTexel };
+						uint8_t* pTarget{ target.data() + size_t{ y } * size * 4 };
+						if (isSimd)
+							PixelConversion::ConvertRow(format.layout, pRow, size, pPalette, pTarget);
+						else
+							PixelConversion::ConvertRowScalar(format.layout, pRow, size, pPalette, pTarget);
+					}
+					timesMs[isSimd] = std::min(timesMs[isSimd], ElapsedMs(start));
+				}
+			}
+
+			std::cout << "  " << format.pName << ": " << timesMs[0] << " ms texel by texel, " << timesMs[1] << " ms per row ("
+				<< size * size / timesMs[1] / 1000.f << " MTexels/s)\n";
+		}
+
+		return check.Finish("pixel conversion");
+	}
+
+	bool Benchmark::CookedTextures()
+	{
+		CheckList check{};
+
+		JobSystem jobs{};
+		std::cout << "Cooked textures, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		const std::filesystem::path directory{ std::filesystem::temp_directory_path() / "dae_cooked_texture_check" };
+		std::filesystem::remove_all(directory);
+
+		for (const TextureAsset& asset : Renderer::GetTextureAssets())
+		{
+			const std::string name{ std::filesystem::path{ asset.cookedPath }.filename().string() };
+			const std::filesystem::path path{ directory / name };
+
+			//The file holds the chain exactly, every level on its own page
+			MipChain chain{};
+			const bool isWritten{ Texture::LoadChain(asset.sources, asset.settings, chain, &jobs) && CookedTexture::Write(path, chain) };
+			if (!isWritten)
+			{
+				check(false, name + " can be cooked, run from the directory that holds Resources");
+				continue;
+			}
+
+			{
+				const CookedTexture cooked{ path };
+				bool isExact{ cooked.IsValid() && cooked.GetFormat() == chain.format && cooked.GetNumLevels() == chain.levels.size()
+					&& cooked.GetDataSize() == chain.pixels.size() };
+				bool isAligned{ true };
+				for (uint32_t i{}; isExact && i < cooked.GetNumLevels(); ++i)
+				{
+					const TextureLevel& level{ cooked.GetLevels()[i] };
+					const TextureLevel expected{ chain.GetLevel(i) };
+					const size_t size{ size_t{ GetNumRows(chain.format, level.height) } * level.rowPitch };
+					isExact = level.width == expected.width && level.height == expected.height && level.rowPitch == expected.rowPitch
+						&& std::memcmp(level.pPixels, expected.pPixels, size) == 0;
+					isAligned = isAligned && reinterpret_cast<uintptr_t>(level.pPixels) % 4096 == 0;
+				}
+				check(isExact && isAligned, name + " maps back to the chain it was cooked from, every level page aligned");
+			}
+
+			//Timings, best of a few runs: the images decoded, the images to a device texture, the cooked file to a device texture
+			constexpr int numRuns{ 3 };
+			float decodeMs{ FLT_MAX };
+			float loadMs{ FLT_MAX };
+			float cookedMs{ FLT_MAX };
+			bool isLoaded{ true };
+			for (int run{}; run < numRuns; ++run)
+			{
+				Clock::time_point start{ Clock::now() };
+				for (const ChannelSource& source : asset.sources)
+					SDL_FreeSurface(IMG_Load(source.path.c_str()));
+				decodeMs = std::min(decodeMs, ElapsedMs(start));
+
+				NullDevice device{};
+				start = Clock::now();
+				Texture* pLoaded{ Texture::LoadPacked(asset.sources, &device, asset.settings, &jobs) };
+				loadMs = std::min(loadMs, ElapsedMs(start));
+
+				start = Clock::now();
+				Texture* pCooked{ Texture::LoadCooked(path.string(), &device) };
+				cookedMs = std::min(cookedMs, ElapsedMs(start));
+
+				isLoaded = isLoaded && pCooked->GetHandle() != TextureHandle::Invalid && pCooked->GetMemorySize() == pLoaded->GetMemorySize()
+					&& device.GetNumErrors() == 0;
+				delete pLoaded;
+				delete pCooked;
+			}
+
+			std::ostringstream message{};
+			message << name << ": IMG_Load " << decodeMs << " ms, images to texture " << loadMs << " ms, cooked to texture " << cookedMs << " ms ("
+				<< std::filesystem::file_size(path) / 1024 << " KiB file)";
+			check(isLoaded, message.str());
+		}
+
+		//Damaged and stale files are refused, so the images get loaded instead
+		const std::filesystem::path sourcePath{ directory / std::filesystem::path{ Renderer::GetTextureAssets()[0].cookedPath }.filename() };
+		if (std::filesystem::exists(sourcePath))
+		{
+			const std::filesystem::path damagedPath{ directory / "damaged.dtex" };
+			std::filesystem::copy_file(sourcePath, damagedPath);
+			std::filesystem::resize_file(damagedPath, std::filesystem::file_size(sourcePath) - 1);
+			check(!CookedTexture{ damagedPath }.IsValid(), "a truncated file is refused");
+
+			std::filesystem::copy_file(sourcePath, damagedPath, std::filesystem::copy_options::overwrite_existing);
+			{
+				std::fstream file{ damagedPath, std::ios::binary | std::ios::in | std::ios::out };
+				const uint32_t version{ 0xffffffff };
+				file.seekp(4);
+				file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+			}
+			check(!CookedTexture{ damagedPath }.IsValid(), "a file from another version is refused");
+			check(!CookedTexture{ directory / "missing.dtex" }.IsValid(), "a missing file is refused");
+
+			const std::vector<ChannelSource>& sources{ Renderer::GetTextureAssets()[0].sources };
+			const bool isCurrent{ CookedTexture::IsUpToDate(sourcePath, sources) };
+			std::filesystem::last_write_time(sourcePath, std::filesystem::last_write_time(sources[0].path) - std::chrono::hours{ 1 });
+			check(isCurrent && !CookedTexture::IsUpToDate(sourcePath, sources), "a file older than its images is stale");
+		}
+
+		std::error_code error{};
+		std::filesystem::remove_all(directory, error);
+
+		return check.Finish("cooked texture");
+	}
+
+	bool Benchmark::TextureStreaming()
+	{
+		CheckList check{};
+
+		JobSystem jobs{};
+		std::cout << "Texture streaming, " << jobs.GetNumThreads() << " thread(s)\n";
+
+		//1024 texels across 1 UV, 1 world unit per UV, 90 degree field of view on a 1024 pixel screen:
+		//1:1 at distance 0.5, every doubling of the distance is one level
+		check(TextureStreamer::ComputeMipLevel(0.5f, 1.f, 1024, 1.f, 1024.f) == 0.f && TextureStreamer::ComputeMipLevel(4.f, 1.f, 1024, 1.f, 1024.f) == 3.f
+			&& TextureStreamer::ComputeMipLevel(4.f, 2.f, 1024, 1.f, 1024.f) == 2.f, "mip level from distance and texel density");
+
+		//2048x2048 BC1 textures, room for three of them at full resolution
+		constexpr uint32_t numTextures{ 8 };
+		constexpr uint32_t textureSize{ 2048 };
+		const uint64_t fullBytes{ CreateBlankChain(TextureFormat::Bc1, textureSize).pixels.size() };
+		const uint64_t tailBytes{ CreateBlankChain(TextureFormat::Bc1, 64).pixels.size() };
+		{
+			NullDevice device{};
+			TextureStreamer streamer{ &device, &jobs, StreamingSettings{ 3 * fullBytes + numTextures * tailBytes } };
+			for (uint32_t i{}; i < numTextures; ++i)
+				streamer.Add(CreateBlankChain(TextureFormat::Bc1, textureSize));
+
+			bool isTail{ device.GetNumLiveResources() == numTextures && streamer.GetResidentBytes() == numTextures * tailBytes };
+			for (StreamedTextureId id{}; id < numTextures; ++id)
+				isTail = isTail && streamer.GetResidentLevel(id) == 5 && streamer.GetTailLevel(id) == 5;
+			check(isTail, "textures start with their 64x64 tail resident");
+
+			//One frame requesting, one frame picking up the finished loads
+			uint64_t frameIndex{};
+			std::vector<TextureSwap> swaps{};
+			bool isWithinBudget{ true };
+			const auto runFrame = [&](std::initializer_list<StreamedTextureId> ids)
+				{
+					for (StreamedTextureId id : ids)
+						streamer.Request(id, 0.f);
+					streamer.Update(frameIndex++, swaps);
+					streamer.WaitForLoads();
+					streamer.Update(frameIndex++, swaps);
+					isWithinBudget = isWithinBudget && streamer.GetTargetBytes() <= 3 * fullBytes + numTextures * tailBytes;
+				};
+
+			runFrame({ 0 });
+			check(streamer.GetResidentLevel(0) == 0 && swaps.size() == 1 && swaps[0].id == 0 && swaps[0].current == streamer.GetHandle(0)
+				&& device.GetNumLiveResources() == numTextures + 1, "a requested texture streams in, the one it replaced is kept for the frames in flight");
+
+			runFrame({ 1 });
+			runFrame({ 2 });
+			check(device.GetNumLiveResources() == numTextures + 1, "replaced textures are released two frames later");
+
+			//Full: the least recently requested one goes back to its tail to make room
+			runFrame({ 3 });
+			check(streamer.GetTargetLevel(0) == 5 && streamer.GetTargetLevel(1) == 0 && streamer.GetTargetLevel(2) == 0 && streamer.GetTargetLevel(3) == 0,
+				"the least recently requested texture is evicted");
+			runFrame({ 1, 4 });
+			check(streamer.GetTargetLevel(2) == 5 && streamer.GetTargetLevel(1) == 0 && streamer.GetTargetLevel(3) == 0 && streamer.GetTargetLevel(4) == 0,
+				"a request refreshes a texture, the next oldest goes");
+			check(isWithinBudget && streamer.GetNumEvictions() == 2, "never over budget, 2 evictions");
+
+			//Everything wanted at once: the finest levels that fit, nothing above the budget
+			runFrame({ 0, 1, 2, 3, 4, 5, 6, 7 });
+			runFrame({ 0, 1, 2, 3, 4, 5, 6, 7 });
+			check(isWithinBudget && streamer.GetResidentBytes() == streamer.GetTargetBytes() && streamer.GetTargetBytes() > 2 * fullBytes,
+				"all of them requested settle within the budget");
+
+			//A lowered budget is met without being asked for anything
+			streamer.SetBudget(numTextures * tailBytes);
+			runFrame({});
+			check(streamer.GetResidentBytes() == numTextures * tailBytes, "a lowered budget drops everything to its tail");
+
+			runFrame({});
+			check(device.GetNumLiveResources() == numTextures && device.GetNumErrors() == 0, "every level range was valid on the device");
+		}
+
+		//Fly-through: a camera moving down a road lined with vehicles, 32 different 1024x1024 BC1 textures between them.
+		//Reports what streaming keeps resident against uploading every texture fully.
+		{
+			constexpr uint32_t numSharedTextures{ 32 };
+			constexpr uint32_t numVehicles{ 400 };
+			constexpr int numFrames{ 600 };
+			constexpr float vehicleSpacing{ 5.f };
+			constexpr float cameraSpeed{ 3.f };
+			constexpr float viewDistance{ 150.f };
+			constexpr float tanHalfFov{ 0.41f };
+			constexpr float screenHeight{ 720.f };
+			constexpr uint64_t budget{ 8ull * 1024 * 1024 };
+
+			NullDevice device{};
+			TextureStreamer streamer{ &device, &jobs, StreamingSettings{ budget } };
+			for (uint32_t i{}; i < numSharedTextures; ++i)
+				streamer.Add(CreateBlankChain(TextureFormat::Bc1, 1024));
+			const uint64_t allBytes{ numSharedTextures * CreateBlankChain(TextureFormat::Bc1, 1024).pixels.size() };
+
+			std::vector<TextureSwap> swaps{};
+			uint64_t peakTargetBytes{};
+			uint64_t peakResidentBytes{};
+			uint64_t numMissingLevels{};
+			uint64_t numRequests{};
+			float updateMs{};
+			for (int frame{}; frame < numFrames; ++frame)
+			{
+				const float cameraZ{ frame * cameraSpeed };
+				std::vector<float> needed(numSharedTextures, FLT_MAX);
+				for (uint32_t vehicle{}; vehicle < numVehicles; ++vehicle)
+				{
+					//Two rows, 3 units to each side of the road, only the ones ahead within view distance
+					const float ahead{ (vehicle / 2) * vehicleSpacing - cameraZ };
+					if (ahead < 0.f || ahead > viewDistance)
+						continue;
+
+					const float distance{ std::sqrt(ahead * ahead + 9.f) };
+					const StreamedTextureId id{ vehicle % numSharedTextures };
+					const float level{ TextureStreamer::ComputeMipLevel(distance, 4.f, 1024, tanHalfFov, screenHeight) };
+					needed[id] = std::min(needed[id], level);
+					streamer.Request(id, level);
+				}
+
+				const Clock::time_point start{ Clock::now() };
+				swaps.clear();
+				streamer.Update(frame, swaps);
+				updateMs += ElapsedMs(start);
+
+				for (StreamedTextureId id{}; id < numSharedTextures; ++id)
+				{
+					if (needed[id] == FLT_MAX)
+						continue;
+					const uint32_t neededLevel{ needed[id] <= 0.f ? 0 : static_cast<uint32_t>(needed[id]) };
+					numMissingLevels += streamer.GetResidentLevel(id) > neededLevel ? streamer.GetResidentLevel(id) - neededLevel : 0;
+					++numRequests;
+				}
+
+				peakTargetBytes = std::max(peakTargetBytes, streamer.GetTargetBytes());
+				peakResidentBytes = std::max(peakResidentBytes, streamer.GetResidentBytes());
+			}
+			streamer.WaitForLoads();
+
+			std::cout << "  " << numFrames << " frames, " << numVehicles << " vehicles: " << streamer.GetNumLoads() << " loads, " << streamer.GetNumEvictions()
+				<< " evictions, peak " << peakResidentBytes / 1024 << " KiB resident of " << allBytes / 1024 << " KiB fully loaded, "
+				<< static_cast<float>(numMissingLevels) / numRequests << " levels short per used texture, " << updateMs / numFrames << " ms per update\n";
+			check(peakTargetBytes <= budget && device.GetNumErrors() == 0, "the fly-through stays within its 8 MiB budget");
+		}
+
+		return check.Finish("texture streaming");
+	}
+
+	bool Benchmark::TextureAtlases(uint32_t numObjects)
+	{
+		CheckList check{};
+
+		JobSystem jobs{};
+		std::cout << "Texture atlases, " << jobs.GetNumThreads() << " thread(s)\n";
+		std::mt19937 rng{ 1337 };
+
+		//Slots never overlap, stay on the page and start on multiples of the padding
+		{
+			constexpr uint32_t pageSize{ 1024 };
+			constexpr uint32_t padding{ 8 };
+			std::uniform_int_distribution<uint32_t> size{ 4, 100 };
+
+			AtlasPacker packer{ pageSize, pageSize, padding };
+			std::vector<std::array<uint32_t, 4>> slots{};
+			for (int i{}; i < 300; ++i)
+			{
+				const uint32_t width{ size(rng) };
+				const uint32_t height{ size(rng) };
+				uint32_t x{};
+				uint32_t y{};
+				if (packer.Insert(width, height, x, y))
+					slots.push_back({ x - padding, y - padding, x + width + padding, y + height + padding });
+			}
+
+			bool isValid{ !slots.empty() };
+			for (size_t i{}; i < slots.size(); ++i)
+			{
+				isValid = isValid && slots[i][0] % padding == 0 && slots[i][1] % padding == 0 && slots[i][2] <= pageSize && slots[i][3] <= pageSize;
+				for (size_t j{ i + 1 }; isValid && j < slots.size(); ++j)
+					isValid = slots[i][2] <= slots[j][0] || slots[j][2] <= slots[i][0] || slots[i][3] <= slots[j][1] || slots[j][3] <= slots[i][1];
+			}
+
+			std::ostringstream message{};
+			message << slots.size() << " rectangles packed without overlap, " << packer.GetOccupancy() * 100.f << "% of the page used";
+			check(isValid, message.str());
+
+			uint32_t x{};
+			uint32_t y{};
+			AtlasPacker small{ 64, 64, padding };
+			check(!small.Insert(64, 8, x, y) && small.Insert(48, 8, x, y) && x == padding && y == padding, "a rectangle whose slot is wider than the page is refused");
+		}
+
+		//The scene: numObjects props, each with its own flat colored texture of 16 to 64 texels a side
+		std::uniform_int_distribution<uint32_t> blocks{ 4, 16 };
+		std::uniform_int_distribution<uint32_t> channel{ 0, 255 };
+		std::vector<std::vector<uint8_t>> imagePixels(numObjects);
+		std::vector<AtlasImage> images(numObjects);
+		for (uint32_t i{}; i < numObjects; ++i)
+		{
+			const uint32_t width{ blocks(rng) * 4 };
+			const uint32_t height{ blocks(rng) * 4 };
+			const uint8_t color[4]{ static_cast<uint8_t>(channel(rng)), static_cast<uint8_t>(channel(rng)), static_cast<uint8_t>(channel(rng)), 255 };
+			imagePixels[i].resize(size_t{ width } * height * 4);
+			for (size_t texel{}; texel < imagePixels[i].size(); texel += 4)
+				std::memcpy(imagePixels[i].data() + texel, color, 4);
+			images[i] = AtlasImage{ imagePixels[i].data(), width, height, width * 4 };
+		}
+
+		//Every region keeps its color at every level: nothing bled in from a neighbour
+		{
+			AtlasSettings settings{};
+			settings.texture = TextureSettings{ { MipFilter::Box, MipContent::Linear }, TextureFormat::Rgba8 };
+			TextureAtlas atlas{};
+			bool isExact{ AtlasBuilder::Build(images, settings, atlas, &jobs) && atlas.regions.size() == numObjects };
+			for (const MipChain& page : atlas.pages)
+				isExact = isExact && page.levels.size() == 4;
+
+			for (uint32_t i{}; isExact && i < numObjects; ++i)
+			{
+				const AtlasRegion& region{ atlas.regions[i] };
+				const MipChain& page{ atlas.pages[region.page] };
+				for (uint32_t level{}; isExact && level < page.levels.size(); ++level)
+				{
+					const TextureLevel texels{ page.GetLevel(level) };
+					for (uint32_t y{ region.y >> level }; isExact && y <= (region.y + region.height - 1) >> level; ++y)
+						for (uint32_t x{ region.x >> level }; isExact && x <= (region.x + region.width - 1) >> level; ++x)
+							isExact = std::memcmp(static_cast<const uint8_t*>(texels.pPixels) + size_t{ y } * texels.rowPitch + x * 4, imagePixels[i].data(), 4) == 0;
+				}
+			}
+			check(isExact, "every region keeps its own texels down to the last level the padding covers");
+		}
+
+		//UVs move into the region, tiled ones are left alone
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			Mesh::CreateCube(vertices, indices);
+			const AtlasRegion region{ 0, 16, 32, 8, 4, Vector2{ 0.25f, 0.5f }, Vector2{ 0.125f, 0.0625f } };
+			const bool canRemap{ AtlasBuilder::CanRemap(vertices) };
+			AtlasBuilder::RemapUvs(vertices, region);
+
+			std::vector<Vertex> tiled{ vertices };
+			tiled[0].uv = Vector2{ 2.f, 0.f };
+			check(canRemap && !AtlasBuilder::CanRemap(tiled) && vertices[0].uv.x == 0.25f && vertices[0].uv.y == 0.5f
+				&& vertices[2].uv.x == 0.375f && vertices[2].uv.y == 0.5625f, "UVs are remapped into their region, tiling UVs are refused");
+		}
+
+		//Draws: every prop with its own texture (and so its own effect), against props merged per atlas page
+		std::vector<Vertex> cubeVertices{};
+		std::vector<uint32_t> cubeIndices{};
+		Mesh::CreateCube(cubeVertices, cubeIndices);
+
+		std::uniform_real_distribution<float> position{ -40.f, 40.f };
+		std::vector<Matrix> worlds(numObjects);
+		for (Matrix& world : worlds)
+			world = Matrix::CreateScale(0.5f, 0.5f, 0.5f) * Matrix::CreateTranslation(position(rng), position(rng), position(rng));
+
+		struct SceneStats
+		{
+			uint32_t numDraws{};
+			uint32_t numStateChanges{};
+			uint64_t numIndices{};
+			uint64_t textureBytes{};
+			float frameMs{};
+			uint32_t numErrors{};
+		};
+
+		constexpr int numFrames{ 100 };
+		const auto renderScene = [&](NullDevice& device, const std::vector<Mesh*>& meshes)
+			{
+				constexpr uint32_t frameConstantsSize{ GraphicsDevice::AlignConstantSize(sizeof(FrameConstants)) };
+				constexpr uint32_t constantsStride{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+				CommandBuffer commands{};
+				StateCache stateCache{};
+				FrameStats frameStats{};
+
+				const uint32_t firstDraws{ device.GetNumDraws() };
+				const uint32_t firstStateChanges{ device.GetNumStateChanges() };
+				const uint64_t firstIndices{ device.GetNumIndices() };
+				const Clock::time_point start{ Clock::now() };
+				for (int frame{}; frame < numFrames; ++frame)
+				{
+					device.BeginFrame(ColorRGB{ 0.f, 0.f, 0.3f });
+					const uint32_t numMeshes{ static_cast<uint32_t>(meshes.size()) };
+					const ConstantBlock constants{ device.MapConstants(frameConstantsSize + numMeshes * constantsStride) };
+
+					commands.Reset();
+					for (uint32_t i{}; i < numMeshes; ++i)
+					{
+						const uint32_t offset{ frameConstantsSize + i * constantsStride };
+						meshes[i]->Record(commands, meshes[i]->CreateDrawItem(i), constants.pData + offset, constants.offset + offset, constants.offset);
+					}
+					device.UnmapConstants();
+
+					stateCache.Filter(commands, frameStats);
+					device.Submit(commands);
+					device.Present();
+				}
+
+				return SceneStats{ (device.GetNumDraws() - firstDraws) / numFrames, (device.GetNumStateChanges() - firstStateChanges) / numFrames,
+					(device.GetNumIndices() - firstIndices) / numFrames, 0, ElapsedMs(start) / numFrames, device.GetNumErrors() };
+			};
+
+		const TextureSettings textureSettings{ { MipFilter::Box, MipContent::Srgb }, TextureFormat::Bc1 };
+		SceneStats separate{};
+		{
+			NullDevice device{};
+			std::vector<Mesh*> meshes{};
+			std::vector<EffectHandle> effects{};
+			std::vector<TextureHandle> textures{};
+			uint64_t textureBytes{};
+			for (uint32_t i{}; i < numObjects; ++i)
+			{
+				MipChain mips{};
+				MipGenerator::Generate(images[i].pPixels, images[i].width, images[i].height, images[i].rowPitch, textureSettings.mips, mips);
+				MipChain chain{};
+				BlockCompression::Compress(mips, textureSettings.format, chain);
+
+				std::vector<TextureLevel> levels{};
+				for (uint32_t level{}; level < chain.levels.size(); ++level)
+					levels.push_back(chain.GetLevel(level));
+				textureBytes += chain.pixels.size();
+
+				const EffectHandle effect{ device.CreateEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", {}) };
+				const TextureHandle texture{ device.CreateTexture(chain.format, levels.data(), static_cast<uint32_t>(levels.size())) };
+				device.SetTexture(effect, TextureSlot::Diffuse, texture);
+				effects.push_back(effect);
+				textures.push_back(texture);
+
+				std::vector<Vertex> vertices{};
+				std::vector<uint32_t> indices{};
+				Mesh::AppendTransformed(cubeVertices, cubeIndices, worlds[i], vertices, indices);
+				meshes.push_back(new Mesh{ &device, vertices, indices, effect, InvalidTransformId });
+			}
+
+			separate = renderScene(device, meshes);
+			separate.textureBytes = textureBytes;
+			for (Mesh* pMesh : meshes)
+				delete pMesh;
+			for (TextureHandle texture : textures)
+				device.Release(texture);
+			for (EffectHandle effect : effects)
+				device.Release(effect);
+		}
+
+		SceneStats merged{};
+		uint32_t numPages{};
+		float buildMs{};
+		{
+			NullDevice device{};
+			AtlasSettings settings{};
+			settings.texture = textureSettings;
+			TextureAtlas atlas{};
+			const Clock::time_point start{ Clock::now() };
+			const bool isBuilt{ AtlasBuilder::Build(images, settings, atlas, &jobs) };
+			buildMs = ElapsedMs(start);
+			numPages = static_cast<uint32_t>(atlas.pages.size());
+
+			//One effect, texture and mesh per page, the props' UVs moved into their regions
+			std::vector<std::vector<Vertex>> pageVertices(numPages);
+			std::vector<std::vector<uint32_t>> pageIndices(numPages);
+			for (uint32_t i{}; isBuilt && i < numObjects; ++i)
+			{
+				std::vector<Vertex> vertices{ cubeVertices };
+				AtlasBuilder::RemapUvs(vertices, atlas.regions[i]);
+				Mesh::AppendTransformed(vertices, cubeIndices, worlds[i], pageVertices[atlas.regions[i].page], pageIndices[atlas.regions[i].page]);
+			}
+
+			std::vector<Mesh*> meshes{};
+			std::vector<EffectHandle> effects{};
+			std::vector<TextureHandle> textures{};
+			uint64_t textureBytes{};
+			for (uint32_t page{}; page < numPages; ++page)
+			{
+				const MipChain& chain{ atlas.pages[page] };
+				std::vector<TextureLevel> levels{};
+				for (uint32_t level{}; level < chain.levels.size(); ++level)
+					levels.push_back(chain.GetLevel(level));
+				textureBytes += chain.pixels.size();
+
+				const EffectHandle effect{ device.CreateEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", {}) };
+				const TextureHandle texture{ device.CreateTexture(chain.format, levels.data(), static_cast<uint32_t>(levels.size())) };
+				device.SetTexture(effect, TextureSlot::Diffuse, texture);
+				effects.push_back(effect);
+				textures.push_back(texture);
+				meshes.push_back(new Mesh{ &device, pageVertices[page], pageIndices[page], effect, InvalidTransformId });
+			}
+
+			merged = renderScene(device, meshes);
+			merged.textureBytes = textureBytes;
+			for (Mesh* pMesh : meshes)
+				delete pMesh;
+			for (TextureHandle texture : textures)
+				device.Release(texture);
+			for (EffectHandle effect : effects)
+				device.Release(effect);
+		}
+
+		std::cout << "  " << numObjects << " props, own textures: " << separate.numDraws << " draws, " << separate.numStateChanges << " state changes, "
+			<< separate.textureBytes / 1024 << " KiB of textures, " << separate.frameMs << " ms to record and submit\n";
+		std::cout << "  " << numObjects << " props, " << numPages << " atlas page(s) built in " << buildMs << " ms: " << merged.numDraws << " draws, "
+			<< merged.numStateChanges << " state changes, " << merged.textureBytes / 1024 << " KiB of textures, " << merged.frameMs << " ms to record and submit\n";
+		check(merged.numDraws == numPages && merged.numIndices == separate.numIndices && separate.numErrors == 0 && merged.numErrors == 0,
+			std::to_string(separate.numDraws - merged.numDraws) + " draws saved, the same triangles drawn");
+
+		return check.Finish("texture atlas");
+	}
+}
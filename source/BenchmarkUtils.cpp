@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "BenchmarkUtils.h"
+
+namespace dae
+{
+	float Benchmark::ElapsedMs(Clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	void Benchmark::CheckList::operator()(bool isOk, const std::string& name)
+	{
+		std::cout << "  " << (isOk ? "PASS " : "FAIL ") << name << "\n";
+		Add(isOk);
+	}
+
+	void Benchmark::CheckList::Add(bool isOk)
+	{
+		m_IsPassing = m_IsPassing && isOk;
+	}
+
+	bool Benchmark::CheckList::IsPassing() const
+	{
+		return m_IsPassing;
+	}
+
+	bool Benchmark::CheckList::Finish(const std::string& subject) const
+	{
+		if (m_IsPassing)
+		{
+			std::cout << "All " << subject << " checks passed\n";
+		}
+		else
+		{
+			std::string capitalized{ subject };
+			capitalized[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(capitalized[0])));
+			std::cout << capitalized << " checks FAILED\n";
+		}
+		return m_IsPassing;
+	}
+
+	MipChain Benchmark::CreateBlankChain(TextureFormat format, uint32_t size)
+	{
+		MipChain chain{};
+		chain.format = format;
+		for (uint32_t level{}; level < MipGenerator::GetNumLevels(size, size); ++level)
+		{
+			const uint32_t levelSize{ std::max(1u, size >> level) };
+			chain.levels.push_back(MipChain::Level{ levelSize, levelSize, chain.pixels.size() });
+			chain.pixels.resize(chain.pixels.size() + size_t{ GetNumRows(format, levelSize) } * GetRowPitch(format, levelSize));
+		}
+		return chain;
+	}
+}
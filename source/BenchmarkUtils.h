@@ -0,0 +1,43 @@
+#pragma once
+#include "MipChain.h"
+
+#include <chrono>
+
+namespace dae
+{
+	//What the benchmarks in the Benchmark*.cpp files share
+	namespace Benchmark
+	{
+		using Clock = std::chrono::high_resolution_clock;
+
+		float ElapsedMs(Clock::time_point start);
+
+		//Prints a PASS or FAIL line per check and remembers whether all of them passed
+		class CheckList final
+		{
+		public:
+			CheckList() = default;
+			~CheckList() = default;
+
+			// rule of 5 copypasta
+			CheckList(const CheckList& other) = delete;
+			CheckList(CheckList&& other) = delete;
+			CheckList& operator=(const CheckList& other) = delete;
+			CheckList& operator=(CheckList&& other) = delete;
+
+			void operator()(bool isOk, const std::string& name);
+			//A check that printed its own line
+			void Add(bool isOk);
+
+			bool IsPassing() const;
+			//Prints "All <subject> checks passed" or "<Subject> checks FAILED", returns IsPassing
+			bool Finish(const std::string& subject) const;
+
+		private:
+			bool m_IsPassing{ true };
+		};
+
+		//A square chain down to 1x1 with zeroed texels, for what only cares about sizes
+		MipChain CreateBlankChain(TextureFormat format, uint32_t size);
+	}
+}
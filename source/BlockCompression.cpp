@@ -0,0 +1,741 @@
+#include "pch.h"
+#include "BlockCompression.h"
+
+#include "JobSystem.h"
+
+#include <cstring>
+#include <emmintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		//Block rows per parallel task, the same 16 texel rows as the mip generator
+		constexpr uint32_t g_BlockRowsPerJob{ 4 };
+		//Power iterations for the principal axis, 16 texels converge well before this
+		constexpr int g_NumAxisIterations{ 8 };
+
+		//Bc7 4 bit index weights, out of 64
+		constexpr uint32_t g_Bc7Weights[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		//Mode 6 is written as six 0 bits and a 1
+		constexpr uint32_t g_Bc7Mode6{ 1 << 6 };
+
+		//The block as 16 floats per channel, so 4 texels fit one __m128
+		struct BlockValues
+		{
+			alignas(16) float channels[4][16]{};
+		};
+
+		struct ColorBlock
+		{
+			uint16_t color0{};
+			uint16_t color1{};
+			uint8_t indices[16]{};
+			float error{};
+		};
+
+		struct Bc7Block
+		{
+			uint32_t endpoints[2][4]{};
+			uint32_t pBits[2]{};
+			uint8_t indices[16]{};
+			float error{};
+		};
+
+		BlockValues LoadBlock(const uint8_t (&texels)[64])
+		{
+			BlockValues block{};
+			for (int texel{}; texel < 16; ++texel)
+				for (int channel{}; channel < 4; ++channel)
+					block.channels[channel][texel] = texels[texel * 4 + channel];
+			return block;
+		}
+
+		__m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		float HorizontalSum(__m128 value)
+		{
+			alignas(16) float values[4]{};
+			_mm_store_ps(values, value);
+			return values[0] + values[1] + values[2] + values[3];
+		}
+
+		float HorizontalMin(__m128 value)
+		{
+			alignas(16) float values[4]{};
+			_mm_store_ps(values, value);
+			return std::min(std::min(values[0], values[1]), std::min(values[2], values[3]));
+		}
+
+		float HorizontalMax(__m128 value)
+		{
+			alignas(16) float values[4]{};
+			_mm_store_ps(values, value);
+			return std::max(std::max(values[0], values[1]), std::max(values[2], values[3]));
+		}
+
+		//Nearest palette entry per texel over numChannels channels from firstChannel on, 4 texels at a time.
+		//Returns the summed squared error.
+		float SelectIndices(const BlockValues& block, int firstChannel, int numChannels, const float (*pPalette)[4], int numEntries, uint8_t (&indices)[16])
+		{
+			__m128 totalError{ _mm_setzero_ps() };
+			for (int group{}; group < 4; ++group)
+			{
+				__m128 bestError{ _mm_set1_ps(FLT_MAX) };
+				__m128 bestIndex{ _mm_setzero_ps() };
+				for (int entry{}; entry < numEntries; ++entry)
+				{
+					__m128 error{ _mm_setzero_ps() };
+					for (int channel{}; channel < numChannels; ++channel)
+					{
+						const __m128 texels{ _mm_load_ps(&block.channels[firstChannel + channel][group * 4]) };
+						const __m128 difference{ _mm_sub_ps(texels, _mm_set1_ps(pPalette[entry][channel])) };
+						error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+					}
+
+					//Ties keep the lower index, so a flat block only uses index 0
+					const __m128 isCloser{ _mm_cmplt_ps(error, bestError) };
+					bestError = _mm_min_ps(error, bestError);
+					bestIndex = Select(isCloser, _mm_set1_ps(float(entry)), bestIndex);
+				}
+				totalError = _mm_add_ps(totalError, bestError);
+
+				alignas(16) int32_t groupIndices[4]{};
+				_mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), _mm_cvttps_epi32(bestIndex));
+				for (int i{}; i < 4; ++i)
+					indices[group * 4 + i] = static_cast<uint8_t>(groupIndices[i]);
+			}
+			return HorizontalSum(totalError);
+		}
+
+		//Ends of the segment that covers the texels along their principal axis
+		void FindEndpoints(const BlockValues& block, int numChannels, float (&start)[4], float (&end)[4])
+		{
+			float mean[4]{};
+			for (int channel{}; channel < numChannels; ++channel)
+			{
+				__m128 sum{ _mm_setzero_ps() };
+				for (int group{}; group < 4; ++group)
+					sum = _mm_add_ps(sum, _mm_load_ps(&block.channels[channel][group * 4]));
+				mean[channel] = HorizontalSum(sum) / 16.f;
+			}
+
+			float covariance[4][4]{};
+			for (int row{}; row < numChannels; ++row)
+			{
+				for (int column{ row }; column < numChannels; ++column)
+				{
+					__m128 sum{ _mm_setzero_ps() };
+					for (int group{}; group < 4; ++group)
+					{
+						const __m128 rowOffset{ _mm_sub_ps(_mm_load_ps(&block.channels[row][group * 4]), _mm_set1_ps(mean[row])) };
+						const __m128 columnOffset{ _mm_sub_ps(_mm_load_ps(&block.channels[column][group * 4]), _mm_set1_ps(mean[column])) };
+						sum = _mm_add_ps(sum, _mm_mul_ps(rowOffset, columnOffset));
+					}
+					covariance[row][column] = covariance[column][row] = HorizontalSum(sum);
+				}
+			}
+
+			//Power iteration, started from the column of the channel that varies most so it can't be orthogonal to the axis
+			int widest{};
+			for (int channel{ 1 }; channel < numChannels; ++channel)
+				if (covariance[channel][channel] > covariance[widest][widest])
+					widest = channel;
+
+			float axis[4]{};
+			for (int channel{}; channel < numChannels; ++channel)
+				axis[channel] = covariance[channel][widest];
+
+			for (int iteration{}; iteration < g_NumAxisIterations; ++iteration)
+			{
+				float next[4]{};
+				float largest{};
+				for (int row{}; row < numChannels; ++row)
+				{
+					for (int column{}; column < numChannels; ++column)
+						next[row] += covariance[row][column] * axis[column];
+					largest = std::max(largest, std::abs(next[row]));
+				}
+				if (largest <= 0.f)
+					break;
+				for (int channel{}; channel < numChannels; ++channel)
+					axis[channel] = next[channel] / largest;
+			}
+
+			float lengthSquared{};
+			for (int channel{}; channel < numChannels; ++channel)
+				lengthSquared += axis[channel] * axis[channel];
+
+			//Flat block, both ends on the one color
+			if (lengthSquared <= 1e-12f)
+			{
+				std::copy(std::begin(mean), std::end(mean), std::begin(start));
+				std::copy(std::begin(mean), std::end(mean), std::begin(end));
+				return;
+			}
+
+			const float inverseLength{ 1.f / std::sqrt(lengthSquared) };
+			for (int channel{}; channel < numChannels; ++channel)
+				axis[channel] *= inverseLength;
+
+			__m128 lowest{ _mm_set1_ps(FLT_MAX) };
+			__m128 highest{ _mm_set1_ps(-FLT_MAX) };
+			for (int group{}; group < 4; ++group)
+			{
+				__m128 projection{ _mm_setzero_ps() };
+				for (int channel{}; channel < numChannels; ++channel)
+				{
+					const __m128 offset{ _mm_sub_ps(_mm_load_ps(&block.channels[channel][group * 4]), _mm_set1_ps(mean[channel])) };
+					projection = _mm_add_ps(projection, _mm_mul_ps(offset, _mm_set1_ps(axis[channel])));
+				}
+				lowest = _mm_min_ps(lowest, projection);
+				highest = _mm_max_ps(highest, projection);
+			}
+
+			const float minimum{ HorizontalMin(lowest) };
+			const float maximum{ HorizontalMax(highest) };
+			for (int channel{}; channel < numChannels; ++channel)
+			{
+				start[channel] = std::clamp(mean[channel] + axis[channel] * minimum, 0.f, 255.f);
+				end[channel] = std::clamp(mean[channel] + axis[channel] * maximum, 0.f, 255.f);
+			}
+		}
+
+		//Least squares endpoints for the weights the indices picked, 0 being start and 1 end.
+		//Returns false when every texel has the same weight and the fit is undetermined.
+		bool FitEndpoints(const BlockValues& block, int numChannels, const float (&weights)[16], float (&start)[4], float (&end)[4])
+		{
+			float startSquared{};
+			float startEnd{};
+			float endSquared{};
+			float startSum[4]{};
+			float endSum[4]{};
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const float endWeight{ weights[texel] };
+				const float startWeight{ 1.f - endWeight };
+				startSquared += startWeight * startWeight;
+				startEnd += startWeight * endWeight;
+				endSquared += endWeight * endWeight;
+				for (int channel{}; channel < numChannels; ++channel)
+				{
+					startSum[channel] += startWeight * block.channels[channel][texel];
+					endSum[channel] += endWeight * block.channels[channel][texel];
+				}
+			}
+
+			const float determinant{ startSquared * endSquared - startEnd * startEnd };
+			if (std::abs(determinant) < 1e-6f)
+				return false;
+
+			for (int channel{}; channel < numChannels; ++channel)
+			{
+				start[channel] = std::clamp((endSquared * startSum[channel] - startEnd * endSum[channel]) / determinant, 0.f, 255.f);
+				end[channel] = std::clamp((startSquared * endSum[channel] - startEnd * startSum[channel]) / determinant, 0.f, 255.f);
+			}
+			return true;
+		}
+
+		uint16_t To565(const float (&color)[4])
+		{
+			const uint32_t red{ static_cast<uint32_t>(color[0] * (31.f / 255.f) + 0.5f) };
+			const uint32_t green{ static_cast<uint32_t>(color[1] * (63.f / 255.f) + 0.5f) };
+			const uint32_t blue{ static_cast<uint32_t>(color[2] * (31.f / 255.f) + 0.5f) };
+			return static_cast<uint16_t>(red << 11 | green << 5 | blue);
+		}
+
+		//Bits replicated into the low bits, like the GPU expands them
+		void Expand565(uint16_t packed, uint32_t (&color)[4])
+		{
+			const uint32_t red{ (packed >> 11) & 31u };
+			const uint32_t green{ (packed >> 5) & 63u };
+			const uint32_t blue{ packed & 31u };
+			color[0] = red << 3 | red >> 2;
+			color[1] = green << 2 | green >> 4;
+			color[2] = blue << 3 | blue >> 2;
+			color[3] = 255;
+		}
+
+		//Palette of the 4 color mode, in the order of the indices
+		void GetColorPalette(uint16_t color0, uint16_t color1, uint32_t (&palette)[4][4])
+		{
+			Expand565(color0, palette[0]);
+			Expand565(color1, palette[1]);
+			for (int channel{}; channel < 4; ++channel)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+		}
+
+		//Quantizes the endpoints, orders them for the 4 color mode and picks the indices
+		ColorBlock FitColorBlock(const BlockValues& block, const float (&start)[4], const float (&end)[4])
+		{
+			ColorBlock result{ To565(start), To565(end) };
+			if (result.color0 < result.color1)
+				std::swap(result.color0, result.color1);
+
+			uint32_t palette[4][4]{};
+			GetColorPalette(result.color0, result.color1, palette);
+
+			float floatPalette[4][4]{};
+			for (int entry{}; entry < 4; ++entry)
+				for (int channel{}; channel < 4; ++channel)
+					floatPalette[entry][channel] = float(palette[entry][channel]);
+
+			result.error = SelectIndices(block, 0, 3, floatPalette, 4, result.indices);
+			return result;
+		}
+
+		//Bc1 color block, also the color half of Bc3
+		void EncodeColor(const BlockValues& block, uint8_t* pBlock)
+		{
+			float start[4]{};
+			float end[4]{};
+			FindEndpoints(block, 3, start, end);
+
+			//Pulled in by 1/16 of the range, the interpolated colors then cover the texels in between better
+			for (int channel{}; channel < 3; ++channel)
+			{
+				const float inset{ (end[channel] - start[channel]) / 16.f };
+				start[channel] += inset;
+				end[channel] -= inset;
+			}
+
+			ColorBlock best{ FitColorBlock(block, start, end) };
+
+			constexpr float indexWeights[4]{ 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+			float weights[16]{};
+			for (int texel{}; texel < 16; ++texel)
+				weights[texel] = indexWeights[best.indices[texel]];
+
+			if (FitEndpoints(block, 3, weights, start, end))
+			{
+				const ColorBlock refined{ FitColorBlock(block, start, end) };
+				if (refined.error < best.error)
+					best = refined;
+			}
+
+			uint32_t indices{};
+			for (int texel{}; texel < 16; ++texel)
+				indices |= uint32_t{ best.indices[texel] } << (2 * texel);
+
+			std::memcpy(pBlock, &best.color0, sizeof(best.color0));
+			std::memcpy(pBlock + 2, &best.color1, sizeof(best.color1));
+			std::memcpy(pBlock + 4, &indices, sizeof(indices));
+		}
+
+		//Bc4 block of one channel, also the alpha half of Bc3 and both halves of Bc5.
+		//Always the 8 value mode, the range of the block is all it needs.
+		void EncodeChannel(const BlockValues& block, int channel, uint8_t* pBlock)
+		{
+			__m128 lowest{ _mm_load_ps(&block.channels[channel][0]) };
+			__m128 highest{ lowest };
+			for (int group{ 1 }; group < 4; ++group)
+			{
+				const __m128 texels{ _mm_load_ps(&block.channels[channel][group * 4]) };
+				lowest = _mm_min_ps(lowest, texels);
+				highest = _mm_max_ps(highest, texels);
+			}
+
+			const uint32_t high{ static_cast<uint32_t>(HorizontalMax(highest) + 0.5f) };
+			const uint32_t low{ static_cast<uint32_t>(HorizontalMin(lowest) + 0.5f) };
+			std::memset(pBlock, 0, 8);
+			pBlock[0] = static_cast<uint8_t>(high);
+			pBlock[1] = static_cast<uint8_t>(low);
+			if (high == low)
+				return;
+
+			float palette[8][4]{};
+			palette[0][0] = float(high);
+			palette[1][0] = float(low);
+			for (uint32_t step{ 1 }; step < 7; ++step)
+				palette[step + 1][0] = float(((7 - step) * high + step * low + 3) / 7);
+
+			uint8_t indices[16]{};
+			SelectIndices(block, channel, 1, palette, 8, indices);
+
+			uint64_t bits{};
+			for (int texel{}; texel < 16; ++texel)
+				bits |= uint64_t{ indices[texel] } << (3 * texel);
+			for (int i{}; i < 6; ++i)
+				pBlock[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+		}
+
+		//7 bits per channel plus a p-bit shared by the channels of the endpoint, whichever p-bit lands closer
+		void QuantizeBc7Endpoint(const float (&endpoint)[4], uint32_t (&quantized)[4], uint32_t& pBit)
+		{
+			float bestError{ FLT_MAX };
+			for (uint32_t bit{}; bit < 2; ++bit)
+			{
+				uint32_t candidate[4]{};
+				float error{};
+				for (int channel{}; channel < 4; ++channel)
+				{
+					candidate[channel] = static_cast<uint32_t>(std::clamp(int((endpoint[channel] - bit) * 0.5f + 0.5f), 0, 127));
+					const float difference{ float(candidate[channel] * 2 + bit) - endpoint[channel] };
+					error += difference * difference;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = bit;
+					std::copy(std::begin(candidate), std::end(candidate), std::begin(quantized));
+				}
+			}
+		}
+
+		void GetBc7Palette(const uint32_t (&endpoints)[2][4], const uint32_t (&pBits)[2], uint32_t (&palette)[16][4])
+		{
+			for (int channel{}; channel < 4; ++channel)
+			{
+				const uint32_t start{ endpoints[0][channel] << 1 | pBits[0] };
+				const uint32_t end{ endpoints[1][channel] << 1 | pBits[1] };
+				for (int entry{}; entry < 16; ++entry)
+					palette[entry][channel] = ((64 - g_Bc7Weights[entry]) * start + g_Bc7Weights[entry] * end + 32) >> 6;
+			}
+		}
+
+		Bc7Block FitBc7Block(const BlockValues& block, const float (&start)[4], const float (&end)[4])
+		{
+			Bc7Block result{};
+			QuantizeBc7Endpoint(start, result.endpoints[0], result.pBits[0]);
+			QuantizeBc7Endpoint(end, result.endpoints[1], result.pBits[1]);
+
+			uint32_t palette[16][4]{};
+			GetBc7Palette(result.endpoints, result.pBits, palette);
+
+			float floatPalette[16][4]{};
+			for (int entry{}; entry < 16; ++entry)
+				for (int channel{}; channel < 4; ++channel)
+					floatPalette[entry][channel] = float(palette[entry][channel]);
+
+			result.error = SelectIndices(block, 0, 4, floatPalette, 16, result.indices);
+			return result;
+		}
+
+		void WriteBits(uint8_t* pBlock, uint32_t& position, uint32_t value, uint32_t numBits)
+		{
+			for (uint32_t bit{}; bit < numBits; ++bit, ++position)
+				pBlock[position / 8] |= static_cast<uint8_t>(((value >> bit) & 1u) << (position % 8));
+		}
+
+		uint32_t ReadBits(const uint8_t* pBlock, uint32_t& position, uint32_t numBits)
+		{
+			uint32_t value{};
+			for (uint32_t bit{}; bit < numBits; ++bit, ++position)
+				value |= uint32_t{ (pBlock[position / 8] >> (position % 8)) & 1u } << bit;
+			return value;
+		}
+
+		//Mode 6 only: one subset, RGBA endpoints, 4 bit indices
+		void EncodeBc7(const BlockValues& block, uint8_t* pBlock)
+		{
+			float start[4]{};
+			float end[4]{};
+			FindEndpoints(block, 4, start, end);
+
+			Bc7Block best{ FitBc7Block(block, start, end) };
+
+			float weights[16]{};
+			for (int texel{}; texel < 16; ++texel)
+				weights[texel] = g_Bc7Weights[best.indices[texel]] / 64.f;
+
+			if (FitEndpoints(block, 4, weights, start, end))
+			{
+				const Bc7Block refined{ FitBc7Block(block, start, end) };
+				if (refined.error < best.error)
+					best = refined;
+			}
+
+			//The first index is stored without its top bit, swapping the endpoints makes it 0
+			if (best.indices[0] >= 8)
+			{
+				for (int channel{}; channel < 4; ++channel)
+					std::swap(best.endpoints[0][channel], best.endpoints[1][channel]);
+				std::swap(best.pBits[0], best.pBits[1]);
+				for (uint8_t& index : best.indices)
+					index = static_cast<uint8_t>(15 - index);
+			}
+
+			std::memset(pBlock, 0, 16);
+			uint32_t position{};
+			WriteBits(pBlock, position, g_Bc7Mode6, 7);
+			for (int channel{}; channel < 4; ++channel)
+			{
+				WriteBits(pBlock, position, best.endpoints[0][channel], 7);
+				WriteBits(pBlock, position, best.endpoints[1][channel], 7);
+			}
+			WriteBits(pBlock, position, best.pBits[0], 1);
+			WriteBits(pBlock, position, best.pBits[1], 1);
+			WriteBits(pBlock, position, best.indices[0], 3);
+			for (int texel{ 1 }; texel < 16; ++texel)
+				WriteBits(pBlock, position, best.indices[texel], 4);
+		}
+
+		void DecodeColor(const uint8_t* pBlock, bool isFourColorOnly, uint8_t (&texels)[64])
+		{
+			uint16_t color0{};
+			uint16_t color1{};
+			uint32_t indices{};
+			std::memcpy(&color0, pBlock, sizeof(color0));
+			std::memcpy(&color1, pBlock + 2, sizeof(color1));
+			std::memcpy(&indices, pBlock + 4, sizeof(indices));
+
+			uint32_t palette[4][4]{};
+			GetColorPalette(color0, color1, palette);
+
+			//Bc1 switches to 3 colors and transparent black when the endpoints are in the other order
+			if (!isFourColorOnly && color0 <= color1)
+			{
+				for (int channel{}; channel < 3; ++channel)
+				{
+					palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+					palette[3][channel] = 0;
+				}
+				palette[3][3] = 0;
+			}
+
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const uint32_t index{ (indices >> (2 * texel)) & 3u };
+				for (int channel{}; channel < 4; ++channel)
+					texels[texel * 4 + channel] = static_cast<uint8_t>(palette[index][channel]);
+			}
+		}
+
+		void DecodeChannel(const uint8_t* pBlock, int channel, uint8_t (&texels)[64])
+		{
+			const uint32_t value0{ pBlock[0] };
+			const uint32_t value1{ pBlock[1] };
+
+			uint32_t palette[8]{ value0, value1 };
+			if (value0 > value1)
+			{
+				for (uint32_t step{ 1 }; step < 7; ++step)
+					palette[step + 1] = ((7 - step) * value0 + step * value1 + 3) / 7;
+			}
+			else
+			{
+				for (uint32_t step{ 1 }; step < 5; ++step)
+					palette[step + 1] = ((5 - step) * value0 + step * value1 + 2) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			uint64_t bits{};
+			for (int i{}; i < 6; ++i)
+				bits |= uint64_t{ pBlock[2 + i] } << (8 * i);
+
+			for (int texel{}; texel < 16; ++texel)
+				texels[texel * 4 + channel] = static_cast<uint8_t>(palette[(bits >> (3 * texel)) & 7u]);
+		}
+
+		void DecodeBc7(const uint8_t* pBlock, uint8_t (&texels)[64])
+		{
+			if ((pBlock[0] & 0x7F) != g_Bc7Mode6)
+			{
+				for (int texel{}; texel < 16; ++texel)
+				{
+					const uint8_t magenta[4]{ 255, 0, 255, 255 };
+					std::memcpy(&texels[texel * 4], magenta, sizeof(magenta));
+				}
+				return;
+			}
+
+			uint32_t position{ 7 };
+			uint32_t endpoints[2][4]{};
+			uint32_t pBits[2]{};
+			for (int channel{}; channel < 4; ++channel)
+			{
+				endpoints[0][channel] = ReadBits(pBlock, position, 7);
+				endpoints[1][channel] = ReadBits(pBlock, position, 7);
+			}
+			pBits[0] = ReadBits(pBlock, position, 1);
+			pBits[1] = ReadBits(pBlock, position, 1);
+
+			uint32_t palette[16][4]{};
+			GetBc7Palette(endpoints, pBits, palette);
+
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const uint32_t index{ ReadBits(pBlock, position, texel == 0 ? 3 : 4) };
+				for (int channel{}; channel < 4; ++channel)
+					texels[texel * 4 + channel] = static_cast<uint8_t>(palette[index][channel]);
+			}
+		}
+
+		void ForRows(JobSystem* pJobs, uint32_t numRows, const std::function<void(uint32_t begin, uint32_t end)>& function)
+		{
+			if (pJobs)
+				pJobs->ParallelFor(numRows, g_BlockRowsPerJob, function);
+			else
+				function(0, numRows);
+		}
+
+		//Texels outside the level repeat its last row and column
+		void GatherBlock(const TextureLevel& level, uint32_t blockX, uint32_t blockY, uint8_t (&texels)[64])
+		{
+			const uint8_t* pPixels{ static_cast<const uint8_t*>(level.pPixels) };
+			for (uint32_t y{}; y < 4; ++y)
+			{
+				const uint8_t* pRow{ pPixels + size_t{ std::min(blockY * 4 + y, level.height - 1) } * level.rowPitch };
+				for (uint32_t x{}; x < 4; ++x)
+					std::memcpy(&texels[(y * 4 + x) * 4], pRow + size_t{ std::min(blockX * 4 + x, level.width - 1) } * 4, 4);
+			}
+		}
+
+		//Rgba8 level without row padding, texels outside it are dropped
+		void ScatterBlock(const uint8_t (&texels)[64], uint32_t blockX, uint32_t blockY, const MipChain::Level& level, uint8_t* pPixels)
+		{
+			const uint32_t numRows{ std::min(4u, level.height - blockY * 4) };
+			const uint32_t numColumns{ std::min(4u, level.width - blockX * 4) };
+			for (uint32_t y{}; y < numRows; ++y)
+				std::memcpy(pPixels + (size_t{ blockY * 4 + y } * level.width + size_t{ blockX } * 4) * 4, &texels[y * 16], size_t{ numColumns } * 4);
+		}
+
+		//Same sizes as source, laid out for format
+		void ResizeChain(const MipChain& source, TextureFormat format, MipChain& chain)
+		{
+			chain.format = format;
+			chain.levels.resize(source.levels.size());
+
+			size_t size{};
+			for (size_t level{}; level < source.levels.size(); ++level)
+			{
+				const uint32_t width{ source.levels[level].width };
+				const uint32_t height{ source.levels[level].height };
+				chain.levels[level] = MipChain::Level{ width, height, size };
+				size += size_t{ GetNumRows(format, height) } * GetRowPitch(format, width);
+			}
+			chain.pixels.resize(size);
+		}
+	}
+
+	void BlockCompression::EncodeBlock(TextureFormat format, const uint8_t (&texels)[64], uint8_t* pBlock)
+	{
+		const BlockValues block{ LoadBlock(texels) };
+		switch (format)
+		{
+		case TextureFormat::Rgba8:
+			break;
+		case TextureFormat::Bc1:
+			EncodeColor(block, pBlock);
+			break;
+		case TextureFormat::Bc3:
+			EncodeChannel(block, 3, pBlock);
+			EncodeColor(block, pBlock + 8);
+			break;
+		case TextureFormat::Bc4:
+			EncodeChannel(block, 0, pBlock);
+			break;
+		case TextureFormat::Bc5:
+			EncodeChannel(block, 0, pBlock);
+			EncodeChannel(block, 1, pBlock + 8);
+			break;
+		case TextureFormat::Bc7:
+			EncodeBc7(block, pBlock);
+			break;
+		}
+	}
+
+	void BlockCompression::DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint8_t (&texels)[64])
+	{
+		switch (format)
+		{
+		case TextureFormat::Rgba8:
+			break;
+		case TextureFormat::Bc1:
+			DecodeColor(pBlock, false, texels);
+			break;
+		case TextureFormat::Bc3:
+			DecodeColor(pBlock + 8, true, texels);
+			DecodeChannel(pBlock, 3, texels);
+			break;
+		case TextureFormat::Bc4:
+		case TextureFormat::Bc5:
+			for (int texel{}; texel < 16; ++texel)
+			{
+				const uint8_t black[4]{ 0, 0, 0, 255 };
+				std::memcpy(&texels[texel * 4], black, sizeof(black));
+			}
+			DecodeChannel(pBlock, 0, texels);
+			if (format == TextureFormat::Bc5)
+				DecodeChannel(pBlock + 8, 1, texels);
+			break;
+		case TextureFormat::Bc7:
+			DecodeBc7(pBlock, texels);
+			break;
+		}
+	}
+
+	void BlockCompression::Compress(const MipChain& source, TextureFormat format, MipChain& compressed, JobSystem* pJobs)
+	{
+		if (format == TextureFormat::Rgba8)
+		{
+			compressed = source;
+			return;
+		}
+
+		ResizeChain(source, format, compressed);
+
+		const uint32_t blockSize{ GetBlockSize(format) };
+		for (uint32_t level{}; level < source.levels.size(); ++level)
+		{
+			const TextureLevel sourceLevel{ source.GetLevel(level) };
+			const TextureLevel targetLevel{ compressed.GetLevel(level) };
+			uint8_t* pTarget{ compressed.pixels.data() + compressed.levels[level].offset };
+
+			const uint32_t numBlocksX{ (sourceLevel.width + 3) / 4 };
+			ForRows(pJobs, GetNumRows(format, sourceLevel.height), [&](uint32_t begin, uint32_t end)
+				{
+					uint8_t texels[64]{};
+					for (uint32_t blockY{ begin }; blockY < end; ++blockY)
+					{
+						for (uint32_t blockX{}; blockX < numBlocksX; ++blockX)
+						{
+							GatherBlock(sourceLevel, blockX, blockY, texels);
+							EncodeBlock(format, texels, pTarget + size_t{ blockY } * targetLevel.rowPitch + size_t{ blockX } * blockSize);
+						}
+					}
+				});
+		}
+	}
+
+	void BlockCompression::Decompress(const MipChain& source, MipChain& decompressed, JobSystem* pJobs)
+	{
+		if (source.format == TextureFormat::Rgba8)
+		{
+			decompressed = source;
+			return;
+		}
+
+		ResizeChain(source, TextureFormat::Rgba8, decompressed);
+
+		const uint32_t blockSize{ GetBlockSize(source.format) };
+		for (uint32_t level{}; level < source.levels.size(); ++level)
+		{
+			const TextureLevel sourceLevel{ source.GetLevel(level) };
+			const uint8_t* pSource{ static_cast<const uint8_t*>(sourceLevel.pPixels) };
+			const MipChain::Level& targetLevel{ decompressed.levels[level] };
+			uint8_t* pTarget{ decompressed.pixels.data() + targetLevel.offset };
+
+			const uint32_t numBlocksX{ (sourceLevel.width + 3) / 4 };
+			ForRows(pJobs, GetNumRows(source.format, sourceLevel.height), [&](uint32_t begin, uint32_t end)
+				{
+					uint8_t texels[64]{};
+					for (uint32_t blockY{ begin }; blockY < end; ++blockY)
+					{
+						for (uint32_t blockX{}; blockX < numBlocksX; ++blockX)
+						{
+							DecodeBlock(source.format, pSource + size_t{ blockY } * sourceLevel.rowPitch + size_t{ blockX } * blockSize, texels);
+							ScatterBlock(texels, blockX, blockY, targetLevel, pTarget);
+						}
+					}
+				});
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "MipChain.h"
+
+namespace dae
+{
+	class JobSystem;
+
+	//CPU encoders for the block compressed texture formats, in the layouts D3D11 samples them from.
+	//Blocks are 4x4 texels, given and returned as 64 bytes of RGBA, row by row.
+	namespace BlockCompression
+	{
+		//Endpoints along the principal axis of the block, refined once by least squares.
+		//Bc1 always uses its 4 color mode, Bc7 always writes mode 6 (one subset, RGBA, 4 bit indices).
+		void EncodeBlock(TextureFormat format, const uint8_t (&texels)[64], uint8_t* pBlock);
+
+		//What the GPU would sample: Bc1 and Bc7 give RGBA, Bc4 gives (r, 0, 0, 255) and Bc5 (r, g, 0, 255).
+		//Bc7 blocks in modes other than 6 aren't decoded and come out as opaque magenta.
+		void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint8_t (&texels)[64]);
+
+		//Encodes every level of an Rgba8 chain, the block rows of a level are split over the job system's threads.
+		//Levels smaller than a block repeat their last row and column. Rgba8 just copies the chain.
+		void Compress(const MipChain& source, TextureFormat format, MipChain& compressed, JobSystem* pJobs = nullptr);
+
+		//Back to Rgba8, for checks and CPU-side sampling. An Rgba8 chain is copied.
+		void Decompress(const MipChain& source, MipChain& decompressed, JobSystem* pJobs = nullptr);
+	}
+}
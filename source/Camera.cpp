@@ -18,6 +18,9 @@ namespace dae
 
 		origin = _origin;
 		forward = Vector3::UnitZ;
+
+		isViewDirty = true;
+		isProjectionDirty = true;
 	}
 
 	void Camera::CalculateViewMatrix()
@@ -25,12 +28,13 @@ namespace dae
 		right = Vector3::Cross(Vector3::UnitY, forward).Normalized();
 		up = Vector3::Cross(forward, right);
 
-		invViewMatrix = Matrix{ right,up,forward,origin };
-
+		//Orthonormal basis => rigid, so the inverse is a transpose + translation fix-up
+		invViewMatrix = Matrix::CreateRigid(right, up, forward, origin);
 
-		viewMatrix = invViewMatrix.Inverse();
+		viewMatrix = Matrix::Inverse(invViewMatrix);
 
-		invViewMatrix = Matrix{ right,up,forward,origin };
+		isViewDirty = false;
+		++viewVersion;
 
 		//ViewMatrix => Matrix::CreateLookAtLH(...) [not implemented yet]
 		//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
@@ -43,6 +47,9 @@ namespace dae
 									Vector4{ 0,0,farClip / (farClip - nearClip), 1},
 									Vector4{ 0,0,-(farClip * nearClip) / (farClip - nearClip), 0} };
 
+		isProjectionDirty = false;
+		++projectionVersion;
+
 		//const float Sw{ 2 * sqrtf(((nearClip * nearClip) / (cosf(fov) * cosf(fov)) - (nearClip * nearClip))) };
 		//const float Sh{ 2 * sqrtf(((nearClip * nearClip) / (cosf(fov * aspectRatio) * cosf(fov * aspectRatio)) - (nearClip * nearClip))) };
 
@@ -70,6 +77,26 @@ namespace dae
 		return &invViewMatrix;
 	}
 
+	uint32_t Camera::GetViewVersion() const
+	{
+		return viewVersion;
+	}
+
+	uint32_t Camera::GetProjectionVersion() const
+	{
+		return projectionVersion;
+	}
+
+	Vector3 Camera::GetOrigin() const
+	{
+		return origin;
+	}
+
+	float Camera::GetTanHalfFov() const
+	{
+		return fov;
+	}
+
 	void Camera::Update(const Timer* pTimer)
 	{
 		//Camera Update Logic
@@ -80,21 +107,33 @@ namespace dae
 		constexpr float movementSpeed = 13.f;
 		constexpr float mouseSens = 0.006f;
 
+		const Vector3 previousOrigin{ origin };
+		const float previousPitch{ totalPitch };
+		const float previousYaw{ totalYaw };
+
 		DoKeyboardInput(deltaTime, movementSpeed);
 
 		DoMouseInput(deltaTime, movementSpeed, mouseSens);
 
-		const Matrix finalRotation{ Matrix::CreateRotation(totalPitch, totalYaw, 0) };
+		if (totalPitch != previousPitch || totalYaw != previousYaw)
+		{
+			const Matrix finalRotation{ Matrix::CreateRotation(totalPitch, totalYaw, 0) };
 
-		forward = finalRotation.TransformVector(Vector3::UnitZ);
-		forward.Normalize();
+			forward = finalRotation.TransformVector(Vector3::UnitZ);
+			forward.Normalize();
 
+			isViewDirty = true;
+		}
 
+		if (origin.x != previousOrigin.x || origin.y != previousOrigin.y || origin.z != previousOrigin.z)
+			isViewDirty = true;
 
 
-		//Update Matrices
-		CalculateViewMatrix();
-		CalculateProjectionMatrix(); //Try to optimize this - should only be called once or when fov/aspectRatio changes
+		//Update Matrices (only when their inputs changed)
+		if (isViewDirty)
+			CalculateViewMatrix();
+		if (isProjectionDirty)
+			CalculateProjectionMatrix();
 	}
 
 	void dae::Camera::DoKeyboardInput(float deltaTime, float moveSpeed)
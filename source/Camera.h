@@ -22,6 +22,14 @@ namespace dae
 		Matrix GetViewMatrix() const;
 		Matrix* GetInvViewMatrix();
 
+		//Bumped every time the matrix is actually recalculated
+		uint32_t GetViewVersion() const;
+		uint32_t GetProjectionVersion() const;
+
+		Vector3 GetOrigin() const;
+		//tan of half the vertical field of view
+		float GetTanHalfFov() const;
+
 		void Update(const Timer* pTimer);
 
 	private:
@@ -44,6 +52,11 @@ namespace dae
 		Matrix viewMatrix{};
 		Matrix projectionMatrix{};
 
+		bool isViewDirty{ true };
+		bool isProjectionDirty{ true };
+		uint32_t viewVersion{};
+		uint32_t projectionVersion{};
+
 		void CalculateViewMatrix();
 
 		void CalculateProjectionMatrix();
@@ -0,0 +1,64 @@
+#include "pch.h"
+#include "CommandBuffer.h"
+
+namespace dae
+{
+	void CommandBuffer::Reset()
+	{
+		m_Commands.clear();
+	}
+
+	void CommandBuffer::SetPrimitiveTopology(PrimitiveTopology topology)
+	{
+		Command command{ CommandType::SetPrimitiveTopology, {} };
+		command.setPrimitiveTopology = { topology };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::SetInputLayout(InputLayoutHandle layout)
+	{
+		Command command{ CommandType::SetInputLayout, {} };
+		command.setInputLayout = { layout };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint32_t offset)
+	{
+		Command command{ CommandType::SetVertexBuffer, {} };
+		command.setVertexBuffer = { buffer, stride, offset };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::SetIndexBuffer(BufferHandle buffer)
+	{
+		Command command{ CommandType::SetIndexBuffer, {} };
+		command.setIndexBuffer = { buffer };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::SetConstants(ConstantSlot slot, uint32_t offset, uint32_t size)
+	{
+		Command command{ CommandType::SetConstants, {} };
+		command.setConstants = { slot, offset, size };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::ApplyPass(EffectHandle effect, uint32_t pass)
+	{
+		Command command{ CommandType::ApplyPass, {} };
+		command.applyPass = { effect, pass };
+		m_Commands.push_back(command);
+	}
+
+	void CommandBuffer::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
+	{
+		Command command{ CommandType::DrawIndexed, {} };
+		command.drawIndexed = { indexCount, startIndex, baseVertex };
+		m_Commands.push_back(command);
+	}
+
+	const std::vector<Command>& CommandBuffer::GetCommands() const
+	{
+		return m_Commands;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+namespace dae
+{
+	//Opaque handles, only the backend that replays a buffer knows what they point to
+	enum class BufferHandle : uintptr_t { Invalid = 0 };
+	enum class InputLayoutHandle : uintptr_t { Invalid = 0 };
+	enum class EffectHandle : uintptr_t { Invalid = 0 };
+	enum class TextureHandle : uintptr_t { Invalid = 0 };
+	enum class SamplerHandle : uintptr_t { Invalid = 0 };
+
+	enum class PrimitiveTopology : uint8_t
+	{
+		TriangleList
+	};
+
+	//Constant buffer registers that are bound from the device's constant ring instead of by the effect
+	enum class ConstantSlot : uint8_t
+	{
+		Frame = 0,
+		Object = 1
+	};
+	constexpr uint32_t NumConstantSlots{ 2 };
+
+	enum class CommandType : uint8_t
+	{
+		SetPrimitiveTopology,
+		SetInputLayout,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetConstants,
+		ApplyPass,
+		DrawIndexed
+	};
+
+	//Plain data, one per state change or draw
+	struct Command
+	{
+		struct SetPrimitiveTopologyArgs { PrimitiveTopology topology; };
+		struct SetInputLayoutArgs { InputLayoutHandle layout; };
+		struct SetVertexBufferArgs { BufferHandle buffer; uint32_t stride; uint32_t offset; };
+		struct SetIndexBufferArgs { BufferHandle buffer; };
+		struct SetConstantsArgs { ConstantSlot slot; uint32_t offset; uint32_t size; };
+		struct ApplyPassArgs { EffectHandle effect; uint32_t pass; };
+		struct DrawIndexedArgs { uint32_t indexCount; uint32_t startIndex; int32_t baseVertex; };
+
+		CommandType type;
+		union
+		{
+			SetPrimitiveTopologyArgs setPrimitiveTopology;
+			SetInputLayoutArgs setInputLayout;
+			SetVertexBufferArgs setVertexBuffer;
+			SetIndexBufferArgs setIndexBuffer;
+			SetConstantsArgs setConstants;
+			ApplyPassArgs applyPass;
+			DrawIndexedArgs drawIndexed;
+		};
+	};
+	static_assert(std::is_trivially_copyable_v<Command>, "Commands are copied around as raw data");
+
+	//Recorded by one thread, replayed later by a CommandBackend.
+	//Keeps its capacity across Reset so recording doesn't allocate once it warmed up.
+	class CommandBuffer final
+	{
+	public:
+		void Reset();
+
+		void SetPrimitiveTopology(PrimitiveTopology topology);
+		void SetInputLayout(InputLayoutHandle layout);
+		void SetVertexBuffer(BufferHandle buffer, uint32_t stride, uint32_t offset = 0);
+		void SetIndexBuffer(BufferHandle buffer);
+		//Binds a block of the device's constant ring, it has to come after the ApplyPass it belongs to
+		void SetConstants(ConstantSlot slot, uint32_t offset, uint32_t size);
+		void ApplyPass(EffectHandle effect, uint32_t pass);
+		void DrawIndexed(uint32_t indexCount, uint32_t startIndex = 0, int32_t baseVertex = 0);
+
+		const std::vector<Command>& GetCommands() const;
+
+		//Drops every command the predicate returns true for, in order
+		template<typename Predicate>
+		void RemoveCommands(Predicate isRemoved)
+		{
+			size_t numKept{};
+			for (const Command& command : m_Commands)
+			{
+				if (!isRemoved(command))
+					m_Commands[numKept++] = command;
+			}
+			m_Commands.resize(numKept);
+		}
+
+	private:
+		std::vector<Command> m_Commands{};
+	};
+
+	//Replays command buffers, in the order they are submitted
+	class CommandBackend
+	{
+	public:
+		CommandBackend() = default;
+		virtual ~CommandBackend() = default;
+
+		// rule of 5 copypasta
+		CommandBackend(const CommandBackend& other) = delete;
+		CommandBackend(CommandBackend&& other) = delete;
+		CommandBackend& operator=(const CommandBackend& other) = delete;
+		CommandBackend& operator=(CommandBackend&& other) = delete;
+
+		virtual void Submit(const CommandBuffer& buffer) = 0;
+	};
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include "CommandBuffer.h"
+
+namespace dae
+{
+	//One member of a cbuffer, where the C++ mirror keeps it
+	struct ConstantMember
+	{
+		const char* pName;
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	//Name, register and members of a cbuffer as the C++ side lays it out.
+	//Effects check it against their reflection once when they are created.
+	struct ConstantLayout
+	{
+		const char* pName;
+		uint32_t registerIndex;
+		uint32_t size;
+		const ConstantMember* pMembers;
+		uint32_t numMembers;
+	};
+
+	//HLSL packing rules: members in order without overlap, none straddles a 16 byte register,
+	//and anything larger than a register starts on one
+	constexpr bool IsPackingValid(const ConstantLayout& layout)
+	{
+		uint32_t end{};
+		for (uint32_t i{}; i < layout.numMembers; ++i)
+		{
+			const ConstantMember& member{ layout.pMembers[i] };
+			const uint32_t registerOffset{ member.offset % 16 };
+			if (member.offset < end || member.size == 0 || member.offset + member.size > layout.size)
+				return false;
+			if (member.size <= 16 ? registerOffset + member.size > 16 : registerOffset != 0)
+				return false;
+			end = member.offset + member.size;
+		}
+		return true;
+	}
+
+	//cbPerFrame, written once per frame into the device's constant ring
+	struct FrameConstants final
+	{
+		float viewInverse[16];
+		float lightDirection[3];
+		float lightIntensity;
+	};
+
+	//cbPerObject, written per draw into the device's constant ring
+	struct ObjectConstants final
+	{
+		float worldViewProjection[16];
+		float world[16];
+	};
+
+	//cbMaterial, kept by the effect and uploaded whole when it changed
+	struct MaterialConstants final
+	{
+		float shininess{ 25.f };
+		float alphaCutoff{ 0.5f };
+	};
+
+	//Matrix is row-major like the cbuffers declare their matrices. Its 16 floats come first, the type tag after them stays behind.
+	inline void StoreMatrix(float (&destination)[16], const Matrix& matrix)
+	{
+		static_assert(sizeof(Matrix) >= sizeof(destination));
+		std::memcpy(destination, &matrix, sizeof(destination));
+	}
+
+	//Specialized for every block, Layout describes the matching cbuffer
+	template<typename T>
+	struct ConstantTraits;
+
+	template<>
+	struct ConstantTraits<FrameConstants>
+	{
+		static constexpr ConstantMember Members[]{
+			{ "gViewInverseMatrix", offsetof(FrameConstants, viewInverse), sizeof(FrameConstants::viewInverse) },
+			{ "gLightDirection", offsetof(FrameConstants, lightDirection), sizeof(FrameConstants::lightDirection) },
+			{ "gLightIntensity", offsetof(FrameConstants, lightIntensity), sizeof(FrameConstants::lightIntensity) }
+		};
+		static constexpr ConstantLayout Layout{ "cbPerFrame", static_cast<uint32_t>(ConstantSlot::Frame), sizeof(FrameConstants), Members, 3 };
+	};
+
+	template<>
+	struct ConstantTraits<ObjectConstants>
+	{
+		static constexpr ConstantMember Members[]{
+			{ "gWorldViewProj", offsetof(ObjectConstants, worldViewProjection), sizeof(ObjectConstants::worldViewProjection) },
+			{ "gWorldMatrix", offsetof(ObjectConstants, world), sizeof(ObjectConstants::world) }
+		};
+		static constexpr ConstantLayout Layout{ "cbPerObject", static_cast<uint32_t>(ConstantSlot::Object), sizeof(ObjectConstants), Members, 2 };
+	};
+
+	template<>
+	struct ConstantTraits<MaterialConstants>
+	{
+		static constexpr ConstantMember Members[]{
+			{ "gShininess", offsetof(MaterialConstants, shininess), sizeof(MaterialConstants::shininess) },
+			{ "gAlphaCutoff", offsetof(MaterialConstants, alphaCutoff), sizeof(MaterialConstants::alphaCutoff) }
+		};
+		static constexpr ConstantLayout Layout{ "cbMaterial", 2, sizeof(MaterialConstants), Members, 2 };
+	};
+
+	static_assert(IsPackingValid(ConstantTraits<FrameConstants>::Layout), "FrameConstants doesn't follow HLSL packing");
+	static_assert(IsPackingValid(ConstantTraits<ObjectConstants>::Layout), "ObjectConstants doesn't follow HLSL packing");
+	static_assert(IsPackingValid(ConstantTraits<MaterialConstants>::Layout), "MaterialConstants doesn't follow HLSL packing");
+}
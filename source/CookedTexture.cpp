@@ -0,0 +1,221 @@
+#include "pch.h"
+#include "CookedTexture.h"
+#include "DiskCache.h"
+
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		//Bump when the layout changes, old files then fail to open and the images are loaded instead
+		constexpr uint32_t FormatVersion{ 1 };
+		constexpr uint32_t Magic{ 0x58455444 }; //"DTEX"
+		//A page, so every level starts page aligned in the mapping
+		constexpr uint64_t LevelAlignment{ 4096 };
+
+		struct FileHeader
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint32_t format{};
+			uint32_t numLevels{};
+		};
+
+		struct FileLevel
+		{
+			uint32_t width{};
+			uint32_t height{};
+			uint32_t rowPitch{};
+			uint32_t numRows{};
+			uint64_t offset{};
+		};
+
+		uint64_t AlignUp(uint64_t value)
+		{
+			return (value + LevelAlignment - 1) / LevelAlignment * LevelAlignment;
+		}
+	}
+
+	CookedTexture::CookedTexture(const std::filesystem::path& path)
+	{
+#if defined(_WIN32)
+		const HANDLE file{ CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+		m_pFile = file;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+			return;
+
+		m_pMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_pMapping)
+			return;
+
+		m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_pMapping, FILE_MAP_READ, 0, 0, 0));
+		m_Size = static_cast<size_t>(size.QuadPart);
+#else
+		const int file{ open(path.c_str(), O_RDONLY) };
+		if (file < 0)
+			return;
+
+		struct stat status{};
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			void* pData{ mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0) };
+			if (pData != MAP_FAILED)
+			{
+				m_pData = static_cast<const uint8_t*>(pData);
+				m_Size = static_cast<size_t>(status.st_size);
+			}
+		}
+		//The mapping keeps the file alive
+		close(file);
+#endif
+		if (!m_pData || m_Size < sizeof(FileHeader))
+		{
+			Unmap();
+			return;
+		}
+
+		FileHeader header{};
+		std::memcpy(&header, m_pData, sizeof(header));
+		const bool isHeaderValid{ header.magic == Magic && header.version == FormatVersion
+			&& header.format <= static_cast<uint32_t>(TextureFormat::Bc7) && header.numLevels > 0 && header.numLevels <= 32
+			&& sizeof(FileHeader) + header.numLevels * sizeof(FileLevel) <= m_Size };
+		if (!isHeaderValid)
+		{
+			Unmap();
+			return;
+		}
+
+		m_Format = static_cast<TextureFormat>(header.format);
+		m_Levels.resize(header.numLevels);
+		for (uint32_t i{}; i < header.numLevels; ++i)
+		{
+			FileLevel level{};
+			std::memcpy(&level, m_pData + sizeof(FileHeader) + i * sizeof(FileLevel), sizeof(level));
+
+			//The level has to be what the device will read for its size, and inside the file
+			const uint64_t size{ uint64_t{ level.rowPitch } * level.numRows };
+			const bool isLevelValid{ level.width > 0 && level.height > 0
+				&& level.rowPitch >= GetRowPitch(m_Format, level.width) && level.numRows == GetNumRows(m_Format, level.height)
+				&& level.offset % LevelAlignment == 0 && level.offset + size <= m_Size };
+			if (!isLevelValid)
+			{
+				m_Levels.clear();
+				Unmap();
+				return;
+			}
+
+			m_Levels[i] = TextureLevel{ m_pData + level.offset, level.width, level.height, level.rowPitch };
+			m_DataSize += size;
+		}
+	}
+
+	CookedTexture::~CookedTexture()
+	{
+		Unmap();
+	}
+
+	bool CookedTexture::IsValid() const
+	{
+		return !m_Levels.empty();
+	}
+
+	TextureFormat CookedTexture::GetFormat() const
+	{
+		return m_Format;
+	}
+
+	uint32_t CookedTexture::GetNumLevels() const
+	{
+		return static_cast<uint32_t>(m_Levels.size());
+	}
+
+	const TextureLevel* CookedTexture::GetLevels() const
+	{
+		return m_Levels.data();
+	}
+
+	uint64_t CookedTexture::GetDataSize() const
+	{
+		return m_DataSize;
+	}
+
+	bool CookedTexture::Write(const std::filesystem::path& path, const MipChain& chain)
+	{
+		if (chain.levels.empty())
+			return false;
+
+		const FileHeader header{ Magic, FormatVersion, static_cast<uint32_t>(chain.format), static_cast<uint32_t>(chain.levels.size()) };
+		std::vector<FileLevel> levels(chain.levels.size());
+		uint64_t offset{ AlignUp(sizeof(FileHeader) + levels.size() * sizeof(FileLevel)) };
+		for (uint32_t i{}; i < levels.size(); ++i)
+		{
+			const MipChain::Level& level{ chain.levels[i] };
+			levels[i] = FileLevel{ level.width, level.height, GetRowPitch(chain.format, level.width), GetNumRows(chain.format, level.height), offset };
+			offset = AlignUp(offset + uint64_t{ levels[i].rowPitch } * levels[i].numRows);
+		}
+
+		std::error_code error{};
+		std::filesystem::create_directories(path.parent_path(), error);
+
+		//Written next to the target and renamed, so a running game never maps half a file
+		const std::vector<char> padding(LevelAlignment);
+		std::vector<FileSpan> spans{ { &header, sizeof(header) }, { levels.data(), levels.size() * sizeof(FileLevel) } };
+		uint64_t end{ sizeof(header) + levels.size() * sizeof(FileLevel) };
+		for (uint32_t i{}; i < levels.size(); ++i)
+		{
+			const uint64_t levelSize{ uint64_t{ levels[i].rowPitch } * levels[i].numRows };
+			spans.push_back(FileSpan{ padding.data(), static_cast<size_t>(levels[i].offset - end) });
+			spans.push_back(FileSpan{ chain.pixels.data() + chain.levels[i].offset, static_cast<size_t>(levelSize) });
+			end = levels[i].offset + levelSize;
+		}
+		return WriteFileAtomic(path, spans.data(), spans.size());
+	}
+
+	bool CookedTexture::IsUpToDate(const std::filesystem::path& path, const std::vector<ChannelSource>& sources)
+	{
+		std::error_code error{};
+		const std::filesystem::file_time_type cookedTime{ std::filesystem::last_write_time(path, error) };
+		if (error)
+			return false;
+
+		for (const ChannelSource& source : sources)
+		{
+			const std::filesystem::file_time_type sourceTime{ std::filesystem::last_write_time(source.path, error) };
+			if (error || sourceTime > cookedTime)
+				return false;
+		}
+		return true;
+	}
+
+	void CookedTexture::Unmap()
+	{
+#if defined(_WIN32)
+		if (m_pData)
+			UnmapViewOfFile(m_pData);
+		if (m_pMapping)
+			CloseHandle(m_pMapping);
+		if (m_pFile)
+			CloseHandle(m_pFile);
+#else
+		if (m_pData)
+			munmap(const_cast<uint8_t*>(m_pData), m_Size);
+#endif
+		m_pData = nullptr;
+		m_pMapping = nullptr;
+		m_pFile = nullptr;
+		m_Size = 0;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <filesystem>
+#include "Texture.h"
+
+namespace dae
+{
+	//A texture as it's uploaded, written once by --cook-textures so startup doesn't decode, filter or encode anything.
+	//The file is a header, one entry per level, then the levels, each starting on a 4 KiB boundary.
+	//Opening one maps the file, the levels are handed to the device straight from the mapping.
+	class CookedTexture final
+	{
+	public:
+		//IsValid is false if the file is missing, truncated or from another version
+		explicit CookedTexture(const std::filesystem::path& path);
+		~CookedTexture();
+
+		// rule of 5 copypasta
+		CookedTexture(const CookedTexture& other) = delete;
+		CookedTexture(CookedTexture&& other) = delete;
+		CookedTexture& operator=(const CookedTexture& other) = delete;
+		CookedTexture& operator=(CookedTexture&& other) = delete;
+
+		bool IsValid() const;
+		TextureFormat GetFormat() const;
+		uint32_t GetNumLevels() const;
+		//Points into the mapping, only valid while this object lives
+		const TextureLevel* GetLevels() const;
+		//Bytes of level data, without the header and padding
+		uint64_t GetDataSize() const;
+
+		static bool Write(const std::filesystem::path& path, const MipChain& chain);
+		//False if the cooked file is missing or older than one of the images it was cooked from
+		static bool IsUpToDate(const std::filesystem::path& path, const std::vector<ChannelSource>& sources);
+
+	private:
+		void Unmap();
+
+		const uint8_t* m_pData{ nullptr };
+		size_t m_Size{};
+		//Windows file and mapping handles, unused elsewhere
+		void* m_pFile{ nullptr };
+		void* m_pMapping{ nullptr };
+
+		TextureFormat m_Format{ TextureFormat::Rgba8 };
+		std::vector<TextureLevel> m_Levels{};
+		uint64_t m_DataSize{};
+	};
+}
@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "CpuShader.h"
+#include "ShaderPermutation.h"
+
+#include <array>
+#include <utility>
+
+namespace dae
+{
+	namespace
+	{
+		//Line by line the PS of PosCol3D.fx
+		template<uint32_t Features>
+		bool ShadePixel(const CpuShader::PixelInput& input, const FrameConstants& frame, const MaterialConstants& material, Vector4& color)
+		{
+			const Vector3 lightDirection{ frame.lightDirection[0], frame.lightDirection[1], frame.lightDirection[2] };
+			const Vector4 textureColor{ input.diffuse * (1.f / PI) };
+
+			if constexpr ((Features & ShaderFeature::AlphaTest) != 0)
+			{
+				if (textureColor.w * PI - material.alphaCutoff < 0.f)
+					return false;
+			}
+
+			Vector3 normal{ input.normal };
+			if constexpr ((Features & ShaderFeature::NormalMap) != 0)
+			{
+				//BC5 only stores XY, Z follows from the normal being unit length and facing out of the surface
+				const Vector3 binormal{ Vector3::Cross(input.normal, input.tangent) };
+				const Vector2 normalXY{ 2.f * input.normalMap.x - 1.f, 2.f * input.normalMap.y - 1.f };
+				const float normalZ{ std::sqrt(Saturate(1.f - Vector2::Dot(normalXY, normalXY))) };
+				normal = input.tangent * normalXY.x + binormal * normalXY.y + input.normal * normalZ;
+			}
+
+			const float observedArea{ Saturate(Vector3::Dot(normal, -lightDirection)) };
+
+			if constexpr ((Features & ShaderFeature::SpecularMap) != 0)
+			{
+				const Vector3 cameraPosition{ frame.viewInverse[12], frame.viewInverse[13], frame.viewInverse[14] };
+				const Vector3 viewDirection{ (input.worldPosition - cameraPosition).Normalized() };
+				const Vector3 reflection{ Vector3::Reflect(-lightDirection, input.normal) };
+				const float cosAlpha{ Saturate(Vector3::Dot(reflection, viewDirection)) };
+
+				const Vector4& specularGlossiness{ input.specularGlossiness };
+				float specularExp{ material.shininess };
+				if constexpr ((Features & ShaderFeature::GlossinessMap) != 0)
+					specularExp *= specularGlossiness.w;
+
+				const Vector4 specular{ Vector4{ specularGlossiness.x, specularGlossiness.y, specularGlossiness.z, 1.f } * std::pow(cosAlpha, specularExp) };
+				color = (textureColor * frame.lightIntensity + specular) * observedArea;
+			}
+			else
+			{
+				color = textureColor * (frame.lightIntensity * observedArea);
+			}
+			return true;
+		}
+
+		template<uint32_t... Features>
+		constexpr std::array<CpuShader::ShadePixelFunction, sizeof...(Features)> MakePermutations(std::integer_sequence<uint32_t, Features...>)
+		{
+			return { &ShadePixel<Features>... };
+		}
+
+		constexpr std::array<CpuShader::ShadePixelFunction, ShaderFeature::NumPermutations> g_Permutations{
+			MakePermutations(std::make_integer_sequence<uint32_t, ShaderFeature::NumPermutations>{}) };
+	}
+
+	CpuShader::ShadePixelFunction CpuShader::GetShadePixel(uint32_t features)
+	{
+		return g_Permutations[features & (ShaderFeature::NumPermutations - 1)];
+	}
+}
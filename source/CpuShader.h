@@ -0,0 +1,31 @@
+#pragma once
+#include "ConstantBlocks.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//The pixel shader of PosCol3D.fx on the CPU, for the software device and --bench-permutations.
+	//Sampling is left to the caller, which batches its samples however suits it.
+	namespace CpuShader
+	{
+		//The interpolated vertex outputs and the texels the shader samples at the pixel's uv
+		struct PixelInput
+		{
+			Vector3 worldPosition{};
+			Vector3 normal{};
+			Vector3 tangent{};
+			Vector4 diffuse{};
+			//Only read with ShaderFeature::NormalMap
+			Vector4 normalMap{};
+			//Glossiness in w, only read with ShaderFeature::SpecularMap
+			Vector4 specularGlossiness{};
+		};
+
+		//Writes the color of the pixel, returns false where the shader clips it
+		using ShadePixelFunction = bool (*)(const PixelInput& input, const FrameConstants& frame, const MaterialConstants& material, Vector4& color);
+
+		//The permutation for a set of ShaderFeature flags, with its switches resolved at compile time
+		ShadePixelFunction GetShadePixel(uint32_t features);
+	}
+}
@@ -0,0 +1,534 @@
+#include "pch.h"
+#include "CpuTexture.h"
+#include "BlockCompression.h"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		//Most probes one sample can take: two levels for each anisotropic probe
+		constexpr uint32_t g_MaxProbesPerSample{ 2 * 16 };
+
+		//One bilinear (or point) lookup into one level, weighted into the sample it belongs to
+		struct Probe
+		{
+			uint32_t sample{};
+			uint32_t level{};
+			float u{};
+			float v{};
+			float weight{};
+		};
+
+		//The level(s) and positions the filter reads for one sample, the same for the scalar and the batched path
+		uint32_t CreateProbes(const SamplerDesc& sampler, uint32_t numLevels, float width, float height,
+			float u, float v, float dudx, float dvdx, float dudy, float dvdy, uint32_t sample, Probe* pProbes)
+		{
+			//Footprint of the pixel in level 0 texels along screen x and y
+			const float lengthX{ std::sqrt(dudx * width * dudx * width + dvdx * height * dvdx * height) };
+			const float lengthY{ std::sqrt(dudy * width * dudy * width + dvdy * height * dvdy * height) };
+			const float longest{ std::max(lengthX, lengthY) };
+			const float maxLevel{ static_cast<float>(numLevels - 1) };
+
+			if (sampler.filter == SamplerFilter::Point)
+			{
+				//Nearest level
+				const float lod{ longest > 0.f ? std::log2(longest) : 0.f };
+				const uint32_t level{ static_cast<uint32_t>(std::clamp(std::floor(lod + 0.5f), 0.f, maxLevel)) };
+				pProbes[0] = Probe{ sample, level, u, v, 1.f };
+				return 1;
+			}
+
+			//Anisotropic: probes spread along the longer axis, each one as wide as the shorter axis
+			uint32_t numTaps{ 1 };
+			float tapU{};
+			float tapV{};
+			if (sampler.filter == SamplerFilter::Anisotropic && longest > 0.f)
+			{
+				const float shortest{ std::min(lengthX, lengthY) };
+				const float maxTaps{ static_cast<float>(std::clamp<uint32_t>(sampler.maxAnisotropy, 1, 16)) };
+				numTaps = static_cast<uint32_t>(shortest > 0.f ? std::min(std::ceil(longest / shortest), maxTaps) : maxTaps);
+				tapU = lengthX >= lengthY ? dudx : dudy;
+				tapV = lengthX >= lengthY ? dvdx : dvdy;
+			}
+
+			//Trilinear: the two levels around the footprint's size, blended
+			const float lod{ longest > 0.f ? std::clamp(std::log2(longest / numTaps), 0.f, maxLevel) : 0.f };
+			const float level{ std::floor(lod) };
+			const float blend{ lod - level };
+			const float tapWeight{ 1.f / numTaps };
+
+			uint32_t numProbes{};
+			for (uint32_t tap{}; tap < numTaps; ++tap)
+			{
+				const float offset{ (tap + 0.5f) / numTaps - 0.5f };
+				const float probeU{ u + tapU * offset };
+				const float probeV{ v + tapV * offset };
+				pProbes[numProbes++] = Probe{ sample, static_cast<uint32_t>(level), probeU, probeV, (1.f - blend) * tapWeight };
+				if (blend > 0.f)
+					pProbes[numProbes++] = Probe{ sample, static_cast<uint32_t>(level) + 1, probeU, probeV, blend * tapWeight };
+			}
+			return numProbes;
+		}
+
+		//Integer texel coordinate (held in a float) to one inside [0, size)
+		float AddressScalar(SamplerAddress address, float coordinate, float size)
+		{
+			switch (address)
+			{
+			case SamplerAddress::Clamp:
+				return std::clamp(coordinate, 0.f, size - 1.f);
+			case SamplerAddress::Mirror:
+			{
+				const float period{ coordinate - std::floor(coordinate / (2.f * size)) * 2.f * size };
+				return period >= size ? 2.f * size - 1.f - period : period;
+			}
+			default:
+				return coordinate - std::floor(coordinate / size) * size;
+			}
+		}
+
+		//Wrap and mirror repeat, so UVs far from [0, 1] are brought back first and keep their precision
+		float ReduceScalar(SamplerAddress address, float uv)
+		{
+			switch (address)
+			{
+			case SamplerAddress::Wrap:
+				return uv - std::floor(uv);
+			case SamplerAddress::Mirror:
+				return uv - 2.f * std::floor(uv * 0.5f);
+			default:
+				return uv;
+			}
+		}
+
+		//floor for values well inside the int32 range, SSE2 only has truncation
+		__m128 Floor(__m128 value)
+		{
+			const __m128 truncated{ _mm_cvtepi32_ps(_mm_cvttps_epi32(value)) };
+			return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.f)));
+		}
+
+		__m128 Address(SamplerAddress address, __m128 coordinate, __m128 size)
+		{
+			const __m128 one{ _mm_set1_ps(1.f) };
+			switch (address)
+			{
+			case SamplerAddress::Clamp:
+				return _mm_min_ps(_mm_max_ps(coordinate, _mm_setzero_ps()), _mm_sub_ps(size, one));
+			case SamplerAddress::Mirror:
+			{
+				const __m128 twice{ _mm_add_ps(size, size) };
+				const __m128 period{ _mm_sub_ps(coordinate, _mm_mul_ps(Floor(_mm_div_ps(coordinate, twice)), twice)) };
+				const __m128 isMirrored{ _mm_cmpge_ps(period, size) };
+				const __m128 mirrored{ _mm_sub_ps(_mm_sub_ps(twice, one), period) };
+				return _mm_or_ps(_mm_and_ps(isMirrored, mirrored), _mm_andnot_ps(isMirrored, period));
+			}
+			default:
+				return _mm_sub_ps(coordinate, _mm_mul_ps(Floor(_mm_div_ps(coordinate, size)), size));
+			}
+		}
+
+		__m128 Reduce(SamplerAddress address, __m128 uv)
+		{
+			switch (address)
+			{
+			case SamplerAddress::Wrap:
+				return _mm_sub_ps(uv, Floor(uv));
+			case SamplerAddress::Mirror:
+				return _mm_sub_ps(uv, _mm_mul_ps(_mm_set1_ps(2.f), Floor(_mm_mul_ps(uv, _mm_set1_ps(0.5f)))));
+			default:
+				return uv;
+			}
+		}
+
+		//Index of a texel inside its tile: the bits of x and y interleaved
+		uint32_t GetMortonIndex(uint32_t x, uint32_t y)
+		{
+			return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2);
+		}
+
+		template<TexelLayout layout>
+		const uint8_t* GetTexelAddress(const TextureLevel& level, uint32_t x, uint32_t y)
+		{
+			const uint8_t* pPixels{ static_cast<const uint8_t*>(level.pPixels) };
+			if constexpr (layout == TexelLayout::Linear)
+				return pPixels + size_t{ y } * level.rowPitch + size_t{ x } * 4;
+			else
+				return pPixels + size_t{ y / TexelTiling::TileSize } * level.rowPitch
+					+ (size_t{ x / TexelTiling::TileSize } * 16 + GetMortonIndex(x, y)) * 4;
+		}
+
+		//Low 32 bits of every lane's product, SSE2 only multiplies the even lanes
+		__m128i Multiply(__m128i a, __m128i b)
+		{
+			const __m128i even{ _mm_mul_epu32(a, b) };
+			const __m128i odd{ _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)) };
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+
+		//In both layouts a texel's byte offset is a part from its column plus a part from its row,
+		//so the 4 texels of a bilinear footprint need two of each
+		template<TexelLayout layout>
+		__m128i GetColumnOffsets(__m128i x)
+		{
+			if constexpr (layout == TexelLayout::Linear)
+				return _mm_slli_epi32(x, 2);
+			else
+			{
+				//The tile, then the bits of x in the Morton index: bit 0 stays, bit 1 moves to bit 2
+				const __m128i tile{ _mm_slli_epi32(_mm_srli_epi32(x, 2), 6) };
+				const __m128i bit0{ _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(1)), 2) };
+				const __m128i bit1{ _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(2)), 3) };
+				return _mm_or_si128(tile, _mm_or_si128(bit0, bit1));
+			}
+		}
+
+		template<TexelLayout layout>
+		__m128i GetRowOffsets(__m128i y, __m128i rowPitch)
+		{
+			if constexpr (layout == TexelLayout::Linear)
+				return Multiply(y, rowPitch);
+			else
+			{
+				//The row of tiles, then the bits of y in the Morton index: bit 0 moves to bit 1, bit 1 to bit 3
+				const __m128i tiles{ Multiply(_mm_srli_epi32(y, 2), rowPitch) };
+				const __m128i bit0{ _mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(1)), 3) };
+				const __m128i bit1{ _mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(2)), 4) };
+				return _mm_or_si128(tiles, _mm_or_si128(bit0, bit1));
+			}
+		}
+
+		//RGBA8 to 4 floats in [0, 1]
+		__m128 LoadTexel(const uint8_t* pTexel)
+		{
+			int32_t texel{};
+			std::memcpy(&texel, pTexel, 4);
+			const __m128i zero{ _mm_setzero_si128() };
+			const __m128i channels{ _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(texel), zero), zero) };
+			return _mm_mul_ps(_mm_cvtepi32_ps(channels), _mm_set1_ps(1.f / 255.f));
+		}
+
+		//The batched sample for one layout, so the texel addressing inlines into the probe loop
+		template<TexelLayout layout>
+		void SampleBatched(const std::vector<TextureLevel>& levels, const SamplerDesc& sampler, const SampleBatch& batch, Vector4 (&colors)[SampleBatch::Size])
+		{
+			//One extra accumulator takes the padding probes of the last group
+			__m128 sums[SampleBatch::Size + 1]{};
+			if (levels.empty())
+			{
+				for (Vector4& color : colors)
+					color = Vector4{ 0.f, 0.f, 0.f, 0.f };
+				return;
+			}
+
+			Probe probes[SampleBatch::Size * g_MaxProbesPerSample + 3]{};
+			uint32_t numProbes{};
+			const float width{ static_cast<float>(levels[0].width) };
+			const float height{ static_cast<float>(levels[0].height) };
+			for (uint32_t i{}; i < SampleBatch::Size; ++i)
+			{
+				numProbes += CreateProbes(sampler, static_cast<uint32_t>(levels.size()), width, height,
+					batch.u[i], batch.v[i], batch.dudx[i], batch.dvdx[i], batch.dudy[i], batch.dvdy[i], i, probes + numProbes);
+			}
+			while (numProbes % 4 != 0)
+				probes[numProbes++] = Probe{ SampleBatch::Size, 0, 0.f, 0.f, 0.f };
+
+			const bool isPoint{ sampler.filter == SamplerFilter::Point };
+			const __m128 one{ _mm_set1_ps(1.f) };
+			for (uint32_t first{}; first < numProbes; first += 4)
+			{
+				const Probe* pGroup{ probes + first };
+				const TextureLevel* pLevels[4]{ &levels[pGroup[0].level], &levels[pGroup[1].level], &levels[pGroup[2].level], &levels[pGroup[3].level] };
+				const uint8_t* pPixels[4]{ static_cast<const uint8_t*>(pLevels[0]->pPixels), static_cast<const uint8_t*>(pLevels[1]->pPixels),
+					static_cast<const uint8_t*>(pLevels[2]->pPixels), static_cast<const uint8_t*>(pLevels[3]->pPixels) };
+				const __m128i rowPitch{ _mm_setr_epi32(pLevels[0]->rowPitch, pLevels[1]->rowPitch, pLevels[2]->rowPitch, pLevels[3]->rowPitch) };
+
+				//Addresses and weights of the 4 probes side by side
+				const __m128 levelWidth{ _mm_setr_ps(static_cast<float>(pLevels[0]->width), static_cast<float>(pLevels[1]->width),
+					static_cast<float>(pLevels[2]->width), static_cast<float>(pLevels[3]->width)) };
+				const __m128 levelHeight{ _mm_setr_ps(static_cast<float>(pLevels[0]->height), static_cast<float>(pLevels[1]->height),
+					static_cast<float>(pLevels[2]->height), static_cast<float>(pLevels[3]->height)) };
+				const __m128 u{ Reduce(sampler.address, _mm_setr_ps(pGroup[0].u, pGroup[1].u, pGroup[2].u, pGroup[3].u)) };
+				const __m128 v{ Reduce(sampler.address, _mm_setr_ps(pGroup[0].v, pGroup[1].v, pGroup[2].v, pGroup[3].v)) };
+				const __m128 weight{ _mm_setr_ps(pGroup[0].weight, pGroup[1].weight, pGroup[2].weight, pGroup[3].weight) };
+
+				if (isPoint)
+				{
+					const __m128i x{ _mm_cvttps_epi32(Address(sampler.address, Floor(_mm_mul_ps(u, levelWidth)), levelWidth)) };
+					const __m128i y{ _mm_cvttps_epi32(Address(sampler.address, Floor(_mm_mul_ps(v, levelHeight)), levelHeight)) };
+					alignas(16) uint32_t offsets[4]{};
+					alignas(16) float weights[4]{};
+					_mm_store_si128(reinterpret_cast<__m128i*>(offsets), _mm_add_epi32(GetColumnOffsets<layout>(x), GetRowOffsets<layout>(y, rowPitch)));
+					_mm_store_ps(weights, weight);
+
+					for (uint32_t i{}; i < 4; ++i)
+						sums[pGroup[i].sample] = _mm_add_ps(sums[pGroup[i].sample], _mm_mul_ps(LoadTexel(pPixels[i] + offsets[i]), _mm_set1_ps(weights[i])));
+					continue;
+				}
+
+				const __m128 half{ _mm_set1_ps(0.5f) };
+				const __m128 x{ _mm_sub_ps(_mm_mul_ps(u, levelWidth), half) };
+				const __m128 y{ _mm_sub_ps(_mm_mul_ps(v, levelHeight), half) };
+				const __m128 x0{ Floor(x) };
+				const __m128 y0{ Floor(y) };
+				const __m128 fractionX{ _mm_sub_ps(x, x0) };
+				const __m128 fractionY{ _mm_sub_ps(y, y0) };
+
+				alignas(16) uint32_t left[4]{};
+				alignas(16) uint32_t right[4]{};
+				alignas(16) uint32_t top[4]{};
+				alignas(16) uint32_t bottom[4]{};
+				_mm_store_si128(reinterpret_cast<__m128i*>(left), GetColumnOffsets<layout>(_mm_cvttps_epi32(Address(sampler.address, x0, levelWidth))));
+				_mm_store_si128(reinterpret_cast<__m128i*>(right), GetColumnOffsets<layout>(_mm_cvttps_epi32(Address(sampler.address, _mm_add_ps(x0, one), levelWidth))));
+				_mm_store_si128(reinterpret_cast<__m128i*>(top), GetRowOffsets<layout>(_mm_cvttps_epi32(Address(sampler.address, y0, levelHeight)), rowPitch));
+				_mm_store_si128(reinterpret_cast<__m128i*>(bottom), GetRowOffsets<layout>(_mm_cvttps_epi32(Address(sampler.address, _mm_add_ps(y0, one), levelHeight)), rowPitch));
+
+				//Same products in the same order as the scalar path
+				const __m128 inverseX{ _mm_sub_ps(one, fractionX) };
+				const __m128 inverseY{ _mm_sub_ps(one, fractionY) };
+				alignas(16) float weights[4][4]{};
+				_mm_store_ps(weights[0], _mm_mul_ps(_mm_mul_ps(inverseX, inverseY), weight));
+				_mm_store_ps(weights[1], _mm_mul_ps(_mm_mul_ps(fractionX, inverseY), weight));
+				_mm_store_ps(weights[2], _mm_mul_ps(_mm_mul_ps(inverseX, fractionY), weight));
+				_mm_store_ps(weights[3], _mm_mul_ps(_mm_mul_ps(fractionX, fractionY), weight));
+
+				for (uint32_t i{}; i < 4; ++i)
+				{
+					const uint8_t* pTop{ pPixels[i] + top[i] };
+					const uint8_t* pBottom{ pPixels[i] + bottom[i] };
+					__m128 sum{ sums[pGroup[i].sample] };
+					sum = _mm_add_ps(sum, _mm_mul_ps(LoadTexel(pTop + left[i]), _mm_set1_ps(weights[0][i])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(LoadTexel(pTop + right[i]), _mm_set1_ps(weights[1][i])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(LoadTexel(pBottom + left[i]), _mm_set1_ps(weights[2][i])));
+					sum = _mm_add_ps(sum, _mm_mul_ps(LoadTexel(pBottom + right[i]), _mm_set1_ps(weights[3][i])));
+					sums[pGroup[i].sample] = sum;
+				}
+			}
+
+			for (uint32_t i{}; i < SampleBatch::Size; ++i)
+			{
+				alignas(16) float color[4]{};
+				_mm_store_ps(color, sums[i]);
+				colors[i] = Vector4{ color[0], color[1], color[2], color[3] };
+			}
+		}
+	}
+
+	uint32_t TexelTiling::GetTileRowPitch(uint32_t width)
+	{
+		return (width + TileSize - 1) / TileSize * TileSize * TileSize * 4;
+	}
+
+	size_t TexelTiling::GetTiledSize(uint32_t width, uint32_t height)
+	{
+		return size_t{ GetTileRowPitch(width) } * ((height + TileSize - 1) / TileSize);
+	}
+
+	void TexelTiling::Tile(const uint8_t* pSource, uint32_t width, uint32_t height, uint32_t rowPitch, uint8_t* pTiles)
+	{
+		const uint32_t tileRowPitch{ GetTileRowPitch(width) };
+		for (uint32_t tileY{}; tileY < height; tileY += TileSize)
+		{
+			uint8_t* pTarget{ pTiles + size_t{ tileY / TileSize } * tileRowPitch };
+			const uint8_t* pRows[TileSize]{};
+			for (uint32_t row{}; row < TileSize; ++row)
+				pRows[row] = pSource + size_t{ std::min(tileY + row, height - 1) } * rowPitch;
+
+			//Morton order is 2x2 quads: the first two hold x 0-1 and x 2-3 of rows 0 and 1, the last two those of rows 2 and 3
+			uint32_t tileX{};
+			for (; tileX + TileSize <= width; tileX += TileSize, pTarget += 64)
+			{
+				const __m128i row0{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRows[0] + tileX * 4)) };
+				const __m128i row1{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRows[1] + tileX * 4)) };
+				const __m128i row2{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRows[2] + tileX * 4)) };
+				const __m128i row3{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRows[3] + tileX * 4)) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget), _mm_unpacklo_epi64(row0, row1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + 16), _mm_unpackhi_epi64(row0, row1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + 32), _mm_unpacklo_epi64(row2, row3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + 48), _mm_unpackhi_epi64(row2, row3));
+			}
+
+			//A partial tile at the right edge
+			for (; tileX < width; tileX += TileSize, pTarget += 64)
+			{
+				for (uint32_t y{}; y < TileSize; ++y)
+					for (uint32_t x{}; x < TileSize; ++x)
+						std::memcpy(pTarget + GetMortonIndex(x, y) * 4, pRows[y] + std::min(tileX + x, width - 1) * 4, 4);
+			}
+		}
+	}
+
+	void TexelTiling::Untile(const uint8_t* pTiles, uint32_t width, uint32_t height, uint8_t* pTarget, uint32_t rowPitch)
+	{
+		const uint32_t tileRowPitch{ GetTileRowPitch(width) };
+		for (uint32_t tileY{}; tileY < height; tileY += TileSize)
+		{
+			const uint8_t* pSource{ pTiles + size_t{ tileY / TileSize } * tileRowPitch };
+			const uint32_t numRows{ std::min(TileSize, height - tileY) };
+			uint8_t* pRows[TileSize]{};
+			for (uint32_t row{}; row < numRows; ++row)
+				pRows[row] = pTarget + size_t{ tileY + row } * rowPitch;
+
+			uint32_t tileX{};
+			for (; numRows == TileSize && tileX + TileSize <= width; tileX += TileSize, pSource += 64)
+			{
+				const __m128i quad0{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource)) };
+				const __m128i quad1{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + 16)) };
+				const __m128i quad2{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + 32)) };
+				const __m128i quad3{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + 48)) };
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRows[0] + tileX * 4), _mm_unpacklo_epi64(quad0, quad1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRows[1] + tileX * 4), _mm_unpackhi_epi64(quad0, quad1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRows[2] + tileX * 4), _mm_unpacklo_epi64(quad2, quad3));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRows[3] + tileX * 4), _mm_unpackhi_epi64(quad2, quad3));
+			}
+
+			//Partial tiles, only the texels inside the level are written
+			for (; tileX < width; tileX += TileSize, pSource += 64)
+			{
+				for (uint32_t y{}; y < numRows; ++y)
+					for (uint32_t x{}; x < std::min(TileSize, width - tileX); ++x)
+						std::memcpy(pRows[y] + (tileX + x) * 4, pSource + GetMortonIndex(x, y) * 4, 4);
+			}
+		}
+	}
+
+	CpuTexture::CpuTexture(const MipChain& chain, JobSystem* pJobs, TexelLayout layout)
+		:m_Layout{ layout }
+	{
+		MipChain decoded{};
+		if (chain.format != TextureFormat::Rgba8)
+			BlockCompression::Decompress(chain, decoded, pJobs);
+		const MipChain& rgba{ chain.format == TextureFormat::Rgba8 ? chain : decoded };
+
+		if (layout == TexelLayout::Linear)
+		{
+			m_Texels = rgba.pixels;
+			for (const MipChain::Level& level : rgba.levels)
+				m_Levels.push_back(TextureLevel{ m_Texels.data() + level.offset, level.width, level.height, level.width * 4 });
+			return;
+		}
+
+		//Every level tiled on its own, one after the other
+		std::vector<size_t> offsets{};
+		size_t size{};
+		for (const MipChain::Level& level : rgba.levels)
+		{
+			offsets.push_back(size);
+			size += TexelTiling::GetTiledSize(level.width, level.height);
+		}
+
+		m_Texels.resize(size);
+		for (uint32_t level{}; level < rgba.levels.size(); ++level)
+		{
+			const TextureLevel source{ rgba.GetLevel(level) };
+			TexelTiling::Tile(static_cast<const uint8_t*>(source.pPixels), source.width, source.height, source.rowPitch, m_Texels.data() + offsets[level]);
+			m_Levels.push_back(TextureLevel{ m_Texels.data() + offsets[level], source.width, source.height, TexelTiling::GetTileRowPitch(source.width) });
+		}
+	}
+
+	CpuTexture* CpuTexture::Load(const std::vector<ChannelSource>& sources, const TextureSettings& settings, JobSystem* pJobs, TextureCache* pCache, TexelLayout layout)
+	{
+		MipChain chain{};
+		if (!Texture::LoadChain(sources, settings, chain, pJobs, pCache))
+			return nullptr;
+		return new CpuTexture{ chain, pJobs, layout };
+	}
+
+	uint32_t CpuTexture::GetWidth() const
+	{
+		return m_Levels.empty() ? 0 : m_Levels[0].width;
+	}
+
+	uint32_t CpuTexture::GetHeight() const
+	{
+		return m_Levels.empty() ? 0 : m_Levels[0].height;
+	}
+
+	uint32_t CpuTexture::GetNumLevels() const
+	{
+		return static_cast<uint32_t>(m_Levels.size());
+	}
+
+	TexelLayout CpuTexture::GetLayout() const
+	{
+		return m_Layout;
+	}
+
+	Vector4 CpuTexture::GetTexel(uint32_t level, uint32_t x, uint32_t y) const
+	{
+		const uint8_t* pTexel{ m_Layout == TexelLayout::Tiled ? GetTexelAddress<TexelLayout::Tiled>(m_Levels[level], x, y)
+			: GetTexelAddress<TexelLayout::Linear>(m_Levels[level], x, y) };
+		return Vector4{ pTexel[0] / 255.f, pTexel[1] / 255.f, pTexel[2] / 255.f, pTexel[3] / 255.f };
+	}
+
+	void CpuTexture::CopyLevel(uint32_t level, uint8_t* pTarget, uint32_t rowPitch) const
+	{
+		const TextureLevel& source{ m_Levels[level] };
+		if (m_Layout == TexelLayout::Tiled)
+		{
+			TexelTiling::Untile(static_cast<const uint8_t*>(source.pPixels), source.width, source.height, pTarget, rowPitch);
+			return;
+		}
+
+		for (uint32_t y{}; y < source.height; ++y)
+			std::memcpy(pTarget + size_t{ y } * rowPitch, static_cast<const uint8_t*>(source.pPixels) + size_t{ y } * source.rowPitch, size_t{ source.width } * 4);
+	}
+
+	Vector4 CpuTexture::Sample(const SamplerDesc& sampler, const Vector2& uv, const Vector2& ddx, const Vector2& ddy) const
+	{
+		Vector4 color{ 0.f, 0.f, 0.f, 0.f };
+		if (m_Levels.empty())
+			return color;
+
+		Probe probes[g_MaxProbesPerSample]{};
+		const uint32_t numProbes{ CreateProbes(sampler, GetNumLevels(), static_cast<float>(GetWidth()), static_cast<float>(GetHeight()),
+			uv.x, uv.y, ddx.x, ddx.y, ddy.x, ddy.y, 0, probes) };
+
+		for (uint32_t i{}; i < numProbes; ++i)
+		{
+			const Probe& probe{ probes[i] };
+			const float width{ static_cast<float>(m_Levels[probe.level].width) };
+			const float height{ static_cast<float>(m_Levels[probe.level].height) };
+			const float u{ ReduceScalar(sampler.address, probe.u) };
+			const float v{ ReduceScalar(sampler.address, probe.v) };
+
+			if (sampler.filter == SamplerFilter::Point)
+			{
+				const float x{ AddressScalar(sampler.address, std::floor(u * width), width) };
+				const float y{ AddressScalar(sampler.address, std::floor(v * height), height) };
+				color += GetTexel(probe.level, static_cast<uint32_t>(x), static_cast<uint32_t>(y)) * probe.weight;
+				continue;
+			}
+
+			//Texel centers sit at half coordinates, the four around the position weighted by how close they are
+			const float x{ u * width - 0.5f };
+			const float y{ v * height - 0.5f };
+			const float x0{ std::floor(x) };
+			const float y0{ std::floor(y) };
+			const float fractionX{ x - x0 };
+			const float fractionY{ y - y0 };
+			const uint32_t left{ static_cast<uint32_t>(AddressScalar(sampler.address, x0, width)) };
+			const uint32_t right{ static_cast<uint32_t>(AddressScalar(sampler.address, x0 + 1.f, width)) };
+			const uint32_t top{ static_cast<uint32_t>(AddressScalar(sampler.address, y0, height)) };
+			const uint32_t bottom{ static_cast<uint32_t>(AddressScalar(sampler.address, y0 + 1.f, height)) };
+
+			color += GetTexel(probe.level, left, top) * ((1.f - fractionX) * (1.f - fractionY) * probe.weight);
+			color += GetTexel(probe.level, right, top) * (fractionX * (1.f - fractionY) * probe.weight);
+			color += GetTexel(probe.level, left, bottom) * ((1.f - fractionX) * fractionY * probe.weight);
+			color += GetTexel(probe.level, right, bottom) * (fractionX * fractionY * probe.weight);
+		}
+		return color;
+	}
+
+	void CpuTexture::Sample(const SamplerDesc& sampler, const SampleBatch& batch, Vector4 (&colors)[SampleBatch::Size]) const
+	{
+		if (m_Layout == TexelLayout::Tiled)
+			SampleBatched<TexelLayout::Tiled>(m_Levels, sampler, batch, colors);
+		else
+			SampleBatched<TexelLayout::Linear>(m_Levels, sampler, batch, colors);
+	}
+}
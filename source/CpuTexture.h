@@ -0,0 +1,88 @@
+#pragma once
+#include "Texture.h"
+
+namespace dae
+{
+	class JobSystem;
+	class TextureCache;
+
+	//How a CpuTexture keeps its texels in memory
+	enum class TexelLayout
+	{
+		//Rows one after the other, like the chain it came from
+		Linear,
+		//4x4 tiles of 64 bytes (one cache line), tiles row after row, the texels in a tile in Morton order.
+		//A bilinear footprint, or a walk across the texture in any direction, touches far fewer lines than rows apart,
+		//but the extra address math outweighs that on textures that stay in cache (--bench-tiling), so it's opt-in.
+		Tiled
+	};
+
+	//Conversion between rows of RGBA8 texels and 4x4 tiles. Whole tiles are moved with SSE2, 4 rows of 4 texels at a time.
+	namespace TexelTiling
+	{
+		constexpr uint32_t TileSize{ 4 };
+
+		//Bytes between two rows of tiles, and of a whole level: the size rounded up to whole tiles
+		uint32_t GetTileRowPitch(uint32_t width);
+		size_t GetTiledSize(uint32_t width, uint32_t height);
+		//Texels of the last tiles that are past the edge repeat the edge, they are never sampled
+		void Tile(const uint8_t* pSource, uint32_t width, uint32_t height, uint32_t rowPitch, uint8_t* pTiles);
+		void Untile(const uint8_t* pTiles, uint32_t width, uint32_t height, uint8_t* pTarget, uint32_t rowPitch);
+	}
+
+	//8 samples, structure of arrays. The derivatives are the UV's change per pixel along screen x and y,
+	//they pick the mip level and the anisotropy. Zero derivatives sample the top level.
+	struct SampleBatch
+	{
+		static constexpr uint32_t Size{ 8 };
+
+		float u[Size]{};
+		float v[Size]{};
+		float dudx[Size]{};
+		float dvdx[Size]{};
+		float dudy[Size]{};
+		float dvdy[Size]{};
+	};
+
+	//A texture with every mip level as RGBA8 in memory, sampled the way the device samples with a SamplerDesc:
+	//point (nearest level), linear (trilinear) or anisotropic (up to maxAnisotropy trilinear probes along the longer axis
+	//of the pixel's footprint), with the sampler's addressing. Device textures keep no CPU copy, this is for baking,
+	//picking by alpha and reference renders. Channels come back in [0, 1], as stored (no sRGB decoding).
+	class CpuTexture final
+	{
+	public:
+		//Block compressed chains are decoded, with a job system level by level on its threads
+		explicit CpuTexture(const MipChain& chain, JobSystem* pJobs = nullptr, TexelLayout layout = TexelLayout::Linear);
+		~CpuTexture() = default;
+
+		// rule of 5 copypasta
+		CpuTexture(const CpuTexture& other) = delete;
+		CpuTexture(CpuTexture&& other) = delete;
+		CpuTexture& operator=(const CpuTexture& other) = delete;
+		CpuTexture& operator=(CpuTexture&& other) = delete;
+
+		//The chain Texture::LoadChain builds, nullptr if an image can't be loaded
+		static CpuTexture* Load(const std::vector<ChannelSource>& sources, const TextureSettings& settings,
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr, TexelLayout layout = TexelLayout::Linear);
+
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		uint32_t GetNumLevels() const;
+		TexelLayout GetLayout() const;
+		Vector4 GetTexel(uint32_t level, uint32_t x, uint32_t y) const;
+		//The level as rows of RGBA8 texels, whatever the layout
+		void CopyLevel(uint32_t level, uint8_t* pTarget, uint32_t rowPitch) const;
+
+		//One sample, plain scalar code: the reference the batched version is checked against
+		Vector4 Sample(const SamplerDesc& sampler, const Vector2& uv, const Vector2& ddx = {}, const Vector2& ddy = {}) const;
+		//SampleBatch::Size samples. Every sample becomes one or more bilinear (or point) probes,
+		//texel addresses and weights are computed for 4 probes at a time with SSE, the texels blended as RGBA vectors.
+		void Sample(const SamplerDesc& sampler, const SampleBatch& batch, Vector4 (&colors)[SampleBatch::Size]) const;
+
+	private:
+		TexelLayout m_Layout{ TexelLayout::Linear };
+		std::vector<uint8_t> m_Texels{};
+		//Tiled levels have a rowPitch of one row of tiles
+		std::vector<TextureLevel> m_Levels{};
+	};
+}
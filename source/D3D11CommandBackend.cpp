@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "D3D11CommandBackend.h"
+#include "Effect.h"
+
+namespace dae
+{
+	namespace
+	{
+		D3D11_PRIMITIVE_TOPOLOGY ToD3D11(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case PrimitiveTopology::TriangleList:
+			default:
+				return D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+			}
+		}
+	}
+
+	D3D11CommandBackend::D3D11CommandBackend(ID3D11DeviceContext1* pDeviceContext)
+		:m_pDeviceContext{ pDeviceContext }
+	{
+	}
+
+	void D3D11CommandBackend::SetConstantRing(ID3D11Buffer* pBuffer)
+	{
+		m_pConstantRing = pBuffer;
+	}
+
+	void D3D11CommandBackend::Submit(const CommandBuffer& buffer)
+	{
+		for (const Command& command : buffer.GetCommands())
+		{
+			switch (command.type)
+			{
+			case CommandType::SetPrimitiveTopology:
+				m_pDeviceContext->IASetPrimitiveTopology(ToD3D11(command.setPrimitiveTopology.topology));
+				break;
+			case CommandType::SetInputLayout:
+				m_pDeviceContext->IASetInputLayout(FromHandle<ID3D11InputLayout>(command.setInputLayout.layout));
+				break;
+			case CommandType::SetVertexBuffer:
+			{
+				ID3D11Buffer* pBuffer{ FromHandle<ID3D11Buffer>(command.setVertexBuffer.buffer) };
+				const UINT stride{ command.setVertexBuffer.stride };
+				const UINT offset{ command.setVertexBuffer.offset };
+				m_pDeviceContext->IASetVertexBuffers(0, 1, &pBuffer, &stride, &offset);
+				break;
+			}
+			case CommandType::SetIndexBuffer:
+				m_pDeviceContext->IASetIndexBuffer(FromHandle<ID3D11Buffer>(command.setIndexBuffer.buffer), DXGI_FORMAT_R32_UINT, 0);
+				break;
+			case CommandType::SetConstants:
+			{
+				//Offset and size are in shader constants of 16 bytes, ApplyPass bound the effect's own buffer to this slot before
+				const UINT slot{ static_cast<UINT>(command.setConstants.slot) };
+				const UINT firstConstant{ command.setConstants.offset / 16 };
+				const UINT numConstants{ command.setConstants.size / 16 };
+				m_pDeviceContext->VSSetConstantBuffers1(slot, 1, &m_pConstantRing, &firstConstant, &numConstants);
+				m_pDeviceContext->PSSetConstantBuffers1(slot, 1, &m_pConstantRing, &firstConstant, &numConstants);
+				break;
+			}
+			case CommandType::ApplyPass:
+				FromHandle<Effect>(command.applyPass.effect)->Apply(command.applyPass.pass, m_pDeviceContext);
+				break;
+			case CommandType::DrawIndexed:
+				m_pDeviceContext->DrawIndexed(command.drawIndexed.indexCount, command.drawIndexed.startIndex, command.drawIndexed.baseVertex);
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "CommandBuffer.h"
+
+namespace dae
+{
+	class Effect;
+
+	//Handles handed out for D3D11 objects are the object pointers themselves
+	inline BufferHandle ToHandle(ID3D11Buffer* pBuffer) { return static_cast<BufferHandle>(reinterpret_cast<uintptr_t>(pBuffer)); }
+	inline InputLayoutHandle ToHandle(ID3D11InputLayout* pLayout) { return static_cast<InputLayoutHandle>(reinterpret_cast<uintptr_t>(pLayout)); }
+	inline EffectHandle ToHandle(Effect* pEffect) { return static_cast<EffectHandle>(reinterpret_cast<uintptr_t>(pEffect)); }
+	inline TextureHandle ToHandle(ID3D11ShaderResourceView* pSRV) { return static_cast<TextureHandle>(reinterpret_cast<uintptr_t>(pSRV)); }
+	inline SamplerHandle ToHandle(ID3D11SamplerState* pSampler) { return static_cast<SamplerHandle>(reinterpret_cast<uintptr_t>(pSampler)); }
+
+	template<typename T, typename Handle>
+	T* FromHandle(Handle handle)
+	{
+		return reinterpret_cast<T*>(static_cast<uintptr_t>(handle));
+	}
+
+	//Replays command buffers onto a device context, only ever used from the thread that owns the context
+	class D3D11CommandBackend final : public CommandBackend
+	{
+	public:
+		explicit D3D11CommandBackend(ID3D11DeviceContext1* pDeviceContext);
+		virtual ~D3D11CommandBackend() = default;
+
+		// rule of 5 copypasta
+		D3D11CommandBackend(const D3D11CommandBackend& other) = delete;
+		D3D11CommandBackend(D3D11CommandBackend&& other) = delete;
+		D3D11CommandBackend& operator=(const D3D11CommandBackend& other) = delete;
+		D3D11CommandBackend& operator=(D3D11CommandBackend&& other) = delete;
+
+		virtual void Submit(const CommandBuffer& buffer) override;
+
+		//Buffer SetConstants offsets point into, changes when the device grows its constant ring
+		void SetConstantRing(ID3D11Buffer* pBuffer);
+
+	private:
+		ID3D11DeviceContext1* m_pDeviceContext{ nullptr };
+		ID3D11Buffer* m_pConstantRing{ nullptr };
+	};
+}
@@ -0,0 +1,564 @@
+#include "pch.h"
+#include "D3D11Device.h"
+#include "EffectShaded.h"
+#include "EffectTransparent.h"
+#include "EffectCache.h"
+
+#include <chrono>
+
+namespace dae
+{
+	namespace
+	{
+		D3D11_FILTER ToD3D11(SamplerFilter filter)
+		{
+			switch (filter)
+			{
+			case SamplerFilter::Linear:
+				return D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+			case SamplerFilter::Anisotropic:
+				return D3D11_FILTER_ANISOTROPIC;
+			case SamplerFilter::Point:
+			default:
+				return D3D11_FILTER_MIN_MAG_MIP_POINT;
+			}
+		}
+
+		D3D11_TEXTURE_ADDRESS_MODE ToD3D11(SamplerAddress address)
+		{
+			switch (address)
+			{
+			case SamplerAddress::Mirror:
+				return D3D11_TEXTURE_ADDRESS_MIRROR;
+			case SamplerAddress::Clamp:
+				return D3D11_TEXTURE_ADDRESS_CLAMP;
+			case SamplerAddress::Wrap:
+			default:
+				return D3D11_TEXTURE_ADDRESS_WRAP;
+			}
+		}
+	}
+
+	D3D11Device::D3D11Device(SDL_Window* pWindow, bool isEffectCacheEnabled)
+	{
+		if (isEffectCacheEnabled)
+			m_pEffectCache = new EffectCache{ "Resources/Cache" };
+
+		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+
+		//Initialize DirectX pipeline
+		const HRESULT result = InitializeDirectX(pWindow);
+		if (result == S_OK)
+		{
+			m_IsInitialized = true;
+			std::cout << "DirectX is initialized and ready!\n";
+		}
+		else
+		{
+			std::cout << "DirectX initialization failed!\n";
+		}
+
+		m_pCommandBackend = new D3D11CommandBackend{ m_pDeviceContext1 };
+		m_pCommandBackend->SetConstantRing(m_pConstantRing);
+	}
+
+	D3D11Device::~D3D11Device()
+	{
+		delete m_pCommandBackend;
+		delete m_pEffectCache;
+
+		if (m_pConstantRing) m_pConstantRing->Release();
+
+		if (m_pRenderTargetView) m_pRenderTargetView->Release();
+		if (m_pRenderTargetBuffer) m_pRenderTargetBuffer->Release();
+
+		if (m_pDepthStencilView) m_pDepthStencilView->Release();
+		if (m_pDepthStencilBuffer) m_pDepthStencilBuffer->Release();
+
+		if (m_pSwapChain) m_pSwapChain->Release();
+
+		if (m_pDeviceContext1) m_pDeviceContext1->Release();
+		if (m_pDeviceContext)
+		{
+			m_pDeviceContext->ClearState();
+			m_pDeviceContext->Flush();
+			m_pDeviceContext->Release();
+		}
+		if (m_pDevice) m_pDevice->Release();
+	}
+
+	bool D3D11Device::IsInitialized() const
+	{
+		return m_IsInitialized;
+	}
+
+	BufferHandle D3D11Device::CreateVertexBuffer(const void* pVertices, uint32_t byteSize)
+	{
+		D3D11_BUFFER_DESC bd{};
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = byteSize;
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bd.CPUAccessFlags = 0;
+		bd.MiscFlags = 0;
+
+		D3D11_SUBRESOURCE_DATA initData = {};
+		initData.pSysMem = pVertices;
+
+		ID3D11Buffer* pBuffer{ nullptr };
+		const HRESULT result = m_pDevice->CreateBuffer(&bd, &initData, &pBuffer);
+		if (FAILED(result))
+			return BufferHandle::Invalid;
+
+		return ToHandle(pBuffer);
+	}
+
+	BufferHandle D3D11Device::CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices)
+	{
+		D3D11_BUFFER_DESC bd{};
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = sizeof(uint32_t) * numIndices;
+		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		bd.CPUAccessFlags = 0;
+		bd.MiscFlags = 0;
+
+		D3D11_SUBRESOURCE_DATA initData = {};
+		initData.pSysMem = pIndices;
+
+		ID3D11Buffer* pBuffer{ nullptr };
+		const HRESULT result = m_pDevice->CreateBuffer(&bd, &initData, &pBuffer);
+		if (FAILED(result))
+			return BufferHandle::Invalid;
+
+		return ToHandle(pBuffer);
+	}
+
+	TextureHandle D3D11Device::CreateTexture(TextureFormat textureFormat, const TextureLevel* pLevels, uint32_t numLevels)
+	{
+		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		switch (textureFormat)
+		{
+		case TextureFormat::Rgba8:
+			break;
+		case TextureFormat::Bc1:
+			format = DXGI_FORMAT_BC1_UNORM;
+			break;
+		case TextureFormat::Bc3:
+			format = DXGI_FORMAT_BC3_UNORM;
+			break;
+		case TextureFormat::Bc4:
+			format = DXGI_FORMAT_BC4_UNORM;
+			break;
+		case TextureFormat::Bc5:
+			format = DXGI_FORMAT_BC5_UNORM;
+			break;
+		case TextureFormat::Bc7:
+			format = DXGI_FORMAT_BC7_UNORM;
+			break;
+		}
+
+		D3D11_TEXTURE2D_DESC desc{};
+		desc.Width = pLevels[0].width;
+		desc.Height = pLevels[0].height;
+		desc.MipLevels = numLevels;
+		desc.ArraySize = 1;
+		desc.Format = format;
+		desc.SampleDesc.Count = 1;
+		desc.SampleDesc.Quality = 0;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		desc.CPUAccessFlags = 0;
+		desc.MiscFlags = 0;
+
+		//Every level is uploaded with the texture, immutable from then on
+		std::vector<D3D11_SUBRESOURCE_DATA> initData(numLevels);
+		for (uint32_t level{}; level < numLevels; ++level)
+		{
+			initData[level].pSysMem = pLevels[level].pPixels;
+			initData[level].SysMemPitch = static_cast<UINT>(pLevels[level].rowPitch);
+			initData[level].SysMemSlicePitch = static_cast<UINT>(GetNumRows(textureFormat, pLevels[level].height) * pLevels[level].rowPitch);
+		}
+
+		ID3D11Texture2D* pResource{ nullptr };
+		HRESULT hr = m_pDevice->CreateTexture2D(&desc, initData.data(), &pResource);
+		if (FAILED(hr))
+		{
+			std::cout << "Failed to load Texture\n";
+			return TextureHandle::Invalid;
+		}
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
+		SRVDesc.Format = format;
+		SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		SRVDesc.Texture2D.MipLevels = numLevels;
+
+		//The view keeps the resource alive, the handle is the view
+		ID3D11ShaderResourceView* pSRV{ nullptr };
+		hr = m_pDevice->CreateShaderResourceView(pResource, &SRVDesc, &pSRV);
+		pResource->Release();
+
+		if (FAILED(hr))
+		{
+			std::cout << "Failed to load ShaderResourceView\n";
+			return TextureHandle::Invalid;
+		}
+
+		return ToHandle(pSRV);
+	}
+
+	EffectHandle D3D11Device::CreateEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines)
+	{
+		const auto start{ std::chrono::high_resolution_clock::now() };
+
+		Effect* pEffect{ nullptr };
+		switch (type)
+		{
+		case EffectType::Shaded:
+			pEffect = new EffectShaded{ m_pDevice, assetFile, defines, m_pEffectCache };
+			break;
+		case EffectType::Transparent:
+			pEffect = new EffectTransparent{ m_pDevice, assetFile, defines, m_pEffectCache };
+			break;
+		}
+
+		if (!pEffect->AreConstantsValid())
+		{
+			std::wcout << assetFile << L": constant blocks don't match ConstantBlocks.h\n";
+			delete pEffect;
+			return EffectHandle::Invalid;
+		}
+
+		//One line per effect so the startup cost with and without the cache can be compared
+		const float ms{ std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() };
+		const wchar_t* pSource{ !m_pEffectCache ? L"compiled, cache disabled" : pEffect->IsLoadedFromCache() ? L"cache hit" : L"compiled" };
+		std::wstringstream ss;
+		ss << assetFile;
+		for (const EffectDefine& define : defines)
+			ss << L" " << std::wstring(define.name.begin(), define.name.end()) << L"=" << std::wstring(define.value.begin(), define.value.end());
+		ss << L": " << ms << L" ms (" << pSource << L")";
+
+		uint32_t numInstructions{};
+		uint32_t numTextureSamples{};
+		if (pEffect->GetPixelShaderStats(numInstructions, numTextureSamples))
+			ss << L", pixel shader " << numInstructions << L" instructions, " << numTextureSamples << L" samples";
+		ss << L"\n";
+		std::wcout << ss.str();
+
+		return ToHandle(pEffect);
+	}
+
+	InputLayoutHandle D3D11Device::CreateInputLayout(EffectHandle effect)
+	{
+		return ToHandle(FromHandle<Effect>(effect)->LoadInputLayout(m_pDevice));
+	}
+
+	SamplerHandle D3D11Device::CreateSampler(const SamplerDesc& desc)
+	{
+		// Create the SampleState description
+		D3D11_SAMPLER_DESC sampleDesc{};
+		sampleDesc.AddressU = ToD3D11(desc.address);
+		sampleDesc.AddressV = ToD3D11(desc.address);
+		sampleDesc.AddressW = ToD3D11(desc.address);
+		sampleDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+		sampleDesc.MipLODBias = 0;
+		sampleDesc.MinLOD = 0;
+		sampleDesc.MaxLOD = D3D11_FLOAT32_MAX;
+		sampleDesc.MaxAnisotropy = desc.maxAnisotropy;
+		sampleDesc.Filter = ToD3D11(desc.filter);
+
+		ID3D11SamplerState* pSamplerState{ nullptr };
+		HRESULT result{ m_pDevice->CreateSamplerState(&sampleDesc, &pSamplerState) };
+		if (FAILED(result))
+		{
+			std::cout << "m_pSamplerState failed to load\n";
+			return SamplerHandle::Invalid;
+		}
+
+		return ToHandle(pSamplerState);
+	}
+
+	uint32_t D3D11Device::GetNumPasses(EffectHandle effect) const
+	{
+		D3DX11_TECHNIQUE_DESC techDesc{};
+		FromHandle<Effect>(effect)->GetTechnique()->GetDesc(&techDesc);
+		return techDesc.Passes;
+	}
+
+	void D3D11Device::Release(BufferHandle buffer)
+	{
+		if (ID3D11Buffer* pBuffer{ FromHandle<ID3D11Buffer>(buffer) }) pBuffer->Release();
+	}
+
+	void D3D11Device::Release(TextureHandle texture)
+	{
+		if (ID3D11ShaderResourceView* pSRV{ FromHandle<ID3D11ShaderResourceView>(texture) }) pSRV->Release();
+	}
+
+	void D3D11Device::Release(EffectHandle effect)
+	{
+		delete FromHandle<Effect>(effect);
+	}
+
+	void D3D11Device::Release(InputLayoutHandle layout)
+	{
+		if (ID3D11InputLayout* pLayout{ FromHandle<ID3D11InputLayout>(layout) }) pLayout->Release();
+	}
+
+	void D3D11Device::Release(SamplerHandle sampler)
+	{
+		if (ID3D11SamplerState* pSampler{ FromHandle<ID3D11SamplerState>(sampler) }) pSampler->Release();
+	}
+
+	void D3D11Device::SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture)
+	{
+		Effect* pEffect{ FromHandle<Effect>(effect) };
+		ID3D11ShaderResourceView* pSRV{ FromHandle<ID3D11ShaderResourceView>(texture) };
+		switch (slot)
+		{
+		case TextureSlot::Diffuse:
+			pEffect->SetDiffuseMap(pSRV);
+			break;
+		case TextureSlot::Normal:
+			pEffect->SetNormalMap(pSRV);
+			break;
+		case TextureSlot::Specular:
+			pEffect->SetSpecularMap(pSRV);
+			break;
+		}
+	}
+
+	void D3D11Device::SetSampler(EffectHandle effect, SamplerHandle sampler)
+	{
+		FromHandle<Effect>(effect)->SetSampleState(FromHandle<ID3D11SamplerState>(sampler));
+	}
+
+	void D3D11Device::SetMaterial(EffectHandle effect, const MaterialConstants& material)
+	{
+		FromHandle<Effect>(effect)->SetMaterial(material);
+	}
+
+	void D3D11Device::BeginFrame(const ColorRGB& clearColor)
+	{
+		//1. CLEAR RTV & DSV
+		m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, &clearColor.r);
+		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+
+		if (m_FrameIndex >= FrameLatency)
+			m_ConstantRing.RetireFrame(m_FrameIndex - FrameLatency);
+		m_ConstantRing.BeginFrame(m_FrameIndex);
+	}
+
+	void D3D11Device::Submit(const CommandBuffer& buffer)
+	{
+		m_pCommandBackend->Submit(buffer);
+	}
+
+	void D3D11Device::Present()
+	{
+		//3. PRESENT BACKBUFFER (SWAP)
+		m_pSwapChain->Present(0, 0);
+
+		m_ConstantRing.EndFrame();
+		++m_FrameIndex;
+	}
+
+	ConstantBlock D3D11Device::MapConstants(uint32_t size)
+	{
+		RingAllocation allocation{};
+		bool isNewRing{ false };
+		if (!m_ConstantRing.Allocate(size, allocation))
+		{
+			//Earlier blocks of this frame are bound by offset into the current buffer
+			if (m_ConstantRing.GetFrameUsed() > 0)
+				return ConstantBlock{};
+
+			//The old buffer stays alive until the GPU is done with it, so the frames in flight can be dropped
+			uint32_t capacity{ m_ConstantRing.GetCapacity() };
+			do
+			{
+				capacity *= 2;
+			} while (capacity < AlignConstantSize(size) * (FrameLatency + 1));
+
+			if (FAILED(CreateConstantRing(capacity)))
+				return ConstantBlock{};
+
+			m_ConstantRing.Reset(capacity);
+			m_pCommandBackend->SetConstantRing(m_pConstantRing);
+			m_ConstantRing.Allocate(size, allocation);
+			isNewRing = true;
+		}
+
+		//No-overwrite promises the GPU isn't reading this range, the allocator made sure of that
+		const D3D11_MAP mapType{ allocation.isDiscard || !m_IsNoOverwriteSupported ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE };
+
+		D3D11_MAPPED_SUBRESOURCE mapped{};
+		const HRESULT result{ m_pDeviceContext->Map(m_pConstantRing, 0, mapType, 0, &mapped) };
+		if (FAILED(result))
+			return ConstantBlock{};
+
+		return ConstantBlock{ static_cast<uint8_t*>(mapped.pData) + allocation.offset, allocation.offset, isNewRing };
+	}
+
+	void D3D11Device::UnmapConstants()
+	{
+		m_pDeviceContext->Unmap(m_pConstantRing, 0);
+	}
+
+	HRESULT D3D11Device::CreateConstantRing(uint32_t capacity)
+	{
+		D3D11_BUFFER_DESC bd{};
+		bd.Usage = D3D11_USAGE_DYNAMIC;
+		bd.ByteWidth = capacity;
+		bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bd.MiscFlags = 0;
+
+		ID3D11Buffer* pBuffer{ nullptr };
+		const HRESULT result{ m_pDevice->CreateBuffer(&bd, nullptr, &pBuffer) };
+		if (FAILED(result))
+			return result;
+
+		if (m_pConstantRing) m_pConstantRing->Release();
+		m_pConstantRing = pBuffer;
+		return result;
+	}
+
+	HRESULT D3D11Device::InitializeDirectX(SDL_Window* pWindow)
+	{
+		//1. Create Device & DeviceContext
+		//=====
+		D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
+		uint32_t createDeviceFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+		createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+		HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, createDeviceFlags, &featureLevel,
+											1, D3D11_SDK_VERSION, &m_pDevice, nullptr, &m_pDeviceContext);
+
+		if (FAILED(result))
+			return result;
+
+		//Constant blocks are bound by offset, which needs the 11.1 context
+		result = m_pDeviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&m_pDeviceContext1));
+		if (FAILED(result))
+			return result;
+
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options{};
+		result = m_pDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+		if (FAILED(result) || !options.ConstantBufferOffsetting)
+			return E_NOINTERFACE;
+		m_IsNoOverwriteSupported = options.MapNoOverwriteOnDynamicConstantBuffer;
+
+		//Never more frames in flight than the constant ring assumes
+		IDXGIDevice1* pDxgiDevice{ nullptr };
+		if (SUCCEEDED(m_pDevice->QueryInterface(__uuidof(IDXGIDevice1), reinterpret_cast<void**>(&pDxgiDevice))))
+		{
+			pDxgiDevice->SetMaximumFrameLatency(FrameLatency);
+			pDxgiDevice->Release();
+		}
+
+		result = CreateConstantRing(m_ConstantRing.GetCapacity());
+		if (FAILED(result))
+			return result;
+
+		//Create DXGI Factory
+		IDXGIFactory1* pDxgiFactory{};
+		result = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&pDxgiFactory));
+		if (FAILED(result))
+			return result;
+
+
+
+		//2. Create Swapchain
+		//=====
+		DXGI_SWAP_CHAIN_DESC swapChainDesc{};
+		swapChainDesc.BufferDesc.Width = m_Width;
+		swapChainDesc.BufferDesc.Height = m_Height;
+		swapChainDesc.BufferDesc.RefreshRate.Numerator = 1;
+		swapChainDesc.BufferDesc.RefreshRate.Denominator = 60;
+		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+		swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+		swapChainDesc.SampleDesc.Count = 1;
+		swapChainDesc.SampleDesc.Quality = 0;
+		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+		swapChainDesc.BufferCount = 1;
+		swapChainDesc.Windowed = true;
+		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
+		swapChainDesc.Flags = 0;
+
+		// Get the handle (HWND) from the SDL Backbuffer
+		SDL_SysWMinfo sysWMInfo{};
+		SDL_VERSION(&sysWMInfo.version)
+		SDL_GetWindowWMInfo(pWindow, &sysWMInfo);
+		swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
+
+		//Create SwapChain
+		result = pDxgiFactory->CreateSwapChain(m_pDevice, &swapChainDesc, &m_pSwapChain);
+		if (FAILED(result))
+			return result;
+
+		//3. Create DepthStencil (DS) & DepthStencilView (DSV)
+		//Resource
+		D3D11_TEXTURE2D_DESC depthStencilDesc{};
+		depthStencilDesc.Width = m_Width;
+		depthStencilDesc.Height = m_Height;
+		depthStencilDesc.MipLevels = 1;
+		depthStencilDesc.ArraySize = 1;
+		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		depthStencilDesc.SampleDesc.Count = 1;
+		depthStencilDesc.SampleDesc.Quality = 0;
+		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
+		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		depthStencilDesc.CPUAccessFlags = 0;
+		depthStencilDesc.MiscFlags = 0;
+
+		//View
+		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
+		depthStencilViewDesc.Format = depthStencilDesc.Format;
+		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		depthStencilViewDesc.Texture2D.MipSlice = 0;
+
+		result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
+		if (FAILED(result))
+			return result;
+
+		result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &depthStencilViewDesc, &m_pDepthStencilView);
+		if (FAILED(result))
+			return result;
+
+
+		//4. Create RenderTarget (RT) & RenderTargetView (RTV)
+		//=====
+
+		//Resource
+		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
+		if (FAILED(result))
+			return result;
+
+		//View
+		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
+		if (FAILED(result))
+			return result;
+
+
+		//5. Bind RTV & DSV to Output Merger Stage
+		//=====
+		m_pDeviceContext->OMSetRenderTargets(1, &m_pRenderTargetView, m_pDepthStencilView);
+
+
+		//6. Set Viewport
+		//=====
+		D3D11_VIEWPORT viewport{};
+		viewport.Width = static_cast<float>(m_Width);
+		viewport.Height = static_cast<float>(m_Height);
+		viewport.TopLeftX = 0.f;
+		viewport.TopLeftY = 0.f;
+		viewport.MinDepth = 0.f;
+		viewport.MaxDepth = 1.f;
+		m_pDeviceContext->RSSetViewports(1, &viewport);
+
+		return result;
+
+	}
+}
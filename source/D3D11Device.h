@@ -0,0 +1,85 @@
+#pragma once
+#include "GraphicsDevice.h"
+#include "D3D11CommandBackend.h"
+#include "FrameRingAllocator.h"
+
+struct SDL_Window;
+
+namespace dae
+{
+	class EffectCache;
+
+	//Device, swap chain and back buffers of an SDL window. Handles are the D3D11 objects themselves.
+	class D3D11Device final : public GraphicsDevice
+	{
+	public:
+		//Compiled effects are cached in Resources/Cache unless isEffectCacheEnabled is false
+		explicit D3D11Device(SDL_Window* pWindow, bool isEffectCacheEnabled = true);
+		virtual ~D3D11Device();
+
+		// rule of 5 copypasta
+		D3D11Device(const D3D11Device& other) = delete;
+		D3D11Device(D3D11Device&& other) = delete;
+		D3D11Device& operator=(const D3D11Device& other) = delete;
+		D3D11Device& operator=(D3D11Device&& other) = delete;
+
+		virtual bool IsInitialized() const override;
+
+		virtual BufferHandle CreateVertexBuffer(const void* pVertices, uint32_t byteSize) override;
+		virtual BufferHandle CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices) override;
+		virtual TextureHandle CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels) override;
+		virtual EffectHandle CreateEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines) override;
+		virtual InputLayoutHandle CreateInputLayout(EffectHandle effect) override;
+		virtual SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+
+		virtual uint32_t GetNumPasses(EffectHandle effect) const override;
+
+		virtual void Release(BufferHandle buffer) override;
+		virtual void Release(TextureHandle texture) override;
+		virtual void Release(EffectHandle effect) override;
+		virtual void Release(InputLayoutHandle layout) override;
+		virtual void Release(SamplerHandle sampler) override;
+
+		virtual void SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture) override;
+		virtual void SetSampler(EffectHandle effect, SamplerHandle sampler) override;
+		virtual void SetMaterial(EffectHandle effect, const MaterialConstants& material) override;
+
+		virtual void BeginFrame(const ColorRGB& clearColor) override;
+		virtual void Submit(const CommandBuffer& buffer) override;
+		virtual void Present() override;
+
+		virtual ConstantBlock MapConstants(uint32_t size) override;
+		virtual void UnmapConstants() override;
+
+	private:
+		HRESULT InitializeDirectX(SDL_Window* pWindow);
+		HRESULT CreateConstantRing(uint32_t capacity);
+
+		//Frames DXGI lets the CPU run ahead, constant blocks of older frames are no longer read
+		static constexpr uint32_t FrameLatency{ 3 };
+		static constexpr uint32_t InitialConstantRingSize{ 1024 * 1024 };
+
+		int m_Width{};
+		int m_Height{};
+		bool m_IsInitialized{ false };
+
+		ID3D11Device* m_pDevice{ nullptr };
+		ID3D11DeviceContext* m_pDeviceContext{ nullptr };
+		ID3D11DeviceContext1* m_pDeviceContext1{ nullptr };
+		IDXGISwapChain* m_pSwapChain{ nullptr };
+		ID3D11Texture2D* m_pDepthStencilBuffer{ nullptr };
+		ID3D11DepthStencilView* m_pDepthStencilView{ nullptr };
+		ID3D11RenderTargetView* m_pRenderTargetView{ nullptr };
+		ID3D11Resource* m_pRenderTargetBuffer{ nullptr };
+
+		D3D11CommandBackend* m_pCommandBackend{ nullptr };
+		EffectCache* m_pEffectCache{ nullptr };
+
+		//Dynamic constant buffer shared by all draws of a frame, blocks are bound by offset
+		ID3D11Buffer* m_pConstantRing{ nullptr };
+		FrameRingAllocator m_ConstantRing{ InitialConstantRingSize, ConstantAlignment };
+		//Without it dynamic constant buffers can only be mapped with discard
+		bool m_IsNoOverwriteSupported{ false };
+		uint64_t m_FrameIndex{};
+	};
+}
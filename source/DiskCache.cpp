@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "DiskCache.h"
+
+#include <thread>
+
+namespace dae
+{
+	uint64_t Hash(uint64_t hash, const void* pData, size_t size)
+	{
+		const uint8_t* pBytes{ static_cast<const uint8_t*>(pData) };
+		for (size_t i{}; i < size; ++i)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	uint64_t Hash(uint64_t hash, const std::string& text)
+	{
+		const uint64_t length{ text.size() };
+		hash = Hash(hash, &length, sizeof(length));
+		return Hash(hash, text.data(), text.size());
+	}
+
+	bool WriteFileAtomic(const std::filesystem::path& path, std::initializer_list<FileSpan> spans)
+	{
+		return WriteFileAtomic(path, spans.begin(), spans.size());
+	}
+
+	bool WriteFileAtomic(const std::filesystem::path& path, const FileSpan* pSpans, size_t numSpans)
+	{
+		//Unique per thread, so two threads writing the same path never share a temporary file
+		std::filesystem::path tempPath{ path };
+		tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+		std::error_code error{};
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+			for (size_t i{}; i < numSpans && file; ++i)
+				file.write(static_cast<const char*>(pSpans[i].pData), static_cast<std::streamsize>(pSpans[i].size));
+
+			if (!file)
+			{
+				file.close();
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	DiskCache::DiskCache(const std::filesystem::path& directory, const std::string& extension)
+		:m_Directory{ directory }
+		,m_Extension{ extension }
+	{
+		std::error_code error{};
+		std::filesystem::create_directories(m_Directory, error);
+		if (error)
+			std::cout << "DiskCache: can't create " << m_Directory.string() << ", nothing will be cached in it\n";
+	}
+
+	std::ifstream DiskCache::Open(uint64_t key) const
+	{
+		return std::ifstream{ GetEntryPath(key), std::ios::binary };
+	}
+
+	bool DiskCache::Write(uint64_t key, std::initializer_list<FileSpan> spans) const
+	{
+		return WriteFileAtomic(GetEntryPath(key), spans);
+	}
+
+	bool DiskCache::CountLoad(bool isHit)
+	{
+		if (isHit)
+			++m_NumHits;
+		else
+			++m_NumMisses;
+		return isHit;
+	}
+
+	uint32_t DiskCache::GetNumHits() const
+	{
+		return m_NumHits;
+	}
+
+	uint32_t DiskCache::GetNumMisses() const
+	{
+		return m_NumMisses;
+	}
+
+	const std::filesystem::path& DiskCache::GetDirectory() const
+	{
+		return m_Directory;
+	}
+
+	std::filesystem::path DiskCache::GetEntryPath(uint64_t key) const
+	{
+		char name[32]{};
+		snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+		return m_Directory / (name + m_Extension);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+
+namespace dae
+{
+	//FNV-1a, for cache keys and checksums that only have to change with their input, not resist attacks
+	constexpr uint64_t HashSeed{ 14695981039346656037ull };
+	uint64_t Hash(uint64_t hash, const void* pData, size_t size);
+	//Hashes the length first, which keeps "ab"+"c" and "a"+"bc" apart
+	uint64_t Hash(uint64_t hash, const std::string& text);
+
+	//Bytes written to a file one after another
+	struct FileSpan
+	{
+		const void* pData;
+		size_t size;
+	};
+
+	//Writes the spans to a temporary file next to path and renames it into place, so readers either see the old file,
+	//none, or the complete new one. Several threads may write the same path at once.
+	bool WriteFileAtomic(const std::filesystem::path& path, std::initializer_list<FileSpan> spans);
+	bool WriteFileAtomic(const std::filesystem::path& path, const FileSpan* pSpans, size_t numSpans);
+
+	//A directory of entries named after their 64-bit key, with hit and miss counts.
+	//The caches built on it only define what an entry holds and when a loaded one is valid.
+	class DiskCache final
+	{
+	public:
+		DiskCache(const std::filesystem::path& directory, const std::string& extension);
+		~DiskCache() = default;
+
+		// rule of 5 copypasta
+		DiskCache(const DiskCache& other) = delete;
+		DiskCache(DiskCache&& other) = delete;
+		DiskCache& operator=(const DiskCache& other) = delete;
+		DiskCache& operator=(DiskCache&& other) = delete;
+
+		//Fails to read when there's no entry for the key
+		std::ifstream Open(uint64_t key) const;
+		bool Write(uint64_t key, std::initializer_list<FileSpan> spans) const;
+		//Counts the outcome of a load and returns it
+		bool CountLoad(bool isHit);
+
+		uint32_t GetNumHits() const;
+		uint32_t GetNumMisses() const;
+		const std::filesystem::path& GetDirectory() const;
+
+	private:
+		std::filesystem::path GetEntryPath(uint64_t key) const;
+
+		std::filesystem::path m_Directory{};
+		std::string m_Extension{};
+		std::atomic<uint32_t> m_NumHits{};
+		std::atomic<uint32_t> m_NumMisses{};
+	};
+}
@@ -1,25 +1,80 @@
 #include "pch.h"
 #include "Effect.h"
+#include "EffectCache.h"
 
 #include <cassert>
+#include <fstream>
 
 namespace dae
 {
-	Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile)
+	bool ValidateConstantLayout(ID3DX11Effect* pEffect, const ConstantLayout& layout)
 	{
-		m_pEffect = LoadEffect(pDevice, assetFile);
+		ID3DX11EffectConstantBuffer* pBuffer{ pEffect->GetConstantBufferByName(layout.pName) };
+		if (!pBuffer->IsValid())
+		{
+			std::cout << layout.pName << " not found\n";
+			return false;
+		}
+
+		bool isValid{ true };
+		D3DX11_EFFECT_VARIABLE_DESC bufferDesc{};
+		pBuffer->GetDesc(&bufferDesc);
+		if (bufferDesc.ExplicitBindPoint != layout.registerIndex)
+		{
+			std::cout << layout.pName << ": register b" << bufferDesc.ExplicitBindPoint << ", expected b" << layout.registerIndex << "\n";
+			isValid = false;
+		}
+
+		for (uint32_t i{}; i < layout.numMembers; ++i)
+		{
+			const ConstantMember& member{ layout.pMembers[i] };
+			ID3DX11EffectVariable* pVariable{ pBuffer->GetMemberByName(member.pName) };
+			if (!pVariable->IsValid())
+			{
+				std::cout << layout.pName << ": " << member.pName << " not found\n";
+				isValid = false;
+				continue;
+			}
+
+			D3DX11_EFFECT_VARIABLE_DESC desc{};
+			pVariable->GetDesc(&desc);
+			D3DX11_EFFECT_TYPE_DESC typeDesc{};
+			pVariable->GetType()->GetDesc(&typeDesc);
+			if (desc.BufferOffset != member.offset || typeDesc.UnpackedSize != member.size)
+			{
+				std::cout << layout.pName << ": " << member.pName << " at " << desc.BufferOffset << " (" << typeDesc.UnpackedSize
+					<< " bytes), expected " << member.offset << " (" << member.size << " bytes)\n";
+				isValid = false;
+			}
+		}
+
+		//A member the C++ side doesn't know would never be written
+		uint32_t numMembers{};
+		while (pBuffer->GetMemberByIndex(numMembers)->IsValid())
+			++numMembers;
+		if (numMembers != layout.numMembers)
+		{
+			std::cout << layout.pName << ": " << numMembers << " members, expected " << layout.numMembers << "\n";
+			isValid = false;
+		}
+
+		return isValid;
+	}
+
+	Effect::Effect(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines, EffectCache* pCache)
+	{
+		m_pEffect = LoadEffect(pDevice, assetFile, defines, pCache);
 
 		m_pTechnique = m_pEffect->GetTechniqueByName("DefaultTechnique");
 		if (!m_pTechnique->IsValid())
 			std::wcout << L"Technique not valid\n";
 
-		m_pWorldViewProjMatrixVariable = m_pEffect->GetVariableByName("gWorldViewProj")->AsMatrix();
-		if (!m_pWorldViewProjMatrixVariable->IsValid())
-			std::wcout << L"m_pMatWorldViewProjVariable not valid!\n";
-
 		m_pSamplerStateVariable = m_pEffect->GetVariableByName("gSamState")->AsSampler();
 		if (!m_pSamplerStateVariable->IsValid())
 			std::wcout << L"m_pSamplerStateVariable not valid\n";
+
+		//Every effect draws meshes, whose constants come from the ring
+		m_AreConstantsValid = ValidateConstantLayout(m_pEffect, ConstantTraits<ObjectConstants>::Layout);
 	}
 
 	Effect::~Effect()
@@ -27,9 +82,43 @@ namespace dae
 		if (m_pEffect) m_pEffect->Release();
 	}
 
-	void Effect::SetWorldViewProjMatrix(const float* matrix)
+	bool Effect::IsLoadedFromCache() const
+	{
+		return m_IsLoadedFromCache;
+	}
+
+	bool Effect::AreConstantsValid() const
+	{
+		return m_AreConstantsValid;
+	}
+
+	void Effect::Apply(uint32_t pass, ID3D11DeviceContext* pDeviceContext)
 	{
-		m_pWorldViewProjMatrixVariable->SetMatrix(matrix);
+		UploadConstants();
+		m_pTechnique->GetPassByIndex(pass)->Apply(0, pDeviceContext);
+	}
+
+	bool Effect::GetPixelShaderStats(uint32_t& numInstructions, uint32_t& numTextureSamples) const
+	{
+		D3DX11_PASS_SHADER_DESC passShaderDesc{};
+		if (FAILED(m_pTechnique->GetPassByIndex(0)->GetPixelShaderDesc(&passShaderDesc)))
+			return false;
+
+		D3DX11_EFFECT_SHADER_DESC shaderDesc{};
+		if (FAILED(passShaderDesc.pShaderVariable->GetShaderDesc(passShaderDesc.ShaderIndex, &shaderDesc)))
+			return false;
+
+		ID3D11ShaderReflection* pReflection{ nullptr };
+		if (FAILED(D3DReflect(shaderDesc.pBytecode, shaderDesc.BytecodeLength, IID_ID3D11ShaderReflection, reinterpret_cast<void**>(&pReflection))))
+			return false;
+
+		D3D11_SHADER_DESC desc{};
+		pReflection->GetDesc(&desc);
+		pReflection->Release();
+
+		numInstructions = desc.InstructionCount;
+		numTextureSamples = desc.TextureNormalInstructions;
+		return true;
 	}
 
 	ID3DX11Effect* Effect::GetEffect() const
@@ -98,7 +187,7 @@ namespace dae
 			std::wcout << L"Failed to set sample state";
 	}
 
-	ID3DX11Effect* Effect::LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile) const
+	ID3DX11Effect* Effect::LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines, EffectCache* pCache)
 	{
 		HRESULT result;
 		ID3D10Blob* pErrorBlob{ nullptr };
@@ -111,20 +200,64 @@ namespace dae
 		shaderFlags |= D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
 
-		// Load the effect form the file
-		result = D3DX11CompileEffectFromFile
+		//Compiled blobs are only valid for the compiler that made them, so its version is part of the target
+		const std::string target{ "fx_5_0/" + std::to_string(D3D_COMPILER_VERSION) };
+
+		std::string source{};
+		{
+			std::ifstream file{ std::filesystem::path{ assetFile }, std::ios::binary };
+			std::ostringstream stream{};
+			stream << file.rdbuf();
+			source = stream.str();
+		}
+
+		if (source.empty())
+		{
+			std::wstringstream ss;
+			ss << "EffectLoader: Failed to read effect!\nPath: " << assetFile;
+			std::wcout << ss.str() << "\n";
+			return nullptr;
+		}
+
+		// Load the compiled effect from the cache
+		const uint64_t key{ pCache ? EffectCache::ComputeKey(assetFile, source, defines, shaderFlags, target) : 0 };
+		std::vector<uint8_t> blob{};
+		if (pCache && pCache->Load(key, blob))
+		{
+			result = D3DX11CreateEffectFromMemory(blob.data(), blob.size(), 0, pDevice, &pEffect);
+			if (SUCCEEDED(result))
+			{
+				m_IsLoadedFromCache = true;
+				return pEffect;
+			}
+		}
+
+		// Compile the effect from the source on a miss
+		const std::string sourceName{ std::filesystem::path{ assetFile }.string() };
+
+		//Null terminated list the compiler expects
+		std::vector<D3D_SHADER_MACRO> macros{};
+		for (const EffectDefine& define : defines)
+			macros.push_back(D3D_SHADER_MACRO{ define.name.c_str(), define.value.c_str() });
+		macros.push_back(D3D_SHADER_MACRO{ nullptr, nullptr });
+
+		ID3D10Blob* pCodeBlob{ nullptr };
+		result = D3DCompile
 		(
-			assetFile.c_str(),
-			nullptr,
+			source.data(),
+			source.size(),
+			sourceName.c_str(),
+			macros.data(),
+			D3D_COMPILE_STANDARD_FILE_INCLUDE,
 			nullptr,
+			"fx_5_0",
 			shaderFlags,
 			0,
-			pDevice,
-			&pEffect,
+			&pCodeBlob,
 			&pErrorBlob
 		);
 
-		// If loading the effect failed, print an error message
+		// If compiling the effect failed, print an error message
 		if (FAILED(result))
 		{
 			if (pErrorBlob != nullptr)
@@ -148,11 +281,19 @@ namespace dae
 				std::wstringstream ss;
 				ss << "EffectLoader: Failed to CreateEffectFromFile!\nPath: " << assetFile;
 				std::wcout << ss.str() << "\n";
-				return nullptr;
 			}
+			return nullptr;
 		}
 
-		return pEffect;
+		//Warnings
+		if (pErrorBlob) pErrorBlob->Release();
+
+		result = D3DX11CreateEffectFromMemory(pCodeBlob->GetBufferPointer(), pCodeBlob->GetBufferSize(), 0, pDevice, &pEffect);
+		if (SUCCEEDED(result) && pCache)
+			pCache->Store(key, pCodeBlob->GetBufferPointer(), pCodeBlob->GetBufferSize());
+
+		pCodeBlob->Release();
+		return SUCCEEDED(result) ? pEffect : nullptr;
 	}
 }
 
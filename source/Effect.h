@@ -1,12 +1,56 @@
 #pragma once
+#include "ConstantBlocks.h"
+#include "EffectDefine.h"
+
 namespace dae
 {
-	class Texture;
+	class EffectCache;
+
+	//Checks the C++ mirror of a cbuffer against the effect's reflection: register, members, their offsets and sizes.
+	//Prints every mismatch and returns false if there was one.
+	bool ValidateConstantLayout(ID3DX11Effect* pEffect, const ConstantLayout& layout);
+
+	//One of the effect's own cbuffers, set as a whole from its C++ mirror.
+	//A changed block is copied into the effect once, at the next Upload, and sent to the GPU by the pass that follows.
+	template<typename T>
+	class EffectConstantBuffer final
+	{
+	public:
+		//Returns false if the effect has no such cbuffer or its layout differs
+		bool Load(ID3DX11Effect* pEffect)
+		{
+			m_pBuffer = pEffect->GetConstantBufferByName(ConstantTraits<T>::Layout.pName);
+			m_IsDirty = true;
+			return m_pBuffer->IsValid() && ValidateConstantLayout(pEffect, ConstantTraits<T>::Layout);
+		}
+
+		void Set(const T& data)
+		{
+			if (std::memcmp(&m_Data, &data, sizeof(T)) == 0)
+				return;
+			m_Data = data;
+			m_IsDirty = true;
+		}
+
+		void Upload()
+		{
+			if (!m_IsDirty || !m_pBuffer)
+				return;
+			m_pBuffer->SetRawValue(&m_Data, 0, sizeof(T));
+			m_IsDirty = false;
+		}
+
+	private:
+		ID3DX11EffectConstantBuffer* m_pBuffer{ nullptr };
+		T m_Data{};
+		bool m_IsDirty{ true };
+	};
 
 	class Effect
 	{
 	public:
-		Effect(ID3D11Device* pDevice, const std::wstring& assetFile);
+		//Without a cache the effect is compiled every time
+		Effect(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines = {}, EffectCache* pCache = nullptr);
 		virtual ~Effect();
 
 		// rule of 5 copypasta
@@ -18,20 +62,25 @@ namespace dae
 		ID3DX11Effect* GetEffect() const;
 		ID3DX11EffectTechnique* GetTechnique() const;
 		ID3D11InputLayout* LoadInputLayout(ID3D11Device* pDevice);
+		bool IsLoadedFromCache() const;
+		//False if a cbuffer doesn't match its C++ mirror, drawing with it would feed the shader garbage
+		bool AreConstantsValid() const;
 
-		void SetWorldViewProjMatrix(const float* matrix);
+		//Uploads the constant blocks that changed, then applies the pass
+		void Apply(uint32_t pass, ID3D11DeviceContext* pDeviceContext);
+		//Compiler statistics of the first pass' pixel shader, to compare permutations
+		bool GetPixelShaderStats(uint32_t& numInstructions, uint32_t& numTextureSamples) const;
 
 		// pure virtuals
-		virtual void SetDiffuseMap(const Texture* texture) = 0;
-		virtual void SetNormalMap(const Texture* texture) = 0;
-		virtual void SetSpecularMap(const Texture* texture) = 0;
-		virtual void SetGlossinessMap(const Texture* texture) = 0;
-		virtual void SetWorldMatrix(const float* matrix) = 0;
-		virtual void SetInverseViewMatrix(const float* matrix) = 0;
+		virtual void SetDiffuseMap(ID3D11ShaderResourceView* pSRV) = 0;
+		virtual void SetNormalMap(ID3D11ShaderResourceView* pSRV) = 0;
+		virtual void SetSpecularMap(ID3D11ShaderResourceView* pSRV) = 0;
+		virtual void SetMaterial(const MaterialConstants& material) = 0;
 
 		void SetSampleState(ID3D11SamplerState* pSampleState);
 	protected:
-		ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile) const;
+		ID3DX11Effect* LoadEffect(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines, EffectCache* pCache);
+		virtual void UploadConstants() {};
 
 
 		ID3DX11Effect* m_pEffect{ nullptr };
@@ -40,7 +89,9 @@ namespace dae
 		ID3DX11EffectTechnique* m_pTechnique{ nullptr };
 
 		ID3DX11EffectSamplerVariable* m_pSamplerStateVariable{ nullptr };
-		ID3DX11EffectMatrixVariable* m_pWorldViewProjMatrixVariable{ nullptr };
+
+		bool m_IsLoadedFromCache{ false };
+		bool m_AreConstantsValid{ true };
 
 	};
 }
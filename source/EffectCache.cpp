@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "EffectCache.h"
+
+#include <unordered_set>
+
+namespace dae
+{
+	namespace
+	{
+		//Bump when the entry layout or the key changes, old entries then simply miss
+		constexpr uint32_t FormatVersion{ 1 };
+		constexpr uint32_t Magic{ 0x43584645 }; //"EFXC"
+		//Include chains deeper than this are a cycle the visited set didn't catch (e.g. via different spellings)
+		constexpr int MaxIncludeDepth{ 32 };
+
+		struct EntryHeader
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint64_t key{};
+			uint64_t size{};
+			uint64_t checksum{};
+		};
+
+		bool ReadFile(const std::filesystem::path& path, std::string& contents)
+		{
+			std::ifstream file{ path, std::ios::binary };
+			if (!file)
+				return false;
+
+			std::ostringstream stream{};
+			stream << file.rdbuf();
+			contents = stream.str();
+			return true;
+		}
+
+		//Hashes the quoted includes of source in order, a missing include hashes as its name only
+		uint64_t HashIncludes(uint64_t hash, const std::filesystem::path& directory, const std::string& source,
+			std::unordered_set<std::string>& visited, int depth)
+		{
+			if (depth > MaxIncludeDepth)
+				return hash;
+
+			std::istringstream lines{ source };
+			std::string line{};
+			while (std::getline(lines, line))
+			{
+				const size_t directive{ line.find_first_not_of(" \t") };
+				if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0)
+					continue;
+
+				const size_t open{ line.find('"', directive + 8) };
+				const size_t close{ open == std::string::npos ? open : line.find('"', open + 1) };
+				if (close == std::string::npos)
+					continue;
+
+				const std::string name{ line.substr(open + 1, close - open - 1) };
+				hash = Hash(hash, name);
+
+				const std::filesystem::path includePath{ (directory / name).lexically_normal() };
+				if (!visited.insert(includePath.generic_string()).second)
+					continue;
+
+				std::string include{};
+				if (ReadFile(includePath, include))
+				{
+					hash = Hash(hash, include);
+					hash = HashIncludes(hash, includePath.parent_path(), include, visited, depth + 1);
+				}
+			}
+			return hash;
+		}
+	}
+
+	EffectCache::EffectCache(const std::filesystem::path& directory)
+		:m_Entries{ directory, ".fxo" }
+	{
+	}
+
+	uint64_t EffectCache::ComputeKey(const std::filesystem::path& sourceFile, const std::string& source,
+		const std::vector<EffectDefine>& defines, uint32_t flags, const std::string& target)
+	{
+		uint64_t hash{ HashSeed };
+		hash = Hash(hash, &FormatVersion, sizeof(FormatVersion));
+		hash = Hash(hash, target);
+		hash = Hash(hash, &flags, sizeof(flags));
+
+		for (const EffectDefine& define : defines)
+		{
+			hash = Hash(hash, define.name);
+			hash = Hash(hash, define.value);
+		}
+
+		hash = Hash(hash, source);
+
+		std::unordered_set<std::string> visited{ sourceFile.lexically_normal().generic_string() };
+		return HashIncludes(hash, sourceFile.parent_path(), source, visited, 0);
+	}
+
+	bool EffectCache::Load(uint64_t key, std::vector<uint8_t>& blob)
+	{
+		std::ifstream file{ m_Entries.Open(key) };
+
+		EntryHeader header{};
+		const bool isHeaderValid{ file && file.read(reinterpret_cast<char*>(&header), sizeof(header))
+			&& header.magic == Magic && header.version == FormatVersion && header.key == key };
+
+		if (isHeaderValid)
+		{
+			blob.resize(header.size);
+			if (file.read(reinterpret_cast<char*>(blob.data()), blob.size())
+				&& Hash(HashSeed, blob.data(), blob.size()) == header.checksum)
+				return m_Entries.CountLoad(true);
+		}
+
+		blob.clear();
+		return m_Entries.CountLoad(false);
+	}
+
+	bool EffectCache::Store(uint64_t key, const void* pData, size_t size)
+	{
+		const EntryHeader header{ Magic, FormatVersion, key, size, Hash(HashSeed, pData, size) };
+		return m_Entries.Write(key, { { &header, sizeof(header) }, { pData, size } });
+	}
+
+	uint32_t EffectCache::GetNumHits() const
+	{
+		return m_Entries.GetNumHits();
+	}
+
+	uint32_t EffectCache::GetNumMisses() const
+	{
+		return m_Entries.GetNumMisses();
+	}
+
+	const std::filesystem::path& EffectCache::GetDirectory() const
+	{
+		return m_Entries.GetDirectory();
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "DiskCache.h"
+#include "EffectDefine.h"
+
+namespace dae
+{
+	//Compiled effect binaries on disk, one file per key.
+	//The key covers everything that changes the compiler output, so a stale entry is never loaded:
+	//a changed source, include, define or flag simply misses and compiles again. Safe to use from several threads.
+	class EffectCache final
+	{
+	public:
+		explicit EffectCache(const std::filesystem::path& directory);
+		~EffectCache() = default;
+
+		// rule of 5 copypasta
+		EffectCache(const EffectCache& other) = delete;
+		EffectCache(EffectCache&& other) = delete;
+		EffectCache& operator=(const EffectCache& other) = delete;
+		EffectCache& operator=(EffectCache&& other) = delete;
+
+		//Hashes the source, every file it #includes with quotes (relative to the including file),
+		//the defines, the compile flags and the compiler target
+		static uint64_t ComputeKey(const std::filesystem::path& sourceFile, const std::string& source,
+			const std::vector<EffectDefine>& defines, uint32_t flags, const std::string& target);
+
+		//Returns false on a miss, or when the entry is truncated or corrupt
+		bool Load(uint64_t key, std::vector<uint8_t>& blob);
+		bool Store(uint64_t key, const void* pData, size_t size);
+
+		uint32_t GetNumHits() const;
+		uint32_t GetNumMisses() const;
+		const std::filesystem::path& GetDirectory() const;
+
+	private:
+		DiskCache m_Entries;
+	};
+}
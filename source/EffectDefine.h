@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+
+namespace dae
+{
+	//Preprocessor define passed to the effect compiler
+	struct EffectDefine
+	{
+		std::string name{};
+		std::string value{};
+
+		bool operator==(const EffectDefine& other) const = default;
+	};
+}
@@ -1,11 +1,10 @@
 #include "pch.h"
 #include "EffectShaded.h"
-#include "Texture.h"
 
 using namespace dae;
 
-EffectShaded::EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile)
-	: Effect(pDevice, assetFile)
+EffectShaded::EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines, EffectCache* pCache)
+	: Effect(pDevice, assetFile, defines, pCache)
 {
 	m_pDiffuseMapVariable = m_pEffect->GetVariableByName("gDiffuseMap")->AsShaderResource();
 	if (!m_pDiffuseMapVariable->IsValid())
@@ -19,17 +18,12 @@ EffectShaded::EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile)
 	if (!m_pSpecularMapVariable->IsValid())
 		std::wcout << L"m_pSpecularMapVariable not valid!\n";
 
-	m_pGlossinessMapVariable = m_pEffect->GetVariableByName("gGlossinessMap")->AsShaderResource();
-	if (!m_pGlossinessMapVariable->IsValid())
-		std::wcout << L"m_pGlossinessMapVariable not valid!\n";
+	//The per-frame block comes from the ring like the per-object one, only the material lives in the effect
+	if (!ValidateConstantLayout(m_pEffect, ConstantTraits<FrameConstants>::Layout))
+		m_AreConstantsValid = false;
 
-	m_pWorldMatrixVariable = m_pEffect->GetVariableByName("gWorldMatrix")->AsMatrix();
-	if (!m_pWorldMatrixVariable->IsValid())
-		std::wcout << L"m_pWorldMatrixVariable not valid\n";
-
-	m_pInverseViewMatrixVariable = m_pEffect->GetVariableByName("gViewInverseMatrix")->AsMatrix();
-	if (!m_pInverseViewMatrixVariable->IsValid())
-		std::wcout << L"m_pInverseViewMatrixVariable not valid\n";
+	if (!m_Material.Load(m_pEffect))
+		m_AreConstantsValid = false;
 }
 
 EffectShaded::~EffectShaded()
@@ -37,40 +31,30 @@ EffectShaded::~EffectShaded()
 
 }
 
-void EffectShaded::SetDiffuseMap(const Texture* texture)
+void EffectShaded::SetDiffuseMap(ID3D11ShaderResourceView* pSRV)
 {
 	if (m_pDiffuseMapVariable)
-		m_pDiffuseMapVariable->SetResource(texture->GetSRV());
-	delete texture;
+		m_pDiffuseMapVariable->SetResource(pSRV);
 }
 
-void EffectShaded::SetNormalMap(const Texture* texture)
+void EffectShaded::SetNormalMap(ID3D11ShaderResourceView* pSRV)
 {
 	if (m_pNormalMapVariable)
-		m_pNormalMapVariable->SetResource(texture->GetSRV());
-	delete texture;
+		m_pNormalMapVariable->SetResource(pSRV);
 }
 
-void EffectShaded::SetSpecularMap(const Texture* texture)
+void EffectShaded::SetSpecularMap(ID3D11ShaderResourceView* pSRV)
 {
 	if (m_pSpecularMapVariable)
-		m_pSpecularMapVariable->SetResource(texture->GetSRV());
-	delete texture;
-}
-
-void EffectShaded::SetGlossinessMap(const Texture* texture)
-{
-	if (m_pGlossinessMapVariable)
-		m_pGlossinessMapVariable->SetResource(texture->GetSRV());
-	delete texture;
+		m_pSpecularMapVariable->SetResource(pSRV);
 }
 
-void dae::EffectShaded::SetWorldMatrix(const float* matrix)
+void EffectShaded::SetMaterial(const MaterialConstants& material)
 {
-	m_pWorldMatrixVariable->SetMatrix(matrix);
+	m_Material.Set(material);
 }
 
-void dae::EffectShaded::SetInverseViewMatrix(const float* matrix)
+void EffectShaded::UploadConstants()
 {
-	m_pInverseViewMatrixVariable->SetMatrix(matrix);
+	m_Material.Upload();
 }
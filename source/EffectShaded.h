@@ -3,12 +3,10 @@
 
 namespace dae
 {
-	class Texture;
-
 	class EffectShaded final : public Effect
 	{
 	public:
-		EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile);
+		EffectShaded(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines = {}, EffectCache* pCache = nullptr);
 		virtual ~EffectShaded();
 
 		// rule of 5 copypasta
@@ -17,22 +15,20 @@ namespace dae
 		EffectShaded& operator=(const EffectShaded& other) = delete;
 		EffectShaded& operator=(EffectShaded&& other) = delete;
 
-		virtual void SetDiffuseMap(const Texture* texture) override;
-		virtual void SetNormalMap(const Texture* texture) override;
-		virtual void SetSpecularMap(const Texture* texture) override;
-		virtual void SetGlossinessMap(const Texture* texture) override;
-		virtual void SetWorldMatrix(const float* matrix) override;
-		virtual void SetInverseViewMatrix(const float* matrix) override;
+		virtual void SetDiffuseMap(ID3D11ShaderResourceView* pSRV) override;
+		virtual void SetNormalMap(ID3D11ShaderResourceView* pSRV) override;
+		virtual void SetSpecularMap(ID3D11ShaderResourceView* pSRV) override;
+		virtual void SetMaterial(const MaterialConstants& material) override;
 
+	protected:
+		virtual void UploadConstants() override;
 
 	private:
 		ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{ nullptr };
 		ID3DX11EffectShaderResourceVariable* m_pNormalMapVariable{ nullptr };
 		ID3DX11EffectShaderResourceVariable* m_pSpecularMapVariable{ nullptr };
-		ID3DX11EffectShaderResourceVariable* m_pGlossinessMapVariable{ nullptr };
 
-		ID3DX11EffectMatrixVariable* m_pWorldMatrixVariable{};
-		ID3DX11EffectMatrixVariable* m_pInverseViewMatrixVariable{};
+		EffectConstantBuffer<MaterialConstants> m_Material{};
 
 	};
 }
@@ -1,11 +1,10 @@
 #include "pch.h"
 #include "EffectTransparent.h"
-#include "Texture.h"
 
 using namespace dae;
 
-EffectTransparent::EffectTransparent(ID3D11Device* pDevice, const std::wstring& assetFile)
-	: Effect(pDevice, assetFile)
+EffectTransparent::EffectTransparent(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines, EffectCache* pCache)
+	: Effect(pDevice, assetFile, defines, pCache)
 {
 	m_pDiffuseMapVariable = m_pEffect->GetVariableByName("gDiffuseMap")->AsShaderResource();
 	if (!m_pDiffuseMapVariable->IsValid())
@@ -18,9 +17,8 @@ EffectTransparent::~EffectTransparent()
 
 }
 
-void EffectTransparent::SetDiffuseMap(const Texture* texture)
+void EffectTransparent::SetDiffuseMap(ID3D11ShaderResourceView* pSRV)
 {
 	if (m_pDiffuseMapVariable)
-		m_pDiffuseMapVariable->SetResource(texture->GetSRV());
-	delete texture;
+		m_pDiffuseMapVariable->SetResource(pSRV);
 }
@@ -3,12 +3,10 @@
 
 namespace dae
 {
-	class Texture;
-
 	class EffectTransparent final : public Effect
 	{
 	public:
-		EffectTransparent(ID3D11Device* pDevice, const std::wstring& assetFile);
+		EffectTransparent(ID3D11Device* pDevice, const std::wstring& assetFile, const std::vector<EffectDefine>& defines = {}, EffectCache* pCache = nullptr);
 		virtual ~EffectTransparent();
 
 		// rule of 5 copypasta
@@ -17,14 +15,12 @@ namespace dae
 		EffectTransparent& operator=(const EffectTransparent& other) = delete;
 		EffectTransparent& operator=(EffectTransparent&& other) = delete;
 
-		virtual void SetDiffuseMap(const Texture* texture) override;
+		virtual void SetDiffuseMap(ID3D11ShaderResourceView* pSRV) override;
 
 		//empty funcitons
-		virtual void SetNormalMap(const Texture* texture) override {};
-		virtual void SetSpecularMap(const Texture* texture) override {};
-		virtual void SetGlossinessMap(const Texture* texture) override {};
-		virtual void SetWorldMatrix(const float* matrix) override {};
-		virtual void SetInverseViewMatrix(const float* matrix) override {};
+		virtual void SetNormalMap(ID3D11ShaderResourceView* pSRV) override {};
+		virtual void SetSpecularMap(ID3D11ShaderResourceView* pSRV) override {};
+		virtual void SetMaterial(const MaterialConstants& material) override {};
 
 	private:
 		ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{ nullptr };
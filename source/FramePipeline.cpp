@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "FramePipeline.h"
+
+namespace dae
+{
+	FramePacket& FramePipeline::BeginWrite()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this]() { return m_NumInFlight < NumPackets || m_IsShutdown; });
+
+		return m_Packets[m_WriteIndex];
+	}
+
+	void FramePipeline::EndWrite()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			if (m_IsShutdown)
+				return;
+
+			m_WriteIndex = (m_WriteIndex + 1) % NumPackets;
+			++m_NumInFlight;
+		}
+		m_Condition.notify_all();
+	}
+
+	const FramePacket* FramePipeline::BeginRead()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this]() { return m_NumInFlight > 0 || m_IsShutdown; });
+
+		if (m_IsShutdown)
+			return nullptr;
+
+		return &m_Packets[m_ReadIndex];
+	}
+
+	void FramePipeline::EndRead()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_ReadIndex = (m_ReadIndex + 1) % NumPackets;
+			--m_NumInFlight;
+		}
+		m_Condition.notify_all();
+	}
+
+	void FramePipeline::WaitIdle()
+	{
+		std::unique_lock lock{ m_Mutex };
+		m_Condition.wait(lock, [this]() { return m_NumInFlight == 0 || m_IsShutdown; });
+	}
+
+	void FramePipeline::Shutdown()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsShutdown = true;
+		}
+		m_Condition.notify_all();
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include "FrameStats.h"
+#include "GraphicsDevice.h"
+
+namespace dae
+{
+	//Everything the render thread needs to submit one mesh
+	struct DrawItem
+	{
+		uint32_t meshIndex{};
+		//Laid out like the cbuffer already, recording copies it into the constant ring as is
+		ObjectConstants constants{};
+	};
+
+	//A texture the render thread binds before drawing, a streamed texture that got more or fewer levels
+	struct TextureBinding
+	{
+		EffectHandle effect{ EffectHandle::Invalid };
+		TextureSlot slot{ TextureSlot::Diffuse };
+		TextureHandle texture{ TextureHandle::Invalid };
+	};
+
+	//Immutable snapshot of one simulated frame, produced by the update thread and consumed by the render thread
+	struct FramePacket
+	{
+		uint64_t frameIndex{};
+
+		Matrix viewProjection{};
+		FrameConstants constants{};
+
+		SamplerFilter samplerFilter{ SamplerFilter::Point };
+		std::vector<TextureBinding> textureBindings{};
+
+		std::vector<DrawItem> draws{};
+
+		//Filled in by the update thread, the render thread adds its own counters
+		FrameStats stats{};
+	};
+
+	//Double buffered hand-off between one producer (simulation) and one consumer (render).
+	//The producer can be at most one packet ahead, which bounds the added latency to a single frame.
+	class FramePipeline final
+	{
+	public:
+		FramePipeline() = default;
+		~FramePipeline() = default;
+
+		FramePipeline(const FramePipeline& other) = delete;
+		FramePipeline(FramePipeline&& other) = delete;
+		FramePipeline& operator=(const FramePipeline& other) = delete;
+		FramePipeline& operator=(FramePipeline&& other) = delete;
+
+		//Blocks while both packets are still queued or being rendered
+		FramePacket& BeginWrite();
+		void EndWrite();
+
+		//Blocks until a packet is published, returns nullptr once shut down
+		const FramePacket* BeginRead();
+		void EndRead();
+
+		//Blocks until every published packet was read
+		void WaitIdle();
+
+		//Wakes up both sides, BeginRead returns nullptr from then on
+		void Shutdown();
+
+	private:
+		static constexpr uint32_t NumPackets{ 2 };
+
+		FramePacket m_Packets[NumPackets]{};
+		uint32_t m_WriteIndex{};
+		uint32_t m_ReadIndex{};
+		//Published but not yet released by the reader
+		uint32_t m_NumInFlight{};
+		bool m_IsShutdown{ false };
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+	};
+}
@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "FrameRingAllocator.h"
+
+#include <cassert>
+
+namespace dae
+{
+	FrameRingAllocator::FrameRingAllocator(uint32_t capacity, uint32_t alignment)
+		:m_Capacity{ capacity }
+		,m_Alignment{ alignment }
+	{
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && "Alignment has to be a power of 2");
+		assert(capacity % alignment == 0);
+	}
+
+	void FrameRingAllocator::BeginFrame(uint64_t frameIndex)
+	{
+		assert(!m_IsInFrame);
+		m_IsInFrame = true;
+		m_CurrentFrame = Frame{ frameIndex, 0 };
+	}
+
+	void FrameRingAllocator::EndFrame()
+	{
+		assert(m_IsInFrame);
+		m_IsInFrame = false;
+
+		if (m_CurrentFrame.size > 0)
+			m_FramesInFlight.push_back(m_CurrentFrame);
+	}
+
+	void FrameRingAllocator::RetireFrame(uint64_t frameIndex)
+	{
+		while (!m_FramesInFlight.empty() && m_FramesInFlight.front().index <= frameIndex)
+		{
+			m_Used -= m_FramesInFlight.front().size;
+			m_FramesInFlight.pop_front();
+		}
+	}
+
+	bool FrameRingAllocator::Allocate(uint32_t size, RingAllocation& allocation)
+	{
+		assert(m_IsInFrame && "Allocations have to belong to a frame");
+
+		const uint32_t alignedSize{ (size + m_Alignment - 1) & ~(m_Alignment - 1) };
+		if (alignedSize == 0 || alignedSize > m_Capacity)
+			return false;
+
+		//Nothing in flight: start over at the front instead of wrapping around a hole
+		if (m_Used == 0 && m_Head != 0)
+		{
+			m_Head = 0;
+			m_IsDiscardPending = true;
+		}
+
+		//Blocks are contiguous, the tail end of the buffer is skipped when the block doesn't fit there
+		const bool isWrapping{ m_Head + alignedSize > m_Capacity };
+		const uint32_t padding{ isWrapping ? m_Capacity - m_Head : 0 };
+		if (m_Used + padding + alignedSize > m_Capacity)
+			return false;
+
+		if (isWrapping)
+			m_Head = 0;
+
+		allocation.offset = m_Head;
+		allocation.isDiscard = isWrapping || m_IsDiscardPending;
+
+		m_Head += alignedSize;
+		m_Used += padding + alignedSize;
+		m_CurrentFrame.size += padding + alignedSize;
+		m_IsDiscardPending = false;
+		return true;
+	}
+
+	void FrameRingAllocator::Reset(uint32_t capacity)
+	{
+		assert(capacity % m_Alignment == 0);
+		m_Capacity = capacity;
+		m_Head = 0;
+		m_Used = 0;
+		m_IsDiscardPending = true;
+		m_CurrentFrame.size = 0;
+		m_FramesInFlight.clear();
+	}
+
+	uint32_t FrameRingAllocator::GetCapacity() const
+	{
+		return m_Capacity;
+	}
+
+	uint32_t FrameRingAllocator::GetAlignment() const
+	{
+		return m_Alignment;
+	}
+
+	uint32_t FrameRingAllocator::GetUsed() const
+	{
+		return m_Used;
+	}
+
+	uint32_t FrameRingAllocator::GetFrameUsed() const
+	{
+		return m_CurrentFrame.size;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+
+namespace dae
+{
+	struct RingAllocation
+	{
+		uint32_t offset{};
+		//The block starts a new pass over the buffer: map with discard, otherwise no-overwrite is safe
+		bool isDiscard{};
+	};
+
+	//Linear allocator over a fixed-size buffer that wraps around.
+	//Space is handed back per frame: everything allocated between BeginFrame and EndFrame
+	//stays reserved until that frame is retired (i.e. the GPU is done reading it).
+	class FrameRingAllocator final
+	{
+	public:
+		FrameRingAllocator(uint32_t capacity, uint32_t alignment);
+
+		void BeginFrame(uint64_t frameIndex);
+		void EndFrame();
+		//The frame and every frame before it are no longer in use
+		void RetireFrame(uint64_t frameIndex);
+
+		//Returns false if the block doesn't fit next to the frames still in flight
+		bool Allocate(uint32_t size, RingAllocation& allocation);
+
+		//Drops every allocation, e.g. after the buffer was recreated with a new capacity
+		void Reset(uint32_t capacity);
+
+		uint32_t GetCapacity() const;
+		uint32_t GetAlignment() const;
+		//Bytes reserved by frames in flight, including the padding lost when wrapping
+		uint32_t GetUsed() const;
+		//Bytes reserved by the current frame so far
+		uint32_t GetFrameUsed() const;
+
+	private:
+		struct Frame
+		{
+			uint64_t index{};
+			uint32_t size{};
+		};
+
+		uint32_t m_Capacity{};
+		uint32_t m_Alignment{};
+
+		uint32_t m_Head{};
+		uint32_t m_Used{};
+		//The next block starts a new pass over the buffer even if it doesn't wrap
+		bool m_IsDiscardPending{ true };
+
+		bool m_IsInFrame{ false };
+		Frame m_CurrentFrame{};
+		std::deque<Frame> m_FramesInFlight{};
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+namespace dae
+{
+	//Per-frame counters, reset at the start of every Renderer::Update
+	struct FrameStats
+	{
+		uint32_t matricesComputed{};
+		uint32_t matricesSkipped{};
+		uint32_t uploadsIssued{};
+		uint32_t uploadsSkipped{};
+		uint32_t statesIssued{};
+		uint32_t statesFiltered{};
+
+		//CPU time of the two pipeline stages, the frame time approaches the larger one
+		float updateMs{};
+		float renderMs{};
+
+		void Reset()
+		{
+			*this = FrameStats{};
+		}
+
+		FrameStats& operator+=(const FrameStats& other)
+		{
+			matricesComputed += other.matricesComputed;
+			matricesSkipped += other.matricesSkipped;
+			uploadsIssued += other.uploadsIssued;
+			uploadsSkipped += other.uploadsSkipped;
+			statesIssued += other.statesIssued;
+			statesFiltered += other.statesFiltered;
+			return *this;
+		}
+	};
+
+	inline std::ostream& operator<<(std::ostream& os, const FrameStats& stats)
+	{
+		os << "matrices computed/skipped: " << stats.matricesComputed << '/' << stats.matricesSkipped
+			<< ", uploads issued/skipped: " << stats.uploadsIssued << '/' << stats.uploadsSkipped
+			<< ", states issued/filtered: " << stats.statesIssued << '/' << stats.statesFiltered
+			<< ", update " << stats.updateMs << " ms, render " << stats.renderMs << " ms";
+		return os;
+	}
+}
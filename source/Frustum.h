@@ -0,0 +1,46 @@
+#pragma once
+#include "Math.h"
+
+namespace dae
+{
+	//View frustum as 6 planes (xyz = inward normal, w = distance), used for CPU-side culling
+	struct Frustum
+	{
+		Vector4 planes[6]{};
+
+		//Gribb/Hartmann extraction for row vectors (clip = p * m) and a D3D [0, 1] depth range
+		static Frustum FromViewProjection(const Matrix& m)
+		{
+			const Vector4 column0{ m[0].x, m[1].x, m[2].x, m[3].x };
+			const Vector4 column1{ m[0].y, m[1].y, m[2].y, m[3].y };
+			const Vector4 column2{ m[0].z, m[1].z, m[2].z, m[3].z };
+			const Vector4 column3{ m[0].w, m[1].w, m[2].w, m[3].w };
+
+			Frustum frustum{};
+			frustum.planes[0] = column3 + column0;	//left
+			frustum.planes[1] = column3 - column0;	//right
+			frustum.planes[2] = column3 + column1;	//bottom
+			frustum.planes[3] = column3 - column1;	//top
+			frustum.planes[4] = column2;			//near
+			frustum.planes[5] = column3 - column2;	//far
+
+			for (Vector4& plane : frustum.planes)
+			{
+				const float length{ Vector3{ plane }.Magnitude() };
+				plane = plane * (1.f / length);
+			}
+
+			return frustum;
+		}
+
+		bool IsSphereVisible(const Vector3& center, float radius) const
+		{
+			for (const Vector4& plane : planes)
+			{
+				if (Vector3::Dot(Vector3{ plane }, center) + plane.w < -radius)
+					return false;
+			}
+			return true;
+		}
+	};
+}
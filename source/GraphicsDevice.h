@@ -0,0 +1,176 @@
+#pragma once
+#include "CommandBuffer.h"
+#include "ConstantBlocks.h"
+#include "EffectDefine.h"
+
+namespace dae
+{
+	class JobSystem;
+
+	enum class EffectType : uint8_t
+	{
+		Shaded,
+		Transparent
+	};
+
+	enum class TextureSlot : uint8_t
+	{
+		Diffuse,
+		Normal,
+		//Specular color in RGB, glossiness in A
+		Specular
+	};
+
+	enum class SamplerFilter : uint8_t
+	{
+		Point,
+		Linear,
+		Anisotropic
+	};
+
+	enum class SamplerAddress : uint8_t
+	{
+		Wrap,
+		Mirror,
+		Clamp
+	};
+
+	struct SamplerDesc
+	{
+		SamplerFilter filter{ SamplerFilter::Point };
+		SamplerAddress address{ SamplerAddress::Wrap };
+		//Only used by SamplerFilter::Anisotropic
+		uint8_t maxAnisotropy{ 16 };
+
+		bool operator==(const SamplerDesc& other) const = default;
+	};
+
+	enum class TextureFormat : uint8_t
+	{
+		//8 bit RGBA per texel
+		Rgba8,
+		//Block compressed, 4x4 texels per block (BlockCompression.h)
+		//RGB in 8 bytes
+		Bc1,
+		//RGB as Bc1 + alpha as Bc4 in 16 bytes
+		Bc3,
+		//One channel in 8 bytes, sampled as R
+		Bc4,
+		//Two Bc4 channels in 16 bytes, sampled as RG
+		Bc5,
+		//RGBA in 16 bytes
+		Bc7
+	};
+
+	//Bytes per 4x4 block, 0 for formats stored per texel
+	constexpr uint32_t GetBlockSize(TextureFormat format)
+	{
+		switch (format)
+		{
+		case TextureFormat::Bc1:
+		case TextureFormat::Bc4:
+			return 8;
+		case TextureFormat::Bc3:
+		case TextureFormat::Bc5:
+		case TextureFormat::Bc7:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	//Bytes per row of texels, or per row of blocks for block compressed formats
+	constexpr uint32_t GetRowPitch(TextureFormat format, uint32_t width)
+	{
+		return GetBlockSize(format) == 0 ? width * 4 : (width + 3) / 4 * GetBlockSize(format);
+	}
+
+	//Rows of texels, or rows of blocks
+	constexpr uint32_t GetNumRows(TextureFormat format, uint32_t height)
+	{
+		return GetBlockSize(format) == 0 ? height : (height + 3) / 4;
+	}
+
+	//One mip level, rows as GetRowPitch lays them out (rowPitch can be larger)
+	struct TextureLevel
+	{
+		const void* pPixels{ nullptr };
+		uint32_t width{};
+		uint32_t height{};
+		uint32_t rowPitch{};
+	};
+
+	//Block of the per-frame constant ring, written through pData and bound by offset
+	struct ConstantBlock
+	{
+		uint8_t* pData{ nullptr };
+		uint32_t offset{};
+		//The ring was recreated to fit the block, constants bound before still point into the old buffer
+		bool isNewRing{ false };
+	};
+
+	//Everything the renderer needs from a graphics API.
+	//Resources can be created from any thread, effect state, frames and command buffers belong to the render thread.
+	class GraphicsDevice : public CommandBackend
+	{
+	public:
+		GraphicsDevice() = default;
+		virtual ~GraphicsDevice() = default;
+
+		// rule of 5 copypasta
+		GraphicsDevice(const GraphicsDevice& other) = delete;
+		GraphicsDevice(GraphicsDevice&& other) = delete;
+		GraphicsDevice& operator=(const GraphicsDevice& other) = delete;
+		GraphicsDevice& operator=(GraphicsDevice&& other) = delete;
+
+		//Offsets of bound constant blocks are in units of 16 constants (D3D11.1 *SetConstantBuffers1)
+		static constexpr uint32_t ConstantAlignment{ 256 };
+		static constexpr uint32_t AlignConstantSize(uint32_t size)
+		{
+			return (size + ConstantAlignment - 1) & ~(ConstantAlignment - 1);
+		}
+
+		virtual bool IsInitialized() const = 0;
+
+		//Threads the device may spread its own work over, the renderer hands it its pool (null takes it back).
+		//Only called while no frame is being rendered. Devices that leave the work to a GPU ignore it.
+		virtual void SetJobSystem(JobSystem*) {}
+
+		//Resources
+		virtual BufferHandle CreateVertexBuffer(const void* pVertices, uint32_t byteSize) = 0;
+		virtual BufferHandle CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices) = 0;
+		//Level 0 first, every next level half the size of the one before (rounded down, at least 1).
+		//Block compressed textures need a level 0 that is a multiple of 4 texels wide and high.
+		virtual TextureHandle CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels) = 0;
+		//Every call compiles or loads a new effect, ResourceRegistry shares them
+		virtual EffectHandle CreateEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines) = 0;
+		//Layout of a Vertex as the first pass of the effect expects it
+		virtual InputLayoutHandle CreateInputLayout(EffectHandle effect) = 0;
+		virtual SamplerHandle CreateSampler(const SamplerDesc& desc) = 0;
+
+		virtual uint32_t GetNumPasses(EffectHandle effect) const = 0;
+
+		virtual void Release(BufferHandle buffer) = 0;
+		virtual void Release(TextureHandle texture) = 0;
+		virtual void Release(EffectHandle effect) = 0;
+		virtual void Release(InputLayoutHandle layout) = 0;
+		virtual void Release(SamplerHandle sampler) = 0;
+
+		//Effect state, kept by the effect until it's set again
+		virtual void SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture) = 0;
+		virtual void SetSampler(EffectHandle effect, SamplerHandle sampler) = 0;
+		//Effects without a cbMaterial ignore it
+		virtual void SetMaterial(EffectHandle effect, const MaterialConstants& material) = 0;
+
+		//Frame, draws in between are submitted as command buffers
+		virtual void BeginFrame(const ColorRGB& clearColor) = 0;
+		virtual void Present() = 0;
+
+		//Reserves size bytes of constant data for the current frame, in one contiguous block.
+		//The block stays valid until the GPU is done with the frame, the pointer only until UnmapConstants.
+		//pData is null if the block doesn't fit, the ring only grows at the first map of a frame.
+		//After it grew every constant slot has to be set again, even to the same offset.
+		virtual ConstantBlock MapConstants(uint32_t size) = 0;
+		virtual void UnmapConstants() = 0;
+	};
+}
@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+#include <cassert>
+
+namespace dae
+{
+	namespace
+	{
+		//Which queue the current thread owns, non-worker threads share the last one
+		thread_local const JobSystem* t_pOwner{ nullptr };
+		thread_local uint32_t t_QueueIndex{};
+	}
+
+	bool JobCounter::IsDone() const
+	{
+		return m_Pending.load(std::memory_order_acquire) == 0;
+	}
+
+	JobSystem::JobSystem(uint32_t numWorkers)
+		: m_Queues(numWorkers + 1)
+	{
+		m_Workers.reserve(numWorkers);
+		for (uint32_t i{}; i < numWorkers; ++i)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard lock{ m_SleepMutex };
+			m_IsRunning = false;
+		}
+		m_SleepCondition.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t JobSystem::DefaultNumWorkers()
+	{
+		const uint32_t numCores{ std::thread::hardware_concurrency() };
+		return numCores > 1 ? numCores - 1 : 0;
+	}
+
+	uint32_t JobSystem::GetNumThreads() const
+	{
+		return static_cast<uint32_t>(m_Workers.size()) + 1;
+	}
+
+	void JobSystem::Run(std::function<void()> job, JobCounter* pCounter)
+	{
+		if (pCounter)
+			pCounter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		Push(Job{ std::move(job), pCounter });
+	}
+
+	void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* pCounter)
+	{
+		if (pCounter)
+			pCounter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			//The lock orders us against the job that brings the dependency to zero and drains the continuations
+			std::lock_guard lock{ dependency.m_Mutex };
+			if (!dependency.IsDone())
+			{
+				dependency.m_Continuations.emplace_back([this, job = std::move(job), pCounter]() mutable
+					{
+						Push(Job{ std::move(job), pCounter });
+					});
+				return;
+			}
+		}
+
+		Push(Job{ std::move(job), pCounter });
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		const bool isWorker{ t_pOwner == this };
+		const uint32_t queueIndex{ isWorker ? t_QueueIndex : static_cast<uint32_t>(m_Queues.size()) - 1 };
+		//Without workers nobody else runs the rest, e.g. what a RunAfter continuation queued
+		const JobCounter* pOnly{ isWorker || m_Workers.empty() ? nullptr : &counter };
+		while (!counter.IsDone())
+		{
+			if (!TryExecuteOne(queueIndex, pOnly))
+				std::this_thread::yield();
+		}
+
+		//The last job drops the count while holding the lock, wait for it to let go before the counter can be destroyed
+		std::lock_guard lock{ counter.m_Mutex };
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function)
+	{
+		assert(batchSize > 0);
+		if (count == 0)
+			return;
+
+		//A single batch doesn't need the round trip through the queues
+		if (count <= batchSize)
+		{
+			function(0, count);
+			return;
+		}
+
+		JobCounter counter{};
+		for (uint32_t begin{}; begin < count; begin += batchSize)
+		{
+			const uint32_t end{ std::min(count, begin + batchSize) };
+			Run([&function, begin, end]() { function(begin, end); }, &counter);
+		}
+
+		Wait(counter);
+	}
+
+	void JobSystem::Push(Job&& job)
+	{
+		const uint32_t queueIndex{ t_pOwner == this ? t_QueueIndex : static_cast<uint32_t>(m_Queues.size()) - 1 };
+		{
+			WorkQueue& queue{ m_Queues[queueIndex] };
+			std::lock_guard lock{ queue.mutex };
+			queue.jobs.push_back(std::move(job));
+		}
+
+		m_NumQueued.fetch_add(1, std::memory_order_release);
+		{
+			//Taking the lock makes sure a worker that just found nothing is already waiting
+			std::lock_guard lock{ m_SleepMutex };
+		}
+		m_SleepCondition.notify_one();
+	}
+
+	bool JobSystem::TryExecuteOne(uint32_t queueIndex, const JobCounter* pOnly)
+	{
+		Job job{};
+		bool hasJob{ false };
+		const auto isWanted = [pOnly](const Job& queued) { return !pOnly || queued.pCounter == pOnly; };
+
+		//Own queue: newest first, it's most likely still in cache
+		{
+			WorkQueue& queue{ m_Queues[queueIndex] };
+			std::lock_guard lock{ queue.mutex };
+			const auto it{ std::find_if(queue.jobs.rbegin(), queue.jobs.rend(), isWanted) };
+			if (it != queue.jobs.rend())
+			{
+				job = std::move(*it);
+				queue.jobs.erase(std::next(it).base());
+				hasJob = true;
+			}
+		}
+
+		//Steal the oldest job of another queue
+		const uint32_t numQueues{ static_cast<uint32_t>(m_Queues.size()) };
+		for (uint32_t offset{ 1 }; !hasJob && offset < numQueues; ++offset)
+		{
+			WorkQueue& queue{ m_Queues[(queueIndex + offset) % numQueues] };
+			std::lock_guard lock{ queue.mutex };
+			const auto it{ std::find_if(queue.jobs.begin(), queue.jobs.end(), isWanted) };
+			if (it != queue.jobs.end())
+			{
+				job = std::move(*it);
+				queue.jobs.erase(it);
+				hasJob = true;
+			}
+		}
+
+		if (!hasJob)
+			return false;
+
+		m_NumQueued.fetch_sub(1, std::memory_order_relaxed);
+		Execute(job);
+		return true;
+	}
+
+	void JobSystem::Execute(Job& job)
+	{
+		job.function();
+
+		JobCounter* pCounter{ job.pCounter };
+		if (!pCounter)
+			return;
+
+		std::vector<std::function<void()>> continuations{};
+		{
+			std::lock_guard lock{ pCounter->m_Mutex };
+			if (pCounter->m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				continuations.swap(pCounter->m_Continuations);
+		}
+
+		for (std::function<void()>& continuation : continuations)
+		{
+			continuation();
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t workerIndex)
+	{
+		t_pOwner = this;
+		t_QueueIndex = workerIndex;
+
+		while (true)
+		{
+			if (TryExecuteOne(workerIndex))
+				continue;
+
+			std::unique_lock lock{ m_SleepMutex };
+			m_SleepCondition.wait(lock, [this]()
+				{
+					return !m_IsRunning || m_NumQueued.load(std::memory_order_acquire) > 0;
+				});
+
+			if (!m_IsRunning)
+				return;
+		}
+	}
+}
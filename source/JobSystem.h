@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace dae
+{
+	class JobSystem;
+
+	//Counts the jobs that still have to finish, jobs queued with RunAfter start when it reaches zero
+	class JobCounter final
+	{
+	public:
+		JobCounter() = default;
+		~JobCounter() = default;
+
+		JobCounter(const JobCounter& other) = delete;
+		JobCounter(JobCounter&& other) = delete;
+		JobCounter& operator=(const JobCounter& other) = delete;
+		JobCounter& operator=(JobCounter&& other) = delete;
+
+		bool IsDone() const;
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_Pending{};
+		mutable std::mutex m_Mutex{};
+		std::vector<std::function<void()>> m_Continuations{};
+	};
+
+	//Fixed pool of worker threads, each with its own deque.
+	//A worker pops its newest job first and steals the oldest job from the others when it runs dry.
+	//Threads that wait on a counter execute jobs instead of blocking. Workers take any job, other threads only the jobs
+	//of the counter they wait on: the render thread waiting on its ParallelFor never ends up running a texture load.
+	class JobSystem final
+	{
+	public:
+		//0 workers is valid: everything then runs on the thread that waits
+		explicit JobSystem(uint32_t numWorkers = DefaultNumWorkers());
+		~JobSystem();
+
+		JobSystem(const JobSystem& other) = delete;
+		JobSystem(JobSystem&& other) = delete;
+		JobSystem& operator=(const JobSystem& other) = delete;
+		JobSystem& operator=(JobSystem&& other) = delete;
+
+		void Run(std::function<void()> job, JobCounter* pCounter = nullptr);
+		//Starts the job once dependency is done (or immediately if it already is)
+		void RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* pCounter = nullptr);
+		void Wait(const JobCounter& counter);
+
+		//Splits [0, count) into batches of batchSize and blocks until all of them ran
+		void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+		//Workers + the calling thread
+		uint32_t GetNumThreads() const;
+
+		static uint32_t DefaultNumWorkers();
+
+	private:
+		struct Job
+		{
+			std::function<void()> function{};
+			JobCounter* pCounter{ nullptr };
+		};
+
+		struct WorkQueue
+		{
+			std::mutex mutex{};
+			std::deque<Job> jobs{};
+		};
+
+		void Push(Job&& job);
+		//With pOnly set, only a job of that counter
+		bool TryExecuteOne(uint32_t queueIndex, const JobCounter* pOnly = nullptr);
+		void Execute(Job& job);
+		void WorkerLoop(uint32_t workerIndex);
+
+		std::vector<std::thread> m_Workers{};
+		//One queue per worker plus one shared by every non-worker thread
+		std::vector<WorkQueue> m_Queues;
+
+		std::atomic<uint32_t> m_NumQueued{};
+		std::atomic<bool> m_IsRunning{ true };
+		std::mutex m_SleepMutex{};
+		std::condition_variable m_SleepCondition{};
+	};
+}
@@ -19,14 +19,27 @@ namespace dae {
 		data[1] = yAxis;
 		data[2] = zAxis;
 		data[3] = t;
+
+		ClassifyFromWColumn();
 	}
 
 	Matrix::Matrix(const Matrix& m)
 	{
-		data[0] = m[0];
-		data[1] = m[1];
-		data[2] = m[2];
-		data[3] = m[3];
+		//StoreMatrix and the SIMD transforms read the first 64 bytes as the rows
+		static_assert(offsetof(Matrix, data) == 0 && sizeof(data) == 16 * sizeof(float), "Matrix has to start with its 16 floats");
+
+		data[0] = m.data[0];
+		data[1] = m.data[1];
+		data[2] = m.data[2];
+		data[3] = m.data[3];
+		type = m.type;
+	}
+
+	void Matrix::ClassifyFromWColumn()
+	{
+		//Without knowing how the axes were built, the best we can tell cheaply is affine or not
+		const bool isAffine{ data[0].w == 0.f && data[1].w == 0.f && data[2].w == 0.f && data[3].w == 1.f };
+		type = isAffine ? TransformType::Affine : TransformType::Projective;
 	}
 
 	Vector3 Matrix::TransformVector(const Vector3& v) const
@@ -74,24 +87,101 @@ namespace dae {
 
 	const Matrix& Matrix::Transpose()
 	{
+		if (type == TransformType::Identity)
+			return *this;
+
 		Matrix result{};
 		for (int r{ 0 }; r < 4; ++r)
 		{
 			for (int c{ 0 }; c < 4; ++c)
 			{
-				result[r][c] = data[c][r];
+				result.data[r][c] = data[c][r];
 			}
 		}
 
-		data[0] = result[0];
-		data[1] = result[1];
-		data[2] = result[2];
-		data[3] = result[3];
+		data[0] = result.data[0];
+		data[1] = result.data[1];
+		data[2] = result.data[2];
+		data[3] = result.data[3];
+
+		ClassifyFromWColumn();
 
 		return *this;
 	}
 
 	const Matrix& Matrix::Inverse()
+	{
+		switch (type)
+		{
+		case TransformType::Identity:
+			break;
+		case TransformType::Translation:
+			*this = InverseTranslation();
+			break;
+		case TransformType::Rigid:
+			*this = InverseRigid();
+			break;
+		case TransformType::Affine:
+			*this = InverseAffine();
+			break;
+		case TransformType::Projective:
+			*this = InverseProjective();
+			break;
+		}
+
+		return *this;
+	}
+
+	Matrix Matrix::InverseTranslation() const
+	{
+		return CreateTranslation(-data[3].x, -data[3].y, -data[3].z);
+	}
+
+	Matrix Matrix::InverseRigid() const
+	{
+		//Orthonormal axes => the 3x3 inverse is its transpose, translation becomes -t * R^T
+		const Vector3 a = data[0];
+		const Vector3 b = data[1];
+		const Vector3 c = data[2];
+		const Vector3 t = data[3];
+
+		Matrix result{
+			Vector4{ a.x, b.x, c.x, 0.f },
+			Vector4{ a.y, b.y, c.y, 0.f },
+			Vector4{ a.z, b.z, c.z, 0.f },
+			Vector4{ -Vector3::Dot(t, a), -Vector3::Dot(t, b), -Vector3::Dot(t, c), 1.f } };
+		result.type = TransformType::Rigid;
+
+		return result;
+	}
+
+	Matrix Matrix::InverseAffine() const
+	{
+		//3x3 inverse through cross products, translation becomes -t * A^-1
+		const Vector3 a = data[0];
+		const Vector3 b = data[1];
+		const Vector3 c = data[2];
+		const Vector3 t = data[3];
+
+		const Vector3 bc = Vector3::Cross(b, c);
+		const Vector3 ca = Vector3::Cross(c, a);
+		const Vector3 ab = Vector3::Cross(a, b);
+
+		const float det = Vector3::Dot(a, bc);
+		assert((!AreEqual(det, 0.f)) && "ERROR: determinant is 0, there is no INVERSE!");
+		const float invDet = 1.f / det;
+
+		const Vector3 r0 = Vector3{ bc.x, ca.x, ab.x } * invDet;
+		const Vector3 r1 = Vector3{ bc.y, ca.y, ab.y } * invDet;
+		const Vector3 r2 = Vector3{ bc.z, ca.z, ab.z } * invDet;
+
+		Matrix result{ r0, r1, r2, -(r0 * t.x + r1 * t.y + r2 * t.z) };
+		result.type = TransformType::Affine;
+
+		return result;
+	}
+
+	Matrix Matrix::InverseProjective() const
 	{
 		//Optimized Inverse as explained in FGED1 - used widely in other libraries too.
 		const Vector3& a = data[0];
@@ -118,14 +208,16 @@ namespace dae {
 		const Vector3 r0 = Vector3::Cross(b, v) + t * y;
 		const Vector3 r1 = Vector3::Cross(v, a) - t * x;
 		const Vector3 r2 = Vector3::Cross(d, u) + s * w;
-		//Vector3 r3 = Vector3::Cross(u, c) - s * z;
+		const Vector3 r3 = Vector3::Cross(u, c) - s * z;
 
-		data[0] = Vector4{ r0.x, r1.x, r2.x, 0.f };
-		data[1] = Vector4{ r0.y, r1.y, r2.y, 0.f };
-		data[2] = Vector4{ r0.z, r1.z, r2.z, 0.f };
-		data[3] = {-Vector3::Dot(b, t),Vector3::Dot(a, t),-Vector3::Dot(d, s),Vector3::Dot(c, s) };
+		Matrix result{};
+		result.data[0] = Vector4{ r0.x, r1.x, r2.x, r3.x };
+		result.data[1] = Vector4{ r0.y, r1.y, r2.y, r3.y };
+		result.data[2] = Vector4{ r0.z, r1.z, r2.z, r3.z };
+		result.data[3] = {-Vector3::Dot(b, t),Vector3::Dot(a, t),-Vector3::Dot(d, s),Vector3::Dot(c, s) };
+		result.type = TransformType::Projective;
 
-		return *this;
+		return result;
 	}
 
 	Matrix Matrix::Transpose(const Matrix& m)
@@ -176,6 +268,11 @@ namespace dae {
 		return data[3];
 	}
 
+	TransformType Matrix::GetTransformType() const
+	{
+		return type;
+	}
+
 	Matrix Matrix::CreateTranslation(float x, float y, float z)
 	{
 		return CreateTranslation({ x, y, z });
@@ -183,37 +280,49 @@ namespace dae {
 
 	Matrix Matrix::CreateTranslation(const Vector3& t)
 	{
-		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+		Matrix result{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+		result.type = TransformType::Translation;
+
+		return result;
 	}
 
 	Matrix Matrix::CreateRotationX(float pitch)
 	{
-		return {
+		Matrix result{
 			{1, 0, 0, 0},
 			{0, cos(pitch), -sin(pitch), 0},
 			{0, sin(pitch), cos(pitch), 0},
 			{0, 0, 0, 1}
 		};
+		result.type = TransformType::Rigid;
+
+		return result;
 	}
 
 	Matrix Matrix::CreateRotationY(float yaw)
 	{
-		return {
+		Matrix result{
 			{cos(yaw), 0, -sin(yaw), 0},
 			{0, 1, 0, 0},
 			{sin(yaw), 0, cos(yaw), 0},
 			{0, 0, 0, 1}
 		};
+		result.type = TransformType::Rigid;
+
+		return result;
 	}
 
 	Matrix Matrix::CreateRotationZ(float roll)
 	{
-		return {
+		Matrix result{
 			{cos(roll), sin(roll), 0, 0},
 			{-sin(roll), cos(roll), 0, 0},
 			{0, 0, 1, 0},
 			{0, 0, 0, 1}
 		};
+		result.type = TransformType::Rigid;
+
+		return result;
 	}
 
 	Matrix Matrix::CreateRotation(float pitch, float yaw, float roll)
@@ -236,11 +345,29 @@ namespace dae {
 		return CreateScale(s[0], s[1], s[2]);
 	}
 
+	Matrix Matrix::CreateRigid(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t)
+	{
+		//Caller guarantees orthonormal axes, only checked in debug
+		assert(AreEqual(xAxis.SqrMagnitude(), 1.f, 0.001f) && AreEqual(yAxis.SqrMagnitude(), 1.f, 0.001f) && AreEqual(zAxis.SqrMagnitude(), 1.f, 0.001f));
+		assert(AreEqual(Vector3::Dot(xAxis, yAxis), 0.f, 0.001f) && AreEqual(Vector3::Dot(yAxis, zAxis), 0.f, 0.001f) && AreEqual(Vector3::Dot(zAxis, xAxis), 0.f, 0.001f));
+
+		Matrix result{ xAxis, yAxis, zAxis, t };
+		result.type = TransformType::Rigid;
+
+		return result;
+	}
+
 #pragma region Operator Overloads
-	Vector4& Matrix::operator[](int index)
+	void Matrix::SetRow(int index, const Vector4& row)
 	{
 		assert(index <= 3 && index >= 0);
-		return data[index];
+		data[index] = row;
+
+		//A new translation leaves the axes, and what we knew about them, as they were
+		if (index == 3 && row.w == 1.f && type <= TransformType::Affine)
+			type = std::max(type, TransformType::Translation);
+		else
+			ClassifyFromWColumn();
 	}
 
 	Vector4 Matrix::operator[](int index) const
@@ -251,34 +378,61 @@ namespace dae {
 
 	Matrix Matrix::operator*(const Matrix& m) const
 	{
-		Matrix result{};
-		Matrix m_transposed = Transpose(m);
+		if (m.type == TransformType::Identity)
+			return *this;
+		if (type == TransformType::Identity)
+			return m;
+
+		if (type == TransformType::Translation && m.type == TransformType::Translation)
+			return CreateTranslation(GetTranslation() + m.GetTranslation());
+
+		if (type <= TransformType::Affine && m.type <= TransformType::Affine)
+			return MultiplyAffine(*this, m);
 
+		return MultiplyProjective(*this, m);
+	}
+
+	const Matrix& Matrix::operator*=(const Matrix& m)
+	{
+		*this = *this * m;
+
+		return *this;
+	}
+
+	Matrix Matrix::MultiplyAffine(const Matrix& m1, const Matrix& m2)
+	{
+		//Both w columns are (0,0,0,1): skip them and only add m2's translation to the last row
+		Matrix result{};
 		for (int r{ 0 }; r < 4; ++r)
 		{
-			for (int c{ 0 }; c < 4; ++c)
-			{
-				result[r][c] = Vector4::Dot(data[r], m_transposed[c]);
-			}
+			const Vector4& row = m1.data[r];
+			const Vector3 transformed = m2.data[0] * row.x + m2.data[1] * row.y + m2.data[2] * row.z;
+			result.data[r] = Vector4{ transformed, row.w };
 		}
+		result.data[3] += Vector4{ m2.data[3].x, m2.data[3].y, m2.data[3].z, 0.f };
+
+		result.type = std::max(m1.type, m2.type);
 
 		return result;
 	}
 
-	const Matrix& Matrix::operator*=(const Matrix& m)
+	Matrix Matrix::MultiplyProjective(const Matrix& m1, const Matrix& m2)
 	{
-		Matrix copy{ *this };
-		Matrix m_transposed = Transpose(m);
+		Matrix result{};
+		const Matrix m_transposed = Transpose(m2);
 
 		for (int r{ 0 }; r < 4; ++r)
 		{
 			for (int c{ 0 }; c < 4; ++c)
 			{
-				data[r][c] = Vector4::Dot(copy[r], m_transposed[c]);
+				result.data[r][c] = Vector4::Dot(m1.data[r], m_transposed.data[c]);
 			}
 		}
 
-		return *this;
+		//Two projective matrices could still combine into an affine one
+		result.ClassifyFromWColumn();
+
+		return result;
 	}
 #pragma endregion
 }
\ No newline at end of file
@@ -3,6 +3,16 @@
 #include "Vector4.h"
 
 namespace dae {
+	//Ordered from cheapest to most general, combining two transforms yields the "largest" of both
+	enum class TransformType : uint8_t
+	{
+		Identity = 0,
+		Translation = 1,
+		Rigid = 2,		//rotation + translation (orthonormal axes)
+		Affine = 3,		//any 3x3 + translation, w column is (0,0,0,1)
+		Projective = 4
+	};
+
 	struct Matrix
 	{
 		Matrix() = default;
@@ -19,6 +29,7 @@ namespace dae {
 			const Vector4& t);
 
 		Matrix(const Matrix& m);
+		Matrix& operator=(const Matrix& m) = default;
 
 		Vector3 TransformVector(const Vector3& v) const;
 		Vector3 TransformVector(float x, float y, float z) const;
@@ -35,6 +46,7 @@ namespace dae {
 		Vector3 GetAxisY() const;
 		Vector3 GetAxisZ() const;
 		Vector3 GetTranslation() const;
+		TransformType GetTransformType() const;
 
 		static Matrix CreateTranslation(float x, float y, float z);
 		static Matrix CreateTranslation(const Vector3& t);
@@ -45,18 +57,29 @@ namespace dae {
 		static Matrix CreateRotation(const Vector3& r);
 		static Matrix CreateScale(float sx, float sy, float sz);
 		static Matrix CreateScale(const Vector3& s);
+		static Matrix CreateRigid(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t);
 		static Matrix Transpose(const Matrix& m);
 		static Matrix Inverse(const Matrix& m);
 
 		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
 		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
 
-		Vector4& operator[](int index);
+		//Writes go through SetRow so the type stays right, there is no non-const operator[]
 		Vector4 operator[](int index) const;
+		void SetRow(int index, const Vector4& row);
 		Matrix operator*(const Matrix& m) const;
 		const Matrix& operator*=(const Matrix& m);
 
 	private:
+		Matrix InverseTranslation() const;
+		Matrix InverseRigid() const;
+		Matrix InverseAffine() const;
+		Matrix InverseProjective() const;
+
+		static Matrix MultiplyAffine(const Matrix& m1, const Matrix& m2);
+		static Matrix MultiplyProjective(const Matrix& m1, const Matrix& m2);
+
+		void ClassifyFromWColumn();
 
 		//Row-Major Matrix
 		Vector4 data[4]
@@ -71,5 +94,8 @@ namespace dae {
 		// v1x v1y v1z v1w
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
+
+		//Tracked by the Create... functions and SetRow. It comes after the 16 floats, which StoreMatrix copies as they are.
+		TransformType type{ TransformType::Identity };
 	};
 }
\ No newline at end of file
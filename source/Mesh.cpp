@@ -1,117 +1,215 @@
 #include "pch.h"
 #include "Mesh.h"
-#include "Effect.h"
 #include <cassert>
-#include "utils.h"
+#include <cstring>
+#include "Utils.h"
+#include "FrameStats.h"
+#include "Frustum.h"
+#include "FramePipeline.h"
 
 using namespace dae;
 
-Mesh::Mesh(ID3D11Device* pDevice, const std::string& objectPath, Effect* pEffect)
-	:m_pEffect{ pEffect }
+Mesh::Mesh(GraphicsDevice* pDevice, const std::string& objectPath, EffectHandle effect, TransformId transformId)
+	:m_pDevice{ pDevice }
+	,m_Effect{ effect }
+	,m_TransformId{ transformId }
 {
 	std::vector<Vertex> vertices{};
 	std::vector<uint32_t> indices{};
 	Utils::ParseOBJ(objectPath, vertices, indices);
 
-	m_pInputLayout = m_pEffect->LoadInputLayout(pDevice);
+	InitMesh(vertices, indices);
+}
 
-	InitMesh(pDevice, vertices, indices);
+Mesh::Mesh(GraphicsDevice* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, EffectHandle effect, TransformId transformId)
+	:m_pDevice{ pDevice }
+	,m_Effect{ effect }
+	,m_TransformId{ transformId }
+{
+	InitMesh(vertices, indices);
 }
 
-void Mesh::InitMesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+void Mesh::InitMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
 {
-	//Create Vertex buffer
-	D3D11_BUFFER_DESC bd{};
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(vertices.size());
-	bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
+	m_InputLayout = m_pDevice->CreateInputLayout(m_Effect);
+	m_NumPasses = m_pDevice->GetNumPasses(m_Effect);
 
-	D3D11_SUBRESOURCE_DATA initData = {};
-	initData.pSysMem = vertices.data();
+	//Bounding sphere around the center of the AABB
+	if (!vertices.empty())
+	{
+		Vector3 min{ vertices[0].position };
+		Vector3 max{ vertices[0].position };
+		for (const Vertex& vertex : vertices)
+		{
+			min = { std::min(min.x, vertex.position.x), std::min(min.y, vertex.position.y), std::min(min.z, vertex.position.z) };
+			max = { std::max(max.x, vertex.position.x), std::max(max.y, vertex.position.y), std::max(max.z, vertex.position.z) };
+		}
+
+		m_BoundsCenter = (min + max) * 0.5f;
+		for (const Vertex& vertex : vertices)
+		{
+			m_BoundsRadius = std::max(m_BoundsRadius, (vertex.position - m_BoundsCenter).SqrMagnitude());
+		}
+		m_BoundsRadius = sqrtf(m_BoundsRadius);
+	}
 
-	HRESULT result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
-	if (FAILED(result))
-		return;
+	//Average texel density, what texture streaming picks the mip level from
+	float worldArea{};
+	float uvArea{};
+	for (size_t i{}; i + 2 < indices.size(); i += 3)
+	{
+		const Vertex& v0{ vertices[indices[i]] };
+		const Vertex& v1{ vertices[indices[i + 1]] };
+		const Vertex& v2{ vertices[indices[i + 2]] };
+		worldArea += Vector3::Cross(v1.position - v0.position, v2.position - v0.position).Magnitude();
+		uvArea += std::abs(Vector2::Cross(v1.uv - v0.uv, v2.uv - v0.uv));
+	}
+	if (worldArea > 0.f && uvArea > 0.f)
+		m_WorldUnitsPerUv = sqrtf(worldArea / uvArea);
 
+	m_VertexBuffer = m_pDevice->CreateVertexBuffer(vertices.data(), sizeof(Vertex) * static_cast<uint32_t>(vertices.size()));
 
-	//Create Index Buffer
 	m_NumIndices = static_cast<uint32_t>(indices.size());
-	bd.Usage = D3D11_USAGE_IMMUTABLE;
-	bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
-	bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bd.CPUAccessFlags = 0;
-	bd.MiscFlags = 0;
-	initData.pSysMem = indices.data();
-	result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
-	if (FAILED(result))
-		return;
+	m_IndexBuffer = m_pDevice->CreateIndexBuffer(indices.data(), m_NumIndices);
 }
 
 Mesh::~Mesh()
 {
-	delete m_pEffect;
-
-	if (m_pVertexBuffer) m_pVertexBuffer->Release();
+	m_pDevice->Release(m_VertexBuffer);
+	m_pDevice->Release(m_IndexBuffer);
+	m_pDevice->Release(m_InputLayout);
+}
 
-	if (m_pIndexBuffer) m_pIndexBuffer->Release();
+void Mesh::Update(const TransformSystem& transforms)
+{
+	if (transforms.IsChanged(m_TransformId))
+	{
+		m_WorldMatrix = transforms.GetWorldMatrix(m_TransformId);
+		++m_WorldVersion;
+	}
 }
 
-void Mesh::Update(const Timer* pTimer)
+void Mesh::UpdateMatrices(const Matrix& viewProjection, uint32_t viewProjectionVersion, FrameStats& stats)
 {
-	if (m_IsRotating)
+	if (m_WorldVersion == m_ComputedWorldVersion && viewProjectionVersion == m_ComputedViewProjectionVersion)
 	{
-		constexpr float rotationSpeed{ 1 };
-		m_Rotation += pTimer->GetElapsed() * rotationSpeed;
-		m_WorldMatrix = Matrix::CreateRotationY(m_Rotation) * m_StartWorldMatrix;
+		++stats.matricesSkipped;
+		return;
 	}
+
+	m_WorldViewProjectionMatrix = m_WorldMatrix * viewProjection;
+	m_ComputedWorldVersion = m_WorldVersion;
+	m_ComputedViewProjectionVersion = viewProjectionVersion;
+	++stats.matricesComputed;
 }
 
-void Mesh::Render(ID3D11DeviceContext* pDeviceContext) const
+DrawItem Mesh::CreateDrawItem(uint32_t meshIndex) const
 {
+	DrawItem draw{ meshIndex };
+	StoreMatrix(draw.constants.worldViewProjection, m_WorldViewProjectionMatrix);
+	StoreMatrix(draw.constants.world, m_WorldMatrix);
+	return draw;
+}
+
+void Mesh::Record(CommandBuffer& commands, const DrawItem& draw, uint8_t* pConstants, uint32_t constantsOffset, uint32_t frameConstantsOffset) const
+{
+	//Everything is recorded, the renderer's StateCache drops what the device already has bound
+
+	//0. Per-object constants straight into the mapped ring, one copy however many members the block has
+	std::memcpy(pConstants, &draw.constants, sizeof(ObjectConstants));
+
 	//1. Set Primitive Topology
-	pDeviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commands.SetPrimitiveTopology(PrimitiveTopology::TriangleList);
 
 	//2. Set Input Layout
-	pDeviceContext->IASetInputLayout(m_pInputLayout);
+	commands.SetInputLayout(m_InputLayout);
 
 	//3. Set VertexBuffer
-	constexpr UINT stride = sizeof(Vertex);
-	constexpr UINT offset = 0;
-	pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+	commands.SetVertexBuffer(m_VertexBuffer, sizeof(Vertex));
 
 	//4. Set IndexBuffer
-	pDeviceContext->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+	commands.SetIndexBuffer(m_IndexBuffer);
 
 	//5. Draw
-	D3DX11_TECHNIQUE_DESC techDesc{};
-	m_pEffect->GetTechnique()->GetDesc(&techDesc);
-	for (UINT p = 0; p < techDesc.Passes; ++p)
+	constexpr uint32_t constantsSize{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+	constexpr uint32_t frameConstantsSize{ GraphicsDevice::AlignConstantSize(sizeof(FrameConstants)) };
+	for (uint32_t p{}; p < m_NumPasses; ++p)
 	{
-		m_pEffect->GetTechnique()->GetPassByIndex(p)->Apply(0, pDeviceContext);
-		pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+		commands.ApplyPass(m_Effect, p);
+		commands.SetConstants(ConstantSlot::Frame, frameConstantsOffset, frameConstantsSize);
+		commands.SetConstants(ConstantSlot::Object, constantsOffset, constantsSize);
+		commands.DrawIndexed(m_NumIndices);
 	}
+}
+
+void Mesh::UpdateVisibility(const Frustum& frustum)
+{
+	m_WorldScale = sqrtf(std::max({ m_WorldMatrix.GetAxisX().SqrMagnitude(), m_WorldMatrix.GetAxisY().SqrMagnitude(), m_WorldMatrix.GetAxisZ().SqrMagnitude() }));
+	m_WorldBoundsCenter = m_WorldMatrix.TransformPoint(m_BoundsCenter);
+
+	m_IsVisible = frustum.IsSphereVisible(m_WorldBoundsCenter, m_BoundsRadius * m_WorldScale);
+}
 
+void Mesh::AppendTransformed(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Matrix& world,
+	std::vector<Vertex>& targetVertices, std::vector<uint32_t>& targetIndices)
+{
+	//Directions through the world matrix as is, renormalized: right for rotations and uniform scales, what props use
+	const uint32_t first{ static_cast<uint32_t>(targetVertices.size()) };
+	for (const Vertex& vertex : vertices)
+	{
+		targetVertices.push_back(Vertex{ world.TransformPoint(vertex.position), vertex.uv,
+			world.TransformVector(vertex.normal).Normalized(), world.TransformVector(vertex.tangent).Normalized() });
+	}
+
+	for (uint32_t index : indices)
+		targetIndices.push_back(first + index);
+}
 
+void Mesh::CreateCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	const Vector3 axes[3]{ Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ };
+	for (int axis{}; axis < 3; ++axis)
+	{
+		for (float side : { -1.f, 1.f })
+		{
+			const Vector3 normal{ axes[axis] * side };
+			const Vector3 tangent{ axes[(axis + 1) % 3] };
+			const Vector3 bitangent{ Vector3::Cross(normal, tangent) };
+
+			const uint32_t first{ static_cast<uint32_t>(vertices.size()) };
+			for (const Vector2& corner : { Vector2{ 0.f, 0.f }, Vector2{ 1.f, 0.f }, Vector2{ 1.f, 1.f }, Vector2{ 0.f, 1.f } })
+			{
+				const Vector3 position{ (normal + tangent * (corner.x * 2.f - 1.f) + bitangent * (corner.y * 2.f - 1.f)) * 0.5f };
+				vertices.push_back(Vertex{ position, corner, normal, tangent });
+			}
+			indices.insert(indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+		}
+	}
+}
+
+TransformId Mesh::GetTransformId() const
+{
+	return m_TransformId;
+}
+
+bool Mesh::IsVisible() const
+{
+	return m_IsVisible;
 }
 
-void Mesh::SetMatrix(const Matrix& matrix, Matrix* invViewMatrix)
+Vector3 Mesh::GetWorldBoundsCenter() const
 {
-	m_WorldViewProjectionMatrix = m_WorldMatrix * matrix;
-	m_pEffect->SetWorldViewProjMatrix(reinterpret_cast<float*>(&m_WorldViewProjectionMatrix));
-	m_pEffect->SetWorldMatrix(reinterpret_cast<float*>(&m_WorldMatrix));
-	m_pEffect->SetInverseViewMatrix(reinterpret_cast<float*>(invViewMatrix));
+	return m_WorldBoundsCenter;
 }
 
-void Mesh::ToggleRotation()
+float Mesh::GetWorldBoundsRadius() const
 {
-	m_IsRotating = !m_IsRotating;
+	return m_BoundsRadius * m_WorldScale;
 }
 
-void Mesh::SetSamplerState(ID3D11SamplerState* pSampleState)
+float Mesh::GetWorldUnitsPerUv() const
 {
-	m_pEffect->SetSampleState(pSampleState);
+	return m_WorldUnitsPerUv * m_WorldScale;
 }
 
 
@@ -1,4 +1,6 @@
 #pragma once
+#include "TransformSystem.h"
+#include "GraphicsDevice.h"
 
 namespace dae
 {
@@ -10,13 +12,16 @@ namespace dae
 		Vector3 tangent;
 	};
 
-	class Effect;
-	class Texture;
+	struct FrameStats;
+	struct Frustum;
+	struct DrawItem;
 
 	class Mesh final
 	{
 	public:
-		Mesh(ID3D11Device* pDevice, const std::string& objectPath, Effect* pEffect);
+		//The effect is shared, the renderer owns it
+		Mesh(GraphicsDevice* pDevice, const std::string& objectPath, EffectHandle effect, TransformId transformId);
+		Mesh(GraphicsDevice* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, EffectHandle effect, TransformId transformId);
 		~Mesh();
 
 		// rule of 5 copypasta
@@ -25,29 +30,64 @@ namespace dae
 		Mesh& operator=(const Mesh& other) = delete;
 		Mesh& operator=(Mesh&& other) = delete;
 
-		void Update(const Timer* pTimer);
-		void Render(ID3D11DeviceContext* pDeviceContext) const;
-		void SetMatrix(const Matrix& matrix, Matrix* invViewMatrix);
-		void ToggleRotation();
-		void SetSamplerState(ID3D11SamplerState* pSampleState);
+		//Update thread: only touches the simulation state below
+		void Update(const TransformSystem& transforms);
+		void UpdateMatrices(const Matrix& viewProjection, uint32_t viewProjectionVersion, FrameStats& stats);
+		//Tests the world-space bounding sphere, invisible meshes don't get a DrawItem
+		void UpdateVisibility(const Frustum& frustum);
+		DrawItem CreateDrawItem(uint32_t meshIndex) const;
+
+		//Render side: records the draw instead of issuing it, so meshes can record in parallel.
+		//The per-object constants are written to pConstants, the block at constantsOffset of the device's constant ring.
+		//The per-frame block at frameConstantsOffset is shared by every draw.
+		void Record(CommandBuffer& commands, const DrawItem& draw, uint8_t* pConstants, uint32_t constantsOffset, uint32_t frameConstantsOffset) const;
+
+		//Cook time: the vertices moved to world space and appended, so static meshes with the same effect and textures
+		//(e.g. props whose textures were put in one atlas) become a single mesh drawn once
+		static void AppendTransformed(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const Matrix& world,
+			std::vector<Vertex>& targetVertices, std::vector<uint32_t>& targetIndices);
+		//Unit cube around the origin, 4 vertices per face so every face gets its own normal, UVs covering each face once
+		static void CreateCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		TransformId GetTransformId() const;
+		bool IsVisible() const;
+		//As of the last UpdateVisibility
+		Vector3 GetWorldBoundsCenter() const;
+		float GetWorldBoundsRadius() const;
+		//World units one UV unit spans on average, for picking texture mip levels
+		float GetWorldUnitsPerUv() const;
 
 	private:
-		void InitMesh(ID3D11Device* pDevice, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+		void InitMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
 
-		Effect* m_pEffect{ nullptr };
-		ID3D11InputLayout* m_pInputLayout{ nullptr };
-		ID3D11Buffer* m_pVertexBuffer{ nullptr };
+		GraphicsDevice* m_pDevice{ nullptr };
+		EffectHandle m_Effect{ EffectHandle::Invalid };
+		InputLayoutHandle m_InputLayout{ InputLayoutHandle::Invalid };
+		BufferHandle m_VertexBuffer{ BufferHandle::Invalid };
 
 		uint32_t m_NumIndices{};
-		ID3D11Buffer* m_pIndexBuffer{ nullptr };
+		BufferHandle m_IndexBuffer{ BufferHandle::Invalid };
+		uint32_t m_NumPasses{};
+
+		//Object-space bounding sphere
+		Vector3 m_BoundsCenter{};
+		float m_BoundsRadius{};
+		bool m_IsVisible{ true };
+		Vector3 m_WorldBoundsCenter{};
+		float m_WorldScale{ 1.f };
+		//Object space
+		float m_WorldUnitsPerUv{ 1.f };
 
-		const Matrix m_StartWorldMatrix{ Matrix::CreateTranslation(0,0,0) };
+		//Position/rotation/scale live in the renderer's TransformSystem, we only keep the resulting world matrix
+		TransformId m_TransformId{ InvalidTransformId };
 		Matrix m_WorldMatrix{};
 		Matrix m_WorldViewProjectionMatrix{};
 
-		bool m_IsRotating{ false };
-		float m_Rotation{};
+		//Change tracking (update thread), the world version is bumped whenever the world matrix changes
+		uint32_t m_WorldVersion{ 1 };
+		uint32_t m_ComputedWorldVersion{};
+		uint32_t m_ComputedViewProjectionVersion{};
 	};
 }
 
@@ -0,0 +1,363 @@
+#include "pch.h"
+#include "MipChain.h"
+
+#include "JobSystem.h"
+
+#include <cstring>
+#include <emmintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		//Rows per parallel task
+		constexpr uint32_t g_RowsPerJob{ 16 };
+
+		//Kaiser taps per axis, centered between source texels 2x and 2x + 1
+		constexpr int g_NumKaiserTaps{ 6 };
+		constexpr float g_KaiserBeta{ 4.f };
+
+		//Entries of the linear to sRGB table, enough that neighbouring 8 bit codes never share an entry above black
+		constexpr uint32_t g_LinearToSrgbSize{ 4096 };
+
+		//RGBA in linear light (normals in [-1, 1]), in a struct because std::vector<__m128> drops the type's alignment attribute
+		struct Texel
+		{
+			__m128 rgba;
+		};
+
+		//Working format of the generator
+		struct FloatImage
+		{
+			uint32_t width{};
+			uint32_t height{};
+			std::vector<Texel> texels{};
+
+			void Resize(uint32_t newWidth, uint32_t newHeight)
+			{
+				width = newWidth;
+				height = newHeight;
+				texels.resize(size_t{ width } * height);
+			}
+		};
+
+		struct Tables
+		{
+			float srgbToLinear[256]{};
+			uint8_t linearToSrgb[g_LinearToSrgbSize]{};
+			float kaiserWeights[g_NumKaiserTaps]{};
+		};
+
+		float SrgbToLinear(float value)
+		{
+			return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float LinearToSrgb(float value)
+		{
+			return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+		}
+
+		//Zeroth order modified Bessel function of the first kind, the series converges fast for the betas used here
+		float BesselI0(float x)
+		{
+			float sum{ 1.f };
+			float term{ 1.f };
+			for (int k{ 1 }; k < 20; ++k)
+			{
+				term *= (x / (2.f * k)) * (x / (2.f * k));
+				sum += term;
+			}
+			return sum;
+		}
+
+		Tables BuildTables()
+		{
+			Tables tables{};
+			for (uint32_t i{}; i < 256; ++i)
+				tables.srgbToLinear[i] = SrgbToLinear(i / 255.f);
+
+			for (uint32_t i{}; i < g_LinearToSrgbSize; ++i)
+				tables.linearToSrgb[i] = static_cast<uint8_t>(LinearToSrgb(i / float(g_LinearToSrgbSize - 1)) * 255.f + 0.5f);
+
+			//Half-band sinc for the 2:1 reduction, windowed over 3 source texels on either side
+			constexpr float radius{ g_NumKaiserTaps / 2.f };
+			float sum{};
+			for (int i{}; i < g_NumKaiserTaps; ++i)
+			{
+				const float distance{ i - radius + 0.5f };
+				const float x{ distance * 0.5f * PI };
+				const float sinc{ x == 0.f ? 1.f : std::sin(x) / x };
+				const float ratio{ distance / radius };
+				const float window{ BesselI0(g_KaiserBeta * std::sqrt(std::max(0.f, 1.f - ratio * ratio))) / BesselI0(g_KaiserBeta) };
+				tables.kaiserWeights[i] = sinc * window;
+				sum += tables.kaiserWeights[i];
+			}
+			for (float& weight : tables.kaiserWeights)
+				weight /= sum;
+
+			return tables;
+		}
+
+		const Tables& GetTables()
+		{
+			static const Tables tables{ BuildTables() };
+			return tables;
+		}
+
+		__m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		//Four bytes to four floats in [0, 255]
+		__m128 LoadTexel(const uint8_t* pTexel)
+		{
+			int32_t packed{};
+			std::memcpy(&packed, pTexel, sizeof(packed));
+			const __m128i zero{ _mm_setzero_si128() };
+			const __m128i words{ _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero) };
+			return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+		}
+
+		//Four floats in [0, 255] to four bytes, rounded and clamped
+		void StoreTexel(__m128 value, uint8_t* pTexel)
+		{
+			const __m128 clamped{ _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.f)) };
+			const __m128i integers{ _mm_cvtps_epi32(clamped) };
+			const __m128i words{ _mm_packs_epi32(integers, integers) };
+			const int32_t packed{ _mm_cvtsi128_si32(_mm_packus_epi16(words, words)) };
+			std::memcpy(pTexel, &packed, sizeof(packed));
+		}
+
+		//Unit length xyz, w untouched. Vectors that averaged out to nothing stay as they are.
+		__m128 Renormalize(__m128 texel)
+		{
+			const __m128 squared{ _mm_mul_ps(texel, texel) };
+			const __m128 yzx{ _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(3, 0, 2, 1)) };
+			const __m128 zxy{ _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(3, 1, 0, 2)) };
+			const __m128 lengthSquared{ _mm_add_ps(_mm_add_ps(squared, yzx), zxy) };
+
+			const __m128 isLong{ _mm_cmpgt_ps(lengthSquared, _mm_set1_ps(1e-12f)) };
+			const __m128 normalized{ _mm_div_ps(texel, _mm_sqrt_ps(lengthSquared)) };
+			const __m128 wMask{ _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0)) };
+			return Select(wMask, texel, Select(isLong, normalized, texel));
+		}
+
+		void ForRows(JobSystem* pJobs, uint32_t numRows, const std::function<void(uint32_t begin, uint32_t end)>& function)
+		{
+			if (pJobs)
+				pJobs->ParallelFor(numRows, g_RowsPerJob, function);
+			else
+				function(0, numRows);
+		}
+
+		void Decode(const uint8_t* pPixels, uint32_t rowPitch, MipContent content, FloatImage& image, uint32_t begin, uint32_t end)
+		{
+			const Tables& tables{ GetTables() };
+			const __m128 toUnit{ _mm_set1_ps(1.f / 255.f) };
+			const __m128 normalScale{ _mm_set_ps(1.f / 255.f, 2.f / 255.f, 2.f / 255.f, 2.f / 255.f) };
+			const __m128 normalBias{ _mm_set_ps(0.f, -1.f, -1.f, -1.f) };
+
+			for (uint32_t y{ begin }; y < end; ++y)
+			{
+				const uint8_t* pRow{ pPixels + size_t{ y } * rowPitch };
+				Texel* pTexels{ image.texels.data() + size_t{ y } * image.width };
+				for (uint32_t x{}; x < image.width; ++x)
+				{
+					const uint8_t* pTexel{ pRow + x * 4 };
+					switch (content)
+					{
+					case MipContent::Linear:
+						pTexels[x].rgba = _mm_mul_ps(LoadTexel(pTexel), toUnit);
+						break;
+					case MipContent::Srgb:
+						pTexels[x].rgba = _mm_set_ps(pTexel[3] / 255.f, tables.srgbToLinear[pTexel[2]], tables.srgbToLinear[pTexel[1]], tables.srgbToLinear[pTexel[0]]);
+						break;
+					case MipContent::NormalMap:
+						pTexels[x].rgba = _mm_add_ps(_mm_mul_ps(LoadTexel(pTexel), normalScale), normalBias);
+						break;
+					}
+				}
+			}
+		}
+
+		void Encode(const FloatImage& image, MipContent content, uint8_t* pPixels, uint32_t begin, uint32_t end)
+		{
+			const Tables& tables{ GetTables() };
+			const __m128 fromUnit{ _mm_set1_ps(255.f) };
+			const __m128 normalScale{ _mm_set_ps(255.f, 127.5f, 127.5f, 127.5f) };
+			const __m128 normalBias{ _mm_set_ps(0.f, 127.5f, 127.5f, 127.5f) };
+			const __m128 srgbScale{ _mm_set_ps(255.f, g_LinearToSrgbSize - 1.f, g_LinearToSrgbSize - 1.f, g_LinearToSrgbSize - 1.f) };
+
+			for (uint32_t y{ begin }; y < end; ++y)
+			{
+				const Texel* pTexels{ image.texels.data() + size_t{ y } * image.width };
+				uint8_t* pRow{ pPixels + size_t{ y } * image.width * 4 };
+				for (uint32_t x{}; x < image.width; ++x)
+				{
+					switch (content)
+					{
+					case MipContent::Linear:
+						StoreTexel(_mm_mul_ps(pTexels[x].rgba, fromUnit), pRow + x * 4);
+						break;
+					case MipContent::Srgb:
+					{
+						//Table indices for RGB, alpha is already its 8 bit value
+						const __m128 scaled{ _mm_min_ps(_mm_max_ps(_mm_mul_ps(pTexels[x].rgba, srgbScale), _mm_setzero_ps()), srgbScale) };
+						alignas(16) int32_t indices[4]{};
+						_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(scaled));
+						pRow[x * 4 + 0] = tables.linearToSrgb[indices[0]];
+						pRow[x * 4 + 1] = tables.linearToSrgb[indices[1]];
+						pRow[x * 4 + 2] = tables.linearToSrgb[indices[2]];
+						pRow[x * 4 + 3] = static_cast<uint8_t>(indices[3]);
+						break;
+					}
+					case MipContent::NormalMap:
+						StoreTexel(_mm_add_ps(_mm_mul_ps(pTexels[x].rgba, normalScale), normalBias), pRow + x * 4);
+						break;
+					}
+				}
+			}
+		}
+
+		void DownsampleBox(const FloatImage& source, FloatImage& target, bool isNormalMap, uint32_t begin, uint32_t end)
+		{
+			const __m128 quarter{ _mm_set1_ps(0.25f) };
+			for (uint32_t y{ begin }; y < end; ++y)
+			{
+				//Odd sizes and 1 texel wide levels reuse the last row/column
+				const Texel* pRow0{ source.texels.data() + size_t{ std::min(2 * y, source.height - 1) } * source.width };
+				const Texel* pRow1{ source.texels.data() + size_t{ std::min(2 * y + 1, source.height - 1) } * source.width };
+				Texel* pTarget{ target.texels.data() + size_t{ y } * target.width };
+				for (uint32_t x{}; x < target.width; ++x)
+				{
+					const uint32_t x0{ std::min(2 * x, source.width - 1) };
+					const uint32_t x1{ std::min(2 * x + 1, source.width - 1) };
+					const __m128 sum{ _mm_add_ps(_mm_add_ps(pRow0[x0].rgba, pRow0[x1].rgba), _mm_add_ps(pRow1[x0].rgba, pRow1[x1].rgba)) };
+					const __m128 average{ _mm_mul_ps(sum, quarter) };
+					pTarget[x].rgba = isNormalMap ? Renormalize(average) : average;
+				}
+			}
+		}
+
+		//Horizontal half of the separable Kaiser filter: source rows to target width
+		void KaiserRows(const FloatImage& source, FloatImage& target, uint32_t begin, uint32_t end)
+		{
+			const Tables& tables{ GetTables() };
+			for (uint32_t y{ begin }; y < end; ++y)
+			{
+				const Texel* pSource{ source.texels.data() + size_t{ y } * source.width };
+				Texel* pTarget{ target.texels.data() + size_t{ y } * target.width };
+				for (uint32_t x{}; x < target.width; ++x)
+				{
+					__m128 sum{ _mm_setzero_ps() };
+					for (int tap{}; tap < g_NumKaiserTaps; ++tap)
+					{
+						//Clamped at the edges
+						const int sourceX{ std::clamp(int(2 * x) - g_NumKaiserTaps / 2 + 1 + tap, 0, int(source.width) - 1) };
+						sum = _mm_add_ps(sum, _mm_mul_ps(pSource[sourceX].rgba, _mm_set1_ps(tables.kaiserWeights[tap])));
+					}
+					pTarget[x].rgba = sum;
+				}
+			}
+		}
+
+		//Vertical half: rows of the horizontally filtered image to target height
+		void KaiserColumns(const FloatImage& source, FloatImage& target, bool isNormalMap, uint32_t begin, uint32_t end)
+		{
+			const Tables& tables{ GetTables() };
+			for (uint32_t y{ begin }; y < end; ++y)
+			{
+				const Texel* pRows[g_NumKaiserTaps]{};
+				for (int tap{}; tap < g_NumKaiserTaps; ++tap)
+				{
+					const int sourceY{ std::clamp(int(2 * y) - g_NumKaiserTaps / 2 + 1 + tap, 0, int(source.height) - 1) };
+					pRows[tap] = source.texels.data() + size_t(sourceY) * source.width;
+				}
+
+				Texel* pTarget{ target.texels.data() + size_t{ y } * target.width };
+				for (uint32_t x{}; x < target.width; ++x)
+				{
+					__m128 sum{ _mm_setzero_ps() };
+					for (int tap{}; tap < g_NumKaiserTaps; ++tap)
+						sum = _mm_add_ps(sum, _mm_mul_ps(pRows[tap][x].rgba, _mm_set1_ps(tables.kaiserWeights[tap])));
+
+					//The negative lobes can overshoot, colors are clamped to what 8 bit can hold when encoded
+					pTarget[x].rgba = isNormalMap ? Renormalize(sum) : sum;
+				}
+			}
+		}
+	}
+
+	TextureLevel MipChain::GetLevel(uint32_t level) const
+	{
+		const Level& mip{ levels[level] };
+		return TextureLevel{ pixels.data() + mip.offset, mip.width, mip.height, GetRowPitch(format, mip.width) };
+	}
+
+	uint32_t MipGenerator::GetNumLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t numLevels{ 1 };
+		while (width > 1 || height > 1)
+		{
+			width = std::max(1u, width / 2);
+			height = std::max(1u, height / 2);
+			++numLevels;
+		}
+		return numLevels;
+	}
+
+	void MipGenerator::Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+		const MipSettings& settings, MipChain& chain, JobSystem* pJobs)
+	{
+		const uint32_t numLevels{ GetNumLevels(width, height) };
+		chain.format = TextureFormat::Rgba8;
+		chain.levels.resize(numLevels);
+
+		size_t size{};
+		for (uint32_t level{}; level < numLevels; ++level)
+		{
+			chain.levels[level] = MipChain::Level{ std::max(1u, width >> level), std::max(1u, height >> level), size };
+			size += size_t{ chain.levels[level].width } * chain.levels[level].height * 4;
+		}
+		chain.pixels.resize(size);
+
+		for (uint32_t y{}; y < height; ++y)
+			std::memcpy(chain.pixels.data() + size_t{ y } * width * 4, pPixels + size_t{ y } * rowPitch, size_t{ width } * 4);
+
+		if (numLevels == 1)
+			return;
+
+		const bool isNormalMap{ settings.content == MipContent::NormalMap };
+
+		FloatImage source{};
+		source.Resize(width, height);
+		ForRows(pJobs, height, [&](uint32_t begin, uint32_t end) { Decode(pPixels, rowPitch, settings.content, source, begin, end); });
+
+		FloatImage target{};
+		FloatImage filteredRows{};
+		for (uint32_t level{ 1 }; level < numLevels; ++level)
+		{
+			const MipChain::Level& mip{ chain.levels[level] };
+			target.Resize(mip.width, mip.height);
+
+			switch (settings.filter)
+			{
+			case MipFilter::Box:
+				ForRows(pJobs, mip.height, [&](uint32_t begin, uint32_t end) { DownsampleBox(source, target, isNormalMap, begin, end); });
+				break;
+			case MipFilter::Kaiser:
+				filteredRows.Resize(mip.width, source.height);
+				ForRows(pJobs, source.height, [&](uint32_t begin, uint32_t end) { KaiserRows(source, filteredRows, begin, end); });
+				ForRows(pJobs, mip.height, [&](uint32_t begin, uint32_t end) { KaiserColumns(filteredRows, target, isNormalMap, begin, end); });
+				break;
+			}
+
+			uint8_t* pLevel{ chain.pixels.data() + mip.offset };
+			ForRows(pJobs, mip.height, [&](uint32_t begin, uint32_t end) { Encode(target, settings.content, pLevel, begin, end); });
+
+			std::swap(source, target);
+		}
+	}
+}
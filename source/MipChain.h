@@ -0,0 +1,61 @@
+#pragma once
+#include "GraphicsDevice.h"
+
+namespace dae
+{
+	class JobSystem;
+
+	enum class MipFilter : uint8_t
+	{
+		//2x2 average, the cheapest
+		Box,
+		//Kaiser-windowed sinc over 6 texels per axis, keeps more detail in the smaller levels
+		Kaiser
+	};
+
+	//What the texels mean, which decides how they are averaged
+	enum class MipContent : uint8_t
+	{
+		//Data maps (specular, glossiness, masks): averaged as stored
+		Linear,
+		//Colors: averaged in linear light and encoded again, so bright texels don't get darkened by dark ones
+		Srgb,
+		//Tangent-space normals in RGB: averaged as vectors and renormalized, alpha as stored
+		NormalMap
+	};
+
+	struct MipSettings
+	{
+		MipFilter filter{ MipFilter::Box };
+		MipContent content{ MipContent::Linear };
+	};
+
+	//Every level of a texture in one allocation, level 0 first, rows as GetRowPitch lays them out without padding
+	struct MipChain
+	{
+		struct Level
+		{
+			uint32_t width{};
+			uint32_t height{};
+			size_t offset{};
+		};
+
+		TextureFormat format{ TextureFormat::Rgba8 };
+		std::vector<Level> levels{};
+		std::vector<uint8_t> pixels{};
+
+		TextureLevel GetLevel(uint32_t level) const;
+	};
+
+	namespace MipGenerator
+	{
+		//Levels down to 1x1, e.g. 11 for 1024x1024
+		uint32_t GetNumLevels(uint32_t width, uint32_t height);
+
+		//Builds the whole chain from 8 bit RGBA pixels, level 0 is a copy of them.
+		//Each level is filtered from the one before it in floating point, so rounding doesn't add up.
+		//With a job system the rows of every level are split over its threads.
+		void Generate(const uint8_t* pPixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+			const MipSettings& settings, MipChain& chain, JobSystem* pJobs = nullptr);
+	}
+}
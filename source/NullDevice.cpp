@@ -0,0 +1,338 @@
+#include "pch.h"
+#include "NullDevice.h"
+
+namespace dae
+{
+	NullDevice::~NullDevice()
+	{
+		if (!m_Resources.empty())
+			std::cout << "NullDevice: " << m_Resources.size() << " resource(s) were never released\n";
+	}
+
+	bool NullDevice::IsInitialized() const
+	{
+		return true;
+	}
+
+	BufferHandle NullDevice::CreateVertexBuffer(const void* pVertices, uint32_t byteSize)
+	{
+		if (!pVertices || byteSize == 0)
+			++m_NumErrors;
+
+		return static_cast<BufferHandle>(Create(ResourceType::VertexBuffer));
+	}
+
+	BufferHandle NullDevice::CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices)
+	{
+		if (!pIndices || numIndices == 0)
+			++m_NumErrors;
+
+		return static_cast<BufferHandle>(Create(ResourceType::IndexBuffer));
+	}
+
+	TextureHandle NullDevice::CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels)
+	{
+		//Same rules as D3D11: each level half the size of the previous one, nothing after 1x1,
+		//and block compressed textures start at a whole number of blocks
+		const bool isBlockCompressed{ GetBlockSize(format) != 0 };
+		bool isValid{ pLevels && numLevels > 0 && pLevels[0].width > 0 && pLevels[0].height > 0 };
+		isValid = isValid && (!isBlockCompressed || (pLevels[0].width % 4 == 0 && pLevels[0].height % 4 == 0));
+		for (uint32_t level{}; isValid && level < numLevels; ++level)
+		{
+			const TextureLevel& mip{ pLevels[level] };
+			const bool isAfterLast{ level > 0 && pLevels[level - 1].width == 1 && pLevels[level - 1].height == 1 };
+			isValid = !isAfterLast && mip.pPixels && mip.width == std::max(1u, pLevels[0].width >> level)
+				&& mip.height == std::max(1u, pLevels[0].height >> level) && mip.rowPitch >= GetRowPitch(format, mip.width);
+		}
+
+		if (!isValid)
+			++m_NumErrors;
+
+		return static_cast<TextureHandle>(Create(ResourceType::Texture));
+	}
+
+	EffectHandle NullDevice::CreateEffect(EffectType, const std::wstring&, const std::vector<EffectDefine>&)
+	{
+		return static_cast<EffectHandle>(Create(ResourceType::Effect));
+	}
+
+	InputLayoutHandle NullDevice::CreateInputLayout(EffectHandle effect)
+	{
+		if (!IsLive(static_cast<uintptr_t>(effect), ResourceType::Effect))
+			++m_NumErrors;
+
+		return static_cast<InputLayoutHandle>(Create(ResourceType::InputLayout));
+	}
+
+	SamplerHandle NullDevice::CreateSampler(const SamplerDesc& desc)
+	{
+		if (desc.filter == SamplerFilter::Anisotropic && (desc.maxAnisotropy < 1 || desc.maxAnisotropy > 16))
+			++m_NumErrors;
+
+		return static_cast<SamplerHandle>(Create(ResourceType::Sampler));
+	}
+
+	uint32_t NullDevice::GetNumPasses(EffectHandle) const
+	{
+		return 1;
+	}
+
+	void NullDevice::Release(BufferHandle buffer)
+	{
+		//Either kind of buffer
+		const uintptr_t id{ static_cast<uintptr_t>(buffer) };
+		Destroy(id, IsLive(id, ResourceType::IndexBuffer) ? ResourceType::IndexBuffer : ResourceType::VertexBuffer);
+	}
+
+	void NullDevice::Release(TextureHandle texture)
+	{
+		Destroy(static_cast<uintptr_t>(texture), ResourceType::Texture);
+	}
+
+	void NullDevice::Release(EffectHandle effect)
+	{
+		Destroy(static_cast<uintptr_t>(effect), ResourceType::Effect);
+	}
+
+	void NullDevice::Release(InputLayoutHandle layout)
+	{
+		Destroy(static_cast<uintptr_t>(layout), ResourceType::InputLayout);
+	}
+
+	void NullDevice::Release(SamplerHandle sampler)
+	{
+		Destroy(static_cast<uintptr_t>(sampler), ResourceType::Sampler);
+	}
+
+	void NullDevice::SetTexture(EffectHandle effect, TextureSlot, TextureHandle texture)
+	{
+		if (!IsLive(static_cast<uintptr_t>(effect), ResourceType::Effect) || !IsLive(static_cast<uintptr_t>(texture), ResourceType::Texture, true))
+			++m_NumErrors;
+
+		++m_NumEffectStateChanges;
+	}
+
+	void NullDevice::SetSampler(EffectHandle effect, SamplerHandle sampler)
+	{
+		if (!IsLive(static_cast<uintptr_t>(effect), ResourceType::Effect) || !IsLive(static_cast<uintptr_t>(sampler), ResourceType::Sampler, true))
+			++m_NumErrors;
+
+		++m_NumEffectStateChanges;
+	}
+
+	void NullDevice::SetMaterial(EffectHandle effect, const MaterialConstants&)
+	{
+		if (!IsLive(static_cast<uintptr_t>(effect), ResourceType::Effect))
+			++m_NumErrors;
+
+		++m_NumEffectStateChanges;
+	}
+
+	void NullDevice::BeginFrame(const ColorRGB&)
+	{
+		if (m_IsInFrame)
+			++m_NumErrors;
+
+		m_IsInFrame = true;
+
+		if (m_NumFrames >= FrameLatency)
+			m_ConstantRing.RetireFrame(m_NumFrames - FrameLatency);
+		m_ConstantRing.BeginFrame(m_NumFrames);
+	}
+
+	void NullDevice::Submit(const CommandBuffer& buffer)
+	{
+		//Drawing from a mapped buffer is undefined on a real device
+		if (!m_IsInFrame || m_IsConstantsMapped)
+			++m_NumErrors;
+
+		ValidateCommands(buffer);
+		m_Commands.Submit(buffer);
+	}
+
+	void NullDevice::Present()
+	{
+		if (!m_IsInFrame || m_IsConstantsMapped)
+			++m_NumErrors;
+
+		m_IsInFrame = false;
+		m_ConstantRing.EndFrame();
+		++m_NumFrames;
+	}
+
+	ConstantBlock NullDevice::MapConstants(uint32_t size)
+	{
+		if (!m_IsInFrame || m_IsConstantsMapped)
+		{
+			++m_NumErrors;
+			return ConstantBlock{};
+		}
+
+		if (m_ConstantData.empty())
+			m_ConstantData.resize(m_ConstantRing.GetCapacity());
+
+		RingAllocation allocation{};
+		bool isNewRing{ false };
+		if (!m_ConstantRing.Allocate(size, allocation))
+		{
+			//Earlier blocks of this frame would be lost with the old buffer
+			if (m_ConstantRing.GetFrameUsed() > 0)
+				return ConstantBlock{};
+
+			//Room for this frame and the ones in flight, the old buffer is dropped as a whole
+			uint32_t capacity{ m_ConstantRing.GetCapacity() };
+			do
+			{
+				capacity *= 2;
+			} while (capacity < AlignConstantSize(size) * (FrameLatency + 1));
+
+			m_ConstantRing.Reset(capacity);
+			m_ConstantData.resize(capacity);
+			++m_ConstantRingVersion;
+			m_ConstantRing.Allocate(size, allocation);
+			isNewRing = true;
+		}
+
+		m_IsConstantsMapped = true;
+		m_NumConstantBytes += size;
+		return ConstantBlock{ m_ConstantData.data() + allocation.offset, allocation.offset, isNewRing };
+	}
+
+	void NullDevice::UnmapConstants()
+	{
+		if (!m_IsConstantsMapped)
+			++m_NumErrors;
+
+		m_IsConstantsMapped = false;
+	}
+
+	uint32_t NullDevice::GetNumFrames() const
+	{
+		return m_NumFrames;
+	}
+
+	uint32_t NullDevice::GetNumDraws() const
+	{
+		return m_Commands.GetNumDraws();
+	}
+
+	uint64_t NullDevice::GetNumIndices() const
+	{
+		return m_Commands.GetNumIndices();
+	}
+
+	uint32_t NullDevice::GetNumStateChanges() const
+	{
+		return m_Commands.GetNumCommands() - m_Commands.GetNumDraws() + m_NumEffectStateChanges;
+	}
+
+	uint32_t NullDevice::GetNumErrors() const
+	{
+		return m_NumErrors + m_Commands.GetNumInvalidDraws();
+	}
+
+	uint32_t NullDevice::GetNumLiveResources() const
+	{
+		std::lock_guard lock{ m_ResourcesMutex };
+		return static_cast<uint32_t>(m_Resources.size());
+	}
+
+	uint64_t NullDevice::GetNumConstantBytes() const
+	{
+		return m_NumConstantBytes;
+	}
+
+	uint32_t NullDevice::GetConstantRingCapacity() const
+	{
+		return m_ConstantRing.GetCapacity();
+	}
+
+	uintptr_t NullDevice::Create(ResourceType type)
+	{
+		const uintptr_t id{ m_NextId.fetch_add(1, std::memory_order_relaxed) };
+
+		std::lock_guard lock{ m_ResourcesMutex };
+		m_Resources.emplace(id, type);
+		return id;
+	}
+
+	void NullDevice::Destroy(uintptr_t id, ResourceType type)
+	{
+		//Releasing nothing is fine, same as a null COM pointer
+		if (id == 0)
+			return;
+
+		std::lock_guard lock{ m_ResourcesMutex };
+		const auto it{ m_Resources.find(id) };
+		if (it == m_Resources.end() || it->second != type)
+		{
+			++m_NumErrors;
+			return;
+		}
+
+		m_Resources.erase(it);
+	}
+
+	bool NullDevice::IsLive(uintptr_t id, ResourceType type, bool isOptional) const
+	{
+		if (id == 0)
+			return isOptional;
+
+		std::lock_guard lock{ m_ResourcesMutex };
+		return IsLiveLocked(id, type);
+	}
+
+	bool NullDevice::IsLiveLocked(uintptr_t id, ResourceType type) const
+	{
+		const auto it{ m_Resources.find(id) };
+		return it != m_Resources.end() && it->second == type;
+	}
+
+	void NullDevice::ValidateCommands(const CommandBuffer& buffer)
+	{
+		std::lock_guard lock{ m_ResourcesMutex };
+		for (const Command& command : buffer.GetCommands())
+		{
+			bool isValid{ true };
+			switch (command.type)
+			{
+			case CommandType::SetInputLayout:
+				isValid = IsLiveLocked(static_cast<uintptr_t>(command.setInputLayout.layout), ResourceType::InputLayout);
+				break;
+			case CommandType::SetVertexBuffer:
+				isValid = IsLiveLocked(static_cast<uintptr_t>(command.setVertexBuffer.buffer), ResourceType::VertexBuffer);
+				break;
+			case CommandType::SetIndexBuffer:
+				isValid = IsLiveLocked(static_cast<uintptr_t>(command.setIndexBuffer.buffer), ResourceType::IndexBuffer);
+				break;
+			case CommandType::SetConstants:
+			{
+				//Whole aligned blocks inside the ring, as *SetConstantBuffers1 requires, big enough for the slot's cbuffer
+				const Command::SetConstantsArgs& args{ command.setConstants };
+				const bool isFrame{ args.slot == ConstantSlot::Frame };
+				const uint32_t blockSize{ isFrame ? uint32_t{ sizeof(FrameConstants) } : uint32_t{ sizeof(ObjectConstants) } };
+				isValid = (isFrame || args.slot == ConstantSlot::Object) && args.size >= blockSize
+					&& args.offset % ConstantAlignment == 0 && args.size % ConstantAlignment == 0
+					&& uint64_t{ args.offset } + args.size <= m_ConstantRing.GetCapacity();
+				if (isValid)
+					m_BoundRingVersions[static_cast<uint32_t>(args.slot)] = m_ConstantRingVersion;
+				break;
+			}
+			case CommandType::ApplyPass:
+				isValid = IsLiveLocked(static_cast<uintptr_t>(command.applyPass.effect), ResourceType::Effect)
+					&& command.applyPass.pass < GetNumPasses(command.applyPass.effect);
+				std::fill(std::begin(m_BoundRingVersions), std::end(m_BoundRingVersions), 0u);
+				break;
+			case CommandType::DrawIndexed:
+				isValid = std::all_of(std::begin(m_BoundRingVersions), std::end(m_BoundRingVersions),
+					[this](uint32_t version) { return version == m_ConstantRingVersion; });
+				break;
+			case CommandType::SetPrimitiveTopology:
+				break;
+			}
+
+			if (!isValid)
+				++m_NumErrors;
+		}
+	}
+}
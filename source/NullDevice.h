@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "GraphicsDevice.h"
+#include "RecordingCommandBackend.h"
+#include "FrameRingAllocator.h"
+
+namespace dae
+{
+	//Headless device: hands out ids instead of GPU objects, validates every handle and call order,
+	//and counts what a real device would have been asked to do
+	class NullDevice final : public GraphicsDevice
+	{
+	public:
+		NullDevice() = default;
+		virtual ~NullDevice();
+
+		// rule of 5 copypasta
+		NullDevice(const NullDevice& other) = delete;
+		NullDevice(NullDevice&& other) = delete;
+		NullDevice& operator=(const NullDevice& other) = delete;
+		NullDevice& operator=(NullDevice&& other) = delete;
+
+		virtual bool IsInitialized() const override;
+
+		virtual BufferHandle CreateVertexBuffer(const void* pVertices, uint32_t byteSize) override;
+		virtual BufferHandle CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices) override;
+		virtual TextureHandle CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels) override;
+		virtual EffectHandle CreateEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines) override;
+		virtual InputLayoutHandle CreateInputLayout(EffectHandle effect) override;
+		virtual SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+
+		virtual uint32_t GetNumPasses(EffectHandle effect) const override;
+
+		virtual void Release(BufferHandle buffer) override;
+		virtual void Release(TextureHandle texture) override;
+		virtual void Release(EffectHandle effect) override;
+		virtual void Release(InputLayoutHandle layout) override;
+		virtual void Release(SamplerHandle sampler) override;
+
+		virtual void SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture) override;
+		virtual void SetSampler(EffectHandle effect, SamplerHandle sampler) override;
+		virtual void SetMaterial(EffectHandle effect, const MaterialConstants& material) override;
+
+		virtual void BeginFrame(const ColorRGB& clearColor) override;
+		virtual void Submit(const CommandBuffer& buffer) override;
+		virtual void Present() override;
+
+		virtual ConstantBlock MapConstants(uint32_t size) override;
+		virtual void UnmapConstants() override;
+
+		//Counters since creation, only read them while no frame is being rendered
+		uint32_t GetNumFrames() const;
+		uint32_t GetNumDraws() const;
+		uint64_t GetNumIndices() const;
+		//Every command that isn't a draw, plus effect texture/sampler/material changes
+		uint32_t GetNumStateChanges() const;
+		//Unknown or released handles, wrong resource types, calls outside a frame, draws without a pipeline,
+		//draws with constants bound into a constant ring that has since grown
+		uint32_t GetNumErrors() const;
+		uint32_t GetNumLiveResources() const;
+		uint64_t GetNumConstantBytes() const;
+		uint32_t GetConstantRingCapacity() const;
+
+	private:
+		enum class ResourceType : uint8_t
+		{
+			VertexBuffer,
+			IndexBuffer,
+			Texture,
+			Effect,
+			InputLayout,
+			Sampler
+		};
+
+		uintptr_t Create(ResourceType type);
+		void Destroy(uintptr_t id, ResourceType type);
+		//Invalid handles only pass when isOptional is set, e.g. unbinding a texture
+		bool IsLive(uintptr_t id, ResourceType type, bool isOptional = false) const;
+		//Same without taking the lock, for callers that already hold it
+		bool IsLiveLocked(uintptr_t id, ResourceType type) const;
+		void ValidateCommands(const CommandBuffer& buffer);
+
+		std::atomic<uintptr_t> m_NextId{ 1 };
+		mutable std::mutex m_ResourcesMutex{};
+		std::unordered_map<uintptr_t, ResourceType> m_Resources{};
+
+		std::atomic<uint32_t> m_NumErrors{};
+		uint32_t m_NumFrames{};
+		uint32_t m_NumEffectStateChanges{};
+		bool m_IsInFrame{ false };
+
+		RecordingCommandBackend m_Commands{};
+
+		//Frames the pretend GPU lags behind, its constant blocks are reused once it caught up
+		static constexpr uint32_t FrameLatency{ 2 };
+		static constexpr uint32_t InitialConstantRingSize{ 64 * 1024 };
+
+		FrameRingAllocator m_ConstantRing{ InitialConstantRingSize, ConstantAlignment };
+		std::vector<uint8_t> m_ConstantData{};
+		bool m_IsConstantsMapped{ false };
+		uint64_t m_NumConstantBytes{};
+		//Bumped when the ring grows, a draw needs both slots set since then (and since the last ApplyPass, which unbinds them)
+		uint32_t m_ConstantRingVersion{ 1 };
+		uint32_t m_BoundRingVersions[NumConstantSlots]{};
+	};
+}
@@ -0,0 +1,241 @@
+#include "pch.h"
+#include "PixelConversion.h"
+
+#include <cstring>
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		bool DetectSsse3()
+		{
+#if defined(_MSC_VER)
+			int info[4]{};
+			__cpuid(info, 1);
+			return (info[2] & (1 << 9)) != 0;
+#else
+			return __builtin_cpu_supports("ssse3");
+#endif
+		}
+
+		const bool g_HasSsse3{ DetectSsse3() };
+
+		//Only the alpha byte of every texel
+		const __m128i g_OpaqueAlpha{ _mm_set1_epi32(static_cast<int>(0xff000000)) };
+
+		bool IsGrayPalette(const SDL_Palette* pPalette)
+		{
+			if (!pPalette || pPalette->ncolors != 256)
+				return false;
+
+			for (int i{}; i < 256; ++i)
+			{
+				const SDL_Color& color{ pPalette->colors[i] };
+				if (color.r != i || color.g != i || color.b != i || color.a != 255)
+					return false;
+			}
+			return true;
+		}
+
+		//4 byte texels with their channels moved by mask, 4 texels per shuffle
+		uint32_t ShuffleFourByte(const uint8_t* pSource, uint32_t width, __m128i mask, uint8_t* pTarget)
+		{
+			uint32_t x{};
+			for (; x + 16 <= width; x += 16)
+			{
+				for (uint32_t i{}; i < 16; i += 4)
+				{
+					const __m128i texels{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + (x + i) * 4)) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + (x + i) * 4), _mm_shuffle_epi8(texels, mask));
+				}
+			}
+			return x;
+		}
+
+		//16 texels of 3 bytes are exactly 3 loads, realigned into 4 groups of 4 texels and widened with an opaque alpha
+		uint32_t ShuffleThreeByte(const uint8_t* pSource, uint32_t width, __m128i mask, uint8_t* pTarget)
+		{
+			uint32_t x{};
+			for (; x + 16 <= width; x += 16)
+			{
+				const __m128i a{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x * 3)) };
+				const __m128i b{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x * 3 + 16)) };
+				const __m128i c{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x * 3 + 32)) };
+				const __m128i groups[4]{ a, _mm_alignr_epi8(b, a, 12), _mm_alignr_epi8(c, b, 8), _mm_srli_si128(c, 4) };
+
+				for (uint32_t i{}; i < 4; ++i)
+				{
+					const __m128i texels{ _mm_or_si128(_mm_shuffle_epi8(groups[i], mask), g_OpaqueAlpha) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + (x + i * 4) * 4), texels);
+				}
+			}
+			return x;
+		}
+
+		//16 gray bytes spread over 4 stores, each value repeated into RGB
+		uint32_t ShuffleGray(const uint8_t* pSource, uint32_t width, uint8_t* pTarget)
+		{
+			const __m128i masks[4]{
+				_mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+				_mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+				_mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+				_mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1)
+			};
+
+			uint32_t x{};
+			for (; x + 16 <= width; x += 16)
+			{
+				const __m128i gray{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSource + x)) };
+				for (uint32_t i{}; i < 4; ++i)
+				{
+					const __m128i texels{ _mm_or_si128(_mm_shuffle_epi8(gray, masks[i]), g_OpaqueAlpha) };
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pTarget + (x + i * 4) * 4), texels);
+				}
+			}
+			return x;
+		}
+
+		void ConvertTexels(PixelConversion::Layout layout, const uint8_t* pSource, uint32_t begin, uint32_t end, const SDL_Palette* pPalette, uint8_t* pTarget)
+		{
+			using PixelConversion::Layout;
+			for (uint32_t x{ begin }; x < end; ++x)
+			{
+				uint8_t* pTexel{ pTarget + x * 4 };
+				switch (layout)
+				{
+				case Layout::Rgba:
+					std::memcpy(pTexel, pSource + x * 4, 4);
+					break;
+				case Layout::Bgra:
+					pTexel[0] = pSource[x * 4 + 2];
+					pTexel[1] = pSource[x * 4 + 1];
+					pTexel[2] = pSource[x * 4];
+					pTexel[3] = pSource[x * 4 + 3];
+					break;
+				case Layout::Rgb:
+					pTexel[0] = pSource[x * 3];
+					pTexel[1] = pSource[x * 3 + 1];
+					pTexel[2] = pSource[x * 3 + 2];
+					pTexel[3] = 255;
+					break;
+				case Layout::Bgr:
+					pTexel[0] = pSource[x * 3 + 2];
+					pTexel[1] = pSource[x * 3 + 1];
+					pTexel[2] = pSource[x * 3];
+					pTexel[3] = 255;
+					break;
+				case Layout::Gray:
+					pTexel[0] = pTexel[1] = pTexel[2] = pSource[x];
+					pTexel[3] = 255;
+					break;
+				case Layout::Indexed:
+					//SDL_Color is laid out as RGBA already, indices past the palette are opaque black
+					if (pPalette && pSource[x] < pPalette->ncolors)
+					{
+						std::memcpy(pTexel, &pPalette->colors[pSource[x]], 4);
+					}
+					else
+					{
+						pTexel[0] = pTexel[1] = pTexel[2] = 0;
+						pTexel[3] = 255;
+					}
+					break;
+				case Layout::Unsupported:
+					break;
+				}
+			}
+		}
+	}
+
+	PixelConversion::Layout PixelConversion::GetLayout(const SDL_Surface* pSurface)
+	{
+		if (!pSurface || !pSurface->format)
+			return Layout::Unsupported;
+
+		switch (pSurface->format->format)
+		{
+		case SDL_PIXELFORMAT_RGBA32:
+			return Layout::Rgba;
+		case SDL_PIXELFORMAT_BGRA32:
+			return Layout::Bgra;
+		case SDL_PIXELFORMAT_RGB24:
+			return Layout::Rgb;
+		case SDL_PIXELFORMAT_BGR24:
+			return Layout::Bgr;
+		case SDL_PIXELFORMAT_INDEX8:
+			return IsGrayPalette(pSurface->format->palette) ? Layout::Gray : Layout::Indexed;
+		default:
+			return Layout::Unsupported;
+		}
+	}
+
+	void PixelConversion::ConvertRow(Layout layout, const uint8_t* pSource, uint32_t width, const SDL_Palette* pPalette, uint8_t* pTarget)
+	{
+		if (layout == Layout::Rgba)
+		{
+			std::memcpy(pTarget, pSource, size_t{ width } * 4);
+			return;
+		}
+
+		//Whatever the shuffles leave over, less than 16 texels, goes texel by texel
+		uint32_t x{};
+		if (g_HasSsse3)
+		{
+			switch (layout)
+			{
+			case Layout::Bgra:
+				x = ShuffleFourByte(pSource, width, _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15), pTarget);
+				break;
+			case Layout::Rgb:
+				x = ShuffleThreeByte(pSource, width, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1), pTarget);
+				break;
+			case Layout::Bgr:
+				x = ShuffleThreeByte(pSource, width, _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1), pTarget);
+				break;
+			case Layout::Gray:
+				x = ShuffleGray(pSource, width, pTarget);
+				break;
+			default:
+				break;
+			}
+		}
+
+		ConvertTexels(layout, pSource, x, width, pPalette, pTarget);
+	}
+
+	void PixelConversion::ConvertRowScalar(Layout layout, const uint8_t* pSource, uint32_t width, const SDL_Palette* pPalette, uint8_t* pTarget)
+	{
+		ConvertTexels(layout, pSource, 0, width, pPalette, pTarget);
+	}
+
+	bool PixelConversion::HasSimd()
+	{
+		return g_HasSsse3;
+	}
+
+	bool PixelConversion::ConvertToRgba(const SDL_Surface* pSurface, uint8_t* pTarget, uint32_t targetPitch)
+	{
+		const Layout layout{ GetLayout(pSurface) };
+		if (layout == Layout::Unsupported)
+		{
+			if (!pSurface)
+				return false;
+
+			SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(const_cast<SDL_Surface*>(pSurface), SDL_PIXELFORMAT_RGBA32, 0) };
+			const bool isConverted{ pConverted && GetLayout(pConverted) == Layout::Rgba && ConvertToRgba(pConverted, pTarget, targetPitch) };
+			SDL_FreeSurface(pConverted);
+			return isConverted;
+		}
+
+		for (int y{}; y < pSurface->h; ++y)
+		{
+			const uint8_t* pRow{ static_cast<const uint8_t*>(pSurface->pixels) + size_t(y) * pSurface->pitch };
+			ConvertRow(layout, pRow, static_cast<uint32_t>(pSurface->w), pSurface->format->palette, pTarget + size_t(y) * targetPitch);
+		}
+		return true;
+	}
+}
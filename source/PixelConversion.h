@@ -0,0 +1,35 @@
+#pragma once
+
+namespace dae
+{
+	//Normalizes decoded images to the RGBA8 texel layout textures are built from, written straight into the target.
+	//SDL_image hands out whatever the file stored: RGB for opaque PNGs, palettes for indexed and gray ones, RGBA or BGRA for the rest.
+	namespace PixelConversion
+	{
+		enum class Layout : uint8_t
+		{
+			Rgba,
+			Bgra,
+			Rgb,
+			Bgr,
+			//8 bit palette with r = g = b = index and opaque alpha, how SDL_image loads gray PNGs
+			Gray,
+			Indexed,
+			Unsupported
+		};
+
+		Layout GetLayout(const SDL_Surface* pSurface);
+
+		//One row of width texels. pPalette is only read for Indexed.
+		//The SSSE3 shuffles are used when the CPU has them, 16 texels at a time.
+		void ConvertRow(Layout layout, const uint8_t* pSource, uint32_t width, const SDL_Palette* pPalette, uint8_t* pTarget);
+		//Texel by texel, what the shuffles are checked and timed against
+		void ConvertRowScalar(Layout layout, const uint8_t* pSource, uint32_t width, const SDL_Palette* pPalette, uint8_t* pTarget);
+		bool HasSimd();
+
+		//Every row of the surface to RGBA8 rows targetPitch bytes apart.
+		//Formats without a kernel (16 bit, packed 565, ...) go through SDL_ConvertSurfaceFormat first.
+		//Returns false if that fails too.
+		bool ConvertToRgba(const SDL_Surface* pSurface, uint8_t* pTarget, uint32_t targetPitch);
+	}
+}
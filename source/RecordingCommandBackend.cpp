@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "RecordingCommandBackend.h"
+
+namespace dae
+{
+	void RecordingCommandBackend::Submit(const CommandBuffer& buffer)
+	{
+		for (const Command& command : buffer.GetCommands())
+		{
+			++m_NumCommands;
+			Mix(static_cast<uint64_t>(command.type));
+
+			//Only the fields of the active member are hashed, the rest of the union is undefined
+			switch (command.type)
+			{
+			case CommandType::SetPrimitiveTopology:
+				Mix(static_cast<uint64_t>(command.setPrimitiveTopology.topology));
+				break;
+			case CommandType::SetInputLayout:
+				m_InputLayout = command.setInputLayout.layout;
+				Mix(static_cast<uint64_t>(m_InputLayout));
+				break;
+			case CommandType::SetVertexBuffer:
+				m_VertexBuffer = command.setVertexBuffer.buffer;
+				Mix(static_cast<uint64_t>(m_VertexBuffer));
+				Mix(command.setVertexBuffer.stride);
+				Mix(command.setVertexBuffer.offset);
+				break;
+			case CommandType::SetIndexBuffer:
+				m_IndexBuffer = command.setIndexBuffer.buffer;
+				Mix(static_cast<uint64_t>(m_IndexBuffer));
+				break;
+			case CommandType::SetConstants:
+				Mix(static_cast<uint64_t>(command.setConstants.slot));
+				Mix(command.setConstants.offset);
+				Mix(command.setConstants.size);
+				break;
+			case CommandType::ApplyPass:
+				m_AppliedEffect = command.applyPass.effect;
+				Mix(static_cast<uint64_t>(m_AppliedEffect));
+				Mix(command.applyPass.pass);
+				break;
+			case CommandType::DrawIndexed:
+				++m_NumDraws;
+				m_NumIndices += command.drawIndexed.indexCount;
+				Mix(command.drawIndexed.indexCount);
+				Mix(command.drawIndexed.startIndex);
+				Mix(static_cast<uint32_t>(command.drawIndexed.baseVertex));
+
+				if (m_InputLayout == InputLayoutHandle::Invalid || m_VertexBuffer == BufferHandle::Invalid
+					|| m_IndexBuffer == BufferHandle::Invalid || m_AppliedEffect == EffectHandle::Invalid)
+					++m_NumInvalidDraws;
+				break;
+			}
+		}
+	}
+
+	void RecordingCommandBackend::Reset()
+	{
+		m_Checksum = HashSeed;
+		m_NumCommands = 0;
+		m_NumDraws = 0;
+		m_NumIndices = 0;
+		m_NumInvalidDraws = 0;
+
+		m_InputLayout = InputLayoutHandle::Invalid;
+		m_VertexBuffer = BufferHandle::Invalid;
+		m_IndexBuffer = BufferHandle::Invalid;
+		m_AppliedEffect = EffectHandle::Invalid;
+	}
+
+	uint64_t RecordingCommandBackend::GetChecksum() const
+	{
+		return m_Checksum;
+	}
+
+	uint32_t RecordingCommandBackend::GetNumCommands() const
+	{
+		return m_NumCommands;
+	}
+
+	uint32_t RecordingCommandBackend::GetNumDraws() const
+	{
+		return m_NumDraws;
+	}
+
+	uint64_t RecordingCommandBackend::GetNumIndices() const
+	{
+		return m_NumIndices;
+	}
+
+	uint32_t RecordingCommandBackend::GetNumInvalidDraws() const
+	{
+		return m_NumInvalidDraws;
+	}
+
+	void RecordingCommandBackend::Mix(uint64_t value)
+	{
+		m_Checksum = Hash(m_Checksum, &value, sizeof(value));
+	}
+}
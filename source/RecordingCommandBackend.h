@@ -0,0 +1,47 @@
+#pragma once
+#include "CommandBuffer.h"
+#include "DiskCache.h"
+
+namespace dae
+{
+	//Headless backend: keeps the pipeline state a real device would have, checks every draw against it
+	//and folds everything it sees into a checksum, so two submissions can be compared without a GPU
+	class RecordingCommandBackend final : public CommandBackend
+	{
+	public:
+		RecordingCommandBackend() = default;
+		virtual ~RecordingCommandBackend() = default;
+
+		// rule of 5 copypasta
+		RecordingCommandBackend(const RecordingCommandBackend& other) = delete;
+		RecordingCommandBackend(RecordingCommandBackend&& other) = delete;
+		RecordingCommandBackend& operator=(const RecordingCommandBackend& other) = delete;
+		RecordingCommandBackend& operator=(RecordingCommandBackend&& other) = delete;
+
+		virtual void Submit(const CommandBuffer& buffer) override;
+
+		//Clears the recorded state, as if the device was recreated
+		void Reset();
+
+		uint64_t GetChecksum() const;
+		uint32_t GetNumCommands() const;
+		uint32_t GetNumDraws() const;
+		uint64_t GetNumIndices() const;
+		//Draws issued without a complete pipeline (no layout, buffers or applied pass)
+		uint32_t GetNumInvalidDraws() const;
+
+	private:
+		void Mix(uint64_t value);
+
+		uint64_t m_Checksum{ HashSeed };
+		uint32_t m_NumCommands{};
+		uint32_t m_NumDraws{};
+		uint64_t m_NumIndices{};
+		uint32_t m_NumInvalidDraws{};
+
+		InputLayoutHandle m_InputLayout{ InputLayoutHandle::Invalid };
+		BufferHandle m_VertexBuffer{ BufferHandle::Invalid };
+		BufferHandle m_IndexBuffer{ BufferHandle::Invalid };
+		EffectHandle m_AppliedEffect{ EffectHandle::Invalid };
+	};
+}
@@ -2,323 +2,495 @@
 #include "Renderer.h"
 #include "Mesh.h"
 #include "Camera.h"
-#include "EffectShaded.h"
-#include "EffectTransparent.h"
 #include "Utils.h"
 #include "Texture.h"
+#include "TextureCache.h"
+#include "CookedTexture.h"
+#include "TransformSystem.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "ResourceRegistry.h"
+#include "ShaderPermutation.h"
+
+#include <chrono>
+#include <cstring>
 
 namespace dae {
 
-	Renderer::Renderer(SDL_Window* pWindow) :
-		m_pWindow(pWindow)
+	Renderer::Renderer(GraphicsDevice* pDevice, int width, int height, uint32_t numSyntheticMeshes)
+		:m_pDevice{ pDevice }
+		,m_Width{ width }
+		,m_Height{ height }
 	{
-		//Initialize
-		SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+		m_IsInitialized = m_pDevice->IsInitialized();
 
-		//Initialize DirectX pipeline
-		const HRESULT result = InitializeDirectX();
-		if (result == S_OK)
-		{
-			m_IsInitialized = true;
-			std::cout << "DirectX is initialized and ready!\n";
-		}
-		else
-		{
-			std::cout << "DirectX initialization failed!\n";
-		}
+		m_pRegistry = new ResourceRegistry(m_pDevice);
+		m_pJobs = new JobSystem();
+		//One pool for the whole process: a device with CPU work of its own would otherwise oversubscribe the cores
+		m_pDevice->SetJobSystem(m_pJobs);
+		m_pTransforms = new TransformSystem();
+		m_pStreamer = new TextureStreamer(m_pDevice, m_pJobs);
 
-		InitMeshes();
+		if (numSyntheticMeshes == 0)
+			InitMeshes();
+		else
+			InitSyntheticMeshes(numSyntheticMeshes);
 
 		m_pCamera = new Camera();
 		m_pCamera->Initialize(float(m_Width) / m_Height, 45.f, { 0,0,-50.f });
 
+		//From here on the device's frame functions belong to the render thread
+		m_pPipeline = new FramePipeline();
+		m_RenderThread = std::thread{ &Renderer::RenderLoop, this };
 	}
 
 	Renderer::~Renderer()
 	{
+		m_pPipeline->Shutdown();
+		if (m_RenderThread.joinable())
+			m_RenderThread.join();
+		delete m_pPipeline;
+
 		delete m_pCamera;
 		for (Mesh* pMesh : m_MeshPtrs)
 		{
 			delete pMesh;
 		}
-
-		if (m_pRenderTargetView) m_pRenderTargetView->Release();
-		if (m_pRenderTargetBuffer) m_pRenderTargetBuffer->Release();
-
-		if (m_pDepthStencilView) m_pDepthStencilView->Release();
-		if (m_pDepthStencilBuffer) m_pDepthStencilBuffer->Release();
-
-		if (m_pSwapChain) m_pSwapChain->Release();
-
-		if (m_pDeviceContext)
+		delete m_pStreamer;
+		for (EffectHandle effect : m_Effects)
 		{
-			m_pDeviceContext->ClearState();
-			m_pDeviceContext->Flush();
-			m_pDeviceContext->Release();
+			m_pRegistry->Release(effect);
 		}
-		if (m_pDevice) m_pDevice->Release();
+		m_pRegistry->Release(m_Sampler);
+		delete m_pRegistry;
+		delete m_pTransforms;
+		m_pDevice->SetJobSystem(nullptr);
+		delete m_pJobs;
+
+		delete m_pDevice;
 	}
 
 	void Renderer::Update(const Timer* pTimer)
 	{
+		const auto updateStart{ std::chrono::high_resolution_clock::now() };
+
 		m_pCamera->Update(pTimer);
-		for (Mesh* pMesh : m_MeshPtrs)
+		m_pTransforms->Update(pTimer->GetElapsed(), *m_pJobs);
+
+		//Only blocks if the render thread hasn't started on the previous packet yet
+		FramePacket& packet{ m_pPipeline->BeginWrite() };
+		packet.frameIndex = m_FrameIndex++;
+		packet.stats.Reset();
+
+		const uint32_t viewVersion{ m_pCamera->GetViewVersion() };
+		const uint32_t projectionVersion{ m_pCamera->GetProjectionVersion() };
+
+		//The camera only bumps its versions when it recalculated a matrix
+		const bool isViewChanged{ viewVersion != m_CameraViewVersion };
+		const bool isProjectionChanged{ projectionVersion != m_CameraProjectionVersion };
+		packet.stats.matricesComputed += uint32_t(isViewChanged) + uint32_t(isProjectionChanged);
+		packet.stats.matricesSkipped += uint32_t(!isViewChanged) + uint32_t(!isProjectionChanged);
+
+		if (isViewChanged || isProjectionChanged)
 		{
-			pMesh->SetMatrix(m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix(), m_pCamera->GetInvViewMatrix());
+			m_ViewProjectionMatrix = m_pCamera->GetViewMatrix() * m_pCamera->GetProjectionMatrix();
+			m_Frustum = Frustum::FromViewProjection(m_ViewProjectionMatrix);
+			++m_ViewProjectionVersion;
+			++packet.stats.matricesComputed;
 
-			pMesh->Update(pTimer);
+			m_CameraViewVersion = viewVersion;
+			m_CameraProjectionVersion = projectionVersion;
+		}
+		else
+		{
+			++packet.stats.matricesSkipped;
+		}
+
+		packet.viewProjection = m_ViewProjectionMatrix;
+		StoreMatrix(packet.constants.viewInverse, *m_pCamera->GetInvViewMatrix());
+		packet.constants.lightDirection[0] = m_LightDirection.x;
+		packet.constants.lightDirection[1] = m_LightDirection.y;
+		packet.constants.lightDirection[2] = m_LightDirection.z;
+		packet.constants.lightIntensity = m_LightIntensity;
+		packet.samplerFilter = m_SamplerFilter;
+
+		//Meshes only touch their own simulation state, so they update and cull in parallel
+		constexpr uint32_t meshesPerJob{ 16 };
+		std::mutex statsMutex{};
+		m_pJobs->ParallelFor(static_cast<uint32_t>(m_MeshPtrs.size()), meshesPerJob, [&](uint32_t begin, uint32_t end)
+			{
+				FrameStats stats{};
+				for (uint32_t i{ begin }; i < end; ++i)
+				{
+					Mesh* pMesh{ m_MeshPtrs[i] };
+					pMesh->Update(*m_pTransforms);
+					pMesh->UpdateVisibility(m_Frustum);
+					if (pMesh->IsVisible())
+						pMesh->UpdateMatrices(m_ViewProjectionMatrix, m_ViewProjectionVersion, stats);
+				}
+
+				std::lock_guard lock{ statsMutex };
+				packet.stats += stats;
+			});
+
+		RequestTextures(packet);
+
+		packet.draws.clear();
+		for (uint32_t i{}; i < m_MeshPtrs.size(); ++i)
+		{
+			if (m_MeshPtrs[i]->IsVisible())
+				packet.draws.push_back(m_MeshPtrs[i]->CreateDrawItem(i));
 		}
+
+		packet.stats.updateMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count();
+
+		m_pPipeline->EndWrite();
 	}
 
+	void Renderer::RenderLoop()
+	{
+		while (const FramePacket* pPacket = m_pPipeline->BeginRead())
+		{
+			Render(*pPacket);
+			m_pPipeline->EndRead();
+		}
+	}
 
-	void Renderer::Render() const
+	void Renderer::Render(const FramePacket& packet)
 	{
 		if (!m_IsInitialized)
 			return;
 
+		const auto renderStart{ std::chrono::high_resolution_clock::now() };
+		FrameStats stats{ packet.stats };
+
+		if (packet.samplerFilter != m_AppliedSamplerFilter)
+		{
+			LoadSampleState(packet.samplerFilter);
+			m_AppliedSamplerFilter = packet.samplerFilter;
+		}
+
+		//Streamed textures that changed, the textures they replace are kept alive until this frame is done
+		for (const TextureBinding& binding : packet.textureBindings)
+		{
+			m_pDevice->SetTexture(binding.effect, binding.slot, binding.texture);
+		}
+		if (!packet.textureBindings.empty())
+			m_StateCache.Reset();
+
 
 		//1. CLEAR RTV & DSV
 		constexpr ColorRGB clearColor{ 0.f,0.f,0.3f };
-		m_pDeviceContext->ClearRenderTargetView(m_pRenderTargetView, &clearColor.r);
-		m_pDeviceContext->ClearDepthStencilView(m_pDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.f, 0);
+		m_pDevice->BeginFrame(clearColor);
 
 
 		//2. SET PIPELINE + INVOKE DRAWCALLS (= RENDER)
-		for (Mesh* pMesh : m_MeshPtrs)
+		//Disjoint draw ranges are recorded on the workers, only the replay touches the device
+		//One map for the whole frame: the per-frame block first, then a fixed slice per draw so the workers never share one
+		constexpr uint32_t frameConstantsSize{ GraphicsDevice::AlignConstantSize(sizeof(FrameConstants)) };
+		constexpr uint32_t constantsStride{ GraphicsDevice::AlignConstantSize(sizeof(ObjectConstants)) };
+		uint32_t numDraws{ static_cast<uint32_t>(packet.draws.size()) };
+		const ConstantBlock constants{ numDraws > 0 ? m_pDevice->MapConstants(frameConstantsSize + numDraws * constantsStride) : ConstantBlock{} };
+		if (constants.pData)
+			std::memcpy(constants.pData, &packet.constants, sizeof(FrameConstants));
+		else
+			numDraws = 0;
+		//Same offsets as last frame would be filtered while they now point into the new buffer
+		if (constants.isNewRing)
+			m_StateCache.Reset();
+
+		constexpr uint32_t drawsPerCommandBuffer{ 64 };
+		const uint32_t numCommandBuffers{ (numDraws + drawsPerCommandBuffer - 1) / drawsPerCommandBuffer };
+		if (m_CommandBuffers.size() < numCommandBuffers)
+			m_CommandBuffers.resize(numCommandBuffers);
+
+		m_pJobs->ParallelFor(numDraws, drawsPerCommandBuffer, [&](uint32_t begin, uint32_t end)
+			{
+				CommandBuffer& commands{ m_CommandBuffers[begin / drawsPerCommandBuffer] };
+				commands.Reset();
+
+				for (uint32_t i{ begin }; i < end; ++i)
+				{
+					const DrawItem& draw{ packet.draws[i] };
+					const uint32_t drawOffset{ frameConstantsSize + i * constantsStride };
+					m_MeshPtrs[draw.meshIndex]->Record(commands, draw, constants.pData + drawOffset, constants.offset + drawOffset, constants.offset);
+				}
+			});
+
+		if (numDraws > 0)
+			m_pDevice->UnmapConstants();
+
+		//The cache follows the device state across buffers and frames, so this part stays in submission order
+		for (uint32_t i{}; i < numCommandBuffers; ++i)
 		{
-			pMesh->Render(m_pDeviceContext);
+			m_StateCache.Filter(m_CommandBuffers[i], stats);
+			m_pDevice->Submit(m_CommandBuffers[i]);
 		}
 
 
 
 
 		//3. PRESENT BACKBUFFER (SWAP)
-		m_pSwapChain->Present(0, 0);
+		m_pDevice->Present();
+
+		const auto renderEnd{ std::chrono::high_resolution_clock::now() };
+		stats.renderMs = std::chrono::duration<float, std::milli>(renderEnd - renderStart).count();
+		if (packet.frameIndex == 0)
+			m_TimeToFirstFrameMs = std::chrono::duration<float, std::milli>(renderEnd - m_CreationTime).count();
+
+		std::lock_guard lock{ m_FrameStatsMutex };
+		m_FrameStats = stats;
+	}
+
+	FrameStats Renderer::GetFrameStats() const
+	{
+		std::lock_guard lock{ m_FrameStatsMutex };
+		return m_FrameStats;
+	}
+
+	float Renderer::GetTimeToFirstFrame() const
+	{
+		return m_TimeToFirstFrameMs;
+	}
+
+	const ResourceRegistry& Renderer::GetRegistry() const
+	{
+		return *m_pRegistry;
+	}
 
+	const TextureStreamer& Renderer::GetTextureStreamer() const
+	{
+		return *m_pStreamer;
+	}
+
+	void Renderer::SetTextureBudget(uint64_t budgetBytes)
+	{
+		m_pStreamer->SetBudget(budgetBytes);
+	}
+
+	void Renderer::RequestTextures(FramePacket& packet)
+	{
+		//Every visible use asks for the level its closest point needs
+		const Vector3 cameraOrigin{ m_pCamera->GetOrigin() };
+		const float tanHalfFov{ m_pCamera->GetTanHalfFov() };
+		for (const StreamedBinding& binding : m_StreamedBindings)
+		{
+			const Mesh* pMesh{ m_MeshPtrs[binding.meshIndex] };
+			if (!pMesh->IsVisible())
+				continue;
+
+			const float distance{ std::max((pMesh->GetWorldBoundsCenter() - cameraOrigin).Magnitude() - pMesh->GetWorldBoundsRadius(), 0.f) };
+			m_pStreamer->Request(binding.id, TextureStreamer::ComputeMipLevel(distance, pMesh->GetWorldUnitsPerUv(),
+				m_pStreamer->GetSize(binding.id), tanHalfFov, static_cast<float>(m_Height)));
+		}
+
+		//Packets are only reused once rendered, which is what the streamer's release delay counts on
+		m_TextureSwaps.clear();
+		m_pStreamer->Update(packet.frameIndex, m_TextureSwaps);
+
+		packet.textureBindings.clear();
+		for (const TextureSwap& swap : m_TextureSwaps)
+		{
+			for (const StreamedBinding& binding : m_StreamedBindings)
+			{
+				if (binding.id == swap.id)
+					packet.textureBindings.push_back(TextureBinding{ binding.effect, binding.slot, swap.current });
+			}
+		}
 	}
 
 	void Renderer::ToggleRotation()
 	{
+		m_IsRotating = !m_IsRotating;
+
+		constexpr float rotationSpeed{ 1 };
+		const Vector3 angularVelocity{ 0.f, m_IsRotating ? rotationSpeed : 0.f, 0.f };
 		for (Mesh* pMesh : m_MeshPtrs)
 		{
-			pMesh->ToggleRotation();
+			m_pTransforms->SetAngularVelocity(pMesh->GetTransformId(), angularVelocity);
 		}
 	}
 
 	void Renderer::ToggleFilteringMethod()
 	{
-		D3D11_FILTER newFilter{};
-		switch (m_FilteringMethod)
+		switch (m_SamplerFilter)
 		{
-		case FilteringMethod::Point:
-			m_FilteringMethod = FilteringMethod::Linear;
-			newFilter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+		case SamplerFilter::Point:
+			m_SamplerFilter = SamplerFilter::Linear;
 			std::cout << "FILTERING METHOD: LINEAR\n";
 			break;
-		case FilteringMethod::Linear:
-			m_FilteringMethod = FilteringMethod::Anisotropic;
-			newFilter = D3D11_FILTER_ANISOTROPIC;
+		case SamplerFilter::Linear:
+			m_SamplerFilter = SamplerFilter::Anisotropic;
 			std::cout << "FILTERING METHOD: ANISOTROPIC\n";
 			break;
-		case FilteringMethod::Anisotropic:
-			m_FilteringMethod = FilteringMethod::Point;
-			newFilter = D3D11_FILTER_MIN_MAG_MIP_POINT;
+		case SamplerFilter::Anisotropic:
+			m_SamplerFilter = SamplerFilter::Point;
 			std::cout << "FILTERING METHOD: POINT\n";
 			break;
 		}
 
-		LoadSampleState(newFilter, m_pDevice);
+		//The sampler is (re)created on the render thread when the next packet reaches it
 	}
 
-	void Renderer::InitMeshes()
+	void Renderer::Flush()
 	{
-		//Vehicle
-		EffectShaded* vehicleEffect{ new EffectShaded{ m_pDevice, L"Resources/PosCol3D.fx" } };
-
-		//Load textures
-		Texture* pDiffuse{ Texture::LoadFromFile("Resources/vehicle_diffuse.png", m_pDevice) };
-		vehicleEffect->SetDiffuseMap(pDiffuse);
-
-		Texture* pNormal{ Texture::LoadFromFile("Resources/vehicle_normal.png", m_pDevice) };
-		vehicleEffect->SetNormalMap(pNormal);
-
-		Texture* pSpecular{ Texture::LoadFromFile("Resources/vehicle_specular.png", m_pDevice) };
-		vehicleEffect->SetSpecularMap(pSpecular);
+		m_pPipeline->WaitIdle();
+	}
 
-		Texture* pGlossiness{ Texture::LoadFromFile("Resources/vehicle_gloss.png", m_pDevice) };
-		vehicleEffect->SetGlossinessMap(pGlossiness);
+	void Renderer::InitMeshes()
+	{
+		//Everything below is independent except that a Mesh needs its effect for the input layout.
+		//The device is free-threaded, so effects, textures and meshes are all created on the workers:
+		//the PNGs are decoded next to each other, the effect compiles and the OBJ parsing, not before them.
+		EffectHandle vehicleEffect{ EffectHandle::Invalid };
+		EffectHandle fireEffect{ EffectHandle::Invalid };
+		StreamedTextureId textures[4]{ InvalidStreamedTextureId, InvalidStreamedTextureId, InvalidStreamedTextureId, InvalidStreamedTextureId };
+		Mesh* pVehicle{ nullptr };
+		Mesh* pFire{ nullptr };
+
+		const TransformId vehicleTransform{ m_pTransforms->Add(Vector3::Zero) };
+		const TransformId fireTransform{ m_pTransforms->Add(Vector3::Zero) };
+
+		JobCounter vehicleEffectCounter{};
+		JobCounter fireEffectCounter{};
+		JobCounter loadCounter{};
+
+		//Effects, the vehicle has every map so it gets the full variant
+		const uint32_t vehicleFeatures{ ShaderPermutation::Select(true, true, true, false) };
+		m_pJobs->Run([&]() { vehicleEffect = m_pRegistry->AcquireEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", ShaderPermutation::GetDefines(vehicleFeatures)); }, &vehicleEffectCounter);
+		m_pJobs->Run([&]() { fireEffect = m_pRegistry->AcquireEffect(EffectType::Transparent, L"Resources/PartialCoverage.fx"); }, &fireEffectCounter);
+
+		//Textures: cooked files are mapped as they are, unless an image changed since they were cooked.
+		//Otherwise the images are decoded and encoded, or their encoded chain comes from the texture cache.
+		//Only the tails are uploaded here, the rest streams in once the meshes are seen.
+		const std::vector<TextureAsset>& assets{ GetTextureAssets() };
+		TextureCache textureCache{ "Resources/Cache/Textures" };
+		for (size_t i{}; i < assets.size(); ++i)
+		{
+			m_pJobs->Run([&, i]() { textures[i] = m_pStreamer->Add(assets[i], &textureCache); }, &loadCounter);
+		}
 
-		//The Set...Map function autiomatically deletes the texture so no need to delete them here
+		//Meshes
+		m_pJobs->RunAfter(vehicleEffectCounter, [&]() { pVehicle = new Mesh{ m_pDevice, "Resources/vehicle.obj", vehicleEffect, vehicleTransform }; }, &loadCounter);
+		m_pJobs->RunAfter(fireEffectCounter, [&]() { pFire = new Mesh{ m_pDevice, "Resources/fireFX.obj", fireEffect, fireTransform }; }, &loadCounter);
+
+		m_pJobs->Wait(vehicleEffectCounter);
+		m_pJobs->Wait(fireEffectCounter);
+		m_pJobs->Wait(loadCounter);
+
+		const uint32_t vehicleIndex{ static_cast<uint32_t>(m_MeshPtrs.size()) };
+		const uint32_t fireIndex{ vehicleIndex + 1 };
+		const auto [diffuse, normal, specularGlossiness, fireDiffuse] { textures };
+		m_StreamedBindings.insert(m_StreamedBindings.end(), {
+			{ diffuse, vehicleIndex, vehicleEffect, TextureSlot::Diffuse },
+			{ normal, vehicleIndex, vehicleEffect, TextureSlot::Normal },
+			{ specularGlossiness, vehicleIndex, vehicleEffect, TextureSlot::Specular },
+			{ fireDiffuse, fireIndex, fireEffect, TextureSlot::Diffuse } });
+		std::erase_if(m_StreamedBindings, [](const StreamedBinding& binding) { return binding.id == InvalidStreamedTextureId; });
+
+		for (const StreamedBinding& binding : m_StreamedBindings)
+		{
+			m_pDevice->SetTexture(binding.effect, binding.slot, m_pStreamer->GetHandle(binding.id));
+		}
+		m_pDevice->SetMaterial(vehicleEffect, MaterialConstants{});
 
-		//Create vehicle
-		Mesh* pVehicle{ new Mesh{ m_pDevice, "Resources/vehicle.obj", vehicleEffect} };
+		m_Effects.push_back(vehicleEffect);
+		m_Effects.push_back(fireEffect);
 		m_MeshPtrs.push_back(pVehicle);
-
-
-
-		//Fire
-		EffectTransparent* fireEffect{ new EffectTransparent{ m_pDevice, L"Resources/PartialCoverage.fx" } };
-
-		//Load textures
-		Texture* pFireDiffuse{ Texture::LoadFromFile("Resources/fireFX_diffuse.png", m_pDevice) };
-		fireEffect->SetDiffuseMap(pFireDiffuse);
-
-		//The Set...Map function autiomatically deletes the texture so no need to delete them here
-
-		//Create fire
-		Mesh* pFire{ new Mesh{ m_pDevice, "Resources/fireFX.obj", fireEffect} };
 		m_MeshPtrs.push_back(pFire);
-
-
-
-
-
 	}
 
-	HRESULT Renderer::InitializeDirectX()
+	const std::vector<TextureAsset>& Renderer::GetTextureAssets()
 	{
-		//1. Create Device & DeviceContext
-		//=====
-		D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_1;
-		uint32_t createDeviceFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG)
-		createDeviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
-#endif
-
-		HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, 0, createDeviceFlags, &featureLevel,
-											1, D3D11_SDK_VERSION, &m_pDevice, nullptr, &m_pDeviceContext);
-
-		if (FAILED(result))
-			return result;
-
-		//Create DXGI Factory
-		IDXGIFactory1* pDxgiFactory{};
-		result = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&pDxgiFactory));
-		if (FAILED(result))
-			return result;
-
-
-
-		//2. Create Swapchain
-		//=====
-		DXGI_SWAP_CHAIN_DESC swapChainDesc{};
-		swapChainDesc.BufferDesc.Width = m_Width;
-		swapChainDesc.BufferDesc.Height = m_Height;
-		swapChainDesc.BufferDesc.RefreshRate.Numerator = 1;
-		swapChainDesc.BufferDesc.RefreshRate.Denominator = 60;
-		swapChainDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		swapChainDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-		swapChainDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
-		swapChainDesc.SampleDesc.Count = 1;
-		swapChainDesc.SampleDesc.Quality = 0;
-		swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-		swapChainDesc.BufferCount = 1;
-		swapChainDesc.Windowed = true;
-		swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_DISCARD;
-		swapChainDesc.Flags = 0;
-
-		// Get the handle (HWND) from the SDL Backbuffer
-		SDL_SysWMinfo sysWMInfo{};
-		SDL_VERSION(&sysWMInfo.version)
-		SDL_GetWindowWMInfo(m_pWindow, &sysWMInfo);
-		swapChainDesc.OutputWindow = sysWMInfo.info.win.window;
-
-		//Create SwapChain
-		result = pDxgiFactory->CreateSwapChain(m_pDevice, &swapChainDesc, &m_pSwapChain);
-		if (FAILED(result))
-			return result;
-
-		//3. Create DepthStencil (DS) & DepthStencilView (DSV)
-		//Resource
-		D3D11_TEXTURE2D_DESC depthStencilDesc{};
-		depthStencilDesc.Width = m_Width;
-		depthStencilDesc.Height = m_Height;
-		depthStencilDesc.MipLevels = 1;
-		depthStencilDesc.ArraySize = 1;
-		depthStencilDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
-		depthStencilDesc.SampleDesc.Count = 1;
-		depthStencilDesc.SampleDesc.Quality = 0;
-		depthStencilDesc.Usage = D3D11_USAGE_DEFAULT;
-		depthStencilDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-		depthStencilDesc.CPUAccessFlags = 0;
-		depthStencilDesc.MiscFlags = 0;
-
-		//View
-		D3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc{};
-		depthStencilViewDesc.Format = depthStencilDesc.Format;
-		depthStencilViewDesc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-		depthStencilViewDesc.Texture2D.MipSlice = 0;
-
-		result = m_pDevice->CreateTexture2D(&depthStencilDesc, nullptr, &m_pDepthStencilBuffer);
-		if (FAILED(result))
-			return result;
-
-		result = m_pDevice->CreateDepthStencilView(m_pDepthStencilBuffer, &depthStencilViewDesc, &m_pDepthStencilView);
-		if (FAILED(result))
-			return result;
-
-
-		//4. Create RenderTarget (RT) & RenderTargetView (RTV)
-		//=====
-
-		//Resource
-		result = m_pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&m_pRenderTargetBuffer));
-		if (FAILED(result))
-			return result;
-
-		//View
-		result = m_pDevice->CreateRenderTargetView(m_pRenderTargetBuffer, nullptr, &m_pRenderTargetView);
-		if (FAILED(result))
-			return result;
-
-
-		//5. Bind RTV & DSV to Output Merger Stage
-		//=====
-		m_pDeviceContext->OMSetRenderTargets(1, &m_pRenderTargetView, m_pDepthStencilView);
-
-
-		//6. Set Viewport
-		//=====
-		D3D11_VIEWPORT viewport{};
-		viewport.Width = static_cast<float>(m_Width);
-		viewport.Height = static_cast<float>(m_Height);
-		viewport.TopLeftX = 0.f;
-		viewport.TopLeftY = 0.f;
-		viewport.MinDepth = 0.f;
-		viewport.MaxDepth = 1.f;
-		m_pDeviceContext->RSSetViewports(1, &viewport);
-
-		return result;
+		//The mip chains are filtered the way each map is read by the shader and compressed to what it reads:
+		//the normal map keeps XY (the shader rebuilds Z), the fire its alpha.
+		//Glossiness is one channel, it rides along in the alpha of the specular map.
+		static const std::vector<TextureAsset> assets{
+			{ { { "Resources/vehicle_diffuse.png" } }, { { MipFilter::Kaiser, MipContent::Srgb }, TextureFormat::Bc1 }, "Resources/Cooked/vehicle_diffuse.dtex" },
+			{ { { "Resources/vehicle_normal.png" } }, { { MipFilter::Box, MipContent::NormalMap }, TextureFormat::Bc5 }, "Resources/Cooked/vehicle_normal.dtex" },
+			{
+				{
+					{ "Resources/vehicle_specular.png", { 0, 1, 2, ChannelSource::NoChannel } },
+					{ "Resources/vehicle_gloss.png", { ChannelSource::NoChannel, ChannelSource::NoChannel, ChannelSource::NoChannel, 0 } }
+				},
+				{ { MipFilter::Box, MipContent::Linear }, TextureFormat::Bc3 }, "Resources/Cooked/vehicle_specular_gloss.dtex"
+			},
+			{ { { "Resources/fireFX_diffuse.png" } }, { { MipFilter::Kaiser, MipContent::Srgb }, TextureFormat::Bc7 }, "Resources/Cooked/fireFX_diffuse.dtex" }
+		};
+		return assets;
+	}
 
+	const TextureAsset& Renderer::GetTextureAsset(SceneTexture texture)
+	{
+		return GetTextureAssets()[static_cast<uint32_t>(texture)];
 	}
 
-	void Renderer::LoadSampleState(const D3D11_FILTER& filter, ID3D11Device* device)
+	bool Renderer::CookTextures()
 	{
-		// Create the SampleState description
-		D3D11_SAMPLER_DESC sampleDesc{};
-		sampleDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
-		sampleDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
-		sampleDesc.MipLODBias = 0;
-		sampleDesc.MinLOD = 0;
-		sampleDesc.MaxLOD = D3D11_FLOAT32_MAX;
-		sampleDesc.MaxAnisotropy = 16;
-		sampleDesc.Filter = filter;
+		JobSystem jobs{};
+		bool isCooked{ true };
+		for (const TextureAsset& asset : GetTextureAssets())
+		{
+			MipChain chain{};
+			const bool isWritten{ Texture::LoadChain(asset.sources, asset.settings, chain, &jobs) && CookedTexture::Write(asset.cookedPath, chain) };
+			std::cout << (isWritten ? "Cooked " : "Failed to cook ") << asset.cookedPath << "\n";
+			isCooked = isCooked && isWritten;
+		}
+		return isCooked;
+	}
 
+	void Renderer::InitSyntheticMeshes(uint32_t numMeshes)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		Mesh::CreateCube(vertices, indices);
+
+		//Untextured cubes: the variant without normal mapping and specular
+		const uint32_t features{ ShaderPermutation::Select(false, false, false, false) };
+		const EffectHandle effect{ m_pRegistry->AcquireEffect(EffectType::Shaded, L"Resources/PosCol3D.fx", ShaderPermutation::GetDefines(features)) };
+		m_pDevice->SetMaterial(effect, MaterialConstants{});
+		m_Effects.push_back(effect);
+
+		//A block of cubes in front of the camera, wide enough that part of it gets culled. Every fourth one spins.
+		constexpr float spacing{ 2.5f };
+		const uint32_t side{ static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(numMeshes)))) };
+		const float offset{ (side - 1) * spacing * 0.5f };
+
+		m_pTransforms->Reserve(numMeshes);
+		std::vector<TransformId> transforms(numMeshes);
+		for (uint32_t i{}; i < numMeshes; ++i)
+		{
+			const Vector3 position{ (i % side) * spacing - offset, (i / side % side) * spacing - offset, (i / (side * side)) * spacing };
+			transforms[i] = m_pTransforms->Add(position);
+			if (i % 4 == 0)
+				m_pTransforms->SetAngularVelocity(transforms[i], { 0.f, 1.f, 0.f });
+		}
 
-		if (m_pSamplerState) m_pSamplerState->Release();
+		const size_t firstMesh{ m_MeshPtrs.size() };
+		m_MeshPtrs.resize(firstMesh + numMeshes);
 
+		constexpr uint32_t meshesPerJob{ 64 };
+		m_pJobs->ParallelFor(numMeshes, meshesPerJob, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i{ begin }; i < end; ++i)
+					m_MeshPtrs[firstMesh + i] = new Mesh{ m_pDevice, vertices, indices, effect, transforms[i] };
+			});
+	}
 
-		HRESULT result{ device->CreateSamplerState(&sampleDesc, &m_pSamplerState) };
-		if (FAILED(result))
-			std::cout << "m_pSamplerState failed to load\n";
+	void Renderer::LoadSampleState(SamplerFilter filter)
+	{
+		//The registry keeps the previous sampler around, cycling through the filters creates each one once
+		const SamplerHandle previousSampler{ m_Sampler };
+		m_Sampler = m_pRegistry->AcquireSampler(SamplerDesc{ filter });
+		m_pRegistry->Release(previousSampler);
 
-		for (Mesh* pMesh : m_MeshPtrs)
+		for (EffectHandle effect : m_Effects)
 		{
-			pMesh->SetSamplerState(m_pSamplerState);
+			m_pDevice->SetSampler(effect, m_Sampler);
 		}
 
+		//The effects have to be applied again to pick up the new sampler
+		m_StateCache.Reset();
 	}
 
 }
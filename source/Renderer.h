@@ -1,18 +1,41 @@
 #pragma once
-
-struct SDL_Window;
-struct SDL_Surface;
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "FrameStats.h"
+#include "Frustum.h"
+#include "GraphicsDevice.h"
+#include "StateCache.h"
+#include "TextureStreamer.h"
 
 namespace dae
 {
 
 	class Mesh;
 	class Camera;
+	class TransformSystem;
+	class JobSystem;
+	class FramePipeline;
+	class ResourceRegistry;
+	struct FramePacket;
+	struct TextureAsset;
+
+	//The textures of the vehicle scene, in the order Renderer::GetTextureAssets lists them
+	enum class SceneTexture : uint8_t
+	{
+		VehicleDiffuse,
+		VehicleNormal,
+		//Glossiness in alpha
+		VehicleSpecularGlossiness,
+		FireDiffuse
+	};
 
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		//Takes ownership of the device. Loads the vehicle scene, or a block of numSyntheticMeshes cubes for headless profiling.
+		Renderer(GraphicsDevice* pDevice, int width, int height, uint32_t numSyntheticMeshes = 0);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -20,15 +43,44 @@ namespace dae
 		Renderer& operator=(const Renderer&) = delete;
 		Renderer& operator=(Renderer&&) noexcept = delete;
 
+		//Simulates the next frame and hands it to the render thread,
+		//blocks when the render thread is still a full frame behind
 		void Update(const Timer* pTimer);
-		void Render() const;
 		void ToggleRotation();
 		void ToggleFilteringMethod();
 
+		//Blocks until the render thread finished every frame handed to it
+		void Flush();
+
+		//Stats of the last frame the render thread finished
+		FrameStats GetFrameStats() const;
+		//Milliseconds from the start of the constructor until the first frame was presented, 0 before that
+		float GetTimeToFirstFrame() const;
+
+		const ResourceRegistry& GetRegistry() const;
+		const TextureStreamer& GetTextureStreamer() const;
+		//Video memory the scene textures may settle at, they stream down to fit
+		void SetTextureBudget(uint64_t budgetBytes);
+
+		//The textures of the vehicle scene, with the settings they're built with and where their cooked files go
+		static const std::vector<TextureAsset>& GetTextureAssets();
+		static const TextureAsset& GetTextureAsset(SceneTexture texture);
+		//Writes the cooked file of every scene texture, for --cook-textures. Returns false if one fails.
+		static bool CookTextures();
+
 	private:
 		void InitMeshes();
+		void InitSyntheticMeshes(uint32_t numMeshes);
+		//Update thread: asks the streamer for what the visible meshes need and puts the textures it replaced in the packet
+		void RequestTextures(FramePacket& packet);
 
-		SDL_Window* m_pWindow{};
+		//Render thread
+		void RenderLoop();
+		void Render(const FramePacket& packet);
+
+		GraphicsDevice* m_pDevice{ nullptr };
+		//Effects and samplers, shared by every mesh that uses the same one
+		ResourceRegistry* m_pRegistry{ nullptr };
 
 		int m_Width{};
 		int m_Height{};
@@ -36,32 +88,54 @@ namespace dae
 		bool m_IsInitialized{ false };
 
 		std::vector<Mesh*> m_MeshPtrs{};
+		//Scene textures, every one has its tail resident and streams in the levels the visible meshes need
+		TextureStreamer* m_pStreamer{ nullptr };
+		struct StreamedBinding
+		{
+			StreamedTextureId id{ InvalidStreamedTextureId };
+			uint32_t meshIndex{};
+			EffectHandle effect{ EffectHandle::Invalid };
+			TextureSlot slot{ TextureSlot::Diffuse };
+		};
+		std::vector<StreamedBinding> m_StreamedBindings{};
+		std::vector<TextureSwap> m_TextureSwaps{};
+		std::vector<EffectHandle> m_Effects{};
 		Camera* m_pCamera{ nullptr };
+		TransformSystem* m_pTransforms{ nullptr };
+		JobSystem* m_pJobs{ nullptr };
+		bool m_IsRotating{ false };
 
-		ID3D11SamplerState* m_pSamplerState{ nullptr };
-		ID3D11Device* m_pDevice{ nullptr };
-		ID3D11DeviceContext* m_pDeviceContext{ nullptr };
-		IDXGISwapChain* m_pSwapChain{ nullptr };
-		ID3D11Texture2D* m_pDepthStencilBuffer{ nullptr };
-		ID3D11DepthStencilView* m_pDepthStencilView{ nullptr };
-		ID3D11RenderTargetView* m_pRenderTargetView{ nullptr };
-		ID3D11Resource* m_pRenderTargetBuffer{ nullptr };
+		//view * projection, cached against the camera versions it was built from
+		Matrix m_ViewProjectionMatrix{};
+		uint32_t m_ViewProjectionVersion{};
+		uint32_t m_CameraViewVersion{};
+		uint32_t m_CameraProjectionVersion{};
+		Frustum m_Frustum{};
 
+		//Sent to the shaders with the rest of the per-frame constants
+		Vector3 m_LightDirection{ 0.577f, -0.577f, 0.577f };
+		float m_LightIntensity{ 7.f };
 
-		//DIRECTX
-		HRESULT InitializeDirectX();
-		//...
+		FramePipeline* m_pPipeline{ nullptr };
+		std::thread m_RenderThread{};
+		uint64_t m_FrameIndex{};
 
-		enum class FilteringMethod
-		{
-			Point = 0,
-			Linear = 1,
-			Anisotropic = 2
-		};
+		//Render thread: one buffer per recorded draw range, filtered and replayed in order
+		std::vector<CommandBuffer> m_CommandBuffers{};
+		StateCache m_StateCache{};
+
+		FrameStats m_FrameStats{};
+		mutable std::mutex m_FrameStatsMutex{};
+
+		std::chrono::high_resolution_clock::time_point m_CreationTime{ std::chrono::high_resolution_clock::now() };
+		std::atomic<float> m_TimeToFirstFrameMs{};
 
-		FilteringMethod m_FilteringMethod{ 0 };
+		//Requested by the update thread, applied by the render thread when it differs
+		SamplerFilter m_SamplerFilter{ SamplerFilter::Point };
+		SamplerFilter m_AppliedSamplerFilter{ SamplerFilter::Point };
+		SamplerHandle m_Sampler{ SamplerHandle::Invalid };
 
-		void LoadSampleState(const D3D11_FILTER& filter, ID3D11Device* device);
+		void LoadSampleState(SamplerFilter filter);
 
 	};
 }
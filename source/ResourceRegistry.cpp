@@ -0,0 +1,335 @@
+#include "pch.h"
+#include "ResourceRegistry.h"
+
+#include <filesystem>
+
+namespace dae
+{
+	ResourceRegistry::ResourceRegistry(GraphicsDevice* pDevice)
+		:m_pDevice{ pDevice }
+	{
+	}
+
+	ResourceRegistry::~ResourceRegistry()
+	{
+		for (auto& [key, entry] : m_Effects)
+			m_pDevice->Release(entry.effect.get());
+
+		for (auto& [key, entry] : m_Samplers)
+			m_pDevice->Release(entry.sampler);
+
+		for (auto& [key, entry] : m_Textures)
+			delete entry.texture.get();
+	}
+
+	EffectHandle ResourceRegistry::AcquireEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines)
+	{
+		EffectKey key{ type, assetFile, defines };
+
+		std::unique_lock lock{ m_Mutex };
+		const auto it{ m_Effects.find(key) };
+		if (it != m_Effects.end())
+		{
+			++it->second.numReferences;
+			const std::shared_future<EffectHandle> existing{ it->second.effect };
+
+			//Another thread may still be compiling it
+			lock.unlock();
+			return existing.get();
+		}
+
+		std::promise<EffectHandle> promise{};
+		m_Effects.emplace(key, EffectEntry{ promise.get_future().share(), 1 });
+		++m_NumEffectsCreated;
+		lock.unlock();
+
+		//Created outside the lock so different effects still compile in parallel
+		const EffectHandle effect{ m_pDevice->CreateEffect(type, assetFile, defines) };
+		promise.set_value(effect);
+
+		lock.lock();
+		if (effect == EffectHandle::Invalid)
+			m_Effects.erase(key);
+		else
+			m_EffectKeys.emplace(effect, std::move(key));
+		return effect;
+	}
+
+	void ResourceRegistry::Release(EffectHandle effect)
+	{
+		if (effect == EffectHandle::Invalid)
+			return;
+
+		std::lock_guard lock{ m_Mutex };
+		const auto keyIt{ m_EffectKeys.find(effect) };
+		if (keyIt == m_EffectKeys.end())
+			return;
+
+		EffectEntry& entry{ m_Effects.at(keyIt->second) };
+		if (entry.numReferences > 0)
+			--entry.numReferences;
+	}
+
+	SamplerHandle ResourceRegistry::AcquireSampler(const SamplerDesc& desc)
+	{
+		const uint32_t key{ HashSamplerDesc(desc) };
+
+		//Samplers are cheap to create, doing it under the lock keeps this simple
+		std::lock_guard lock{ m_Mutex };
+		SamplerEntry& entry{ m_Samplers[key] };
+		if (entry.sampler == SamplerHandle::Invalid)
+		{
+			entry.sampler = m_pDevice->CreateSampler(desc);
+			++m_NumSamplersCreated;
+			if (entry.sampler == SamplerHandle::Invalid)
+			{
+				m_Samplers.erase(key);
+				return SamplerHandle::Invalid;
+			}
+			m_SamplerKeys.emplace(entry.sampler, key);
+		}
+
+		++entry.numReferences;
+		return entry.sampler;
+	}
+
+	void ResourceRegistry::Release(SamplerHandle sampler)
+	{
+		if (sampler == SamplerHandle::Invalid)
+			return;
+
+		std::lock_guard lock{ m_Mutex };
+		const auto keyIt{ m_SamplerKeys.find(sampler) };
+		if (keyIt == m_SamplerKeys.end())
+			return;
+
+		SamplerEntry& entry{ m_Samplers.at(keyIt->second) };
+		if (entry.numReferences > 0)
+			--entry.numReferences;
+	}
+
+	TextureHandle ResourceRegistry::AcquireTexture(const std::string& path, const TextureSettings& settings, JobSystem* pJobs, TextureCache* pCache)
+	{
+		return AcquireTexture(std::vector<ChannelSource>{ ChannelSource{ path } }, settings, pJobs, pCache);
+	}
+
+	TextureHandle ResourceRegistry::AcquireTexture(const std::vector<ChannelSource>& sources, const TextureSettings& settings, JobSystem* pJobs, TextureCache* pCache)
+	{
+		std::string name{};
+		for (const ChannelSource& source : sources)
+			name += (name.empty() ? "" : "+") + source.path;
+
+		//Decoded and encoded outside the lock, different textures load in parallel
+		return ShareTexture(MakeTextureKey(sources, settings), std::move(name),
+			[&]() { return Texture::LoadPacked(sources, m_pDevice, settings, pJobs, pCache); });
+	}
+
+	TextureHandle ResourceRegistry::AcquireCookedTexture(const std::string& path)
+	{
+		//Its own key space, a cooked file is never the same texture as its images
+		return ShareTexture("cooked|" + NormalizePath(path), path, [&]() { return Texture::LoadCooked(path, m_pDevice); });
+	}
+
+	TextureHandle ResourceRegistry::ShareTexture(const std::string& key, std::string name, const std::function<Texture*()>& load)
+	{
+		std::unique_lock lock{ m_Mutex };
+		const auto it{ m_Textures.find(key) };
+		if (it != m_Textures.end())
+		{
+			++it->second.numReferences;
+			const std::shared_future<Texture*> existing{ it->second.texture };
+
+			lock.unlock();
+			const Texture* pTexture{ existing.get() };
+			return pTexture ? pTexture->GetHandle() : TextureHandle::Invalid;
+		}
+
+		std::promise<Texture*> promise{};
+		m_Textures.emplace(key, TextureEntry{ promise.get_future().share(), std::move(name), 1 });
+		++m_NumTexturesCreated;
+		lock.unlock();
+
+		Texture* pTexture{ load() };
+		if (pTexture->GetHandle() == TextureHandle::Invalid)
+		{
+			delete pTexture;
+			pTexture = nullptr;
+		}
+
+		//Known by handle before anyone waiting gets it, so their Release always finds it
+		lock.lock();
+		if (pTexture)
+			m_TextureKeys.emplace(pTexture->GetHandle(), key);
+		else
+			m_Textures.erase(key);
+		lock.unlock();
+
+		promise.set_value(pTexture);
+		return pTexture ? pTexture->GetHandle() : TextureHandle::Invalid;
+	}
+
+	void ResourceRegistry::Release(TextureHandle texture)
+	{
+		if (texture == TextureHandle::Invalid)
+			return;
+
+		Texture* pUnused{ nullptr };
+		{
+			std::lock_guard lock{ m_Mutex };
+			const auto keyIt{ m_TextureKeys.find(texture) };
+			if (keyIt == m_TextureKeys.end())
+				return;
+
+			const auto it{ m_Textures.find(keyIt->second) };
+			if (--it->second.numReferences > 0)
+				return;
+
+			pUnused = it->second.texture.get();
+			m_Textures.erase(it);
+			m_TextureKeys.erase(keyIt);
+		}
+
+		delete pUnused;
+	}
+
+	void ResourceRegistry::PurgeUnused()
+	{
+		std::lock_guard lock{ m_Mutex };
+		for (auto it{ m_Effects.begin() }; it != m_Effects.end();)
+		{
+			//Entries still being created always have the creator's reference
+			if (it->second.numReferences > 0)
+			{
+				++it;
+				continue;
+			}
+
+			const EffectHandle effect{ it->second.effect.get() };
+			m_pDevice->Release(effect);
+			m_EffectKeys.erase(effect);
+			it = m_Effects.erase(it);
+		}
+
+		for (auto it{ m_Samplers.begin() }; it != m_Samplers.end();)
+		{
+			if (it->second.numReferences > 0)
+			{
+				++it;
+				continue;
+			}
+
+			m_pDevice->Release(it->second.sampler);
+			m_SamplerKeys.erase(it->second.sampler);
+			it = m_Samplers.erase(it);
+		}
+	}
+
+	uint32_t ResourceRegistry::GetNumEffects() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<uint32_t>(m_Effects.size());
+	}
+
+	uint32_t ResourceRegistry::GetNumSamplers() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<uint32_t>(m_Samplers.size());
+	}
+
+	uint32_t ResourceRegistry::GetNumEffectsCreated() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_NumEffectsCreated;
+	}
+
+	uint32_t ResourceRegistry::GetNumSamplersCreated() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_NumSamplersCreated;
+	}
+
+	std::vector<ResourceRegistry::TextureUsage> ResourceRegistry::GetTextureUsage() const
+	{
+		std::vector<TextureUsage> usage{};
+		{
+			std::lock_guard lock{ m_Mutex };
+			for (const auto& [handle, key] : m_TextureKeys)
+			{
+				const TextureEntry& entry{ m_Textures.at(key) };
+				const Texture* pTexture{ entry.texture.get() };
+				usage.push_back(TextureUsage{ entry.name, pTexture->GetFormat(), pTexture->GetMemorySize(), entry.numReferences });
+			}
+		}
+
+		std::sort(usage.begin(), usage.end(), [](const TextureUsage& a, const TextureUsage& b) { return a.numBytes > b.numBytes; });
+		return usage;
+	}
+
+	uint64_t ResourceRegistry::GetTextureMemory() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		uint64_t numBytes{};
+		for (const auto& [handle, key] : m_TextureKeys)
+			numBytes += m_Textures.at(key).texture.get()->GetMemorySize();
+		return numBytes;
+	}
+
+	uint32_t ResourceRegistry::GetNumTextures() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return static_cast<uint32_t>(m_TextureKeys.size());
+	}
+
+	uint32_t ResourceRegistry::GetNumTexturesCreated() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_NumTexturesCreated;
+	}
+
+	size_t ResourceRegistry::EffectKeyHash::operator()(const EffectKey& key) const
+	{
+		//boost::hash_combine
+		size_t hash{ std::hash<std::wstring>{}(key.assetFile) };
+		const auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); };
+
+		combine(static_cast<size_t>(key.type));
+		for (const EffectDefine& define : key.defines)
+		{
+			combine(std::hash<std::string>{}(define.name));
+			combine(std::hash<std::string>{}(define.value));
+		}
+		return hash;
+	}
+
+	uint32_t ResourceRegistry::HashSamplerDesc(const SamplerDesc& desc)
+	{
+		return static_cast<uint32_t>(desc.filter)
+			| static_cast<uint32_t>(desc.address) << 8
+			| static_cast<uint32_t>(desc.maxAnisotropy) << 16;
+	}
+
+	std::string ResourceRegistry::NormalizePath(const std::string& path)
+	{
+		//Resolves "." and "..", and on Windows the spelling of existing files, so each file has one name
+		std::error_code error{};
+		const std::filesystem::path normalized{ std::filesystem::weakly_canonical(path, error) };
+		return error ? std::filesystem::path{ path }.lexically_normal().generic_string() : normalized.generic_string();
+	}
+
+	std::string ResourceRegistry::MakeTextureKey(const std::vector<ChannelSource>& sources, const TextureSettings& settings)
+	{
+		std::string key{};
+		for (const ChannelSource& source : sources)
+		{
+			key += NormalizePath(source.path);
+			key += '|';
+			key.append(reinterpret_cast<const char*>(source.channels), sizeof(source.channels));
+			key += '|';
+		}
+
+		key += static_cast<char>(settings.mips.filter);
+		key += static_cast<char>(settings.mips.content);
+		key += static_cast<char>(settings.format);
+		return key;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "GraphicsDevice.h"
+#include "Texture.h"
+
+namespace dae
+{
+	//Shares effects, samplers and textures between everything that asks for the same one.
+	//Effects are keyed by type, path and defines, samplers by their descriptor, textures by their normalized image paths,
+	//channel mapping and settings. Every Acquire takes a reference and needs a matching Release.
+	//Effects and samplers without references stay cached, so toggling back and forth doesn't create anything,
+	//until PurgeUnused drops them. Shared effects share their texture and sampler bindings too.
+	//Textures are released as soon as their last reference is, they are what fills video memory.
+	//Acquire and Release can be called from any thread; an effect or texture that is still being created by
+	//one thread is waited for by the others instead of being created twice.
+	class ResourceRegistry final
+	{
+	public:
+		explicit ResourceRegistry(GraphicsDevice* pDevice);
+		//Releases every cached object, whether or not it still has references
+		~ResourceRegistry();
+
+		// rule of 5 copypasta
+		ResourceRegistry(const ResourceRegistry& other) = delete;
+		ResourceRegistry(ResourceRegistry&& other) = delete;
+		ResourceRegistry& operator=(const ResourceRegistry& other) = delete;
+		ResourceRegistry& operator=(ResourceRegistry&& other) = delete;
+
+		EffectHandle AcquireEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines = {});
+		void Release(EffectHandle effect);
+
+		SamplerHandle AcquireSampler(const SamplerDesc& desc);
+		void Release(SamplerHandle sampler);
+
+		//"Resources/a.png" and "./Resources/../Resources/a.png" are the same texture.
+		//Invalid if an image can't be loaded, nothing is cached for it then.
+		TextureHandle AcquireTexture(const std::string& path, const TextureSettings& settings = {},
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr);
+		TextureHandle AcquireTexture(const std::vector<ChannelSource>& sources, const TextureSettings& settings = {},
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr);
+		//A file written by --cook-textures, mapped and uploaded as is
+		TextureHandle AcquireCookedTexture(const std::string& path);
+		void Release(TextureHandle texture);
+
+		//Releases the objects nobody holds a reference to anymore
+		void PurgeUnused();
+
+		//Distinct objects the registry holds, referenced or not
+		uint32_t GetNumEffects() const;
+		uint32_t GetNumSamplers() const;
+		//Objects the device was asked to create since the registry was made
+		uint32_t GetNumEffectsCreated() const;
+		uint32_t GetNumSamplersCreated() const;
+
+		struct TextureUsage
+		{
+			//The image paths as first asked for, packed ones joined by '+'
+			std::string name{};
+			TextureFormat format{};
+			uint64_t numBytes{};
+			uint32_t numReferences{};
+		};
+
+		//Live textures only, largest first
+		std::vector<TextureUsage> GetTextureUsage() const;
+		uint64_t GetTextureMemory() const;
+		uint32_t GetNumTextures() const;
+		uint32_t GetNumTexturesCreated() const;
+
+	private:
+		struct EffectKey
+		{
+			EffectType type{};
+			std::wstring assetFile{};
+			std::vector<EffectDefine> defines{};
+
+			bool operator==(const EffectKey& other) const = default;
+		};
+
+		struct EffectKeyHash
+		{
+			size_t operator()(const EffectKey& key) const;
+		};
+
+		struct EffectEntry
+		{
+			//Ready once the creating thread is done
+			std::shared_future<EffectHandle> effect{};
+			uint32_t numReferences{};
+		};
+
+		struct SamplerEntry
+		{
+			SamplerHandle sampler{ SamplerHandle::Invalid };
+			uint32_t numReferences{};
+		};
+
+		struct TextureEntry
+		{
+			//Ready once the creating thread is done, null if it failed
+			std::shared_future<Texture*> texture{};
+			std::string name{};
+			uint32_t numReferences{};
+		};
+
+		//Finds or loads the texture under key, shared with every other caller of that key
+		TextureHandle ShareTexture(const std::string& key, std::string name, const std::function<Texture*()>& load);
+
+		//Every field of the descriptor in one value
+		static uint32_t HashSamplerDesc(const SamplerDesc& desc);
+		static std::string NormalizePath(const std::string& path);
+		//Normalized paths with their channels, then the settings, as one string
+		static std::string MakeTextureKey(const std::vector<ChannelSource>& sources, const TextureSettings& settings);
+
+		GraphicsDevice* m_pDevice{ nullptr };
+
+		mutable std::mutex m_Mutex{};
+		std::unordered_map<EffectKey, EffectEntry, EffectKeyHash> m_Effects{};
+		std::unordered_map<EffectHandle, EffectKey> m_EffectKeys{};
+		std::unordered_map<uint32_t, SamplerEntry> m_Samplers{};
+		std::unordered_map<SamplerHandle, uint32_t> m_SamplerKeys{};
+		std::unordered_map<std::string, TextureEntry> m_Textures{};
+		std::unordered_map<TextureHandle, std::string> m_TextureKeys{};
+		uint32_t m_NumEffectsCreated{};
+		uint32_t m_NumSamplersCreated{};
+		uint32_t m_NumTexturesCreated{};
+	};
+}
@@ -1,6 +1,11 @@
 Texture2D gDiffuseMap	: DiffuseMap;
 
-float4x4 gWorldViewProj : WorldViewProjection;
+//Mirrored by ObjectConstants in ConstantBlocks.h. Per-draw matrices, bound straight from the renderer's constant ring (the effect never writes them)
+cbuffer cbPerObject : register(b1)
+{
+	row_major float4x4 gWorldViewProj;
+	row_major float4x4 gWorldMatrix;
+};
 
 
 SamplerState gSamState
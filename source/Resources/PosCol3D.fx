@@ -1,16 +1,48 @@
+//Permutation switches, set by the renderer per material (ShaderPermutation.h).
+//Without defines this compiles the full shader.
+#ifndef HAS_NORMAL_MAP
+#define HAS_NORMAL_MAP 1
+#endif
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP 1
+#endif
+#ifndef HAS_GLOSSINESS_MAP
+#define HAS_GLOSSINESS_MAP 1
+#endif
+#ifndef ALPHA_TEST
+#define ALPHA_TEST 0
+#endif
+
 Texture2D gDiffuseMap	: DiffuseMap;
 Texture2D gNormalMap	: NormalMap;
+//Specular color in RGB, glossiness in A (packed by the renderer, one sample for both)
 Texture2D gSpecularMap	: SpecularMap;
-Texture2D gGlossinessMap: GlossinessMap;
 
-float4x4 gWorldViewProj : WorldViewProjection;
-float4x4 gWorldMatrix	: WorldMarix;
-float4x4 gViewInverseMatrix	: ViewInverseMarix;
+//Every cbuffer is mirrored by a struct in ConstantBlocks.h, the effect checks both match when it's created
+
+//Per-frame values, bound straight from the renderer's constant ring (the effect never writes them)
+cbuffer cbPerFrame : register(b0)
+{
+	row_major float4x4 gViewInverseMatrix;
+	float3 gLightDirection;
+	float gLightIntensity;
+};
+
+//Per-draw matrices, bound straight from the renderer's constant ring (the effect never writes them)
+cbuffer cbPerObject : register(b1)
+{
+	row_major float4x4 gWorldViewProj;
+	row_major float4x4 gWorldMatrix;
+};
+
+//Set whole by the renderer, uploaded by the effect when it changed
+cbuffer cbMaterial : register(b2)
+{
+	float gShininess;
+	float gAlphaCutoff;
+};
 
-float gPI = 3.14159265359f;
-float gLightIntensity = 7.0f;
-float gShininess = 25.0f;
-float3 gLightDirection = float3(0.577f, -0.577f, 0.577f);
+static const float gPI = 3.14159265359f;
 
 
 
@@ -110,29 +142,44 @@ VS_OUTPUT VS(VS_INPUT input)
 
 float4 PS(VS_OUTPUT input) : SV_TARGET
 {
+	// DIFFUSE
+	float4 TextureColor = gDiffuseMap.Sample(gSamState, input.UV) / gPI ;
+
+#if ALPHA_TEST
+	clip(TextureColor.a * gPI - gAlphaCutoff);
+#endif
+
+#if HAS_NORMAL_MAP
 	float3 binormal = cross(input.Normal, input.Tangent);
 	float4x4 tangentSpaceAxis = float4x4(float4(input.Tangent, 0.0f), float4(binormal, 0.0f), float4(input.Normal, 0.0), float4(0.0f, 0.0f, 0.0f, 1.0f));
-	float3 currentNormalMap = 2.0f * gNormalMap.Sample(gSamState, input.UV).rgb - float3(1.0f, 1.0f, 1.0f);
+	//BC5 only stores XY, Z follows from the normal being unit length and facing out of the surface
+	float2 normalXY = 2.0f * gNormalMap.Sample(gSamState, input.UV).rg - float2(1.0f, 1.0f);
+	float3 currentNormalMap = float3(normalXY, sqrt(saturate(1.0f - dot(normalXY, normalXY))));
 	float3 normal = mul(float4(currentNormalMap, 0.0f), tangentSpaceAxis);
-
-	float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInverseMatrix[3].xyz);
+#else
+	float3 normal = input.Normal;
+#endif
 
 	// OBSERVED AREA
 	float ObservedArea = saturate(dot(normal,  -gLightDirection));
 
-	// DIFFUSE
-	float4 TextureColor = gDiffuseMap.Sample(gSamState, input.UV) / gPI ;
-
-
+#if HAS_SPECULAR_MAP
 	// SPECULAR
+	float3 viewDirection = normalize(input.WorldPosition.xyz - gViewInverseMatrix[3].xyz);
 	float3 reflection = reflect(-gLightDirection, input.Normal);
 	float cosAlpha = saturate(dot(reflection, viewDirection));
-	float specularExp = gShininess * gGlossinessMap.Sample(gSamState, input.UV).r;
-	float4 specular = gSpecularMap.Sample(gSamState, input.UV) * pow(cosAlpha, specularExp);
-
-
+	float4 specularGlossiness = gSpecularMap.Sample(gSamState, input.UV);
+#if HAS_GLOSSINESS_MAP
+	float specularExp = gShininess * specularGlossiness.a;
+#else
+	float specularExp = gShininess;
+#endif
+	float4 specular = float4(specularGlossiness.rgb, 1.0f) * pow(cosAlpha, specularExp);
 
 	return (gLightIntensity * TextureColor + specular) * ObservedArea;
+#else
+	return gLightIntensity * TextureColor * ObservedArea;
+#endif
 }
 
 //------------------------------------------------------
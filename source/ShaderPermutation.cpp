@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "ShaderPermutation.h"
+
+namespace dae
+{
+	uint32_t ShaderPermutation::Select(bool hasNormalMap, bool hasSpecularMap, bool hasGlossinessMap, bool isAlphaTested)
+	{
+		uint32_t features{};
+		if (hasNormalMap)
+			features |= ShaderFeature::NormalMap;
+		if (hasSpecularMap)
+			features |= ShaderFeature::SpecularMap;
+		if (hasSpecularMap && hasGlossinessMap)
+			features |= ShaderFeature::GlossinessMap;
+		if (isAlphaTested)
+			features |= ShaderFeature::AlphaTest;
+		return features;
+	}
+
+	std::vector<EffectDefine> ShaderPermutation::GetDefines(uint32_t features)
+	{
+		const auto toValue = [features](uint32_t feature) { return std::string{ (features & feature) ? "1" : "0" }; };
+
+		return std::vector<EffectDefine>{
+			{ "HAS_NORMAL_MAP", toValue(ShaderFeature::NormalMap) },
+			{ "HAS_SPECULAR_MAP", toValue(ShaderFeature::SpecularMap) },
+			{ "HAS_GLOSSINESS_MAP", toValue(ShaderFeature::GlossinessMap) },
+			{ "ALPHA_TEST", toValue(ShaderFeature::AlphaTest) }
+		};
+	}
+
+	uint32_t ShaderPermutation::FromDefines(const std::vector<EffectDefine>& defines)
+	{
+		const std::pair<const char*, uint32_t> switches[]{
+			{ "HAS_NORMAL_MAP", ShaderFeature::NormalMap },
+			{ "HAS_SPECULAR_MAP", ShaderFeature::SpecularMap },
+			{ "HAS_GLOSSINESS_MAP", ShaderFeature::GlossinessMap },
+			{ "ALPHA_TEST", ShaderFeature::AlphaTest }
+		};
+
+		uint32_t features{ ShaderFeature::Default };
+		for (const EffectDefine& define : defines)
+		{
+			for (const auto& [pName, feature] : switches)
+			{
+				if (define.name != pName)
+					continue;
+				if (define.value == "0")
+					features &= ~feature;
+				else
+					features |= feature;
+			}
+		}
+		return features;
+	}
+}
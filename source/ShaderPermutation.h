@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "GraphicsDevice.h"
+
+namespace dae
+{
+	//Optional parts of PosCol3D.fx, each one compiled in or out with a preprocessor switch
+	namespace ShaderFeature
+	{
+		constexpr uint32_t NormalMap{ 1 << 0 };
+		constexpr uint32_t SpecularMap{ 1 << 1 };
+		//Glossiness in the alpha of the specular map
+		constexpr uint32_t GlossinessMap{ 1 << 2 };
+		constexpr uint32_t AlphaTest{ 1 << 3 };
+
+		//What the shader does without any defines
+		constexpr uint32_t Default{ NormalMap | SpecularMap | GlossinessMap };
+		constexpr uint32_t NumPermutations{ 16 };
+	}
+
+	//Picks and names the variants of the shaded effect
+	namespace ShaderPermutation
+	{
+		//Cheapest variant that still renders the material the same: features without a texture are dropped,
+		//and glossiness only matters when there is a specular map that holds it
+		uint32_t Select(bool hasNormalMap, bool hasSpecularMap, bool hasGlossinessMap, bool isAlphaTested);
+
+		//Every switch is set explicitly, so each variant has exactly one key in the registry and effect cache
+		std::vector<EffectDefine> GetDefines(uint32_t features);
+		//Back from defines to features, switches that aren't set keep what the shader does without them
+		uint32_t FromDefines(const std::vector<EffectDefine>& defines);
+	}
+}
@@ -0,0 +1,883 @@
+#include "pch.h"
+#include "SoftwareDevice.h"
+#include "CpuShader.h"
+#include "CpuTexture.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "ShaderPermutation.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace dae
+{
+	namespace
+	{
+		template<typename T, typename Handle>
+		T* ToObject(Handle handle)
+		{
+			return reinterpret_cast<T*>(static_cast<uintptr_t>(handle));
+		}
+
+		template<typename Handle, typename T>
+		Handle ToHandle(T* pObject)
+		{
+			return static_cast<Handle>(reinterpret_cast<uintptr_t>(pObject));
+		}
+
+		//mul(float4(p, 1), m) with a row-major cbuffer matrix
+		Vector4 TransformPoint(const float (&m)[16], const Vector3& p)
+		{
+			return Vector4{
+				p.x * m[0] + p.y * m[4] + p.z * m[8] + m[12],
+				p.x * m[1] + p.y * m[5] + p.z * m[9] + m[13],
+				p.x * m[2] + p.y * m[6] + p.z * m[10] + m[14],
+				p.x * m[3] + p.y * m[7] + p.z * m[11] + m[15]
+			};
+		}
+
+		//mul(v, (float3x3)m)
+		Vector3 TransformVector(const float (&m)[16], const Vector3& v)
+		{
+			return Vector3{
+				v.x * m[0] + v.y * m[4] + v.z * m[8],
+				v.x * m[1] + v.y * m[5] + v.z * m[9],
+				v.x * m[2] + v.y * m[6] + v.z * m[10]
+			};
+		}
+
+		//R8G8B8A8_UNORM, R in the lowest byte
+		uint32_t PackColor(float r, float g, float b, float a)
+		{
+			const auto toUnorm = [](float value) { return static_cast<uint32_t>(Saturate(value) * 255.f + 0.5f); };
+			return toUnorm(r) | toUnorm(g) << 8 | toUnorm(b) << 16 | toUnorm(a) << 24;
+		}
+
+		Vector4 UnpackColor(uint32_t color)
+		{
+			return Vector4{ (color & 0xFF) / 255.f, (color >> 8 & 0xFF) / 255.f, (color >> 16 & 0xFF) / 255.f, (color >> 24) / 255.f };
+		}
+
+		float Interpolate(const float (&weights)[3], const float (&values)[3])
+		{
+			return weights[0] * values[0] + weights[1] * values[1] + weights[2] * values[2];
+		}
+	}
+
+	SoftwareDevice::SoftwareDevice(uint32_t width, uint32_t height, SDL_Window* pWindow)
+		:m_Width{ width }
+		,m_Height{ height }
+		,m_NumTilesX{ (width + TileSize - 1) / TileSize }
+		,m_NumTilesY{ (height + TileSize - 1) / TileSize }
+		,m_pWindow{ pWindow }
+		,m_ColorBuffer(size_t{ width } * height)
+		,m_DepthBuffer(size_t{ width } * height, 1.f)
+	{
+		//The color buffer as a surface, blitted into whatever format the window has
+		if (m_pWindow)
+			m_pFrameSurface = SDL_CreateRGBSurfaceWithFormatFrom(m_ColorBuffer.data(), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32);
+	}
+
+	SoftwareDevice::~SoftwareDevice()
+	{
+		if (m_NumLiveResources > 0)
+			std::cout << "SoftwareDevice: " << m_NumLiveResources << " resource(s) were never released\n";
+
+		if (m_pFrameSurface)
+			SDL_FreeSurface(m_pFrameSurface);
+	}
+
+	bool SoftwareDevice::IsInitialized() const
+	{
+		return m_Width > 0 && m_Height > 0;
+	}
+
+	void SoftwareDevice::SetJobSystem(JobSystem* pJobs)
+	{
+		m_pJobs = pJobs;
+	}
+
+	BufferHandle SoftwareDevice::CreateVertexBuffer(const void* pVertices, uint32_t byteSize)
+	{
+		if (!pVertices || byteSize == 0)
+		{
+			++m_NumErrors;
+			return BufferHandle::Invalid;
+		}
+
+		const uint8_t* pBytes{ static_cast<const uint8_t*>(pVertices) };
+		++m_NumLiveResources;
+		return ToHandle<BufferHandle>(new Buffer{ std::vector<uint8_t>(pBytes, pBytes + byteSize) });
+	}
+
+	BufferHandle SoftwareDevice::CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices)
+	{
+		if (!pIndices || numIndices == 0)
+		{
+			++m_NumErrors;
+			return BufferHandle::Invalid;
+		}
+
+		const uint8_t* pBytes{ reinterpret_cast<const uint8_t*>(pIndices) };
+		++m_NumLiveResources;
+		return ToHandle<BufferHandle>(new Buffer{ std::vector<uint8_t>(pBytes, pBytes + size_t{ numIndices } * sizeof(uint32_t)) });
+	}
+
+	TextureHandle SoftwareDevice::CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels)
+	{
+		if (!pLevels || numLevels == 0)
+		{
+			++m_NumErrors;
+			return TextureHandle::Invalid;
+		}
+
+		//The levels packed into one chain, rows as GetRowPitch lays them out
+		MipChain chain{};
+		chain.format = format;
+		for (uint32_t level{}; level < numLevels; ++level)
+		{
+			const TextureLevel& source{ pLevels[level] };
+			const uint32_t rowPitch{ GetRowPitch(format, source.width) };
+			const uint32_t numRows{ GetNumRows(format, source.height) };
+			chain.levels.push_back(MipChain::Level{ source.width, source.height, chain.pixels.size() });
+			chain.pixels.resize(chain.pixels.size() + size_t{ rowPitch } * numRows);
+
+			uint8_t* pTarget{ chain.pixels.data() + chain.levels.back().offset };
+			for (uint32_t row{}; row < numRows; ++row)
+				std::memcpy(pTarget + size_t{ row } * rowPitch, static_cast<const uint8_t*>(source.pPixels) + size_t{ row } * source.rowPitch, rowPitch);
+		}
+
+		++m_NumLiveResources;
+		return ToHandle<TextureHandle>(new CpuTexture{ chain });
+	}
+
+	EffectHandle SoftwareDevice::CreateEffect(EffectType type, const std::wstring&, const std::vector<EffectDefine>& defines)
+	{
+		Effect* pEffect{ new Effect{} };
+		pEffect->type = type;
+		pEffect->features = type == EffectType::Shaded ? ShaderPermutation::FromDefines(defines) : 0;
+
+		++m_NumLiveResources;
+		return ToHandle<EffectHandle>(pEffect);
+	}
+
+	InputLayoutHandle SoftwareDevice::CreateInputLayout(EffectHandle effect)
+	{
+		if (effect == EffectHandle::Invalid)
+			++m_NumErrors;
+
+		++m_NumLiveResources;
+		return ToHandle<InputLayoutHandle>(new InputLayout{});
+	}
+
+	SamplerHandle SoftwareDevice::CreateSampler(const SamplerDesc& desc)
+	{
+		++m_NumLiveResources;
+		return ToHandle<SamplerHandle>(new SamplerDesc{ desc });
+	}
+
+	uint32_t SoftwareDevice::GetNumPasses(EffectHandle) const
+	{
+		return 1;
+	}
+
+	void SoftwareDevice::Release(BufferHandle buffer)
+	{
+		if (buffer == BufferHandle::Invalid)
+			return;
+		delete ToObject<Buffer>(buffer);
+		--m_NumLiveResources;
+	}
+
+	void SoftwareDevice::Release(TextureHandle texture)
+	{
+		if (texture == TextureHandle::Invalid)
+			return;
+		delete ToObject<CpuTexture>(texture);
+		--m_NumLiveResources;
+	}
+
+	void SoftwareDevice::Release(EffectHandle effect)
+	{
+		if (effect == EffectHandle::Invalid)
+			return;
+		delete ToObject<Effect>(effect);
+		--m_NumLiveResources;
+	}
+
+	void SoftwareDevice::Release(InputLayoutHandle layout)
+	{
+		if (layout == InputLayoutHandle::Invalid)
+			return;
+		delete ToObject<InputLayout>(layout);
+		--m_NumLiveResources;
+	}
+
+	void SoftwareDevice::Release(SamplerHandle sampler)
+	{
+		if (sampler == SamplerHandle::Invalid)
+			return;
+		delete ToObject<SamplerDesc>(sampler);
+		--m_NumLiveResources;
+	}
+
+	void SoftwareDevice::SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture)
+	{
+		if (effect == EffectHandle::Invalid)
+		{
+			++m_NumErrors;
+			return;
+		}
+
+		//Unbound slots sample 0, like an empty shader resource view
+		ToObject<Effect>(effect)->pTextures[static_cast<uint32_t>(slot)] = ToObject<const CpuTexture>(texture);
+	}
+
+	void SoftwareDevice::SetSampler(EffectHandle effect, SamplerHandle sampler)
+	{
+		if (effect == EffectHandle::Invalid)
+		{
+			++m_NumErrors;
+			return;
+		}
+
+		ToObject<Effect>(effect)->sampler = sampler == SamplerHandle::Invalid ? SamplerDesc{} : *ToObject<const SamplerDesc>(sampler);
+	}
+
+	void SoftwareDevice::SetMaterial(EffectHandle effect, const MaterialConstants& material)
+	{
+		if (effect == EffectHandle::Invalid)
+		{
+			++m_NumErrors;
+			return;
+		}
+
+		ToObject<Effect>(effect)->material = material;
+	}
+
+	void SoftwareDevice::BeginFrame(const ColorRGB& clearColor)
+	{
+		if (m_IsInFrame)
+			++m_NumErrors;
+
+		m_IsInFrame = true;
+		//Tiles clear themselves when they are rasterized
+		m_ClearColor = PackColor(clearColor.r, clearColor.g, clearColor.b, 1.f);
+		m_Draws.clear();
+
+		if (m_FrameIndex > 0)
+			m_ConstantRing.RetireFrame(m_FrameIndex - 1);
+		m_ConstantRing.BeginFrame(m_FrameIndex);
+	}
+
+	void SoftwareDevice::Submit(const CommandBuffer& buffer)
+	{
+		if (!m_IsInFrame || m_IsConstantsMapped)
+			++m_NumErrors;
+
+		ReplayCommands(buffer);
+	}
+
+	void SoftwareDevice::Present()
+	{
+		if (!m_IsInFrame || m_IsConstantsMapped)
+			++m_NumErrors;
+
+		const auto start{ std::chrono::high_resolution_clock::now() };
+
+		TransformVertices();
+
+		//Every draw's triangles one after the other, set up and binned in chunks of consecutive ones
+		m_FirstTriangles.clear();
+		m_NumSubmittedTriangles = 0;
+		for (const Draw& draw : m_Draws)
+		{
+			m_FirstTriangles.push_back(m_NumSubmittedTriangles);
+			m_NumSubmittedTriangles += draw.numIndices / 3;
+		}
+
+		m_NumChunks = (m_NumSubmittedTriangles + TrianglesPerChunk - 1) / TrianglesPerChunk;
+		if (m_Chunks.size() < m_NumChunks)
+			m_Chunks.resize(m_NumChunks);
+		ParallelFor(m_NumChunks, 1, [this](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t chunk{ begin }; chunk < end; ++chunk)
+					SetUpTriangles(chunk);
+			});
+
+		std::atomic<uint64_t> numPixelsShaded{};
+		ParallelFor(m_NumTilesX * m_NumTilesY, 1, [&](uint32_t begin, uint32_t end)
+			{
+				uint64_t numPixels{};
+				for (uint32_t tile{ begin }; tile < end; ++tile)
+					numPixels += RasterizeTile(tile);
+				numPixelsShaded += numPixels;
+			});
+
+		m_NumTriangles = 0;
+		for (uint32_t chunk{}; chunk < m_NumChunks; ++chunk)
+			m_NumTriangles += static_cast<uint32_t>(m_Chunks[chunk].triangles.size());
+		m_NumPixelsShaded = numPixelsShaded;
+
+		CopyToWindow();
+
+		m_IsInFrame = false;
+		m_ConstantRing.EndFrame();
+		++m_FrameIndex;
+		m_RasterizeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	ConstantBlock SoftwareDevice::MapConstants(uint32_t size)
+	{
+		if (!m_IsInFrame || m_IsConstantsMapped)
+		{
+			++m_NumErrors;
+			return ConstantBlock{};
+		}
+
+		if (m_ConstantData.empty())
+			m_ConstantData.resize(m_ConstantRing.GetCapacity());
+
+		RingAllocation allocation{};
+		bool isNewRing{ false };
+		if (!m_ConstantRing.Allocate(size, allocation))
+		{
+			//Earlier blocks of this frame would be lost with the old buffer
+			if (m_ConstantRing.GetFrameUsed() > 0)
+				return ConstantBlock{};
+
+			uint32_t capacity{ m_ConstantRing.GetCapacity() };
+			do
+			{
+				capacity *= 2;
+			} while (capacity < AlignConstantSize(size));
+
+			m_ConstantRing.Reset(capacity);
+			m_ConstantData.resize(capacity);
+			m_ConstantRing.Allocate(size, allocation);
+			isNewRing = true;
+		}
+
+		m_IsConstantsMapped = true;
+		return ConstantBlock{ m_ConstantData.data() + allocation.offset, allocation.offset, isNewRing };
+	}
+
+	void SoftwareDevice::UnmapConstants()
+	{
+		if (!m_IsConstantsMapped)
+			++m_NumErrors;
+
+		m_IsConstantsMapped = false;
+	}
+
+	uint32_t SoftwareDevice::GetWidth() const
+	{
+		return m_Width;
+	}
+
+	uint32_t SoftwareDevice::GetHeight() const
+	{
+		return m_Height;
+	}
+
+	const std::vector<uint32_t>& SoftwareDevice::GetColorBuffer() const
+	{
+		return m_ColorBuffer;
+	}
+
+	uint32_t SoftwareDevice::GetNumTriangles() const
+	{
+		return m_NumTriangles;
+	}
+
+	uint64_t SoftwareDevice::GetNumPixelsShaded() const
+	{
+		return m_NumPixelsShaded;
+	}
+
+	float SoftwareDevice::GetRasterizeMs() const
+	{
+		return m_RasterizeMs;
+	}
+
+	uint32_t SoftwareDevice::GetNumErrors() const
+	{
+		return m_NumErrors;
+	}
+
+	uint32_t SoftwareDevice::GetNumThreads() const
+	{
+		return m_pJobs ? m_pJobs->GetNumThreads() : 1;
+	}
+
+	void SoftwareDevice::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function)
+	{
+		if (m_pJobs)
+			m_pJobs->ParallelFor(count, batchSize, function);
+		else if (count > 0)
+			function(0, count);
+	}
+
+	void SoftwareDevice::ReplayCommands(const CommandBuffer& buffer)
+	{
+		//State stays bound across buffers and frames, like a device context's
+		for (const Command& command : buffer.GetCommands())
+		{
+			switch (command.type)
+			{
+			case CommandType::SetVertexBuffer:
+				m_Pipeline.pVertexBuffer = ToObject<const Buffer>(command.setVertexBuffer.buffer);
+				m_Pipeline.stride = command.setVertexBuffer.stride;
+				m_Pipeline.offset = command.setVertexBuffer.offset;
+				break;
+			case CommandType::SetIndexBuffer:
+				m_Pipeline.pIndexBuffer = ToObject<const Buffer>(command.setIndexBuffer.buffer);
+				break;
+			case CommandType::SetConstants:
+			{
+				const uint32_t slot{ static_cast<uint32_t>(command.setConstants.slot) };
+				if (slot < NumConstantSlots)
+				{
+					m_Pipeline.constantOffsets[slot] = command.setConstants.offset;
+					m_Pipeline.isConstantBound[slot] = true;
+				}
+				break;
+			}
+			case CommandType::ApplyPass:
+				m_Pipeline.pEffect = ToObject<const Effect>(command.applyPass.effect);
+				break;
+			case CommandType::DrawIndexed:
+			{
+				const Command::DrawIndexedArgs& args{ command.drawIndexed };
+				const Pipeline& pipeline{ m_Pipeline };
+				const uint32_t frameOffset{ pipeline.constantOffsets[static_cast<uint32_t>(ConstantSlot::Frame)] };
+				const uint32_t objectOffset{ pipeline.constantOffsets[static_cast<uint32_t>(ConstantSlot::Object)] };
+
+				//Only PosCol3D reads the per-frame block
+				const bool isShaded{ pipeline.pEffect && pipeline.pEffect->type == EffectType::Shaded };
+				const bool isValid{ pipeline.pVertexBuffer && pipeline.pIndexBuffer && pipeline.pEffect
+					&& pipeline.stride >= sizeof(Vertex) && pipeline.offset <= pipeline.pVertexBuffer->bytes.size()
+					&& (uint64_t{ args.startIndex } + args.indexCount) * sizeof(uint32_t) <= pipeline.pIndexBuffer->bytes.size()
+					&& pipeline.isConstantBound[static_cast<uint32_t>(ConstantSlot::Object)]
+					&& uint64_t{ objectOffset } + sizeof(ObjectConstants) <= m_ConstantData.size()
+					&& (!isShaded || (pipeline.isConstantBound[static_cast<uint32_t>(ConstantSlot::Frame)]
+						&& uint64_t{ frameOffset } + sizeof(FrameConstants) <= m_ConstantData.size())) };
+				if (!isValid)
+				{
+					++m_NumErrors;
+					break;
+				}
+
+				Draw& draw{ m_Draws.emplace_back() };
+				draw.effect = *pipeline.pEffect;
+				draw.pVertices = pipeline.pVertexBuffer->bytes.data() + pipeline.offset;
+				draw.stride = pipeline.stride;
+				draw.numVertices = static_cast<uint32_t>((pipeline.pVertexBuffer->bytes.size() - pipeline.offset) / pipeline.stride);
+				draw.pIndices = reinterpret_cast<const uint32_t*>(pipeline.pIndexBuffer->bytes.data()) + args.startIndex;
+				draw.numIndices = args.indexCount - args.indexCount % 3;
+				draw.baseVertex = args.baseVertex;
+				if (isShaded)
+					std::memcpy(&draw.frame, m_ConstantData.data() + frameOffset, sizeof(FrameConstants));
+				std::memcpy(&draw.object, m_ConstantData.data() + objectOffset, sizeof(ObjectConstants));
+				break;
+			}
+			case CommandType::SetPrimitiveTopology:
+			case CommandType::SetInputLayout:
+				break;
+			}
+		}
+	}
+
+	void SoftwareDevice::TransformVertices()
+	{
+		m_FirstVertices.clear();
+		uint32_t numVertices{};
+		for (const Draw& draw : m_Draws)
+		{
+			m_FirstVertices.push_back(numVertices);
+			numVertices += draw.numVertices;
+		}
+		m_Vertices.resize(numVertices);
+
+		constexpr uint32_t verticesPerJob{ 1024 };
+		ParallelFor(numVertices, verticesPerJob, [this](uint32_t begin, uint32_t end)
+			{
+				//The draw the batch starts in, the ones after it follow in order
+				uint32_t drawIndex{ static_cast<uint32_t>(std::upper_bound(m_FirstVertices.begin(), m_FirstVertices.end(), begin) - m_FirstVertices.begin()) - 1 };
+				for (uint32_t i{ begin }; i < end; ++i)
+				{
+					while (drawIndex + 1 < m_FirstVertices.size() && m_FirstVertices[drawIndex + 1] <= i)
+						++drawIndex;
+
+					const Draw& draw{ m_Draws[drawIndex] };
+					Vertex vertex{};
+					std::memcpy(&vertex, draw.pVertices + size_t{ i - m_FirstVertices[drawIndex] } * draw.stride, sizeof(Vertex));
+
+					//The VS of PosCol3D.fx, PartialCoverage.fx only uses the position and uv of it
+					ShadedVertex& shaded{ m_Vertices[i] };
+					shaded.position = TransformPoint(draw.object.worldViewProjection, vertex.position);
+					shaded.worldPosition = TransformPoint(draw.object.world, vertex.position).GetXYZ();
+					shaded.uv = vertex.uv;
+					shaded.normal = TransformVector(draw.object.world, vertex.normal.Normalized());
+					shaded.tangent = TransformVector(draw.object.world, vertex.tangent.Normalized());
+				}
+			});
+	}
+
+	void SoftwareDevice::SetUpTriangles(uint32_t chunkIndex)
+	{
+		Chunk& chunk{ m_Chunks[chunkIndex] };
+		chunk.triangles.clear();
+		chunk.bins.resize(size_t{ m_NumTilesX } * m_NumTilesY);
+		for (std::vector<uint32_t>& bin : chunk.bins)
+			bin.clear();
+
+		const auto lerp = [](const ShadedVertex& a, const ShadedVertex& b, float t)
+			{
+				return ShadedVertex{ a.position + (b.position - a.position) * t, a.worldPosition + (b.worldPosition - a.worldPosition) * t,
+					a.uv + (b.uv - a.uv) * t, a.normal + (b.normal - a.normal) * t, a.tangent + (b.tangent - a.tangent) * t };
+			};
+
+		const uint32_t begin{ chunkIndex * TrianglesPerChunk };
+		const uint32_t end{ std::min(begin + TrianglesPerChunk, m_NumSubmittedTriangles) };
+		uint32_t drawIndex{ static_cast<uint32_t>(std::upper_bound(m_FirstTriangles.begin(), m_FirstTriangles.end(), begin) - m_FirstTriangles.begin()) - 1 };
+		for (uint32_t i{ begin }; i < end; ++i)
+		{
+			while (drawIndex + 1 < m_FirstTriangles.size() && m_FirstTriangles[drawIndex + 1] <= i)
+				++drawIndex;
+
+			const Draw& draw{ m_Draws[drawIndex] };
+			const uint32_t* pIndices{ draw.pIndices + size_t{ i - m_FirstTriangles[drawIndex] } * 3 };
+			ShadedVertex vertices[3]{};
+			bool isValid{ true };
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const int64_t index{ int64_t{ pIndices[corner] } + draw.baseVertex };
+				isValid = isValid && index >= 0 && index < draw.numVertices;
+				if (isValid)
+					vertices[corner] = m_Vertices[m_FirstVertices[drawIndex] + index];
+			}
+			if (!isValid)
+			{
+				++m_NumErrors;
+				continue;
+			}
+
+			//D3D keeps 0 <= z: the part in front of the near plane is cut off, then whatever reaches past the guard band.
+			//Each plane is w * offset + x * scaleX + y * scaleY + z * scaleZ >= 0
+			const float guardX{ 1.f + 2.f * GuardBand / m_Width };
+			const float guardY{ 1.f + 2.f * GuardBand / m_Height };
+			const float planes[5][4]{
+				{ 0.f, 0.f, 0.f, 1.f },
+				{ guardX, -1.f, 0.f, 0.f },
+				{ guardX, 1.f, 0.f, 0.f },
+				{ guardY, 0.f, -1.f, 0.f },
+				{ guardY, 0.f, 1.f, 0.f }
+			};
+			ShadedVertex polygons[2][MaxClippedCorners]{};
+			uint32_t numCorners{ 3 };
+			std::copy(vertices, vertices + 3, polygons[0]);
+			uint32_t current{};
+			for (const float (&plane)[4] : planes)
+			{
+				const auto distance = [&plane](const ShadedVertex& vertex)
+					{
+						return vertex.position.w * plane[0] + vertex.position.x * plane[1] + vertex.position.y * plane[2] + vertex.position.z * plane[3];
+					};
+
+				bool isInside{ true };
+				for (uint32_t corner{}; corner < numCorners; ++corner)
+					isInside = isInside && distance(polygons[current][corner]) >= 0.f;
+				if (isInside)
+					continue;
+
+				const ShadedVertex* pPolygon{ polygons[current] };
+				ShadedVertex* pClipped{ polygons[1 - current] };
+				uint32_t numClippedCorners{};
+				for (uint32_t corner{}; corner < numCorners; ++corner)
+				{
+					const ShadedVertex& vertex{ pPolygon[corner] };
+					const ShadedVertex& next{ pPolygon[(corner + 1) % numCorners] };
+					const float vertexDistance{ distance(vertex) };
+					const float nextDistance{ distance(next) };
+					if (vertexDistance >= 0.f)
+						pClipped[numClippedCorners++] = vertex;
+					if ((vertexDistance >= 0.f) != (nextDistance >= 0.f))
+						pClipped[numClippedCorners++] = lerp(vertex, next, vertexDistance / (vertexDistance - nextDistance));
+				}
+				numCorners = numClippedCorners;
+				current = 1 - current;
+			}
+
+			const ShadedVertex* polygon{ polygons[current] };
+			for (uint32_t corner{ 1 }; corner + 1 < numCorners; ++corner)
+			{
+				const ShadedVertex triangle[3]{ polygon[0], polygon[corner], polygon[corner + 1] };
+				AddTriangle(drawIndex, triangle, chunk);
+			}
+		}
+	}
+
+	void SoftwareDevice::AddTriangle(uint32_t drawIndex, const ShadedVertex (&vertices)[3], Chunk& chunk)
+	{
+		//Viewport: NDC y points up, pixel rows go down
+		const float maxCoordinate{ GuardBand * 2.f + std::max(m_Width, m_Height) };
+		int64_t x[3]{};
+		int64_t y[3]{};
+		float inverseW[3]{};
+		for (uint32_t corner{}; corner < 3; ++corner)
+		{
+			const Vector4& position{ vertices[corner].position };
+			inverseW[corner] = 1.f / position.w;
+			const float screenX{ (position.x * inverseW[corner] + 1.f) * 0.5f * m_Width };
+			const float screenY{ (1.f - position.y * inverseW[corner]) * 0.5f * m_Height };
+
+			//Clipping keeps corners inside the guard band, only NaN gets here
+			if (!(std::abs(screenX) < maxCoordinate && std::abs(screenY) < maxCoordinate))
+				return;
+			x[corner] = static_cast<int64_t>(std::lround(screenX * SubpixelSteps));
+			y[corner] = static_cast<int64_t>(std::lround(screenY * SubpixelSteps));
+		}
+
+		//gRasterizerState culls front faces, which are the clockwise ones on screen, and nothing without area is drawn
+		const int64_t area{ (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]) };
+		if (area >= 0)
+			return;
+
+		const int minX{ static_cast<int>(std::max<int64_t>(std::min({ x[0], x[1], x[2] }) / SubpixelSteps, 0)) };
+		const int minY{ static_cast<int>(std::max<int64_t>(std::min({ y[0], y[1], y[2] }) / SubpixelSteps, 0)) };
+		const int maxX{ static_cast<int>(std::min<int64_t>(std::max({ x[0], x[1], x[2] }) / SubpixelSteps, m_Width - 1)) };
+		const int maxY{ static_cast<int>(std::min<int64_t>(std::max({ y[0], y[1], y[2] }) / SubpixelSteps, m_Height - 1)) };
+		if (minX > maxX || minY > maxY)
+			return;
+
+		Triangle& triangle{ chunk.triangles.emplace_back() };
+		triangle.draw = drawIndex;
+		triangle.minX = minX;
+		triangle.minY = minY;
+		triangle.maxX = maxX;
+		triangle.maxY = maxY;
+		triangle.inverseArea = 1.f / static_cast<float>(-area);
+
+		for (uint32_t corner{}; corner < 3; ++corner)
+		{
+			//The edge opposite the corner, positive on the corner's side
+			const uint32_t first{ (corner + 1) % 3 };
+			const uint32_t second{ (corner + 2) % 3 };
+			triangle.edgeA[corner] = y[second] - y[first];
+			triangle.edgeB[corner] = x[first] - x[second];
+			triangle.edgeC[corner] = x[second] * y[first] - x[first] * y[second];
+			//Left edges have the inside to their right, top edges have it below them
+			const bool isTopLeft{ triangle.edgeA[corner] > 0 || (triangle.edgeA[corner] == 0 && triangle.edgeB[corner] > 0) };
+			triangle.edgeBias[corner] = isTopLeft ? 1 : 0;
+
+			triangle.weightDx[corner] = triangle.edgeA[corner] * SubpixelSteps * triangle.inverseArea;
+			triangle.weightDy[corner] = triangle.edgeB[corner] * SubpixelSteps * triangle.inverseArea;
+
+			const ShadedVertex& vertex{ vertices[corner] };
+			const float values[NumAttributes]{ vertex.worldPosition.x, vertex.worldPosition.y, vertex.worldPosition.z, vertex.uv.x, vertex.uv.y,
+				vertex.normal.x, vertex.normal.y, vertex.normal.z, vertex.tangent.x, vertex.tangent.y, vertex.tangent.z };
+			triangle.depth[corner] = vertex.position.z * inverseW[corner];
+			triangle.inverseW[corner] = inverseW[corner];
+			for (uint32_t attribute{}; attribute < NumAttributes; ++attribute)
+				triangle.attributes[attribute][corner] = values[attribute] * inverseW[corner];
+		}
+
+		const uint32_t index{ static_cast<uint32_t>(chunk.triangles.size() - 1) };
+		for (uint32_t tileY{ minY / TileSize }; tileY <= maxY / TileSize; ++tileY)
+			for (uint32_t tileX{ minX / TileSize }; tileX <= maxX / TileSize; ++tileX)
+				chunk.bins[tileY * m_NumTilesX + tileX].push_back(index);
+	}
+
+	uint64_t SoftwareDevice::RasterizeTile(uint32_t tileIndex)
+	{
+		const int tileX{ static_cast<int>(tileIndex % m_NumTilesX * TileSize) };
+		const int tileY{ static_cast<int>(tileIndex / m_NumTilesX * TileSize) };
+		const int tileEndX{ std::min(tileX + static_cast<int>(TileSize), static_cast<int>(m_Width)) - 1 };
+		const int tileEndY{ std::min(tileY + static_cast<int>(TileSize), static_cast<int>(m_Height)) - 1 };
+
+		for (int y{ tileY }; y <= tileEndY; ++y)
+		{
+			const size_t row{ size_t(y) * m_Width };
+			std::fill(m_ColorBuffer.begin() + row + tileX, m_ColorBuffer.begin() + row + tileEndX + 1, m_ClearColor);
+			std::fill(m_DepthBuffer.begin() + row + tileX, m_DepthBuffer.begin() + row + tileEndX + 1, 1.f);
+		}
+
+		//Pixels that passed the depth test wait here until 8 of the same draw are shaded together
+		Fragment fragments[SampleBatch::Size]{};
+		uint32_t numFragments{};
+		uint32_t fragmentDraw{ UINT32_MAX };
+		uint64_t numShaded{};
+		const auto shade = [&]()
+			{
+				if (numFragments == 0)
+					return;
+				ShadeFragments(m_Draws[fragmentDraw], fragments, numFragments);
+				numShaded += numFragments;
+				numFragments = 0;
+			};
+
+		//Chunks hold consecutive triangles, so this is submission order
+		for (uint32_t chunkIndex{}; chunkIndex < m_NumChunks; ++chunkIndex)
+		{
+			const Chunk& chunk{ m_Chunks[chunkIndex] };
+			for (uint32_t index : chunk.bins[tileIndex])
+			{
+				const Triangle& triangle{ chunk.triangles[index] };
+				if (triangle.draw != fragmentDraw)
+				{
+					shade();
+					fragmentDraw = triangle.draw;
+				}
+
+				//PartialCoverage.fx doesn't write depth, alpha tested pixels only write it once they survived the test
+				const Effect& effect{ m_Draws[triangle.draw].effect };
+				const bool isDepthWritten{ effect.type == EffectType::Shaded && (effect.features & ShaderFeature::AlphaTest) == 0 };
+
+				const int startX{ std::max(triangle.minX, tileX) };
+				const int endX{ std::min(triangle.maxX, tileEndX) };
+				for (int y{ std::max(triangle.minY, tileY) }; y <= std::min(triangle.maxY, tileEndY); ++y)
+				{
+					const int64_t centerY{ y * SubpixelSteps + SubpixelSteps / 2 };
+					const int64_t centerX{ startX * SubpixelSteps + SubpixelSteps / 2 };
+					int64_t edges[3]{};
+					for (uint32_t edge{}; edge < 3; ++edge)
+						edges[edge] = triangle.edgeA[edge] * centerX + triangle.edgeB[edge] * centerY + triangle.edgeC[edge];
+
+					for (int x{ startX }; x <= endX; ++x)
+					{
+						const bool isInside{ edges[0] + triangle.edgeBias[0] > 0 && edges[1] + triangle.edgeBias[1] > 0 && edges[2] + triangle.edgeBias[2] > 0 };
+						if (isInside)
+						{
+							Fragment& fragment{ fragments[numFragments] };
+							for (uint32_t edge{}; edge < 3; ++edge)
+								fragment.weights[edge] = static_cast<float>(edges[edge]) * triangle.inverseArea;
+							fragment.depth = Interpolate(fragment.weights, triangle.depth);
+
+							float& depth{ m_DepthBuffer[size_t(y) * m_Width + x] };
+							if (fragment.depth < depth)
+							{
+								if (isDepthWritten)
+									depth = fragment.depth;
+
+								fragment.pTriangle = &triangle;
+								fragment.x = static_cast<uint32_t>(x);
+								fragment.y = static_cast<uint32_t>(y);
+								if (++numFragments == SampleBatch::Size)
+									shade();
+							}
+						}
+
+						for (uint32_t edge{}; edge < 3; ++edge)
+							edges[edge] += triangle.edgeA[edge] * SubpixelSteps;
+					}
+				}
+			}
+		}
+		shade();
+
+		return numShaded;
+	}
+
+	void SoftwareDevice::ShadeFragments(const Draw& draw, const Fragment* pFragments, uint32_t numFragments)
+	{
+		const Effect& effect{ draw.effect };
+
+		//Interpolation: every attribute over w divided by 1 / w. The uv derivatives pick the mip level like a GPU's pixel quads do.
+		SampleBatch batch{};
+		Vector3 worldPositions[SampleBatch::Size]{};
+		Vector3 normals[SampleBatch::Size]{};
+		Vector3 tangents[SampleBatch::Size]{};
+		for (uint32_t i{}; i < numFragments; ++i)
+		{
+			const Fragment& fragment{ pFragments[i] };
+			const Triangle& triangle{ *fragment.pTriangle };
+			const float w{ 1.f / Interpolate(fragment.weights, triangle.inverseW) };
+
+			float attributes[NumAttributes]{};
+			for (uint32_t attribute{}; attribute < NumAttributes; ++attribute)
+				attributes[attribute] = Interpolate(fragment.weights, triangle.attributes[attribute]) * w;
+
+			batch.u[i] = attributes[3];
+			batch.v[i] = attributes[4];
+			const float inverseWDx{ Interpolate(triangle.weightDx, triangle.inverseW) };
+			const float inverseWDy{ Interpolate(triangle.weightDy, triangle.inverseW) };
+			batch.dudx[i] = (Interpolate(triangle.weightDx, triangle.attributes[3]) - batch.u[i] * inverseWDx) * w;
+			batch.dvdx[i] = (Interpolate(triangle.weightDx, triangle.attributes[4]) - batch.v[i] * inverseWDx) * w;
+			batch.dudy[i] = (Interpolate(triangle.weightDy, triangle.attributes[3]) - batch.u[i] * inverseWDy) * w;
+			batch.dvdy[i] = (Interpolate(triangle.weightDy, triangle.attributes[4]) - batch.v[i] * inverseWDy) * w;
+
+			worldPositions[i] = Vector3{ attributes[0], attributes[1], attributes[2] };
+			normals[i] = Vector3{ attributes[5], attributes[6], attributes[7] };
+			tangents[i] = Vector3{ attributes[8], attributes[9], attributes[10] };
+		}
+
+		const auto sample = [&](TextureSlot slot, Vector4 (&colors)[SampleBatch::Size])
+			{
+				const CpuTexture* pTexture{ effect.pTextures[static_cast<uint32_t>(slot)] };
+				if (pTexture)
+					pTexture->Sample(effect.sampler, batch, colors);
+			};
+
+		const bool isShaded{ effect.type == EffectType::Shaded };
+		const bool hasNormalMap{ isShaded && (effect.features & ShaderFeature::NormalMap) != 0 };
+		const bool hasSpecularMap{ isShaded && (effect.features & ShaderFeature::SpecularMap) != 0 };
+		const bool isAlphaTested{ isShaded && (effect.features & ShaderFeature::AlphaTest) != 0 };
+
+		Vector4 diffuse[SampleBatch::Size]{};
+		Vector4 normalMap[SampleBatch::Size]{};
+		Vector4 specularGlossiness[SampleBatch::Size]{};
+		sample(TextureSlot::Diffuse, diffuse);
+		if (hasNormalMap)
+			sample(TextureSlot::Normal, normalMap);
+		if (hasSpecularMap)
+			sample(TextureSlot::Specular, specularGlossiness);
+
+		const CpuShader::ShadePixelFunction shadePixel{ CpuShader::GetShadePixel(effect.features) };
+		for (uint32_t i{}; i < numFragments; ++i)
+		{
+			const Fragment& fragment{ pFragments[i] };
+			uint32_t& pixel{ m_ColorBuffer[size_t{ fragment.y } * m_Width + fragment.x] };
+
+			//PartialCoverage.fx: the diffuse map blended over what's there, alpha zeroed by the blend state
+			if (!isShaded)
+			{
+				const Vector4 source{ diffuse[i] };
+				const Vector4 target{ UnpackColor(pixel) };
+				const float alpha{ source.w };
+				pixel = PackColor(source.x * alpha + target.x * (1.f - alpha), source.y * alpha + target.y * (1.f - alpha),
+					source.z * alpha + target.z * (1.f - alpha), 0.f);
+				continue;
+			}
+
+			const CpuShader::PixelInput input{ worldPositions[i], normals[i], tangents[i], diffuse[i], normalMap[i], specularGlossiness[i] };
+			Vector4 color{};
+			if (!shadePixel(input, draw.frame, effect.material, color))
+				continue;
+
+			if (isAlphaTested)
+			{
+				//Pixels of the same draw in this batch may have covered it since the early test
+				float& depth{ m_DepthBuffer[size_t{ fragment.y } * m_Width + fragment.x] };
+				if (!(fragment.depth < depth))
+					continue;
+				depth = fragment.depth;
+			}
+
+			pixel = PackColor(color.x, color.y, color.z, color.w);
+		}
+	}
+
+	void SoftwareDevice::CopyToWindow()
+	{
+		if (!m_pFrameSurface)
+			return;
+
+		SDL_Surface* pWindowSurface{ SDL_GetWindowSurface(m_pWindow) };
+		if (!pWindowSurface)
+			return;
+
+		SDL_BlitSurface(m_pFrameSurface, nullptr, pWindowSurface, nullptr);
+		SDL_UpdateWindowSurface(m_pWindow);
+	}
+}
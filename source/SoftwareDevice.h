@@ -0,0 +1,242 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include "GraphicsDevice.h"
+#include "FrameRingAllocator.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	class CpuTexture;
+	class JobSystem;
+
+	//Renders on the CPU what the D3D11 device renders with PosCol3D.fx and PartialCoverage.fx, for machines without a GPU.
+	//Draws are collected while the frame is submitted and rasterized at Present:
+	//1. vertices are transformed like the vertex shaders do, in parallel over every draw's vertices
+	//2. triangles are clipped against the near plane, culled like gRasterizerState and binned into screen tiles, in parallel chunks
+	//3. tiles are rasterized in parallel: depth test, the pixel shader (CpuShader) on 8 pixels at a time with the batched sampler, blending.
+	//Each tile walks its triangles in submission order, so blending comes out as on the GPU.
+	//The frame ends up in an RGBA8 color buffer, and is copied to the window when there is one.
+	class SoftwareDevice final : public GraphicsDevice
+	{
+	public:
+		//pWindow may be null, the frame then only lives in memory.
+		//Everything runs on the render thread until a job system is set, the renderer shares its own.
+		SoftwareDevice(uint32_t width, uint32_t height, SDL_Window* pWindow = nullptr);
+		virtual ~SoftwareDevice();
+
+		// rule of 5 copypasta
+		SoftwareDevice(const SoftwareDevice& other) = delete;
+		SoftwareDevice(SoftwareDevice&& other) = delete;
+		SoftwareDevice& operator=(const SoftwareDevice& other) = delete;
+		SoftwareDevice& operator=(SoftwareDevice&& other) = delete;
+
+		virtual bool IsInitialized() const override;
+		virtual void SetJobSystem(JobSystem* pJobs) override;
+
+		virtual BufferHandle CreateVertexBuffer(const void* pVertices, uint32_t byteSize) override;
+		virtual BufferHandle CreateIndexBuffer(const uint32_t* pIndices, uint32_t numIndices) override;
+		//Block compressed levels are decoded, the texture is sampled like any CpuTexture (rows, the default layout)
+		virtual TextureHandle CreateTexture(TextureFormat format, const TextureLevel* pLevels, uint32_t numLevels) override;
+		//The file isn't read: Shaded is PosCol3D.fx with the features its defines select, Transparent is PartialCoverage.fx
+		virtual EffectHandle CreateEffect(EffectType type, const std::wstring& assetFile, const std::vector<EffectDefine>& defines) override;
+		virtual InputLayoutHandle CreateInputLayout(EffectHandle effect) override;
+		virtual SamplerHandle CreateSampler(const SamplerDesc& desc) override;
+
+		virtual uint32_t GetNumPasses(EffectHandle effect) const override;
+
+		virtual void Release(BufferHandle buffer) override;
+		virtual void Release(TextureHandle texture) override;
+		virtual void Release(EffectHandle effect) override;
+		virtual void Release(InputLayoutHandle layout) override;
+		virtual void Release(SamplerHandle sampler) override;
+
+		virtual void SetTexture(EffectHandle effect, TextureSlot slot, TextureHandle texture) override;
+		virtual void SetSampler(EffectHandle effect, SamplerHandle sampler) override;
+		virtual void SetMaterial(EffectHandle effect, const MaterialConstants& material) override;
+
+		virtual void BeginFrame(const ColorRGB& clearColor) override;
+		virtual void Submit(const CommandBuffer& buffer) override;
+		virtual void Present() override;
+
+		virtual ConstantBlock MapConstants(uint32_t size) override;
+		virtual void UnmapConstants() override;
+
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		//R, G, B, A bytes per pixel, rows top to bottom. Only read it while no frame is being rendered.
+		const std::vector<uint32_t>& GetColorBuffer() const;
+
+		//Of the last frame: triangles that reached the tiles, pixels shaded, and the time Present took
+		uint32_t GetNumTriangles() const;
+		uint64_t GetNumPixelsShaded() const;
+		float GetRasterizeMs() const;
+		//Draws that referenced missing resources or indices past their vertex buffer, and calls outside a frame
+		uint32_t GetNumErrors() const;
+		//The render thread plus the workers of the job system
+		uint32_t GetNumThreads() const;
+
+	private:
+		//Square tiles of the screen, each rasterized by one thread
+		static constexpr uint32_t TileSize{ 32 };
+		//Triangles set up and binned by one job
+		static constexpr uint32_t TrianglesPerChunk{ 1024 };
+
+		struct Buffer
+		{
+			std::vector<uint8_t> bytes{};
+		};
+
+		struct Effect
+		{
+			EffectType type{ EffectType::Shaded };
+			uint32_t features{};
+			const CpuTexture* pTextures[3]{};
+			//gSamState until a sampler is set
+			SamplerDesc sampler{};
+			MaterialConstants material{};
+		};
+
+		//An empty object, there is only one vertex layout
+		struct InputLayout
+		{
+		};
+
+		//Everything a draw reads, copied when it is submitted
+		struct Draw
+		{
+			Effect effect{};
+			const uint8_t* pVertices{ nullptr };
+			uint32_t stride{};
+			uint32_t numVertices{};
+			const uint32_t* pIndices{ nullptr };
+			uint32_t numIndices{};
+			int32_t baseVertex{};
+			FrameConstants frame{};
+			ObjectConstants object{};
+		};
+
+		//What the vertex shader outputs
+		struct ShadedVertex
+		{
+			Vector4 position{};
+			Vector3 worldPosition{};
+			Vector2 uv{};
+			Vector3 normal{};
+			Vector3 tangent{};
+		};
+
+		//World position, uv, normal and tangent
+		static constexpr uint32_t NumAttributes{ 11 };
+		//Vertex positions are snapped to 1/16 pixel, so coverage is exact and neighbouring triangles never overlap or leave gaps
+		static constexpr int64_t SubpixelSteps{ 16 };
+		//Pixels a triangle may reach past the screen's edges before it's clipped, far enough that hardly any is,
+		//close enough that its snapped corners and edge functions stay well inside 64 bits
+		static constexpr float GuardBand{ 1 << 16 };
+		//The near plane and the four guard band planes each add at most one corner to a triangle
+		static constexpr uint32_t MaxClippedCorners{ 8 };
+
+		struct Triangle
+		{
+			uint32_t draw{};
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+			//Per edge a * x + b * y + c at a pixel center in subpixels, positive inside. It is the weight of the opposite vertex
+			//times 2 * area. Pixels exactly on an edge belong to the triangle on its top or left (bias 1).
+			int64_t edgeA[3]{};
+			int64_t edgeB[3]{};
+			int64_t edgeC[3]{};
+			int64_t edgeBias[3]{};
+			float inverseArea{};
+			//How much each vertex' weight changes per pixel along x and y
+			float weightDx[3]{};
+			float weightDy[3]{};
+			//Per vertex: depth, 1 / w and the attributes divided by w, all three linear over the screen
+			float depth[3]{};
+			float inverseW[3]{};
+			float attributes[NumAttributes][3]{};
+		};
+
+		//The triangles one job set up, and per tile the ones that touch it
+		struct Chunk
+		{
+			std::vector<Triangle> triangles{};
+			std::vector<std::vector<uint32_t>> bins{};
+		};
+
+		struct Fragment
+		{
+			const Triangle* pTriangle{ nullptr };
+			uint32_t x{};
+			uint32_t y{};
+			float depth{};
+			float weights[3]{};
+		};
+
+		//On the job system when there is one, else in one go on the render thread
+		void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+		void ReplayCommands(const CommandBuffer& buffer);
+		void TransformVertices();
+		void SetUpTriangles(uint32_t chunkIndex);
+		void AddTriangle(uint32_t drawIndex, const ShadedVertex (&vertices)[3], Chunk& chunk);
+		uint64_t RasterizeTile(uint32_t tileIndex);
+		//The pixel shader for up to 8 fragments of one draw, then the depth and blend stages in their order
+		void ShadeFragments(const Draw& draw, const Fragment* pFragments, uint32_t numFragments);
+		void CopyToWindow();
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		uint32_t m_NumTilesX{};
+		uint32_t m_NumTilesY{};
+		SDL_Window* m_pWindow{ nullptr };
+		SDL_Surface* m_pFrameSurface{ nullptr };
+		JobSystem* m_pJobs{ nullptr };
+
+		std::vector<uint32_t> m_ColorBuffer{};
+		std::vector<float> m_DepthBuffer{};
+		uint32_t m_ClearColor{};
+		bool m_IsInFrame{ false };
+
+		//Bound while commands are replayed
+		struct Pipeline
+		{
+			const Buffer* pVertexBuffer{ nullptr };
+			uint32_t stride{};
+			uint32_t offset{};
+			const Buffer* pIndexBuffer{ nullptr };
+			const Effect* pEffect{ nullptr };
+			uint32_t constantOffsets[NumConstantSlots]{};
+			bool isConstantBound[NumConstantSlots]{};
+		};
+		Pipeline m_Pipeline{};
+
+		//Kept across frames so they stop allocating once warmed up
+		std::vector<Draw> m_Draws{};
+		std::vector<uint32_t> m_FirstVertices{};
+		std::vector<uint32_t> m_FirstTriangles{};
+		std::vector<ShadedVertex> m_Vertices{};
+		std::vector<Chunk> m_Chunks{};
+		uint32_t m_NumSubmittedTriangles{};
+		uint32_t m_NumChunks{};
+
+		//Constant blocks are read when their commands are submitted, so only the current frame's are in use
+		static constexpr uint32_t InitialConstantRingSize{ 64 * 1024 };
+		FrameRingAllocator m_ConstantRing{ InitialConstantRingSize, ConstantAlignment };
+		std::vector<uint8_t> m_ConstantData{};
+		bool m_IsConstantsMapped{ false };
+		uint64_t m_FrameIndex{};
+
+		std::atomic<uint32_t> m_NumErrors{};
+		std::atomic<uint32_t> m_NumLiveResources{};
+		uint32_t m_NumTriangles{};
+		uint64_t m_NumPixelsShaded{};
+		float m_RasterizeMs{};
+	};
+}
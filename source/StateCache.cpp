@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "StateCache.h"
+#include "FrameStats.h"
+
+namespace dae
+{
+	StateCache::StateCache()
+	{
+		Reset();
+	}
+
+	void StateCache::Filter(CommandBuffer& buffer, FrameStats& stats)
+	{
+		buffer.RemoveCommands([&](const Command& command)
+			{
+				if (command.type == CommandType::DrawIndexed)
+					return false;
+
+				const bool isRedundant{ IsRedundant(command) };
+				if (command.type == CommandType::SetConstants)
+				{
+					stats.uploadsIssued += uint32_t(!isRedundant);
+					stats.uploadsSkipped += uint32_t(isRedundant);
+				}
+				else
+				{
+					stats.statesIssued += uint32_t(!isRedundant);
+					stats.statesFiltered += uint32_t(isRedundant);
+				}
+				return isRedundant;
+			});
+	}
+
+	void StateCache::Reset()
+	{
+		m_IsTopologyKnown = false;
+		m_InputLayout = static_cast<InputLayoutHandle>(Unknown);
+		m_VertexBuffer = static_cast<BufferHandle>(Unknown);
+		m_IndexBuffer = static_cast<BufferHandle>(Unknown);
+		m_AppliedEffect = static_cast<EffectHandle>(Unknown);
+		for (ConstantsState& constants : m_Constants)
+			constants.isKnown = false;
+	}
+
+	bool StateCache::IsRedundant(const Command& command)
+	{
+		switch (command.type)
+		{
+		case CommandType::SetPrimitiveTopology:
+			if (m_IsTopologyKnown && command.setPrimitiveTopology.topology == m_Topology)
+				return true;
+			m_Topology = command.setPrimitiveTopology.topology;
+			m_IsTopologyKnown = true;
+			return false;
+
+		case CommandType::SetInputLayout:
+			if (command.setInputLayout.layout == m_InputLayout)
+				return true;
+			m_InputLayout = command.setInputLayout.layout;
+			return false;
+
+		case CommandType::SetVertexBuffer:
+		{
+			const Command::SetVertexBufferArgs& args{ command.setVertexBuffer };
+			if (args.buffer == m_VertexBuffer && args.stride == m_VertexStride && args.offset == m_VertexOffset)
+				return true;
+			m_VertexBuffer = args.buffer;
+			m_VertexStride = args.stride;
+			m_VertexOffset = args.offset;
+			return false;
+		}
+
+		case CommandType::SetIndexBuffer:
+			if (command.setIndexBuffer.buffer == m_IndexBuffer)
+				return true;
+			m_IndexBuffer = command.setIndexBuffer.buffer;
+			return false;
+
+		case CommandType::ApplyPass:
+		{
+			//Effect state only changes outside of command buffers, which resets the cache
+			if (command.applyPass.effect == m_AppliedEffect && command.applyPass.pass == m_AppliedPass)
+				return true;
+
+			m_AppliedEffect = command.applyPass.effect;
+			m_AppliedPass = command.applyPass.pass;
+			for (ConstantsState& constants : m_Constants)
+				constants.isKnown = false;
+			return false;
+		}
+
+		case CommandType::SetConstants:
+		{
+			const Command::SetConstantsArgs& args{ command.setConstants };
+			ConstantsState& constants{ m_Constants[static_cast<uint32_t>(args.slot)] };
+			if (constants.isKnown && args.offset == constants.offset && args.size == constants.size)
+				return true;
+			constants.offset = args.offset;
+			constants.size = args.size;
+			constants.isKnown = true;
+			return false;
+		}
+
+		case CommandType::DrawIndexed:
+			break;
+		}
+
+		return false;
+	}
+}
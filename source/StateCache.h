@@ -0,0 +1,47 @@
+#pragma once
+#include "CommandBuffer.h"
+
+namespace dae
+{
+	struct FrameStats;
+
+	//Mirrors what is bound on the device and strips commands that would bind it again.
+	//Buffers have to be filtered in the order they are submitted. Anything that changes device
+	//or effect state outside of command buffers has to call Reset.
+	class StateCache final
+	{
+	public:
+		StateCache();
+
+		//Removes redundant commands from the buffer, counts issued/filtered state and constant block binds
+		void Filter(CommandBuffer& buffer, FrameStats& stats);
+
+		//Forget everything, the next bind of every kind goes through
+		void Reset();
+
+	private:
+		struct ConstantsState
+		{
+			bool isKnown{ false };
+			uint32_t offset{};
+			uint32_t size{};
+		};
+
+		bool IsRedundant(const Command& command);
+
+		//Never a real handle, so the first bind after a Reset always differs (unbinding with Invalid included)
+		static constexpr uintptr_t Unknown{ ~uintptr_t{} };
+
+		PrimitiveTopology m_Topology{};
+		bool m_IsTopologyKnown{ false };
+		InputLayoutHandle m_InputLayout{};
+		BufferHandle m_VertexBuffer{};
+		uint32_t m_VertexStride{};
+		uint32_t m_VertexOffset{};
+		BufferHandle m_IndexBuffer{};
+		EffectHandle m_AppliedEffect{};
+		uint32_t m_AppliedPass{};
+		//Applying a pass binds the effect's own constant buffers, which drops the ring bindings
+		ConstantsState m_Constants[NumConstantSlots]{};
+	};
+}
@@ -1,67 +1,200 @@
 #include "pch.h"
 #include "Texture.h"
+#include "BlockCompression.h"
+#include "TextureCache.h"
+#include "JobSystem.h"
+#include "PixelConversion.h"
+#include "CookedTexture.h"
+
+#include <fstream>
 
 using namespace dae;
 
+namespace
+{
+	//Copies the channels source provides into the RGBA pixels, leaves the others as they are.
+	//Whatever layout the image was decoded to, it is read as RGBA; an image that fills every channel is converted straight into the pixels.
+	bool PackChannels(const SDL_Surface* pSurface, const ChannelSource& source, std::vector<uint8_t>& pixels)
+	{
+		const uint32_t width{ static_cast<uint32_t>(pSurface->w) };
+		const bool isWhole{ source.channels[0] == 0 && source.channels[1] == 1 && source.channels[2] == 2 && source.channels[3] == 3 };
+		if (isWhole)
+			return PixelConversion::ConvertToRgba(pSurface, pixels.data(), width * 4);
+
+		std::vector<uint8_t> rgba(pixels.size());
+		if (!PixelConversion::ConvertToRgba(pSurface, rgba.data(), width * 4))
+			return false;
+
+		for (size_t texel{}; texel < pixels.size(); texel += 4)
+		{
+			for (int channel{}; channel < 4; ++channel)
+			{
+				if (source.channels[channel] != ChannelSource::NoChannel)
+					pixels[texel + channel] = rgba[texel + source.channels[channel]];
+			}
+		}
+		return true;
+	}
+}
+
 Texture::~Texture()
 {
-	if (m_pResource) m_pResource->Release();
-	if (m_pSRV) m_pSRV->Release();
+	m_pDevice->Release(m_Handle);
 }
 
-Texture* dae::Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice)
+Texture* dae::Texture::LoadFromFile(const std::string& path, GraphicsDevice* pDevice, const TextureSettings& settings, JobSystem* pJobs, TextureCache* pCache)
 {
-	Texture* text{ new Texture(IMG_Load(path.c_str()), pDevice) };
+	return LoadPacked({ ChannelSource{ path } }, pDevice, settings, pJobs, pCache);
+}
+
+Texture* dae::Texture::LoadPacked(const std::vector<ChannelSource>& sources, GraphicsDevice* pDevice, const TextureSettings& settings, JobSystem* pJobs, TextureCache* pCache)
+{
+	MipChain chain{};
+	if (!LoadChain(sources, settings, chain, pJobs, pCache))
+		std::cout << "Failed to load Texture\n";
+
+	Texture* text{ new Texture(chain, pDevice) };
 	return text;
 }
 
-ID3D11ShaderResourceView* dae::Texture::GetSRV() const
+Texture* dae::Texture::LoadCooked(const std::string& path, GraphicsDevice* pDevice)
 {
-	return m_pSRV;
+	const CookedTexture cooked{ path };
+	if (!cooked.IsValid())
+		return new Texture(TextureFormat::Rgba8, {}, pDevice);
+
+	//The device copies the levels out of the mapping while it creates the texture, the file is closed right after
+	const std::vector<TextureLevel> levels(cooked.GetLevels(), cooked.GetLevels() + cooked.GetNumLevels());
+	return new Texture(cooked.GetFormat(), levels, pDevice);
 }
 
-Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
+bool dae::Texture::LoadChain(const std::vector<ChannelSource>& sources, const TextureSettings& settings, MipChain& chain, JobSystem* pJobs, TextureCache* pCache)
 {
-	DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	D3D11_TEXTURE2D_DESC desc{};
-	desc.Width = pSurface->w;
-	desc.Height = pSurface->h;
-	desc.MipLevels = 1;
-	desc.ArraySize = 1;
-	desc.Format = format;
-	desc.SampleDesc.Count = 1;
-	desc.SampleDesc.Quality = 0;
-	desc.Usage = D3D11_USAGE_DEFAULT;
-	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-	desc.CPUAccessFlags = 0;
-	desc.MiscFlags = 0;
-
-	D3D11_SUBRESOURCE_DATA initData;
-	initData.pSysMem = pSurface->pixels;
-	initData.SysMemPitch = static_cast<UINT>(pSurface->pitch);
-	initData.SysMemSlicePitch = static_cast<UINT>(pSurface->h * pSurface->pitch);
-
-	HRESULT hr = pDevice->CreateTexture2D(&desc, &initData, &m_pResource);
-
-	if (FAILED(hr))
+	chain = MipChain{};
+	if (sources.empty())
+		return false;
+
+	//Only block compressed chains are worth caching, the rest is as fast to build as to load
+	const bool isCached{ pCache && settings.format != TextureFormat::Rgba8 };
+	uint64_t key{};
+	if (isCached)
 	{
-		std::cout << "Failed to load Texture\n";
+		//Every file with the channels it fills, sizes first so two files can't hash like one
+		std::vector<uint8_t> keyData{};
+		for (const ChannelSource& source : sources)
+		{
+			std::ifstream file{ source.path, std::ios::binary };
+			const std::vector<uint8_t> fileData{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+			const uint64_t size{ fileData.size() };
+			const uint8_t* pSize{ reinterpret_cast<const uint8_t*>(&size) };
+			keyData.insert(keyData.end(), pSize, pSize + sizeof(size));
+			keyData.insert(keyData.end(), fileData.begin(), fileData.end());
+			keyData.insert(keyData.end(), std::begin(source.channels), std::end(source.channels));
+		}
+		key = TextureCache::ComputeKey(keyData.data(), keyData.size(), settings.mips, settings.format);
+
+		if (pCache->Load(key, chain))
+			return true;
 	}
 
-	D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc{};
-	SRVDesc.Format = format;
-	SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-	SRVDesc.Texture2D.MipLevels = 1;
+	//The images of a packed texture are decoded side by side, which only pays off with spare cores.
+	//Decoding is under a third of a cold load, the mips and block compression after it are the rest.
+	std::vector<SDL_Surface*> surfaces(sources.size());
+	const auto decode = [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i{ begin }; i < end; ++i)
+				surfaces[i] = IMG_Load(sources[i].path.c_str());
+		};
+	if (pJobs && sources.size() > 1)
+		pJobs->ParallelFor(static_cast<uint32_t>(sources.size()), 1, decode);
+	else
+		decode(0, static_cast<uint32_t>(sources.size()));
+
+	const uint32_t width{ surfaces[0] ? static_cast<uint32_t>(surfaces[0]->w) : 0 };
+	const uint32_t height{ surfaces[0] ? static_cast<uint32_t>(surfaces[0]->h) : 0 };
+	bool isValid{ true };
+	for (const SDL_Surface* pSurface : surfaces)
+		isValid = isValid && pSurface && static_cast<uint32_t>(pSurface->w) == width && static_cast<uint32_t>(pSurface->h) == height;
 
-	if (m_pResource != nullptr)
+	std::vector<uint8_t> pixels{};
+	if (isValid)
 	{
-		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pSRV);
+		pixels.assign(size_t{ width } * height * 4, 0);
+		for (size_t alpha{ 3 }; alpha < pixels.size(); alpha += 4)
+			pixels[alpha] = 255;
 
-		if (FAILED(hr))
-		{
-			std::cout << "Failed to load ShaderResourceView\n";
-		}
+		for (size_t i{}; isValid && i < sources.size(); ++i)
+			isValid = PackChannels(surfaces[i], sources[i], pixels);
+	}
+
+	for (SDL_Surface* pSurface : surfaces)
+		SDL_FreeSurface(pSurface);
+
+	if (!isValid)
+		return false;
+
+	//Without mips distant surfaces alias, and anisotropic filtering has nothing to pick from
+	MipChain mips{};
+	MipGenerator::Generate(pixels.data(), width, height, width * 4, settings.mips, mips, pJobs);
+
+	const bool isBlockAligned{ width % 4 == 0 && height % 4 == 0 };
+	if (settings.format == TextureFormat::Rgba8 || !isBlockAligned)
+	{
+		chain = std::move(mips);
+		return true;
 	}
 
-	SDL_FreeSurface(pSurface);
+	BlockCompression::Compress(mips, settings.format, chain, pJobs);
+	if (isCached)
+		pCache->Store(key, chain);
+
+	return true;
+}
+
+TextureHandle dae::Texture::GetHandle() const
+{
+	return m_Handle;
+}
+
+TextureFormat dae::Texture::GetFormat() const
+{
+	return m_Format;
+}
+
+uint64_t dae::Texture::GetMemorySize() const
+{
+	return m_MemorySize;
+}
+
+Texture::Texture(const MipChain& chain, GraphicsDevice* pDevice)
+	:m_pDevice{ pDevice }
+{
+	if (chain.levels.empty())
+		return;
+
+	std::vector<TextureLevel> levels(chain.levels.size());
+	for (uint32_t level{}; level < levels.size(); ++level)
+		levels[level] = chain.GetLevel(level);
+
+	m_Handle = m_pDevice->CreateTexture(chain.format, levels.data(), static_cast<uint32_t>(levels.size()));
+	if (m_Handle != TextureHandle::Invalid)
+	{
+		m_Format = chain.format;
+		m_MemorySize = chain.pixels.size();
+	}
+}
+
+Texture::Texture(TextureFormat format, const std::vector<TextureLevel>& levels, GraphicsDevice* pDevice)
+	:m_pDevice{ pDevice }
+{
+	if (levels.empty())
+		return;
+
+	m_Handle = m_pDevice->CreateTexture(format, levels.data(), static_cast<uint32_t>(levels.size()));
+	if (m_Handle != TextureHandle::Invalid)
+	{
+		m_Format = format;
+		for (const TextureLevel& level : levels)
+			m_MemorySize += uint64_t{ GetNumRows(format, level.height) } * GetRowPitch(format, level.width);
+	}
 }
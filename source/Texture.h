@@ -1,7 +1,38 @@
 #pragma once
+#include "MipChain.h"
 
 namespace dae
 {
+	class JobSystem;
+	class TextureCache;
+
+	struct TextureSettings
+	{
+		MipSettings mips{};
+		//Block compressed formats fall back to Rgba8 when the image isn't a multiple of 4 texels wide and high
+		TextureFormat format{ TextureFormat::Rgba8 };
+	};
+
+	//One image of a packed texture and the channels of the texture it fills
+	struct ChannelSource
+	{
+		static constexpr int8_t NoChannel{ -1 };
+
+		std::string path{};
+		//Per channel of the texture (RGBA), the channel of this image copied there.
+		//Channels no image fills are 0, alpha 255.
+		int8_t channels[4]{ 0, 1, 2, 3 };
+	};
+
+	//A texture of a scene: the images it's built from, how, and where its cooked file goes
+	struct TextureAsset
+	{
+		std::vector<ChannelSource> sources{};
+		TextureSettings settings{};
+		std::string cookedPath{};
+	};
+
+	//A texture on the device. No CPU copy is kept, CpuTexture samples the same chain (see LoadChain) on the CPU.
 	class Texture
 	{
 	public:
@@ -13,16 +44,35 @@ namespace dae
 		Texture& operator=(const Texture& other) = delete;
 		Texture& operator=(Texture&& other) = delete;
 
-		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice);
+		//Creates the texture with its full mip chain, generated and encoded on the job system's threads when one is given.
+		//With a cache, a chain encoded before is loaded instead and the image isn't decoded at all.
+		static Texture* LoadFromFile(const std::string& path, GraphicsDevice* pDevice, const TextureSettings& settings = {},
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr);
+		//Same, with the channels of several images of the same size merged into one texture,
+		//e.g. a specular map in RGB and a glossiness map in A, sampled once instead of twice
+		static Texture* LoadPacked(const std::vector<ChannelSource>& sources, GraphicsDevice* pDevice, const TextureSettings& settings = {},
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr);
 
-		ID3D11ShaderResourceView* GetSRV() const;
-		//ColorRGB Sample(const Vector2& uv) const;
+		//A texture written by --cook-textures, uploaded from the mapped file without decoding or copying it.
+		//The handle is invalid if the file can't be opened.
+		static Texture* LoadCooked(const std::string& path, GraphicsDevice* pDevice);
+
+		//The chain LoadPacked uploads, without a device. Returns false if an image can't be loaded or the sizes differ.
+		static bool LoadChain(const std::vector<ChannelSource>& sources, const TextureSettings& settings, MipChain& chain,
+			JobSystem* pJobs = nullptr, TextureCache* pCache = nullptr);
+
+		TextureHandle GetHandle() const;
+		TextureFormat GetFormat() const;
+		//Bytes of every mip level as uploaded, 0 if the texture failed to load
+		uint64_t GetMemorySize() const;
 
 	private:
-		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice);
+		Texture(const MipChain& chain, GraphicsDevice* pDevice);
+		Texture(TextureFormat format, const std::vector<TextureLevel>& levels, GraphicsDevice* pDevice);
 
-		ID3D11Texture2D* m_pResource{ nullptr };
-		ID3D11ShaderResourceView* m_pSRV{ nullptr };
+		GraphicsDevice* m_pDevice{ nullptr };
+		TextureHandle m_Handle{ TextureHandle::Invalid };
+		TextureFormat m_Format{ TextureFormat::Rgba8 };
+		uint64_t m_MemorySize{};
 	};
 }
-
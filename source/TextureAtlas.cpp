@@ -0,0 +1,244 @@
+#include "pch.h"
+#include "TextureAtlas.h"
+#include "BlockCompression.h"
+#include "Mesh.h"
+
+#include <cstring>
+#include <numeric>
+
+namespace dae
+{
+	namespace
+	{
+		uint32_t AlignUp(uint32_t value, uint32_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		uint32_t GetSlotSize(uint32_t size, uint32_t padding)
+		{
+			return AlignUp(size + 2 * padding, padding);
+		}
+
+		//Levels down to the one where the padding is a single texel
+		uint32_t GetNumAtlasLevels(uint32_t padding)
+		{
+			uint32_t numLevels{ 1 };
+			while ((padding >> numLevels) > 0)
+				++numLevels;
+			return numLevels;
+		}
+
+		//The image into its slot with its edge texels repeated over the padding
+		void CopyPadded(const AtlasImage& image, uint32_t x, uint32_t y, uint32_t padding, uint8_t* pPage, uint32_t pageWidth)
+		{
+			const int lastX{ static_cast<int>(image.width) - 1 };
+			const int lastY{ static_cast<int>(image.height) - 1 };
+			const int size{ static_cast<int>(padding) };
+			for (int row{ -size }; row <= lastY + size; ++row)
+			{
+				const uint8_t* pSource{ image.pPixels + size_t{ image.rowPitch } * std::clamp(row, 0, lastY) };
+				uint8_t* pTarget{ pPage + (size_t{ y + row } * pageWidth + x) * 4 };
+
+				for (int column{ -size }; column < 0; ++column)
+					std::memcpy(pTarget + column * 4, pSource, 4);
+				std::memcpy(pTarget, pSource, size_t{ image.width } * 4);
+				for (int column{ lastX + 1 }; column <= lastX + size; ++column)
+					std::memcpy(pTarget + column * 4, pSource + lastX * 4, 4);
+			}
+		}
+	}
+
+	AtlasPacker::AtlasPacker(uint32_t width, uint32_t height, uint32_t padding)
+		:m_Width{ width }
+		,m_Height{ height }
+		,m_Padding{ padding }
+		,m_Skyline{ Segment{ 0, 0, width } }
+	{
+	}
+
+	bool AtlasPacker::Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+	{
+		const uint32_t slotWidth{ GetSlotSize(width, m_Padding) };
+		const uint32_t slotHeight{ GetSlotSize(height, m_Padding) };
+
+		//Lowest top edge the slot can rest on, starting at each segment. Segments are in x order and cover the width.
+		uint32_t bestX{};
+		uint32_t bestY{ UINT32_MAX };
+		for (size_t i{}; i < m_Skyline.size() && m_Skyline[i].x + slotWidth <= m_Width; ++i)
+		{
+			uint32_t top{};
+			for (size_t j{ i }; j < m_Skyline.size() && m_Skyline[j].x < m_Skyline[i].x + slotWidth; ++j)
+				top = std::max(top, m_Skyline[j].y);
+
+			if (top + slotHeight <= m_Height && top < bestY)
+			{
+				bestX = m_Skyline[i].x;
+				bestY = top;
+			}
+		}
+
+		if (bestY == UINT32_MAX)
+			return false;
+
+		//The slot's top edge replaces the segments under it, a partly covered one keeps what sticks out
+		const uint32_t slotEnd{ bestX + slotWidth };
+		std::vector<Segment> skyline{};
+		skyline.reserve(m_Skyline.size() + 2);
+		for (const Segment& segment : m_Skyline)
+		{
+			const uint32_t segmentEnd{ segment.x + segment.width };
+			if (segmentEnd <= bestX || segment.x >= slotEnd)
+			{
+				skyline.push_back(segment);
+				continue;
+			}
+
+			if (segment.x == bestX)
+				skyline.push_back(Segment{ bestX, bestY + slotHeight, slotWidth });
+			if (segmentEnd > slotEnd)
+				skyline.push_back(Segment{ slotEnd, segment.y, segmentEnd - slotEnd });
+		}
+
+		//Neighbours at the same height become one, fewer starts to try
+		m_Skyline.clear();
+		for (const Segment& segment : skyline)
+		{
+			if (!m_Skyline.empty() && m_Skyline.back().y == segment.y)
+				m_Skyline.back().width += segment.width;
+			else
+				m_Skyline.push_back(segment);
+		}
+
+		m_UsedArea += uint64_t{ slotWidth } * slotHeight;
+		x = bestX + m_Padding;
+		y = bestY + m_Padding;
+		return true;
+	}
+
+	float AtlasPacker::GetOccupancy() const
+	{
+		return static_cast<float>(m_UsedArea) / (static_cast<float>(m_Width) * m_Height);
+	}
+
+	bool AtlasBuilder::Build(const std::vector<AtlasImage>& images, const AtlasSettings& settings, TextureAtlas& atlas, JobSystem* pJobs)
+	{
+		atlas = TextureAtlas{};
+		atlas.regions.resize(images.size());
+
+		const uint32_t padding{ settings.padding };
+		uint32_t maxSlotSize{};
+		for (const AtlasImage& image : images)
+			maxSlotSize = std::max({ maxSlotSize, GetSlotSize(image.width, padding), GetSlotSize(image.height, padding) });
+		if (maxSlotSize > settings.maxSize)
+		{
+			std::cout << "AtlasBuilder: an image doesn't fit a " << settings.maxSize << "x" << settings.maxSize << " page\n";
+			return false;
+		}
+
+		//Tallest first keeps the skyline flat
+		std::vector<uint32_t> remaining(images.size());
+		std::iota(remaining.begin(), remaining.end(), 0);
+		std::sort(remaining.begin(), remaining.end(), [&images](uint32_t a, uint32_t b)
+			{
+				return images[a].height != images[b].height ? images[a].height > images[b].height : images[a].width > images[b].width;
+			});
+
+		while (!remaining.empty())
+		{
+			uint64_t slotArea{};
+			for (uint32_t index : remaining)
+				slotArea += uint64_t{ GetSlotSize(images[index].width, padding) } * GetSlotSize(images[index].height, padding);
+
+			//The smallest page that can hold what's left, grown until it does or the maximum is reached.
+			//Pages grow wider first, so one is never more than twice as large as it needs to be.
+			uint32_t pageWidth{ 4 };
+			uint32_t pageHeight{ 4 };
+			const auto grow = [&]()
+				{
+					if (pageWidth == pageHeight)
+						pageWidth = std::min(pageWidth * 2, settings.maxSize);
+					else
+						pageHeight = std::min(pageHeight * 2, settings.maxSize);
+				};
+			while (pageHeight < maxSlotSize || uint64_t{ pageWidth } * pageHeight < slotArea)
+			{
+				if (pageHeight == settings.maxSize)
+					break;
+				grow();
+			}
+
+			std::vector<uint32_t> placed{};
+			std::vector<uint32_t> left{};
+			for (;;)
+			{
+				placed.clear();
+				left.clear();
+
+				AtlasPacker packer{ pageWidth, pageHeight, padding };
+				const uint32_t page{ static_cast<uint32_t>(atlas.pages.size()) };
+				for (uint32_t index : remaining)
+				{
+					AtlasRegion& region{ atlas.regions[index] };
+					if (packer.Insert(images[index].width, images[index].height, region.x, region.y))
+					{
+						region.page = page;
+						region.width = images[index].width;
+						region.height = images[index].height;
+						placed.push_back(index);
+					}
+					else
+						left.push_back(index);
+				}
+
+				if (left.empty() || pageHeight == settings.maxSize)
+					break;
+				grow();
+			}
+
+			//Every level the padding keeps apart, then compressed like any other texture
+			std::vector<uint8_t> pixels(size_t{ pageWidth } * pageHeight * 4);
+			for (uint32_t index : placed)
+			{
+				AtlasRegion& region{ atlas.regions[index] };
+				CopyPadded(images[index], region.x, region.y, padding, pixels.data(), pageWidth);
+
+				region.uvOffset = Vector2{ static_cast<float>(region.x) / pageWidth, static_cast<float>(region.y) / pageHeight };
+				region.uvScale = Vector2{ static_cast<float>(region.width) / pageWidth, static_cast<float>(region.height) / pageHeight };
+			}
+
+			MipChain mips{};
+			MipGenerator::Generate(pixels.data(), pageWidth, pageHeight, pageWidth * 4, settings.texture.mips, mips, pJobs);
+			const uint32_t numLevels{ std::min(GetNumAtlasLevels(padding), static_cast<uint32_t>(mips.levels.size())) };
+			if (numLevels < mips.levels.size())
+			{
+				mips.pixels.resize(mips.levels[numLevels].offset);
+				mips.levels.resize(numLevels);
+			}
+
+			MipChain& chain{ atlas.pages.emplace_back() };
+			if (settings.texture.format == TextureFormat::Rgba8)
+				chain = std::move(mips);
+			else
+				BlockCompression::Compress(mips, settings.texture.format, chain, pJobs);
+
+			remaining = std::move(left);
+		}
+
+		return true;
+	}
+
+	bool AtlasBuilder::CanRemap(const std::vector<Vertex>& vertices)
+	{
+		return std::all_of(vertices.begin(), vertices.end(), [](const Vertex& vertex)
+			{
+				return vertex.uv.x >= 0.f && vertex.uv.x <= 1.f && vertex.uv.y >= 0.f && vertex.uv.y <= 1.f;
+			});
+	}
+
+	void AtlasBuilder::RemapUvs(std::vector<Vertex>& vertices, const AtlasRegion& region)
+	{
+		for (Vertex& vertex : vertices)
+			vertex.uv = Vector2{ region.uvOffset.x + vertex.uv.x * region.uvScale.x, region.uvOffset.y + vertex.uv.y * region.uvScale.y };
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "Texture.h"
+
+namespace dae
+{
+	class JobSystem;
+	struct Vertex;
+
+	//Skyline bottom-left packer: the packed area is kept as the height of its top edge along x,
+	//every rectangle goes where it ends up lowest, then leftmost.
+	//Rectangles are placed in slots padding texels larger on every side, slots start on multiples of padding.
+	class AtlasPacker final
+	{
+	public:
+		//padding has to be a power of two
+		AtlasPacker(uint32_t width, uint32_t height, uint32_t padding);
+		~AtlasPacker() = default;
+
+		// rule of 5 copypasta
+		AtlasPacker(const AtlasPacker& other) = delete;
+		AtlasPacker(AtlasPacker&& other) = delete;
+		AtlasPacker& operator=(const AtlasPacker& other) = delete;
+		AtlasPacker& operator=(AtlasPacker&& other) = delete;
+
+		//x and y are where the rectangle itself starts, inside its padding. Returns false if its slot doesn't fit.
+		bool Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+		//Slot area used, 0 to 1
+		float GetOccupancy() const;
+
+	private:
+		struct Segment
+		{
+			uint32_t x{};
+			uint32_t y{};
+			uint32_t width{};
+		};
+
+		uint32_t m_Width{};
+		uint32_t m_Height{};
+		uint32_t m_Padding{};
+		std::vector<Segment> m_Skyline{};
+		uint64_t m_UsedArea{};
+	};
+
+	//RGBA8 texels, rowPitch bytes apart
+	struct AtlasImage
+	{
+		const uint8_t* pPixels{ nullptr };
+		uint32_t width{};
+		uint32_t height{};
+		uint32_t rowPitch{};
+	};
+
+	//Where an image ended up. A UV inside the image maps to uvOffset + uv * uvScale on its page.
+	struct AtlasRegion
+	{
+		uint32_t page{};
+		uint32_t x{};
+		uint32_t y{};
+		uint32_t width{};
+		uint32_t height{};
+		Vector2 uvOffset{};
+		Vector2 uvScale{};
+	};
+
+	struct AtlasSettings
+	{
+		//Texels around every image, its edge repeated. Power of two, the mip chain stops at the level where it's 1 texel,
+		//so no level samples a neighbour. With a block compressed format it has to be at least 4.
+		uint32_t padding{ 8 };
+		//Pages are powers of two no larger than this a side, images that don't fit one page go to the next
+		uint32_t maxSize{ 2048 };
+		//Box keeps the regions apart exactly, wider filters can reach past the padding
+		TextureSettings texture{ { MipFilter::Box, MipContent::Srgb }, TextureFormat::Bc1 };
+	};
+
+	struct TextureAtlas
+	{
+		std::vector<MipChain> pages{};
+		//One per image, in the order they were given
+		std::vector<AtlasRegion> regions{};
+	};
+
+	//Cook time: many small textures become a few pages, the meshes that use them get their UVs moved into their region.
+	//Meshes whose textures share a page can then be merged into one draw with one texture bound.
+	namespace AtlasBuilder
+	{
+		//Larger images first, each page as small as what's left needs. Returns false if an image doesn't fit an empty page.
+		bool Build(const std::vector<AtlasImage>& images, const AtlasSettings& settings, TextureAtlas& atlas, JobSystem* pJobs = nullptr);
+
+		//Only UVs inside [0, 1] can be moved into a region, a mesh that tiles its texture has to keep it
+		bool CanRemap(const std::vector<Vertex>& vertices);
+		void RemapUvs(std::vector<Vertex>& vertices, const AtlasRegion& region);
+	}
+}
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "TextureCache.h"
+
+namespace dae
+{
+	namespace
+	{
+		//Bump when the entry layout, the mip generator or an encoder changes, old entries then simply miss
+		constexpr uint32_t FormatVersion{ 1 };
+		constexpr uint32_t Magic{ 0x43584554 }; //"TEXC"
+
+		struct EntryHeader
+		{
+			uint32_t magic{};
+			uint32_t version{};
+			uint64_t key{};
+			uint32_t format{};
+			uint32_t numLevels{};
+			uint64_t size{};
+			uint64_t checksum{};
+		};
+
+		struct EntryLevel
+		{
+			uint32_t width{};
+			uint32_t height{};
+		};
+	}
+
+	TextureCache::TextureCache(const std::filesystem::path& directory)
+		:m_Entries{ directory, ".tex" }
+	{
+	}
+
+	uint64_t TextureCache::ComputeKey(const void* pSourceData, size_t size, const MipSettings& mipSettings, TextureFormat format)
+	{
+		uint64_t hash{ HashSeed };
+		hash = Hash(hash, &FormatVersion, sizeof(FormatVersion));
+		hash = Hash(hash, &mipSettings.filter, sizeof(mipSettings.filter));
+		hash = Hash(hash, &mipSettings.content, sizeof(mipSettings.content));
+		hash = Hash(hash, &format, sizeof(format));
+		return Hash(hash, pSourceData, size);
+	}
+
+	bool TextureCache::Load(uint64_t key, MipChain& chain)
+	{
+		std::ifstream file{ m_Entries.Open(key) };
+
+		EntryHeader header{};
+		const bool isHeaderValid{ file && file.read(reinterpret_cast<char*>(&header), sizeof(header))
+			&& header.magic == Magic && header.version == FormatVersion && header.key == key
+			&& header.format <= static_cast<uint32_t>(TextureFormat::Bc7) && header.numLevels > 0 && header.numLevels <= 32 };
+
+		if (isHeaderValid)
+		{
+			std::vector<EntryLevel> levels(header.numLevels);
+			const size_t levelsSize{ levels.size() * sizeof(EntryLevel) };
+			if (file.read(reinterpret_cast<char*>(levels.data()), levelsSize))
+			{
+				chain.format = static_cast<TextureFormat>(header.format);
+				chain.levels.resize(levels.size());
+
+				//The sizes have to add up to the pixels that follow, offsets aren't stored
+				size_t size{};
+				for (size_t level{}; level < levels.size(); ++level)
+				{
+					chain.levels[level] = MipChain::Level{ levels[level].width, levels[level].height, size };
+					size += size_t{ GetNumRows(chain.format, levels[level].height) } * GetRowPitch(chain.format, levels[level].width);
+				}
+
+				if (size == header.size)
+				{
+					chain.pixels.resize(size);
+					if (file.read(reinterpret_cast<char*>(chain.pixels.data()), chain.pixels.size())
+						&& Hash(Hash(HashSeed, levels.data(), levelsSize), chain.pixels.data(), chain.pixels.size()) == header.checksum)
+						return m_Entries.CountLoad(true);
+				}
+			}
+		}
+
+		chain = MipChain{};
+		return m_Entries.CountLoad(false);
+	}
+
+	bool TextureCache::Store(uint64_t key, const MipChain& chain)
+	{
+		std::vector<EntryLevel> levels(chain.levels.size());
+		for (size_t level{}; level < levels.size(); ++level)
+			levels[level] = EntryLevel{ chain.levels[level].width, chain.levels[level].height };
+
+		const size_t levelsSize{ levels.size() * sizeof(EntryLevel) };
+		const EntryHeader header{ Magic, FormatVersion, key, static_cast<uint32_t>(chain.format), static_cast<uint32_t>(levels.size()),
+			chain.pixels.size(), Hash(Hash(HashSeed, levels.data(), levelsSize), chain.pixels.data(), chain.pixels.size()) };
+
+		return m_Entries.Write(key, { { &header, sizeof(header) }, { levels.data(), levelsSize }, { chain.pixels.data(), chain.pixels.size() } });
+	}
+
+	uint32_t TextureCache::GetNumHits() const
+	{
+		return m_Entries.GetNumHits();
+	}
+
+	uint32_t TextureCache::GetNumMisses() const
+	{
+		return m_Entries.GetNumMisses();
+	}
+
+	const std::filesystem::path& TextureCache::GetDirectory() const
+	{
+		return m_Entries.GetDirectory();
+	}
+}
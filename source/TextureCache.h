@@ -0,0 +1,37 @@
+#pragma once
+#include <filesystem>
+#include "DiskCache.h"
+#include "MipChain.h"
+
+namespace dae
+{
+	//Finished mip chains on disk, one file per key, so a compressed texture is only encoded once.
+	//The key covers the image file and everything that changes the encoder output,
+	//an edited image or different settings simply miss and encode again. Safe to use from several threads.
+	class TextureCache final
+	{
+	public:
+		explicit TextureCache(const std::filesystem::path& directory);
+		~TextureCache() = default;
+
+		// rule of 5 copypasta
+		TextureCache(const TextureCache& other) = delete;
+		TextureCache(TextureCache&& other) = delete;
+		TextureCache& operator=(const TextureCache& other) = delete;
+		TextureCache& operator=(TextureCache&& other) = delete;
+
+		//Hashes the image files as stored (with how their channels are packed), not the decoded pixels, so a hit doesn't decode them
+		static uint64_t ComputeKey(const void* pSourceData, size_t size, const MipSettings& mipSettings, TextureFormat format);
+
+		//Returns false on a miss, or when the entry is truncated or corrupt
+		bool Load(uint64_t key, MipChain& chain);
+		bool Store(uint64_t key, const MipChain& chain);
+
+		uint32_t GetNumHits() const;
+		uint32_t GetNumMisses() const;
+		const std::filesystem::path& GetDirectory() const;
+
+	private:
+		DiskCache m_Entries;
+	};
+}
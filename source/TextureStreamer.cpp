@@ -0,0 +1,389 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "CookedTexture.h"
+
+#include <cmath>
+
+namespace dae
+{
+	TextureStreamer::TextureStreamer(GraphicsDevice* pDevice, JobSystem* pJobs, const StreamingSettings& settings)
+		:m_pDevice{ pDevice }
+		,m_pJobs{ pJobs }
+		,m_Settings{ settings }
+	{
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		WaitForLoads();
+
+		for (const CompletedLoad& load : m_CompletedLoads)
+			m_pDevice->Release(load.handle);
+		for (const RetiredTexture& retired : m_RetiredTextures)
+			m_pDevice->Release(retired.handle);
+
+		for (Entry* pEntry : m_Entries)
+		{
+			m_pDevice->Release(pEntry->handle);
+			delete pEntry->pCooked;
+			delete pEntry;
+		}
+	}
+
+	StreamedTextureId TextureStreamer::Add(const TextureAsset& asset, TextureCache* pCache)
+	{
+		std::string key{ asset.cookedPath };
+		for (const ChannelSource& source : asset.sources)
+			key += "|" + source.path;
+
+		{
+			std::lock_guard lock{ m_EntriesMutex };
+			for (StreamedTextureId id{}; id < m_Entries.size(); ++id)
+			{
+				if (m_Entries[id]->key == key)
+					return id;
+			}
+		}
+
+		Entry* pEntry{ new Entry{} };
+		pEntry->key = std::move(key);
+
+		if (!asset.cookedPath.empty() && CookedTexture::IsUpToDate(asset.cookedPath, asset.sources))
+		{
+			pEntry->pCooked = new CookedTexture{ asset.cookedPath };
+			if (pEntry->pCooked->IsValid())
+			{
+				pEntry->format = pEntry->pCooked->GetFormat();
+				pEntry->levels.assign(pEntry->pCooked->GetLevels(), pEntry->pCooked->GetLevels() + pEntry->pCooked->GetNumLevels());
+			}
+			else
+			{
+				delete pEntry->pCooked;
+				pEntry->pCooked = nullptr;
+			}
+		}
+
+		if (!pEntry->pCooked)
+		{
+			if (!Texture::LoadChain(asset.sources, asset.settings, pEntry->chain, m_pJobs, pCache))
+			{
+				std::cout << "Failed to load streamed texture " << pEntry->key << "\n";
+				delete pEntry;
+				return InvalidStreamedTextureId;
+			}
+
+			pEntry->format = pEntry->chain.format;
+			for (uint32_t level{}; level < pEntry->chain.levels.size(); ++level)
+				pEntry->levels.push_back(pEntry->chain.GetLevel(level));
+		}
+
+		return AddEntry(pEntry);
+	}
+
+	StreamedTextureId TextureStreamer::Add(MipChain&& chain)
+	{
+		if (chain.levels.empty())
+			return InvalidStreamedTextureId;
+
+		Entry* pEntry{ new Entry{} };
+		pEntry->chain = std::move(chain);
+		pEntry->format = pEntry->chain.format;
+		for (uint32_t level{}; level < pEntry->chain.levels.size(); ++level)
+			pEntry->levels.push_back(pEntry->chain.GetLevel(level));
+
+		return AddEntry(pEntry);
+	}
+
+	void TextureStreamer::Request(StreamedTextureId id, float mipLevel)
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		if (id >= m_Entries.size())
+			return;
+
+		Entry& entry{ *m_Entries[id] };
+		entry.requestedLevel = std::min(entry.requestedLevel, mipLevel);
+		entry.isRequested = true;
+	}
+
+	void TextureStreamer::Update(uint64_t frameIndex, std::vector<TextureSwap>& swaps)
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		m_FrameIndex = frameIndex;
+
+		//Finished loads replace what was resident, the old texture lives on until no frame in flight can use it
+		std::vector<CompletedLoad> completedLoads{};
+		{
+			std::lock_guard completedLock{ m_CompletedMutex };
+			completedLoads.swap(m_CompletedLoads);
+		}
+
+		for (const CompletedLoad& load : completedLoads)
+		{
+			Entry& entry{ *m_Entries[load.id] };
+			swaps.push_back(TextureSwap{ load.id, entry.handle, load.handle });
+			m_RetiredTextures.push_back(RetiredTexture{ entry.handle, frameIndex });
+
+			entry.handle = load.handle;
+			entry.residentLevel = load.level;
+			entry.isLoading = false;
+			--m_NumLoadsInFlight;
+		}
+
+		std::erase_if(m_RetiredTextures, [this, frameIndex](const RetiredTexture& retired)
+			{
+				if (retired.frameIndex + RetireLatency > frameIndex)
+					return false;
+
+				m_pDevice->Release(retired.handle);
+				return true;
+			});
+
+		//What every texture needs this frame, textures nobody asked for only need their tail
+		const uint32_t numEntries{ static_cast<uint32_t>(m_Entries.size()) };
+		std::vector<uint32_t> neededLevels(numEntries);
+		for (StreamedTextureId id{}; id < numEntries; ++id)
+		{
+			Entry& entry{ *m_Entries[id] };
+			neededLevels[id] = entry.tailLevel;
+			if (entry.isRequested)
+			{
+				const float level{ std::floor(entry.requestedLevel + m_Settings.mipBias) };
+				neededLevels[id] = GetLoadableLevel(entry, level <= 0.f ? 0 : std::min(static_cast<uint32_t>(level), entry.tailLevel));
+				entry.lastRequestFrame = frameIndex;
+			}
+
+			entry.requestedLevel = FLT_MAX;
+			entry.isRequested = false;
+		}
+
+		//Textures holding more than they still need, least recently requested first
+		std::vector<StreamedTextureId> victims{};
+		uint64_t numFreeableBytes{};
+		for (StreamedTextureId id{}; id < numEntries; ++id)
+		{
+			const Entry& entry{ *m_Entries[id] };
+			if (!entry.isLoading && neededLevels[id] > entry.targetLevel)
+			{
+				victims.push_back(id);
+				numFreeableBytes += entry.bytesFrom[entry.targetLevel] - entry.bytesFrom[neededLevels[id]];
+			}
+		}
+		std::sort(victims.begin(), victims.end(), [this](StreamedTextureId a, StreamedTextureId b)
+			{
+				return m_Entries[a]->lastRequestFrame != m_Entries[b]->lastRequestFrame
+					? m_Entries[a]->lastRequestFrame < m_Entries[b]->lastRequestFrame : a < b;
+			});
+
+		size_t nextVictim{};
+		const auto evict = [&](uint64_t numBytes)
+			{
+				while (m_TargetBytes + numBytes > m_Settings.budgetBytes && nextVictim < victims.size())
+				{
+					const StreamedTextureId id{ victims[nextVictim++] };
+					Entry& entry{ *m_Entries[id] };
+					const uint64_t numFreedBytes{ entry.bytesFrom[entry.targetLevel] - entry.bytesFrom[neededLevels[id]] };
+					m_TargetBytes -= numFreedBytes;
+					numFreeableBytes -= numFreedBytes;
+					entry.targetLevel = neededLevels[id];
+					StartLoad(id, entry.targetLevel, true);
+				}
+			};
+
+		//A lowered budget is met as soon as possible, whatever was requested
+		evict(0);
+
+		//Upgrades, the ones missing the most levels first
+		std::vector<StreamedTextureId> upgrades{};
+		for (StreamedTextureId id{}; id < numEntries; ++id)
+		{
+			if (!m_Entries[id]->isLoading && neededLevels[id] < m_Entries[id]->targetLevel)
+				upgrades.push_back(id);
+		}
+		std::sort(upgrades.begin(), upgrades.end(), [&](StreamedTextureId a, StreamedTextureId b)
+			{
+				const uint32_t missingA{ m_Entries[a]->targetLevel - neededLevels[a] };
+				const uint32_t missingB{ m_Entries[b]->targetLevel - neededLevels[b] };
+				return missingA != missingB ? missingA > missingB : a < b;
+			});
+
+		for (StreamedTextureId id : upgrades)
+		{
+			if (m_NumLoadsInFlight >= m_Settings.maxLoadsInFlight)
+				break;
+
+			//The finest level that fits, even if that's not all the way to what's needed.
+			//Nothing is evicted for an upgrade that can't fit anyway.
+			Entry& entry{ *m_Entries[id] };
+			for (uint32_t level{ neededLevels[id] }; level < entry.targetLevel; ++level)
+			{
+				const uint64_t numNeededBytes{ entry.bytesFrom[level] - entry.bytesFrom[entry.targetLevel] };
+				if (GetLoadableLevel(entry, level) != level || m_TargetBytes + numNeededBytes > m_Settings.budgetBytes + numFreeableBytes)
+					continue;
+
+				evict(numNeededBytes);
+				m_TargetBytes += numNeededBytes;
+				entry.targetLevel = level;
+				StartLoad(id, level, false);
+				break;
+			}
+		}
+	}
+
+	void TextureStreamer::WaitForLoads()
+	{
+		m_pJobs->Wait(m_LoadCounter);
+	}
+
+	void TextureStreamer::SetBudget(uint64_t budgetBytes)
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		m_Settings.budgetBytes = budgetBytes;
+	}
+
+	float TextureStreamer::ComputeMipLevel(float distance, float worldUnitsPerUv, uint32_t textureSize, float tanHalfFov, float screenHeight)
+	{
+		//Texels and pixels per world unit at that distance, every halving of their ratio is one level down
+		const float texelsPerUnit{ static_cast<float>(textureSize) / worldUnitsPerUv };
+		const float pixelsPerUnit{ screenHeight / (2.f * std::max(distance, 0.0001f) * tanHalfFov) };
+		return std::log2(texelsPerUnit / pixelsPerUnit);
+	}
+
+	TextureHandle TextureStreamer::GetHandle(StreamedTextureId id) const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return id < m_Entries.size() ? m_Entries[id]->handle : TextureHandle::Invalid;
+	}
+
+	uint32_t TextureStreamer::GetSize(StreamedTextureId id) const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return id < m_Entries.size() ? std::max(m_Entries[id]->levels[0].width, m_Entries[id]->levels[0].height) : 0;
+	}
+
+	uint32_t TextureStreamer::GetResidentLevel(StreamedTextureId id) const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return id < m_Entries.size() ? m_Entries[id]->residentLevel : 0;
+	}
+
+	uint32_t TextureStreamer::GetTargetLevel(StreamedTextureId id) const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return id < m_Entries.size() ? m_Entries[id]->targetLevel : 0;
+	}
+
+	uint32_t TextureStreamer::GetTailLevel(StreamedTextureId id) const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return id < m_Entries.size() ? m_Entries[id]->tailLevel : 0;
+	}
+
+	uint32_t TextureStreamer::GetNumTextures() const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return static_cast<uint32_t>(m_Entries.size());
+	}
+
+	uint64_t TextureStreamer::GetResidentBytes() const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		uint64_t numBytes{};
+		for (const Entry* pEntry : m_Entries)
+			numBytes += pEntry->bytesFrom[pEntry->residentLevel];
+		return numBytes;
+	}
+
+	uint64_t TextureStreamer::GetTargetBytes() const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return m_TargetBytes;
+	}
+
+	uint32_t TextureStreamer::GetNumLoads() const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return m_NumLoads;
+	}
+
+	uint32_t TextureStreamer::GetNumEvictions() const
+	{
+		std::lock_guard lock{ m_EntriesMutex };
+		return m_NumEvictions;
+	}
+
+	StreamedTextureId TextureStreamer::AddEntry(Entry* pEntry)
+	{
+		const uint32_t numLevels{ static_cast<uint32_t>(pEntry->levels.size()) };
+		pEntry->bytesFrom.resize(numLevels + 1);
+		for (uint32_t level{ numLevels }; level-- > 0;)
+		{
+			const TextureLevel& mip{ pEntry->levels[level] };
+			pEntry->bytesFrom[level] = pEntry->bytesFrom[level + 1] + uint64_t{ GetNumRows(pEntry->format, mip.height) } * mip.rowPitch;
+		}
+
+		uint32_t tailLevel{};
+		while (tailLevel + 1 < numLevels && std::max(pEntry->levels[tailLevel].width, pEntry->levels[tailLevel].height) > m_Settings.tailSize)
+			++tailLevel;
+		pEntry->tailLevel = GetLoadableLevel(*pEntry, tailLevel);
+		pEntry->residentLevel = pEntry->tailLevel;
+		pEntry->targetLevel = pEntry->tailLevel;
+
+		//The tail is there from the start, only the finer levels stream
+		pEntry->handle = CreateTexture(*pEntry, pEntry->tailLevel);
+
+		std::lock_guard lock{ m_EntriesMutex };
+		for (StreamedTextureId id{}; !pEntry->key.empty() && id < m_Entries.size(); ++id)
+		{
+			//Another thread added the same asset in the meantime
+			if (m_Entries[id]->key == pEntry->key)
+			{
+				m_pDevice->Release(pEntry->handle);
+				delete pEntry->pCooked;
+				delete pEntry;
+				return id;
+			}
+		}
+
+		m_TargetBytes += pEntry->bytesFrom[pEntry->tailLevel];
+		m_Entries.push_back(pEntry);
+		return static_cast<StreamedTextureId>(m_Entries.size() - 1);
+	}
+
+	uint32_t TextureStreamer::GetLoadableLevel(const Entry& entry, uint32_t level) const
+	{
+		if (GetBlockSize(entry.format) == 0)
+			return level;
+
+		while (level > 0 && (entry.levels[level].width % 4 != 0 || entry.levels[level].height % 4 != 0))
+			--level;
+		return level;
+	}
+
+	void TextureStreamer::StartLoad(StreamedTextureId id, uint32_t level, bool isEviction)
+	{
+		Entry* pEntry{ m_Entries[id] };
+		pEntry->isLoading = true;
+		++m_NumLoadsInFlight;
+		++(isEviction ? m_NumEvictions : m_NumLoads);
+
+		//The entry's levels never change, the job only reads them
+		const auto load = [this, pEntry, id, level]()
+			{
+				const TextureHandle handle{ CreateTexture(*pEntry, level) };
+
+				std::lock_guard lock{ m_CompletedMutex };
+				m_CompletedLoads.push_back(CompletedLoad{ id, level, handle });
+			};
+
+		//Without workers nothing would run the job until someone waits, the next Update swaps it in either way
+		if (m_pJobs->GetNumThreads() > 1)
+			m_pJobs->Run(load, &m_LoadCounter);
+		else
+			load();
+	}
+
+	TextureHandle TextureStreamer::CreateTexture(const Entry& entry, uint32_t level) const
+	{
+		return m_pDevice->CreateTexture(entry.format, entry.levels.data() + level, static_cast<uint32_t>(entry.levels.size()) - level);
+	}
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <cfloat>
+#include <mutex>
+#include "GraphicsDevice.h"
+#include "JobSystem.h"
+#include "Texture.h"
+
+namespace dae
+{
+	class CookedTexture;
+	class TextureCache;
+
+	using StreamedTextureId = uint32_t;
+	constexpr StreamedTextureId InvalidStreamedTextureId{ UINT32_MAX };
+
+	struct StreamingSettings
+	{
+		//Video memory every streamed texture together may settle at, tails included
+		uint64_t budgetBytes{ 64ull * 1024 * 1024 };
+		//Levels no larger than this (largest side) are always resident, a texture never drops below them
+		uint32_t tailSize{ 64 };
+		//Upgrades that can be loading at once, the others wait for a later frame
+		uint32_t maxLoadsInFlight{ 4 };
+		//Added to every requested level, positive trades sharpness for memory
+		float mipBias{ 0.f };
+	};
+
+	//A resident texture was replaced, everything bound to previous has to be bound to current.
+	//previous stays alive until the frames that may still use it are done.
+	struct TextureSwap
+	{
+		StreamedTextureId id{ InvalidStreamedTextureId };
+		TextureHandle previous{ TextureHandle::Invalid };
+		TextureHandle current{ TextureHandle::Invalid };
+	};
+
+	//Keeps every texture's full mip chain on the CPU side (a mapped cooked file, or a chain in memory)
+	//and only the levels the frame needs on the device. Textures start with their tail resident.
+	//Each frame the update thread requests the level every visible use needs, then Update decides:
+	//upgrades are created on the job system, and when they don't fit the budget the least recently requested
+	//textures are moved back down to what they still need (their tail, if nothing requested them this frame).
+	//The budget holds for what the textures settle at; while a texture is being replaced both copies exist.
+	//Everything but the device objects is plain bookkeeping, so it runs on the null device as is.
+	class TextureStreamer final
+	{
+	public:
+		TextureStreamer(GraphicsDevice* pDevice, JobSystem* pJobs, const StreamingSettings& settings = {});
+		//Waits for the loads in flight and releases every texture it created
+		~TextureStreamer();
+
+		// rule of 5 copypasta
+		TextureStreamer(const TextureStreamer& other) = delete;
+		TextureStreamer(TextureStreamer&& other) = delete;
+		TextureStreamer& operator=(const TextureStreamer& other) = delete;
+		TextureStreamer& operator=(TextureStreamer&& other) = delete;
+
+		//Any thread. The cooked file when it's up to date, otherwise the chain built from the images (through the cache).
+		//The same asset added twice is one texture. Invalid if neither can be loaded.
+		StreamedTextureId Add(const TextureAsset& asset, TextureCache* pCache = nullptr);
+		StreamedTextureId Add(MipChain&& chain);
+
+		//Update thread: the finest level one use of the texture needs this frame, the finest request wins
+		void Request(StreamedTextureId id, float mipLevel);
+		//Update thread, once per frame after the requests: hands out the textures replaced since the last call,
+		//releases the ones replaced long enough ago and starts the loads the requests ask for
+		void Update(uint64_t frameIndex, std::vector<TextureSwap>& swaps);
+		//Blocks until every load started so far finished, its swap comes out of the next Update
+		void WaitForLoads();
+
+		//A lower budget moves the least recently requested textures down at the next Update
+		void SetBudget(uint64_t budgetBytes);
+
+		//The level a use needs: textureSize texels across 1 UV, worldUnitsPerUv world units across 1 UV,
+		//seen from distance with a vertical field of view of 2 * atan(tanHalfFov) on a screen screenHeight pixels high
+		static float ComputeMipLevel(float distance, float worldUnitsPerUv, uint32_t textureSize, float tanHalfFov, float screenHeight);
+
+		TextureHandle GetHandle(StreamedTextureId id) const;
+		//Largest side of level 0
+		uint32_t GetSize(StreamedTextureId id) const;
+		//Finest level on the device
+		uint32_t GetResidentLevel(StreamedTextureId id) const;
+		//Finest level it is or will be at once its load finished
+		uint32_t GetTargetLevel(StreamedTextureId id) const;
+		uint32_t GetTailLevel(StreamedTextureId id) const;
+		uint32_t GetNumTextures() const;
+
+		//Bytes of the textures on the device now, and of what they will settle at
+		uint64_t GetResidentBytes() const;
+		uint64_t GetTargetBytes() const;
+		uint32_t GetNumLoads() const;
+		uint32_t GetNumEvictions() const;
+
+	private:
+		struct Entry
+		{
+			std::string key{};
+			//One of the two holds the levels
+			CookedTexture* pCooked{ nullptr };
+			MipChain chain{};
+			TextureFormat format{ TextureFormat::Rgba8 };
+			std::vector<TextureLevel> levels{};
+			//Bytes of every level from this one down, so a resident range costs one lookup
+			std::vector<uint64_t> bytesFrom{};
+
+			TextureHandle handle{ TextureHandle::Invalid };
+			uint32_t residentLevel{};
+			uint32_t targetLevel{};
+			uint32_t tailLevel{};
+			bool isLoading{ false };
+
+			float requestedLevel{ FLT_MAX };
+			uint64_t lastRequestFrame{};
+			bool isRequested{ false };
+		};
+
+		struct CompletedLoad
+		{
+			StreamedTextureId id{};
+			uint32_t level{};
+			TextureHandle handle{ TextureHandle::Invalid };
+		};
+
+		struct RetiredTexture
+		{
+			TextureHandle handle{ TextureHandle::Invalid };
+			uint64_t frameIndex{};
+		};
+
+		//Frames a replaced texture stays alive: the packet it was swapped in with, and the one rendered before it
+		static constexpr uint64_t RetireLatency{ 2 };
+
+		StreamedTextureId AddEntry(Entry* pEntry);
+		//Finest level the entry may start at: the device wants block compressed levels a whole number of blocks large
+		uint32_t GetLoadableLevel(const Entry& entry, uint32_t level) const;
+		void StartLoad(StreamedTextureId id, uint32_t level, bool isEviction);
+		TextureHandle CreateTexture(const Entry& entry, uint32_t level) const;
+
+		GraphicsDevice* m_pDevice{ nullptr };
+		JobSystem* m_pJobs{ nullptr };
+		StreamingSettings m_Settings{};
+
+		//Entries never move once added, loads read them from the workers
+		mutable std::mutex m_EntriesMutex{};
+		std::vector<Entry*> m_Entries{};
+
+		std::mutex m_CompletedMutex{};
+		std::vector<CompletedLoad> m_CompletedLoads{};
+		JobCounter m_LoadCounter{};
+		uint32_t m_NumLoadsInFlight{};
+
+		std::vector<RetiredTexture> m_RetiredTextures{};
+		uint64_t m_FrameIndex{};
+		uint64_t m_TargetBytes{};
+		uint32_t m_NumLoads{};
+		uint32_t m_NumEvictions{};
+	};
+}
@@ -0,0 +1,328 @@
+#include "pch.h"
+#include "TransformSystem.h"
+
+#include "JobSystem.h"
+
+#include <cassert>
+#include <emmintrin.h>
+
+namespace dae
+{
+	namespace
+	{
+		//Objects per parallel task, a multiple of the SIMD width
+		constexpr uint32_t g_BatchSize{ 1024 };
+
+		__m128 Select(__m128 mask, __m128 a, __m128 b)
+		{
+			return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+		}
+
+		//4-wide sin/cos: reduce to [-PI/4, PI/4] around the nearest multiple of PI/2, then cephes minimax polynomials
+		void SinCos(__m128 x, __m128& sinOut, __m128& cosOut)
+		{
+			const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(2.f / PI)));
+			const __m128 q = _mm_cvtepi32_ps(quadrant);
+
+			//Cody-Waite: PI/2 split in three parts to keep precision for larger angles
+			__m128 y = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(1.5703125f)));
+			y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(4.837512969970703125e-4f)));
+			y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(7.549789948768648e-8f)));
+
+			const __m128 y2 = _mm_mul_ps(y, y);
+
+			__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), y2), _mm_set1_ps(8.3321608736e-3f));
+			s = _mm_add_ps(_mm_mul_ps(s, y2), _mm_set1_ps(-1.6666654611e-1f));
+			s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, y2), y), y);
+
+			__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), y2), _mm_set1_ps(-1.388731625493765e-3f));
+			c = _mm_add_ps(_mm_mul_ps(c, y2), _mm_set1_ps(4.166664568298827e-2f));
+			c = _mm_mul_ps(_mm_mul_ps(c, y2), y2);
+			c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(y2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.f));
+
+			//Odd quadrants swap sin and cos, quadrants 2-3 negate sin, quadrants 1-2 negate cos
+			const __m128i one = _mm_set1_epi32(1);
+			const __m128i two = _mm_set1_epi32(2);
+			const __m128 swapMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+			const __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+			const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+			sinOut = _mm_xor_ps(Select(swapMask, c, s), sinSign);
+			cosOut = _mm_xor_ps(Select(swapMask, s, c), cosSign);
+		}
+	}
+
+	void TransformSystem::Float3Array::Add(const Vector3& v)
+	{
+		x.push_back(v.x);
+		y.push_back(v.y);
+		z.push_back(v.z);
+	}
+
+	void TransformSystem::Float3Array::Set(uint32_t index, const Vector3& v)
+	{
+		x[index] = v.x;
+		y[index] = v.y;
+		z[index] = v.z;
+	}
+
+	void TransformSystem::Float3Array::Reserve(uint32_t count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+	}
+
+	TransformId TransformSystem::Add(const Vector3& position, const Vector3& rotation, const Vector3& scale, TransformId parent)
+	{
+		const TransformId id{ GetCount() };
+		assert((parent == InvalidTransformId || parent < id) && "Parents have to be added before their children");
+
+		const uint32_t depth{ parent == InvalidTransformId ? 0 : m_Depths[parent] + 1 };
+		assert((m_Depths.empty() || depth >= m_Depths.back()) && "Transforms have to be added in breadth-first order");
+		if (depth == m_LevelStarts.size())
+			m_LevelStarts.push_back(id);
+
+		m_Positions.Add(position);
+		m_Rotations.Add(rotation);
+		m_Scales.Add(scale);
+		m_AngularVelocities.Add(Vector3::Zero);
+
+		m_Parents.push_back(parent);
+		m_Depths.push_back(depth);
+
+		m_IsDirty.push_back(true);
+		m_IsChanged.push_back(false);
+		m_LocalMatrices.emplace_back();
+		m_WorldMatrices.emplace_back();
+
+		return id;
+	}
+
+	void TransformSystem::Reserve(uint32_t count)
+	{
+		m_Positions.Reserve(count);
+		m_Rotations.Reserve(count);
+		m_Scales.Reserve(count);
+		m_AngularVelocities.Reserve(count);
+		m_Parents.reserve(count);
+		m_Depths.reserve(count);
+		m_IsDirty.reserve(count);
+		m_IsChanged.reserve(count);
+		m_LocalMatrices.reserve(count);
+		m_WorldMatrices.reserve(count);
+	}
+
+	void TransformSystem::SetPosition(TransformId id, const Vector3& position)
+	{
+		m_Positions.Set(id, position);
+		m_IsDirty[id] = true;
+	}
+
+	void TransformSystem::SetRotation(TransformId id, const Vector3& rotation)
+	{
+		m_Rotations.Set(id, rotation);
+		m_IsDirty[id] = true;
+	}
+
+	void TransformSystem::SetScale(TransformId id, const Vector3& scale)
+	{
+		m_Scales.Set(id, scale);
+		m_IsDirty[id] = true;
+	}
+
+	void TransformSystem::SetAngularVelocity(TransformId id, const Vector3& angularVelocity)
+	{
+		m_AngularVelocities.Set(id, angularVelocity);
+	}
+
+	void TransformSystem::Update(float deltaTime, JobSystem& jobs)
+	{
+		const uint32_t count{ GetCount() };
+
+		//1. Integrate rotations and build every local matrix
+		jobs.ParallelFor(count, g_BatchSize, [this, deltaTime](uint32_t begin, uint32_t end)
+			{
+				UpdateLocalRange(begin, end, deltaTime);
+			});
+
+		//2. Concatenate with the parent, one level at a time since a level only reads the previous one
+		for (size_t level{ 0 }; level < m_LevelStarts.size(); ++level)
+		{
+			const uint32_t levelBegin{ m_LevelStarts[level] };
+			const uint32_t levelEnd{ level + 1 < m_LevelStarts.size() ? m_LevelStarts[level + 1] : count };
+
+			jobs.ParallelFor(levelEnd - levelBegin, g_BatchSize, [this, levelBegin](uint32_t begin, uint32_t end)
+				{
+					UpdateHierarchyRange(levelBegin + begin, levelBegin + end);
+				});
+		}
+	}
+
+	void TransformSystem::UpdateLocalRange(uint32_t begin, uint32_t end, float deltaTime)
+	{
+		const __m128 dt = _mm_set1_ps(deltaTime);
+		const __m128 zero = _mm_setzero_ps();
+
+		uint32_t i{ begin };
+		for (; i + 4 <= end; i += 4)
+		{
+			//Integrate angular velocity
+			const __m128 velX = _mm_loadu_ps(&m_AngularVelocities.x[i]);
+			const __m128 velY = _mm_loadu_ps(&m_AngularVelocities.y[i]);
+			const __m128 velZ = _mm_loadu_ps(&m_AngularVelocities.z[i]);
+
+			const __m128 pitch = _mm_add_ps(_mm_loadu_ps(&m_Rotations.x[i]), _mm_mul_ps(velX, dt));
+			const __m128 yaw = _mm_add_ps(_mm_loadu_ps(&m_Rotations.y[i]), _mm_mul_ps(velY, dt));
+			const __m128 roll = _mm_add_ps(_mm_loadu_ps(&m_Rotations.z[i]), _mm_mul_ps(velZ, dt));
+			_mm_storeu_ps(&m_Rotations.x[i], pitch);
+			_mm_storeu_ps(&m_Rotations.y[i], yaw);
+			_mm_storeu_ps(&m_Rotations.z[i], roll);
+
+			//Skip the batch if none of the four moved
+			const __m128 isMoving = _mm_or_ps(_mm_or_ps(_mm_cmpneq_ps(velX, zero), _mm_cmpneq_ps(velY, zero)), _mm_cmpneq_ps(velZ, zero));
+			const int movingMask{ _mm_movemask_ps(isMoving) };
+			int dirtyMask{ movingMask };
+			for (int k{}; k < 4; ++k)
+			{
+				if (m_IsDirty[i + k])
+					dirtyMask |= 1 << k;
+				m_IsChanged[i + k] = (dirtyMask >> k) & 1;
+				m_IsDirty[i + k] = false;
+			}
+			if (dirtyMask == 0)
+				continue;
+
+			__m128 sx, cx, sy, cy, sz, cz;
+			SinCos(pitch, sx, cx);
+			SinCos(yaw, sy, cy);
+			SinCos(roll, sz, cz);
+
+			//Scale * RotationX * RotationY * RotationZ * Translation, same convention as Matrix::CreateRotation
+			const __m128 scaleX = _mm_loadu_ps(&m_Scales.x[i]);
+			const __m128 scaleY = _mm_loadu_ps(&m_Scales.y[i]);
+			const __m128 scaleZ = _mm_loadu_ps(&m_Scales.z[i]);
+
+			const __m128 sxsy = _mm_mul_ps(sx, sy);
+			const __m128 cxsy = _mm_mul_ps(cx, sy);
+
+			__m128 rows[4][4];
+			rows[0][0] = _mm_mul_ps(_mm_mul_ps(cy, cz), scaleX);
+			rows[0][1] = _mm_mul_ps(_mm_mul_ps(cy, sz), scaleX);
+			rows[0][2] = _mm_mul_ps(_mm_sub_ps(zero, sy), scaleX);
+			rows[0][3] = zero;
+
+			rows[1][0] = _mm_mul_ps(_mm_sub_ps(zero, _mm_add_ps(_mm_mul_ps(sxsy, cz), _mm_mul_ps(cx, sz))), scaleY);
+			rows[1][1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scaleY);
+			rows[1][2] = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(sx, cy)), scaleY);
+			rows[1][3] = zero;
+
+			rows[2][0] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cxsy, cz), _mm_mul_ps(sx, sz)), scaleZ);
+			rows[2][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cxsy, sz), _mm_mul_ps(sx, cz)), scaleZ);
+			rows[2][2] = _mm_mul_ps(_mm_mul_ps(cx, cy), scaleZ);
+			rows[2][3] = zero;
+
+			rows[3][0] = _mm_loadu_ps(&m_Positions.x[i]);
+			rows[3][1] = _mm_loadu_ps(&m_Positions.y[i]);
+			rows[3][2] = _mm_loadu_ps(&m_Positions.z[i]);
+			rows[3][3] = _mm_set1_ps(1.f);
+
+			//Lanes hold the same element of four objects, transpose to get one row per object
+			for (int r{}; r < 4; ++r)
+			{
+				_MM_TRANSPOSE4_PS(rows[r][0], rows[r][1], rows[r][2], rows[r][3]);
+				for (int k{}; k < 4; ++k)
+				{
+					if ((dirtyMask >> k) & 1)
+						_mm_store_ps(m_LocalMatrices[i + k].m[r], rows[r][k]);
+				}
+			}
+		}
+
+		//Tail that doesn't fill a full SIMD register
+		for (; i < end; ++i)
+		{
+			const Vector3 velocity{ m_AngularVelocities.x[i], m_AngularVelocities.y[i], m_AngularVelocities.z[i] };
+			const bool isMoving{ velocity.x != 0.f || velocity.y != 0.f || velocity.z != 0.f };
+
+			m_Rotations.x[i] += velocity.x * deltaTime;
+			m_Rotations.y[i] += velocity.y * deltaTime;
+			m_Rotations.z[i] += velocity.z * deltaTime;
+
+			m_IsChanged[i] = m_IsDirty[i] || isMoving;
+			m_IsDirty[i] = false;
+			if (!m_IsChanged[i])
+				continue;
+
+			const Matrix local{ Matrix::CreateScale(m_Scales.x[i], m_Scales.y[i], m_Scales.z[i])
+				* Matrix::CreateRotation(m_Rotations.x[i], m_Rotations.y[i], m_Rotations.z[i])
+				* Matrix::CreateTranslation(m_Positions.x[i], m_Positions.y[i], m_Positions.z[i]) };
+
+			for (int r{}; r < 4; ++r)
+			{
+				const Vector4 row{ local[r] };
+				m_LocalMatrices[i].m[r][0] = row.x;
+				m_LocalMatrices[i].m[r][1] = row.y;
+				m_LocalMatrices[i].m[r][2] = row.z;
+				m_LocalMatrices[i].m[r][3] = row.w;
+			}
+		}
+	}
+
+	void TransformSystem::UpdateHierarchyRange(uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i{ begin }; i < end; ++i)
+		{
+			const TransformId parent{ m_Parents[i] };
+			if (parent == InvalidTransformId)
+			{
+				if (m_IsChanged[i])
+					m_WorldMatrices[i] = m_LocalMatrices[i];
+				continue;
+			}
+
+			m_IsChanged[i] = m_IsChanged[i] || m_IsChanged[parent];
+			if (!m_IsChanged[i])
+				continue;
+
+			//world = local * parentWorld, each row is a linear combination of the parent rows
+			const Float4x4& parentWorld{ m_WorldMatrices[parent] };
+			const __m128 p0 = _mm_load_ps(parentWorld.m[0]);
+			const __m128 p1 = _mm_load_ps(parentWorld.m[1]);
+			const __m128 p2 = _mm_load_ps(parentWorld.m[2]);
+			const __m128 p3 = _mm_load_ps(parentWorld.m[3]);
+
+			const Float4x4& local{ m_LocalMatrices[i] };
+			Float4x4& world{ m_WorldMatrices[i] };
+			for (int r{}; r < 4; ++r)
+			{
+				const float* pRow{ local.m[r] };
+				__m128 result = _mm_mul_ps(_mm_set1_ps(pRow[0]), p0);
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(pRow[1]), p1));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(pRow[2]), p2));
+				result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(pRow[3]), p3));
+				_mm_store_ps(world.m[r], result);
+			}
+		}
+	}
+
+	Matrix TransformSystem::GetWorldMatrix(TransformId id) const
+	{
+		const Float4x4& world{ m_WorldMatrices[id] };
+		return Matrix{
+			Vector4{ world.m[0][0], world.m[0][1], world.m[0][2], world.m[0][3] },
+			Vector4{ world.m[1][0], world.m[1][1], world.m[1][2], world.m[1][3] },
+			Vector4{ world.m[2][0], world.m[2][1], world.m[2][2], world.m[2][3] },
+			Vector4{ world.m[3][0], world.m[3][1], world.m[3][2], world.m[3][3] } };
+	}
+
+	bool TransformSystem::IsChanged(TransformId id) const
+	{
+		return m_IsChanged[id];
+	}
+
+	uint32_t TransformSystem::GetCount() const
+	{
+		return static_cast<uint32_t>(m_Parents.size());
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	class JobSystem;
+
+	using TransformId = uint32_t;
+	constexpr TransformId InvalidTransformId{ UINT32_MAX };
+
+	//Component-style storage for many dynamic objects.
+	//All inputs live in contiguous SoA arrays, parents are always stored before their children (breadth-first),
+	//so the world matrices can be built level by level in one SIMD pass without chasing pointers.
+	class TransformSystem final
+	{
+	public:
+		TransformSystem() = default;
+		~TransformSystem() = default;
+
+		TransformSystem(const TransformSystem& other) = delete;
+		TransformSystem(TransformSystem&& other) = delete;
+		TransformSystem& operator=(const TransformSystem& other) = delete;
+		TransformSystem& operator=(TransformSystem&& other) = delete;
+
+		//The parent has to be added before the child and no shallower object can follow a deeper one
+		TransformId Add(const Vector3& position, const Vector3& rotation = Vector3::Zero, const Vector3& scale = { 1.f, 1.f, 1.f }, TransformId parent = InvalidTransformId);
+		void Reserve(uint32_t count);
+
+		void SetPosition(TransformId id, const Vector3& position);
+		void SetRotation(TransformId id, const Vector3& rotation);
+		void SetScale(TransformId id, const Vector3& scale);
+		//Radians per second for pitch, yaw and roll, integrated in Update
+		void SetAngularVelocity(TransformId id, const Vector3& angularVelocity);
+
+		void Update(float deltaTime, JobSystem& jobs);
+
+		Matrix GetWorldMatrix(TransformId id) const;
+		//True if the world matrix changed during the last Update
+		bool IsChanged(TransformId id) const;
+		uint32_t GetCount() const;
+
+	private:
+		struct Float3Array
+		{
+			std::vector<float> x{};
+			std::vector<float> y{};
+			std::vector<float> z{};
+
+			void Add(const Vector3& v);
+			void Set(uint32_t index, const Vector3& v);
+			void Reserve(uint32_t count);
+		};
+
+		//Row-major like Matrix, but plain and 16 byte aligned for SSE loads/stores
+		struct alignas(16) Float4x4
+		{
+			float m[4][4];
+		};
+
+		void UpdateLocalRange(uint32_t begin, uint32_t end, float deltaTime);
+		void UpdateHierarchyRange(uint32_t begin, uint32_t end);
+
+		Float3Array m_Positions{};
+		Float3Array m_Rotations{};
+		Float3Array m_Scales{};
+		Float3Array m_AngularVelocities{};
+
+		std::vector<TransformId> m_Parents{};
+		std::vector<uint32_t> m_Depths{};
+		//m_LevelStarts[d] is the first index with depth d
+		std::vector<uint32_t> m_LevelStarts{};
+
+		std::vector<uint8_t> m_IsDirty{};
+		std::vector<uint8_t> m_IsChanged{};
+		std::vector<Float4x4> m_LocalMatrices{};
+		std::vector<Float4x4> m_WorldMatrices{};
+	};
+}
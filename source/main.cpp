@@ -6,6 +6,14 @@
 
 #undef main
 #include "Renderer.h"
+#if defined(_WIN32)
+#include "D3D11Device.h"
+#endif
+#include "SoftwareDevice.h"
+#include "Benchmark.h"
+
+#include <chrono>
+#include <fstream>
 
 using namespace dae;
 
@@ -15,18 +23,81 @@ void ShutDown(SDL_Window* pWindow)
 	SDL_Quit();
 }
 
-int main(int argc, char* args[])
+//Renders numFrames of the scene on the software device without a window, then writes the last one to a binary PPM
+bool RenderHeadless(uint32_t width, uint32_t height, uint32_t numFrames, const std::string& path)
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
+	SoftwareDevice* pDevice{ new SoftwareDevice(width, height) };
+	Renderer* pRenderer{ new Renderer(pDevice, width, height) };
 
-	//Create window + surfaces
-	SDL_Init(SDL_INIT_VIDEO);
+	Timer timer{};
+	timer.Start();
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame{}; frame < numFrames; ++frame)
+	{
+		timer.Update();
+		pRenderer->Update(&timer);
+	}
+	//Rendering runs a frame behind, the last one is only in the color buffer after this
+	pRenderer->Flush();
+	std::cout << numFrames << " frame(s) in " << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+		<< " ms, last frame: " << pRenderer->GetFrameStats() << std::endl;
+
+	//Texels hold R in their lowest byte
+	std::vector<uint8_t> pixels{};
+	pixels.reserve(size_t{ width } * height * 3);
+	for (uint32_t color : pDevice->GetColorBuffer())
+	{
+		pixels.push_back(static_cast<uint8_t>(color));
+		pixels.push_back(static_cast<uint8_t>(color >> 8));
+		pixels.push_back(static_cast<uint8_t>(color >> 16));
+	}
+	const bool isValid{ pDevice->GetNumErrors() == 0 };
+	delete pRenderer;
+
+	std::ofstream file{ path, std::ios::binary };
+	file << "P6\n" << width << ' ' << height << "\n255\n";
+	file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+	if (!file)
+	{
+		std::cout << "Could not write " << path << std::endl;
+		return false;
+	}
+	std::cout << "Wrote " << path << std::endl;
+	return isValid;
+}
+
+int main(int argc, char* args[])
+{
+	//Startup without the compiled effect cache, to compare load times
+	const bool isEffectCacheEnabled{ argc < 2 || std::string{ args[1] } != "--no-effect-cache" };
+	//The same scene rasterized on the CPU, for machines without a D3D11 GPU, and the only device off Windows
+#if defined(_WIN32)
+	const bool isSoftware{ argc > 1 && std::string{ args[1] } == "--software" };
+#else
+	const bool isSoftware{ true };
+#endif
 
 	const uint32_t width = 640;
 	const uint32_t height = 480;
 
+	//Offline step: converts the scene's images to cooked textures, loaded instead of them from then on
+	if (argc > 1 && std::string{ args[1] } == "--cook-textures")
+		return Renderer::CookTextures() ? 0 : 1;
+
+	//Software rendering without a window, e.g. "--software-frames 60 frame.ppm"
+	if (argc > 1 && std::string{ args[1] } == "--software-frames")
+	{
+		const uint32_t numFrames{ argc > 2 ? static_cast<uint32_t>(std::max(std::atoi(args[2]), 1)) : 1 };
+		return RenderHeadless(width, height, numFrames, argc > 3 ? args[3] : "frame.ppm") ? 0 : 1;
+	}
+
+	//Headless benchmarks skip the window entirely
+	if (argc > 1 && isEffectCacheEnabled && std::string{ args[1] } != "--software")
+		return Benchmark::Run(args[1]) ? 0 : 1;
+
+	//Create window + surfaces
+	SDL_Init(SDL_INIT_VIDEO);
+
 	SDL_Window* pWindow = SDL_CreateWindow(
 		"DirectX - Mendel Debrabandere / 2DAE07",
 		SDL_WINDOWPOS_UNDEFINED,
@@ -38,11 +109,22 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto startupStart = std::chrono::high_resolution_clock::now();
+	GraphicsDevice* pDevice{ nullptr };
+	if (isSoftware)
+		pDevice = new SoftwareDevice(width, height, pWindow);
+#if defined(_WIN32)
+	else
+		pDevice = new D3D11Device(pWindow, isEffectCacheEnabled);
+#endif
+	const auto pRenderer = new Renderer(pDevice, width, height);
+	std::cout << "Startup: " << std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count()
+		<< " ms, effect cache " << (isEffectCacheEnabled ? "enabled" : "disabled") << std::endl;
 
 	//Start loop
 	pTimer->Start();
 	float printTimer = 0.f;
+	bool isFirstFrameReported = false;
 	bool isLooping = true;
 	while (isLooping)
 	{
@@ -72,10 +154,14 @@ int main(int argc, char* args[])
 		}
 
 		//--------- Update ---------
+		//Rendering happens on the renderer's own thread, one frame behind this one
 		pRenderer->Update(pTimer);
 
-		//--------- Render ---------
-		pRenderer->Render();
+		if (!isFirstFrameReported && pRenderer->GetTimeToFirstFrame() > 0.f)
+		{
+			isFirstFrameReported = true;
+			std::cout << "Time to first frame: " << pRenderer->GetTimeToFirstFrame() << " ms" << std::endl;
+		}
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -84,6 +170,7 @@ int main(int argc, char* args[])
 		{
 			printTimer = 0.f;
 			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+			std::cout << "Last frame: " << pRenderer->GetFrameStats() << std::endl;
 		}
 	}
 	pTimer->Stop();